@@ -63,6 +63,8 @@ typedef enum MppMetaKey_e {
     KEY_INPUT_PACKET            = FOURCC_META('i', 'p', 'k', 't'),
     KEY_OUTPUT_FRAME            = FOURCC_META('o', 'f', 'r', 'm'),
     KEY_OUTPUT_PACKET           = FOURCC_META('o', 'p', 'k', 't'),
+    /* NULL terminated MppPacket array from decode_put_packets */
+    KEY_INPUT_PACKETS           = FOURCC_META('i', 'p', 'k', 's'),
     /* output motion information for motion detection */
     KEY_MOTION_INFO             = FOURCC_META('m', 'v', 'i', 'f'),
     KEY_HDR_INFO                = FOURCC_META('h', 'd', 'r', ' '),
@@ -219,7 +219,13 @@ typedef struct EncRcCommonInfo_t {
     /* rc stats info: real time bits */
     RK_S32          rt_bits;
 
-    RK_S32          reserve[4];
+    /* rc internal: scaled qp of this frame, scale 64 */
+    RK_S32          scale_qp;
+    /* look-ahead complexity of this frame and mean of the window */
+    RK_S32          la_cost;
+    RK_S32          la_cost_avg;
+
+    RK_S32          reserve[1];
 } EncRcTaskInfo;
 
 typedef struct EncRcTask_s {
@@ -51,6 +51,9 @@
  *
  * decode_get_frame : get video frame from decoder only, async interface
  *
+ * decode_put_packets: send an array of video stream packets to decoder in one
+ *            call, async interface
+ *
  * encode_put_frame : send video frame to encoder only, async interface
  *
  * encode_get_packet: get encoded video packet from encoder only, async interface
@@ -206,10 +209,28 @@ typedef struct MppApi_t {
      */
     MPP_RET (*control)(MppCtx ctx, MpiCmd cmd, MppParam param);
 
+    // batched data flow interface
+    /**
+     * @brief send an array of video stream packets to decoder in one call,
+     *        async interface. The packets are carried to decoder by one input
+     *        task and are parsed in array order, so the input task handshake
+     *        is done once instead of once per packet. Only the last packet
+     *        can carry eos flag.
+     * @param[in] ctx The context of mpp, created by mpp_create() and initiated
+     *                by mpp_init().
+     * @param[in] packets The input video stream array, its usage can refer mpp_packet.h.
+     * @param[in] count The number of packets in the array.
+     * @return 0 and positive for success, negative for failure. The return
+     *         value is an error code. For details, please refer mpp_err.h.
+     */
+    MPP_RET (*decode_put_packets)(MppCtx ctx, MppPacket *packets, RK_S32 count);
+
     /**
      * @brief The reserved segment, may be used in the future
+     *        decode_put_packets takes its slot from the reserved segment so
+     *        that the size of MppApi is kept for binary compatibility.
      */
-    RK_U32 reserv[16];
+    RK_U32 reserv[16 - sizeof(void *) / sizeof(RK_U32)];
 } MppApi;
 
 
@@ -266,6 +287,15 @@ MPP_RET mpp_check_support_format(MppCtxType type, MppCodingType coding);
  */
 void    mpp_show_support_format(void);
 void    mpp_show_color_format(void);
+/**
+ * @ingroup rk_mpi
+ * @brief Get the statistics summed over all mpp sessions since process start.
+ *        Use MPP_GET_STATS control for the statistics of one session.
+ * @param[out] stats statistics output, refer to rk_mpi_stats.h.
+ * @return 0 for success, others for failure.
+ * @note This function does not block any running session.
+ */
+MPP_RET mpp_get_stats(MppStats *stats);
 
 #ifdef __cplusplus
 }
@@ -75,6 +75,11 @@ typedef enum {
     MPP_SET_INPUT_TIMEOUT,              /* parameter type RK_S64 */
     MPP_SET_OUTPUT_TIMEOUT,             /* parameter type RK_S64 */
     MPP_SET_DISABLE_THREAD,             /* MPP no thread mode and use external thread to decode */
+    /* per-frame stage trace, refer to rk_mpi_trace.h */
+    MPP_SET_FRAME_TRACE,                /* parameter type RK_U32 * ring size, zero to stop tracing */
+    MPP_GET_FRAME_TRACE,                /* parameter type MppFrameTraceInfo * */
+    MPP_DUMP_FRAME_TRACE,               /* parameter type char * chrome trace-event json file path */
+    MPP_GET_STATS,                      /* parameter type MppStats *, refer to rk_mpi_stats.h */
 
     MPP_STATE_CMD_BASE                  = CMD_MODULE_MPP | CMD_STATE_OPS,
     MPP_START,
@@ -207,5 +212,7 @@ typedef enum {
 #include "rk_venc_cmd.h"
 #include "rk_venc_cfg.h"
 #include "rk_venc_ref.h"
+#include "rk_mpi_trace.h"
+#include "rk_mpi_stats.h"
 
 #endif /*__RK_MPI_CMD_H__*/
@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef __RK_MPI_STATS_H__
+#define __RK_MPI_STATS_H__
+
+#include "rk_type.h"
+
+/*
+ * Runtime statistics of mpp sessions
+ *
+ * The statistics are always collected with per-cpu atomic counters and can be
+ * read at any time without blocking the codec threads.
+ * MPP_GET_STATS copies the statistics of one session and mpp_get_stats copies
+ * the sum of all sessions since process start.
+ */
+typedef enum MppStatsCounter_e {
+    MPP_STATS_PKT_IN,           /* decoder packets put by user */
+    MPP_STATS_FRM_OUT,          /* decoder frames output */
+    MPP_STATS_FRM_IN,           /* encoder frames put by user */
+    MPP_STATS_PKT_OUT,          /* encoder packets output */
+    MPP_STATS_HW_RUN,           /* hardware tasks finished */
+    MPP_STATS_REENC,            /* encoder reencode times */
+    MPP_STATS_COUNTER_BUTT,
+} MppStatsCounter;
+
+typedef enum MppStatsGauge_e {
+    MPP_STATS_BUF_HIGH_WATER,   /* max buffer group usage in bytes */
+    MPP_STATS_GAUGE_BUTT,
+} MppStatsGauge;
+
+typedef enum MppStatsHistType_e {
+    MPP_STATS_PARSE_TIME,       /* decoder parse or encoder frame setup time */
+    MPP_STATS_HW_WAIT_TIME,     /* hal wait time for hardware finish */
+    MPP_STATS_HIST_BUTT,
+} MppStatsHistType;
+
+/*
+ * latency histogram in microsecond
+ * bins[0] counts samples below 1us, bins[i] counts samples in
+ * [2^(i-1), 2^i) us and the last bin counts all samples beyond.
+ */
+#define MPP_STATS_HIST_BINS     20
+
+typedef struct MppStatsHist_t {
+    RK_U64      count;
+    RK_U64      sum;
+    RK_U64      max;
+    RK_U64      bins[MPP_STATS_HIST_BINS];
+} MppStatsHist;
+
+typedef struct MppStats_t {
+    RK_U64          counter[MPP_STATS_COUNTER_BUTT];
+    RK_U64          gauge[MPP_STATS_GAUGE_BUTT];
+    MppStatsHist    hist[MPP_STATS_HIST_BUTT];
+} MppStats;
+
+#endif /*__RK_MPI_STATS_H__*/
@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef __RK_MPI_TRACE_H__
+#define __RK_MPI_TRACE_H__
+
+#include "rk_type.h"
+
+/*
+ * Per-frame pipeline stage trace
+ *
+ * When enabled by MPP_SET_FRAME_TRACE or env mpp_frame_trace=<ring size> the
+ * decoder and encoder threads stamp mpp_time() (in us) at each stage of one
+ * frame. Finished frames are kept in a per-session ring buffer which can be
+ * copied out by MPP_GET_FRAME_TRACE or written by MPP_DUMP_FRAME_TRACE as
+ * Chrome trace-event json for chrome://tracing or perfetto.
+ *
+ * Stage          decoder                       encoder
+ * INPUT          packet task enqueued by user  frame task enqueued by user
+ * START          packet taken by parser        frame taken by encoder
+ * PREPARE        stream split / prepared       frame and packet checked
+ * SLOT           slot wait done, parse start   output buffer ready
+ * PARSE          syntax parsed                 dpb and rc frame setup done
+ * READY          frame buffer ready for hal    hal task and rc ready
+ * REG_GEN        registers generated           registers generated
+ * HW_START       hardware started              hardware started
+ * HW_DONE        hardware finished             hardware finished
+ * OUTPUT         frame sent to output          packet sent to output
+ *
+ * Skipped stages have zero stamp. The time between two valid stamps is the
+ * time spent in the later stage, e.g. HW_DONE - HW_START is hardware time and
+ * OUTPUT - HW_DONE is the time in display queue for decoder.
+ */
+typedef enum MppFrameTraceStage_e {
+    MPP_TRACE_INPUT,
+    MPP_TRACE_START,
+    MPP_TRACE_PREPARE,
+    MPP_TRACE_SLOT,
+    MPP_TRACE_PARSE,
+    MPP_TRACE_READY,
+    MPP_TRACE_REG_GEN,
+    MPP_TRACE_HW_START,
+    MPP_TRACE_HW_DONE,
+    MPP_TRACE_OUTPUT,
+    MPP_TRACE_STAGE_BUTT,
+} MppFrameTraceStage;
+
+typedef struct MppFrameTraceRecord_t {
+    RK_U32      seq;            /* frame count in output order */
+    RK_S32      index;          /* frame slot index for decoder, task sequence for encoder */
+    RK_S64      pts;
+    RK_S64      stamp[MPP_TRACE_STAGE_BUTT];
+} MppFrameTraceRecord;
+
+/*
+ * MPP_GET_FRAME_TRACE parameter
+ * caller provides records array with count elements, mpp copies the latest
+ * records in output order and updates count. total is the number of frames
+ * traced since tracing started.
+ */
+typedef struct MppFrameTraceInfo_t {
+    RK_S32              count;
+    RK_U32              total;
+    MppFrameTraceRecord *records;
+} MppFrameTraceInfo;
+
+#endif /*__RK_MPI_TRACE_H__*/
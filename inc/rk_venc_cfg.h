@@ -21,6 +21,23 @@
 #include "mpp_err.h"
 
 typedef void* MppEncCfg;
+typedef void* MppEncCfgKey;
+
+/*
+ * key / value pair for batched config update
+ * The value member should match the type of the key, ptr is used for both
+ * pointer and struct config.
+ */
+typedef struct MppEncCfgKv_t {
+    MppEncCfgKey        key;
+    union {
+        RK_S32          s32;
+        RK_U32          u32;
+        RK_S64          s64;
+        RK_U64          u64;
+        void            *ptr;
+    } val;
+} MppEncCfgKv;
 
 #ifdef __cplusplus
 extern "C" {
@@ -43,6 +60,16 @@ MPP_RET mpp_enc_cfg_get_u64(MppEncCfg cfg, const char *name, RK_U64 *val);
 MPP_RET mpp_enc_cfg_get_ptr(MppEncCfg cfg, const char *name, void **val);
 MPP_RET mpp_enc_cfg_get_st(MppEncCfg cfg, const char *name, void *val);
 
+/*
+ * Resolve a config name to a key once and reuse it on later updates.
+ * The key is valid in the whole process and shared by all MppEncCfg.
+ * mpp_enc_cfg_set_kv applies count key / value pairs without string lookup.
+ * Like other setters it only updates MppEncCfg. MPP_ENC_SET_CFG is still
+ * required to apply all the changes to encoder at once.
+ */
+MPP_RET mpp_enc_cfg_get_key(const char *name, MppEncCfgKey *key);
+MPP_RET mpp_enc_cfg_set_kv(MppEncCfg cfg, const MppEncCfgKv *kv, RK_S32 count);
+
 void mpp_enc_cfg_show(void);
 
 #ifdef __cplusplus
@@ -213,6 +213,7 @@ typedef enum MppEncRcCfgChange_e {
     MPP_ENC_RC_CFG_CHANGE_RC_MODE       = (1 << 0),
     MPP_ENC_RC_CFG_CHANGE_QUALITY       = (1 << 1),
     MPP_ENC_RC_CFG_CHANGE_BPS           = (1 << 2),     /* change on bps target / max / min */
+    MPP_ENC_RC_CFG_CHANGE_LOOKAHEAD     = (1 << 3),
     MPP_ENC_RC_CFG_CHANGE_FPS_IN        = (1 << 5),     /* change on fps in  flex / numerator / denominator */
     MPP_ENC_RC_CFG_CHANGE_FPS_OUT       = (1 << 6),     /* change on fps out flex / numerator / denominator */
     MPP_ENC_RC_CFG_CHANGE_GOP           = (1 << 7),
@@ -421,6 +422,14 @@ typedef struct MppEncRcCfg_t {
     MppEncRcRefreshMode     refresh_mode;
     RK_U32                  refresh_num;
     RK_S32                  refresh_length;
+
+    /*
+     * look-ahead window in frames, 0 - disable, max 16
+     * Only works on async encoding with non-block input. Input frames are
+     * held by encoder for lookahead frames before they are encoded and the
+     * last frames are flushed by an eos frame.
+     */
+    RK_S32                  lookahead;
 } MppEncRcCfg;
 
 
@@ -116,6 +116,9 @@ typedef struct bitread_ctx_t {
     RK_S64 prev_two_bytes_;
     // Number of emulation presentation bytes (0x000003) we met.
     RK_S64 emulation_prevention_bytes_;
+    // First byte which may not be loaded by the word fast path, refreshed
+    // by the emulation prevention locator when reached.
+    RK_U8  *epb_guard_;
     // count PPS SPS SEI read bits
     RK_S32 used_bits;
     RK_U8  *buf;
@@ -38,6 +38,9 @@
 #define MPP_BUF_FUNCTION_LEAVE_OK()     mpp_buf_dbg_f(MPP_BUF_DBG_FUNCTION, "success\n")
 #define MPP_BUF_FUNCTION_LEAVE_FAIL()   mpp_buf_dbg_f(MPP_BUF_DBG_FUNCTION, "failed\n")
 
+/* power-of-two size class count for unused buffer lookup, 8K to 128M and above */
+#define MPP_BUF_BUCKET_NUM              16
+
 typedef enum MppBufOps_e {
     GRP_CREATE,
     GRP_RELEASE,
@@ -112,6 +115,8 @@ struct MppBufferImpl_t {
     RK_U32              used;
     RK_S32              ref_count;
     struct list_head    list_status;
+    // link to size class bucket in group when unused
+    struct list_head    list_bucket;
 
     /*
      * mpp_device map for attach / detach operation
@@ -162,6 +167,13 @@ struct MppBufferGroupImpl_t {
     RK_S32              count_used;
     RK_S32              count_unused;
 
+    // size class index of unused buffer for best-fit lookup
+    struct list_head    list_bucket[MPP_BUF_BUCKET_NUM];
+    // unused buffer lookup statistic
+    RK_U32              hit_count;
+    RK_U32              miss_count;
+    RK_U32              evict_count;
+
     // buffer log function
     MppBufLogs          *logs;
 
@@ -185,7 +197,8 @@ extern RK_U32 mpp_buffer_debug;
  *                            for reducing virtual memory usage.
  *
  *  mpp_buffer_get_unused   : get unused buffer with size. it will first search
- *                            the unused list. if failed it will create on from
+ *                            the size class buckets for the smallest unused
+ *                            buffer that fits. if failed it will create on from
  *                            group allocator.
  *
  *  mpp_buffer_ref_inc      : increase buffer's reference counter. if it is unused
@@ -221,7 +234,7 @@ MPP_RET mpp_buffer_group_reset(MppBufferGroupImpl *p);
 MPP_RET mpp_buffer_group_set_callback(MppBufferGroupImpl *p,
                                       MppBufCallback callback, void *arg);
 // mpp_buffer_group helper function
-void mpp_buffer_group_dump(MppBufferGroupImpl *p);
+void mpp_buffer_group_dump(MppBufferGroupImpl *p, const char *caller);
 void mpp_buffer_service_dump(const char *info);
 MppBufferGroupImpl *mpp_buffer_get_misc_group(MppBufferMode mode, MppBufferType type);
 
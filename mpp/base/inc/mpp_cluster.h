@@ -24,6 +24,13 @@
 
 #define MAX_PRIORITY            1
 
+/*
+ * Cluster for cpu work shared by all sessions like decoder parser. It runs
+ * one worker by default and env mpp_cluster_thd_cnt changes the worker count.
+ * A node never runs on two workers at the same time.
+ */
+#define MPP_CLUSTER_CPU         ((MppClientType)VPU_CLIENT_BUTT)
+
 typedef void* MppNode;
 
 typedef MPP_RET (*TaskProc)(void *param);
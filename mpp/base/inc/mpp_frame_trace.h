@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef __MPP_FRAME_TRACE_H__
+#define __MPP_FRAME_TRACE_H__
+
+#include "rk_mpi_cmd.h"
+#include "mpp_err.h"
+
+/* record index for decoder stages before the output slot is known */
+#define MPP_TRACE_STAGING       (-1)
+
+typedef void* MppFrameTrace;
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Frame trace keeps one pending record per in-flight frame indexed by the
+ * decoder frame slot index or the encoder task sequence. Records are moved
+ * into the ring on commit. All stamp functions accept NULL trace and do
+ * nothing when tracing is disabled so the codec threads can call them
+ * unconditionally.
+ */
+MPP_RET mpp_frame_trace_init(MppFrameTrace *trace, RK_S32 size);
+MPP_RET mpp_frame_trace_deinit(MppFrameTrace trace);
+void mpp_frame_trace_enable(MppFrameTrace trace, RK_S32 enable);
+/* drop pending records and queued input stamps on reset */
+void mpp_frame_trace_reset(MppFrameTrace trace);
+
+/* user thread: one task was put to input port */
+void mpp_frame_trace_input(MppFrameTrace trace);
+/*
+ * codec thread: frame starts at index. new_input takes the input stamp of
+ * the next input task, otherwise the input stamp of the current task is kept
+ * for the packets split from one task.
+ */
+void mpp_frame_trace_start(MppFrameTrace trace, RK_S32 index, RK_S32 new_input);
+void mpp_frame_trace_stamp(MppFrameTrace trace, RK_S32 index, MppFrameTraceStage stage);
+/* decoder: move staging stamps to the output slot index after parse */
+void mpp_frame_trace_bind(MppFrameTrace trace, RK_S32 index);
+void mpp_frame_trace_commit(MppFrameTrace trace, RK_S32 index, RK_S64 pts);
+
+MPP_RET mpp_frame_trace_get(MppFrameTrace trace, MppFrameTraceInfo *info);
+MPP_RET mpp_frame_trace_dump(MppFrameTrace trace, const char *path, const char *tag);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __MPP_FRAME_TRACE_H__ */
@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef __MPP_STARTCODE_H__
+#define __MPP_STARTCODE_H__
+
+#include "rk_type.h"
+
+#define MPP_START_CODE_PREFIX       (0x000001)
+#define MPP_EMULATION_PREVENTION    (0x000003)
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Return the offset of the first 00 00 01 prefix which lies completely
+ * inside buf[0, size), or -1 when there is no such prefix.
+ * Uses NEON / SSE2 / AVX2 when available and a scalar loop otherwise.
+ */
+RK_S32 mpp_find_startcode(const RK_U8 *buf, RK_S32 size);
+
+/*
+ * Same as mpp_find_startcode but for the 00 00 03 emulation prevention
+ * sequence of H.264 / H.265 payload.
+ */
+RK_S32 mpp_find_emulation(const RK_U8 *buf, RK_S32 size);
+
+/*
+ * Return the offset of the first 00 00 00 or 00 00 01 sequence which ends
+ * the current H.264 / H.265 nal unit, or -1 when the nal runs to the end.
+ */
+RK_S32 mpp_find_nal_end(const RK_U8 *buf, RK_S32 size);
+
+/*
+ * Bulk replacement of the byte-wise shift register loop used by bitstream
+ * splitters:
+ *
+ *     state = (state << 8) | buf[i];
+ *     if ((state & 0xFFFFFF) == 0x000001) break;
+ *
+ * Consume bytes from buf until a 00 00 01 prefix is completed (prefix may
+ * straddle the previous call through *state) or the buffer runs out.
+ * Return the number of bytes consumed. On return *state holds exactly the
+ * value the byte-wise loop would have, so caller can test
+ * (*state & 0xFFFFFF) == MPP_START_CODE_PREFIX for the result.
+ */
+RK_S32 mpp_startcode_scan(RK_U64 *state, const RK_U8 *buf, RK_S32 size);
+
+/* reference byte-wise implementation of mpp_startcode_scan for test */
+RK_S32 mpp_startcode_scan_c(RK_U64 *state, const RK_U8 *buf, RK_S32 size);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __MPP_STARTCODE_H__ */
@@ -104,6 +104,14 @@ MPP_RET check_mpp_task_name(MppTask task);
  * 6. Mpp layer destory the task queue.
  */
 MPP_RET mpp_task_queue_init(MppTaskQueue *queue, void *mpp, const char *name);
+/*
+ * Switch the queue to single-producer / single-consumer mode before setup.
+ * Each port must then be driven by one thread only. The two ports exchange
+ * tasks through lock-free rings and a blocked poll is woken by eventfd only
+ * when the peer is actually waiting. It is only enabled by the owner of a
+ * queue whose ports are known to be driven by one thread each.
+ */
+MPP_RET mpp_task_queue_set_spsc(MppTaskQueue queue, RK_S32 enable);
 MPP_RET mpp_task_queue_setup(MppTaskQueue queue, RK_S32 task_count);
 MPP_RET mpp_task_queue_deinit(MppTaskQueue queue);
 MppPort mpp_task_queue_get_port(MppTaskQueue queue, MppPortType type);
@@ -20,6 +20,10 @@
 #include "rk_type.h"
 #include "mpp_mem.h"
 #include "mpp_bitread.h"
+#include "mpp_startcode.h"
+
+/* bytes checked by one emulation prevention locator call */
+#define BITREAD_EPB_SCAN_SIZE       (256)
 
 static MPP_RET update_curbyte_default(BitReadCtx_t *bitctx)
 {
@@ -107,6 +111,90 @@ static MPP_RET update_curbyte_avs2(BitReadCtx_t *bitctx)
     return MPP_OK;
 }
 
+static RK_S32 bitread_clz32(RK_U32 val)
+{
+#if defined(__GNUC__)
+    return __builtin_clz(val);
+#else
+    return 31 - mpp_log2(val);
+#endif
+}
+
+static RK_U32 bitread_load32(const RK_U8 *p)
+{
+    return ((RK_U32)p[0] << 24) | ((RK_U32)p[1] << 16) |
+           ((RK_U32)p[2] << 8) | (RK_U32)p[3];
+}
+
+/*
+ * Move epb_guard_ to the 03 of the next raw 00 00 03 which may be an
+ * emulation prevention byte, or to the end of the scanned window. The
+ * sequence may start in the two bytes already consumed.
+ */
+static void bitread_update_guard(BitReadCtx_t *bitctx)
+{
+    RK_U8 *start = bitctx->data_;
+    RK_U8 *end = start + MPP_MIN(bitctx->bytes_left_, BITREAD_EPB_SCAN_SIZE);
+    RK_S32 pos;
+
+    start = (start - bitctx->buf >= 2) ? start - 2 : bitctx->buf;
+    pos = mpp_find_emulation(start, end - start);
+    bitctx->epb_guard_ = (pos < 0) ? end : start + pos + 2;
+}
+
+/*
+ * Check whether the next |bytes| bytes can be loaded directly without the
+ * per byte update_curbyte call. Always keep four bytes readable so the
+ * fast path can use a single word load.
+ */
+static inline RK_S32 bitread_fast_avail(BitReadCtx_t *bitctx, RK_S32 bytes)
+{
+    RK_S32 i;
+
+    if (bitctx->bytes_left_ < 4)
+        return 0;
+
+    if (bitctx->prevention_type == PSEUDO_CODE_NONE)
+        return 1;
+
+    if (bitctx->prevention_type == PSEUDO_CODE_AVS2) {
+        /* 00 00 02 also changes the bit count so just check the 02 bytes */
+        for (i = 0; i < bytes; i++) {
+            if (bitctx->data_[i] == 0x02)
+                return 0;
+        }
+        return 1;
+    }
+
+    if (!bitctx->epb_guard_ || bitctx->data_ + bytes > bitctx->epb_guard_)
+        bitread_update_guard(bitctx);
+
+    return bitctx->data_ + bytes <= bitctx->epb_guard_;
+}
+
+/*
+ * Consume |bits| (1 to 31) bits following curr_byte_ with one word load.
+ * Caller must check bitread_fast_avail first. The byte based state is kept
+ * so the fields stay valid for the parsers which access them directly.
+ */
+static inline RK_U32 bitread_fast_take(BitReadCtx_t *bitctx, RK_S32 bits)
+{
+    RK_S32 bytes = (bits + 7) >> 3;
+    RK_U8 *p = bitctx->data_;
+    RK_U32 word = bitread_load32(p);
+
+    bitctx->data_ += bytes;
+    bitctx->bytes_left_ -= bytes;
+    bitctx->curr_byte_ = p[bytes - 1];
+    bitctx->num_remaining_bits_in_curr_byte_ = bytes * 8 - bits;
+    if (bytes > 1)
+        bitctx->prev_two_bytes_ = (p[bytes - 2] << 8) | p[bytes - 1];
+    else
+        bitctx->prev_two_bytes_ = ((bitctx->prev_two_bytes_ << 8) | p[0]) & 0xffff;
+
+    return word >> (32 - bits);
+}
+
 /*!
 ***********************************************************************
 * \brief
@@ -118,10 +206,21 @@ static MPP_RET update_curbyte_avs2(BitReadCtx_t *bitctx)
 MPP_RET mpp_read_bits(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_S32 *out)
 {
     RK_S32 bits_left = num_bits;
+    RK_S32 remain = bitctx->num_remaining_bits_in_curr_byte_;
+
     *out = 0;
     if (num_bits > 31) {
         return  MPP_ERR_READ_BIT;
     }
+    if (bits_left > remain &&
+        bitread_fast_avail(bitctx, (bits_left - remain + 7) >> 3)) {
+        RK_S32 need = bits_left - remain;
+
+        *out = (RK_S32)(((bitctx->curr_byte_ & ((1 << remain) - 1)) << need) |
+                        bitread_fast_take(bitctx, need));
+        bitctx->used_bits += num_bits;
+        return MPP_OK;
+    }
     while (bitctx->num_remaining_bits_in_curr_byte_ < bits_left) {
         // Take all that's left in current byte, shift to make space for the rest.
         *out |= (bitctx->curr_byte_ << (bits_left - bitctx->num_remaining_bits_in_curr_byte_));
@@ -170,7 +269,14 @@ MPP_RET mpp_read_longbits(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_U32 *out)
 MPP_RET mpp_skip_bits(BitReadCtx_t *bitctx, RK_S32 num_bits)
 {
     RK_S32 bits_left = num_bits;
+    RK_S32 remain = bitctx->num_remaining_bits_in_curr_byte_;
 
+    if (bits_left > remain && bits_left - remain < 32 &&
+        bitread_fast_avail(bitctx, (bits_left - remain + 7) >> 3)) {
+        bitread_fast_take(bitctx, bits_left - remain);
+        bitctx->used_bits += num_bits;
+        return MPP_OK;
+    }
     while (bitctx->num_remaining_bits_in_curr_byte_ < bits_left) {
         // Take all that's left in current byte, shift to make space for the rest.
         bits_left -= bitctx->num_remaining_bits_in_curr_byte_;
@@ -246,6 +352,30 @@ MPP_RET mpp_read_ue(BitReadCtx_t *bitctx, RK_U32 *val)
     RK_S32 num_bits = -1;
     RK_S32 bit;
     RK_S32 rest;
+
+    /*
+     * Fast path: peek 32 bits and count the leading zeros at once. Codes up
+     * to 31 bits long, value below 65535, are consumed from the same word.
+     */
+    if (bitread_fast_avail(bitctx, 4)) {
+        RK_S32 remain = bitctx->num_remaining_bits_in_curr_byte_;
+        RK_U64 window = ((RK_U64)(bitctx->curr_byte_ & ((1 << remain) - 1)) << 32) |
+                        bitread_load32(bitctx->data_);
+        RK_U32 peek = (RK_U32)(window >> remain);
+
+        if (peek >= 0x10000) {
+            RK_S32 len = bitread_clz32(peek) * 2 + 1;
+
+            *val = (peek >> (32 - len)) - 1;
+            if (len > remain)
+                bitread_fast_take(bitctx, len - remain);
+            else
+                bitctx->num_remaining_bits_in_curr_byte_ -= len;
+            bitctx->used_bits += len;
+            return MPP_OK;
+        }
+    }
+
     // Count the number of contiguous zero bits.
     do {
         if (mpp_read_bits(bitctx, 1, &bit)) {
@@ -342,6 +472,7 @@ void mpp_set_bitread_ctx(BitReadCtx_t *bitctx, RK_U8 *data, RK_S32 size)
 void mpp_set_bitread_pseudo_code_type(BitReadCtx_t *bitctx, PseudoCodeType type)
 {
     bitctx->prevention_type = type;
+    bitctx->epb_guard_ = NULL;
     switch (type) {
     case PSEUDO_CODE_H264_H265:
         bitctx->update_curbyte = update_curbyte_h264;
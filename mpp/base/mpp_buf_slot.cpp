@@ -21,6 +21,7 @@
 #include "mpp_mem.h"
 #include "mpp_env.h"
 #include "mpp_list.h"
+#include "mpp_lock.h"
 #include "mpp_debug.h"
 #include "mpp_common.h"
 
@@ -201,6 +202,13 @@ struct MppBufSlotsImpl_t {
     Mutex               *lock;
     RK_U32              slots_idx;
 
+    /*
+     * queue list and queue_use status are protected by queue lock only.
+     * slot status is updated by atomic operation for the concurrent queue
+     * access. impl->lock is always taken before queue lock.
+     */
+    pthread_mutex_t     queue_lock[QUEUE_BUTT];
+
     // status tracing
     RK_U32              decode_count;
     RK_U32              display_count;
@@ -221,6 +229,9 @@ struct MppBufSlotsImpl_t {
     size_t              buf_size;
     RK_S32              buf_count;
     RK_S32              used_count;
+    // bitmap of slot without on_used flag for get_unused lookup
+    RK_U32              *free_map;
+    RK_S32              free_words;
     // buffer size equal to (h_stride * v_stride) * numerator / denominator
     // internal parameter
     RK_U32              numerator;
@@ -410,9 +421,11 @@ static void generate_info_set(MppBufSlotsImpl *impl, MppFrame frame, RK_U32 forc
 
 static void buf_slot_logs_reset(MppBufSlotLogs *logs)
 {
+    pthread_mutex_lock(&logs->lock);
     logs->log_count = 0;
     logs->log_write = 0;
     logs->log_read = 0;
+    pthread_mutex_unlock(&logs->lock);
 }
 
 static MppBufSlotLogs *buf_slot_logs_init(RK_U32 max_count)
@@ -429,6 +442,9 @@ static MppBufSlotLogs *buf_slot_logs_init(RK_U32 max_count)
         return NULL;
     }
 
+    /* ops on queues are only protected by the queue lock of each type */
+    pthread_mutex_init(&logs->lock, NULL);
+
     logs->max_count = max_count;
     logs->logs = (MppBufSlotLog *)(logs + 1);
     buf_slot_logs_reset(logs);
@@ -438,6 +454,7 @@ static MppBufSlotLogs *buf_slot_logs_init(RK_U32 max_count)
 
 static void buf_slot_logs_deinit(MppBufSlotLogs *logs)
 {
+    pthread_mutex_destroy(&logs->lock);
     MPP_FREE(logs);
 }
 
@@ -446,6 +463,8 @@ static void buf_slot_logs_write(MppBufSlotLogs *logs, RK_S32 index, MppBufSlotOp
 {
     MppBufSlotLog *log = NULL;
 
+    pthread_mutex_lock(&logs->lock);
+
     log = &logs->logs[logs->log_write];
     log->index      = index;
     log->ops        = op;
@@ -463,10 +482,14 @@ static void buf_slot_logs_write(MppBufSlotLogs *logs, RK_S32 index, MppBufSlotOp
         if (logs->log_read >= logs->max_count)
             logs->log_read = 0;
     }
+
+    pthread_mutex_unlock(&logs->lock);
 }
 
 static void buf_slot_logs_dump(MppBufSlotLogs *logs)
 {
+    pthread_mutex_lock(&logs->lock);
+
     while (logs->log_count) {
         MppBufSlotLog *log = &logs->logs[logs->log_read];
 
@@ -479,6 +502,8 @@ static void buf_slot_logs_dump(MppBufSlotLogs *logs)
         logs->log_count--;
     }
     mpp_assert(logs->log_read == logs->log_write);
+
+    pthread_mutex_unlock(&logs->lock);
 }
 
 static void _dump_slots(const char *caller, MppBufSlotsImpl *impl)
@@ -508,109 +533,195 @@ static void _dump_slots(const char *caller, MppBufSlotsImpl *impl)
     return;
 }
 
+static void slot_free_map_resize(MppBufSlotsImpl *impl, RK_S32 count)
+{
+    RK_S32 words = (count + 31) / 32;
+
+    if (words > impl->free_words) {
+        impl->free_map = mpp_realloc(impl->free_map, RK_U32, words);
+        mpp_assert(impl->free_map);
+        memset(impl->free_map + impl->free_words, 0,
+               (words - impl->free_words) * sizeof(RK_U32));
+        impl->free_words = words;
+    }
+}
+
+static void slot_free_map_update(MppBufSlotsImpl *impl, RK_S32 index, RK_U32 on_used)
+{
+    RK_U32 bit = 1 << (index & 31);
+
+    if (on_used)
+        impl->free_map[index >> 5] &= ~bit;
+    else
+        impl->free_map[index >> 5] |= bit;
+}
+
+static RK_S32 slot_free_map_find(MppBufSlotsImpl *impl)
+{
+    RK_S32 i;
+
+    for (i = 0; i < impl->free_words; i++) {
+        RK_U32 bits = impl->free_map[i];
+
+        if (bits) {
+            /* lowest free index keeps the old first fit order */
+            RK_S32 index = i * 32 + mpp_log2(bits & (~bits + 1));
+
+            return (index < impl->buf_count) ? index : -1;
+        }
+    }
+
+    return -1;
+}
+
+static void slot_queue_lock_all(MppBufSlotsImpl *impl)
+{
+    RK_S32 i;
+
+    for (i = 0; i < QUEUE_BUTT; i++)
+        pthread_mutex_lock(&impl->queue_lock[i]);
+}
+
+static void slot_queue_unlock_all(MppBufSlotsImpl *impl)
+{
+    RK_S32 i;
+
+    for (i = QUEUE_BUTT - 1; i >= 0; i--)
+        pthread_mutex_unlock(&impl->queue_lock[i]);
+}
+
 static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppBufSlotOps op, void *arg)
 {
     RK_U32 error = 0;
+    RK_U32 warning = 0;
     RK_S32 index = slot->index;
-    SlotStatus status = slot->status;
-    SlotStatus before = status;
-    switch (op) {
-    case SLOT_INIT : {
-        status.val = 0;
-    } break;
-    case SLOT_SET_ON_USE : {
-        status.on_used = 1;
-    } break;
-    case SLOT_CLR_ON_USE : {
-        status.on_used = 0;
-    } break;
-    case SLOT_SET_NOT_READY : {
-        status.not_ready = 1;
-    } break;
-    case SLOT_CLR_NOT_READY : {
-        status.not_ready = 0;
-    } break;
-    case SLOT_SET_CODEC_READY : {
-        status.not_ready = 0;
-    } break;
-    case SLOT_CLR_CODEC_READY : {
-        status.not_ready = 1;
-    } break;
-    case SLOT_SET_CODEC_USE : {
-        status.codec_use = 1;
-    } break;
-    case SLOT_CLR_CODEC_USE : {
-        status.codec_use = 0;
-    } break;
-    case SLOT_SET_HAL_INPUT : {
-        status.hal_use++;
-    } break;
-    case SLOT_CLR_HAL_INPUT : {
-        if (status.hal_use)
-            status.hal_use--;
-        else {
-            mpp_err("can not clr hal_input on slot %d\n", slot->index);
+    SlotStatus status;
+    SlotStatus before;
+
+    do {
+        before.val = *(volatile RK_U32 *)&slot->status.val;
+        status = before;
+        error = 0;
+        warning = 0;
+
+        switch (op) {
+        case SLOT_INIT : {
+            status.val = 0;
+        } break;
+        case SLOT_SET_ON_USE : {
+            status.on_used = 1;
+        } break;
+        case SLOT_CLR_ON_USE : {
+            status.on_used = 0;
+        } break;
+        case SLOT_SET_NOT_READY : {
+            status.not_ready = 1;
+        } break;
+        case SLOT_CLR_NOT_READY : {
+            status.not_ready = 0;
+        } break;
+        case SLOT_SET_CODEC_READY : {
+            status.not_ready = 0;
+        } break;
+        case SLOT_CLR_CODEC_READY : {
+            status.not_ready = 1;
+        } break;
+        case SLOT_SET_CODEC_USE : {
+            status.codec_use = 1;
+        } break;
+        case SLOT_CLR_CODEC_USE : {
+            status.codec_use = 0;
+        } break;
+        case SLOT_SET_HAL_INPUT : {
+            status.hal_use++;
+        } break;
+        case SLOT_CLR_HAL_INPUT : {
+            if (status.hal_use)
+                status.hal_use--;
+            else
+                error = 1;
+        } break;
+        case SLOT_SET_HAL_OUTPUT : {
+            status.hal_output++;
+            status.not_ready  = 1;
+        } break;
+        case SLOT_CLR_HAL_OUTPUT : {
+            if (status.hal_output)
+                status.hal_output--;
+            else
+                warning = 1;
+
+            // NOTE: set output index ready here
+            if (!status.hal_output)
+                status.not_ready  = 0;
+        } break;
+        case SLOT_SET_QUEUE_USE :
+        case SLOT_ENQUEUE_OUTPUT :
+        case SLOT_ENQUEUE_DISPLAY :
+        case SLOT_ENQUEUE_DEINTER :
+        case SLOT_ENQUEUE_CONVERT : {
+            status.queue_use++;
+        } break;
+        case SLOT_CLR_QUEUE_USE :
+        case SLOT_DEQUEUE_OUTPUT :
+        case SLOT_DEQUEUE_DISPLAY :
+        case SLOT_DEQUEUE_DEINTER :
+        case SLOT_DEQUEUE_CONVERT : {
+            if (status.queue_use)
+                status.queue_use--;
+            else
+                error = 1;
+        } break;
+        case SLOT_SET_EOS : {
+            status.eos = 1;
+        } break;
+        case SLOT_CLR_EOS : {
+            status.eos = 0;
+            slot->eos = 0;
+        } break;
+        case SLOT_SET_FRAME : {
+            status.has_frame = (arg) ? (1) : (0);
+        } break;
+        case SLOT_CLR_FRAME : {
+            status.has_frame = 0;
+        } break;
+        case SLOT_SET_BUFFER : {
+            status.has_buffer = (arg) ? (1) : (0);
+        } break;
+        case SLOT_CLR_BUFFER : {
+            status.has_buffer = 0;
+        } break;
+        default : {
             error = 1;
+        } break;
         }
-    } break;
-    case SLOT_SET_HAL_OUTPUT : {
-        status.hal_output++;
-        status.not_ready  = 1;
-    } break;
-    case SLOT_CLR_HAL_OUTPUT : {
-        if (status.hal_output)
-            status.hal_output--;
-        else
-            mpp_err("can not clr hal_output on slot %d\n", slot->index);
+    } while (!MPP_BOOL_CAS(&slot->status.val, before.val, status.val));
 
-        // NOTE: set output index ready here
-        if (!status.hal_output)
-            status.not_ready  = 0;
-    } break;
-    case SLOT_SET_QUEUE_USE :
-    case SLOT_ENQUEUE_OUTPUT :
-    case SLOT_ENQUEUE_DISPLAY :
-    case SLOT_ENQUEUE_DEINTER :
-    case SLOT_ENQUEUE_CONVERT : {
-        status.queue_use++;
-    } break;
-    case SLOT_CLR_QUEUE_USE :
-    case SLOT_DEQUEUE_OUTPUT :
-    case SLOT_DEQUEUE_DISPLAY :
-    case SLOT_DEQUEUE_DEINTER :
-    case SLOT_DEQUEUE_CONVERT : {
-        if (status.queue_use)
-            status.queue_use--;
-        else {
-            mpp_err("can not clr queue_use on slot %d\n", slot->index);
-            error = 1;
+    /* report once on the status really written instead of on each retry */
+    if (error || warning) {
+        switch (op) {
+        case SLOT_CLR_HAL_INPUT : {
+            mpp_err("can not clr hal_input on slot %d\n", index);
+        } break;
+        case SLOT_CLR_HAL_OUTPUT : {
+            mpp_err("can not clr hal_output on slot %d\n", index);
+        } break;
+        case SLOT_CLR_QUEUE_USE :
+        case SLOT_DEQUEUE_OUTPUT :
+        case SLOT_DEQUEUE_DISPLAY :
+        case SLOT_DEQUEUE_DEINTER :
+        case SLOT_DEQUEUE_CONVERT : {
+            mpp_err("can not clr queue_use on slot %d\n", index);
+        } break;
+        default : {
+            mpp_err("found invalid operation code %d\n", op);
+        } break;
         }
-    } break;
-    case SLOT_SET_EOS : {
-        status.eos = 1;
-    } break;
-    case SLOT_CLR_EOS : {
-        status.eos = 0;
-        slot->eos = 0;
-    } break;
-    case SLOT_SET_FRAME : {
-        status.has_frame = (arg) ? (1) : (0);
-    } break;
-    case SLOT_CLR_FRAME : {
-        status.has_frame = 0;
-    } break;
-    case SLOT_SET_BUFFER : {
-        status.has_buffer = (arg) ? (1) : (0);
-    } break;
-    case SLOT_CLR_BUFFER : {
-        status.has_buffer = 0;
-    } break;
-    default : {
-        mpp_err("found invalid operation code %d\n", op);
-        error = 1;
-    } break;
     }
-    slot->status = status;
+
+    if (op == SLOT_INIT || op == SLOT_SET_ON_USE || op == SLOT_CLR_ON_USE)
+        slot_free_map_update(impl, index, status.on_used);
+
     buf_slot_dbg(BUF_SLOT_DBG_OPS_RUNTIME, "slot %3d index %2d op: %s arg %010p status in %08x out %08x",
                  impl->slots_idx, index, op_string[op], arg, before.val, status.val);
     if (impl->logs)
@@ -621,7 +732,13 @@ static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppB
 
 static void init_slot_entry(MppBufSlotsImpl *impl, RK_S32 pos, RK_S32 count)
 {
-    MppBufSlotEntry *slot = impl->slots;
+    MppBufSlotEntry *slot = impl->slots + pos;
+
+    slot_free_map_resize(impl, pos + count);
+    // full reinit may shrink the slot array so drop all stale free bits
+    if (!pos)
+        memset(impl->free_map, 0, impl->free_words * sizeof(RK_U32));
+
     for (RK_S32 i = 0; i < count; i++, slot++) {
         slot->slots = impl;
         INIT_LIST_HEAD(&slot->list);
@@ -701,6 +818,10 @@ static void clear_slots_impl(MppBufSlotsImpl *impl)
     if (impl->lock)
         delete impl->lock;
 
+    for (i = 0; i < QUEUE_BUTT; i++)
+        pthread_mutex_destroy(&impl->queue_lock[i]);
+
+    mpp_free(impl->free_map);
     mpp_free(impl->slots);
     mpp_free(impl);
 }
@@ -726,6 +847,7 @@ MPP_RET mpp_buf_slot_init(MppBufSlots *slots)
 
         for (RK_U32 i = 0; i < MPP_ARRAY_ELEMS(impl->queue); i++) {
             INIT_LIST_HEAD(&impl->queue[i]);
+            pthread_mutex_init(&impl->queue_lock[i], NULL);
         }
 
         if (buf_slot_debug & BUF_SLOT_DBG_OPS_HISTORY) {
@@ -782,6 +904,7 @@ MPP_RET mpp_buf_slot_setup(MppBufSlots slots, RK_S32 count)
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
     AutoMutex auto_lock(impl->lock);
 
+    slot_queue_lock_all(impl);
     if (NULL == impl->slots) {
         // first slot setup
         impl->buf_count = impl->new_count = count;
@@ -797,6 +920,7 @@ MPP_RET mpp_buf_slot_setup(MppBufSlots slots, RK_S32 count)
         }
         impl->new_count = count;
     }
+    slot_queue_unlock_all(impl);
 
     return MPP_OK;
 }
@@ -830,9 +954,11 @@ MPP_RET mpp_buf_slot_ready(MppBufSlots slots)
 
     // ready mean the info_set will be copy to info as the new configuration
     if (impl->buf_count != impl->new_count) {
+        slot_queue_lock_all(impl);
         impl->slots = mpp_realloc(impl->slots, MppBufSlotEntry, impl->new_count);
         mpp_assert(impl->slots);
         init_slot_entry(impl, 0, impl->new_count);
+        slot_queue_unlock_all(impl);
     }
     impl->buf_count = impl->new_count;
 
@@ -893,16 +1019,17 @@ MPP_RET mpp_buf_slot_get_unused(MppBufSlots slots, RK_S32 *index)
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
     AutoMutex auto_lock(impl->lock);
-    RK_S32 i;
-    MppBufSlotEntry *slot = impl->slots;
-    for (i = 0; i < impl->buf_count; i++, slot++) {
-        if (!slot->status.on_used) {
-            *index = i;
-            slot_ops_with_log(impl, slot, SLOT_SET_ON_USE, NULL);
-            slot_ops_with_log(impl, slot, SLOT_SET_NOT_READY, NULL);
-            impl->used_count++;
-            return MPP_OK;
-        }
+    RK_S32 i = slot_free_map_find(impl);
+
+    if (i >= 0) {
+        MppBufSlotEntry *slot = &impl->slots[i];
+
+        slot_assert(impl, !slot->status.on_used);
+        *index = i;
+        slot_ops_with_log(impl, slot, SLOT_SET_ON_USE, NULL);
+        slot_ops_with_log(impl, slot, SLOT_SET_NOT_READY, NULL);
+        impl->used_count++;
+        return MPP_OK;
     }
 
     *index = -1;
@@ -960,7 +1087,8 @@ MPP_RET mpp_buf_slot_enqueue(MppBufSlots slots, RK_S32 index, SlotQueueType type
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
+    // slot may still be linked on other queue so unlink it under all locks
+    slot_queue_lock_all(impl);
     slot_assert(impl, (index >= 0) && (index < impl->buf_count));
     MppBufSlotEntry *slot = &impl->slots[index];
     slot_ops_with_log(impl, slot, (MppBufSlotOps)(SLOT_ENQUEUE + type), NULL);
@@ -968,6 +1096,7 @@ MPP_RET mpp_buf_slot_enqueue(MppBufSlots slots, RK_S32 index, SlotQueueType type
     // add slot to display list
     list_del_init(&slot->list);
     list_add_tail(&slot->list, &impl->queue[type]);
+    slot_queue_unlock_all(impl);
     return MPP_OK;
 }
 
@@ -979,22 +1108,28 @@ MPP_RET mpp_buf_slot_dequeue(MppBufSlots slots, RK_S32 *index, SlotQueueType typ
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
+    MppBufSlotEntry *slot;
+    MPP_RET ret = MPP_NOK;
+
+    pthread_mutex_lock(&impl->queue_lock[type]);
     if (list_empty(&impl->queue[type]))
-        return MPP_NOK;
+        goto DONE;
 
-    MppBufSlotEntry *slot = list_entry(impl->queue[type].next, MppBufSlotEntry, list);
+    slot = list_entry(impl->queue[type].next, MppBufSlotEntry, list);
     if (slot->status.not_ready)
-        return MPP_NOK;
+        goto DONE;
 
     // make sure that this slot is just the next display slot
     list_del_init(&slot->list);
     slot_assert(impl, slot->index < impl->buf_count);
     slot_ops_with_log(impl, slot, (MppBufSlotOps)(SLOT_DEQUEUE + type), NULL);
-    impl->display_count++;
+    MPP_FETCH_ADD(&impl->display_count, 1);
     *index = slot->index;
+    ret = MPP_OK;
 
-    return MPP_OK;
+DONE:
+    pthread_mutex_unlock(&impl->queue_lock[type]);
+    return ret;
 }
 
 MPP_RET mpp_buf_slot_set_prop(MppBufSlots slots, RK_S32 index, SlotPropType type, void *val)
@@ -1146,9 +1281,11 @@ MPP_RET mpp_buf_slot_reset(MppBufSlots slots, RK_S32 index)
     MppBufSlotEntry *slot = &impl->slots[index];
 
     // make sure that this slot is just the next display slot
+    slot_queue_lock_all(impl);
     list_del_init(&slot->list);
     slot_ops_with_log(impl, slot, SLOT_CLR_QUEUE_USE, NULL);
     slot_ops_with_log(impl, slot, SLOT_DEQUEUE, NULL);
+    slot_queue_unlock_all(impl);
     slot_ops_with_log(impl, slot, SLOT_CLR_ON_USE, NULL);
     return MPP_OK;
 }
@@ -1190,8 +1327,13 @@ RK_U32 mpp_slots_is_empty(MppBufSlots slots, SlotQueueType type)
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
-    return list_empty(&impl->queue[type]) ? 1 : 0;
+    RK_U32 empty;
+
+    pthread_mutex_lock(&impl->queue_lock[type]);
+    empty = list_empty(&impl->queue[type]) ? 1 : 0;
+    pthread_mutex_unlock(&impl->queue_lock[type]);
+
+    return empty;
 }
 
 RK_S32 mpp_slots_get_used_count(MppBufSlots slots)
@@ -1201,7 +1343,8 @@ RK_S32 mpp_slots_get_used_count(MppBufSlots slots)
         return 0;
     }
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
+
+    // NOTE: counter read is a snapshot and does not need impl->lock
     return impl->used_count;
 }
 
@@ -1213,9 +1356,10 @@ RK_S32 mpp_slots_get_unused_count(MppBufSlots slots)
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
-    slot_assert(impl, (impl->used_count >= 0) && (impl->used_count <= impl->buf_count));
-    return impl->buf_count - impl->used_count;
+    RK_S32 used_count = impl->used_count;
+
+    slot_assert(impl, (used_count >= 0) && (used_count <= impl->buf_count));
+    return impl->buf_count - used_count;
 }
 
 MPP_RET mpp_slots_set_prop(MppBufSlots slots, SlotsPropType type, void *val)
@@ -30,6 +30,8 @@
 #define MAX_MISC_GROUP_BIT              3
 #define BUFFER_OPS_MAX_COUNT            1024
 #define MPP_ALLOCATOR_WITH_FLAG_NUM     8
+/* max too small unused buffers kept in internal group on lookup miss */
+#define BUFFER_UNUSED_KEEP_MAX          8
 
 #define SEARCH_GROUP_BY_ID(id)  ((MppBufferService::get_instance())->get_group_by_id(id))
 
@@ -58,6 +60,11 @@ private:
     RK_U32              total_size;
     RK_U32              total_max;
 
+    // device map statistic for buffer attach / detach
+    RK_U32              map_lookup;
+    RK_U32              map_attach;
+    RK_U32              map_detach;
+
     // misc group for internal / externl buffer with different type
     RK_U32              misc[MPP_BUFFER_MODE_BUTT][MPP_BUFFER_TYPE_BUTT];
     RK_U32              misc_count;
@@ -93,6 +100,9 @@ public:
     void                dec_total(RK_U32 size);
     RK_U32              get_total_now() { return total_size; };
     RK_U32              get_total_max() { return total_max; };
+    void                inc_map_lookup() { MPP_FETCH_ADD(&map_lookup, 1); };
+    void                inc_map_attach() { MPP_FETCH_ADD(&map_attach, 1); };
+    void                inc_map_detach() { MPP_FETCH_ADD(&map_detach, 1); };
 };
 
 static const char *mode2str[MPP_BUFFER_MODE_BUTT] = {
@@ -243,6 +253,51 @@ static void clear_buffer_info(MppBufferInfo *info)
     info->type = MPP_BUFFER_TYPE_BUTT;
 }
 
+/* bucket k holds unused buffer with size in [4K << k, 8K << k), bucket 0 holds all below 8K */
+static RK_S32 buf_bucket_idx(size_t size)
+{
+    RK_U32 pages = (RK_U32)(size >> 12);
+    RK_S32 idx = pages ? mpp_log2(pages) : 0;
+
+    return (idx < MPP_BUF_BUCKET_NUM) ? idx : (MPP_BUF_BUCKET_NUM - 1);
+}
+
+static void buf_bucket_add(MppBufferGroupImpl *group, MppBufferImpl *buffer)
+{
+    list_add_tail(&buffer->list_bucket, &group->list_bucket[buf_bucket_idx(buffer->info.size)]);
+}
+
+/* find the smallest unused buffer not less than size */
+static MppBufferImpl *buf_bucket_find(MppBufferGroupImpl *group, size_t size)
+{
+    RK_S32 idx;
+
+    for (idx = buf_bucket_idx(size); idx < MPP_BUF_BUCKET_NUM; idx++) {
+        MppBufferImpl *best = NULL;
+        MppBufferImpl *pos;
+
+        list_for_each_entry(pos, &group->list_bucket[idx], MppBufferImpl, list_bucket) {
+            mpp_buf_dbg(MPP_BUF_DBG_CHECK_SIZE, "request size %d on buf idx %d size %d\n",
+                        size, pos->buffer_id, pos->info.size);
+
+            if (pos->info.size < size)
+                continue;
+
+            if (!best || pos->info.size < best->info.size) {
+                best = pos;
+                if (best->info.size == size)
+                    break;
+            }
+        }
+
+        /* any buffer in higher bucket is larger than the best one here */
+        if (best)
+            return best;
+    }
+
+    return NULL;
+}
+
 static MPP_RET put_buffer(MppBufferGroupImpl *group, MppBufferImpl *buffer,
                           RK_U32 reuse, const char *caller)
 {
@@ -263,11 +318,13 @@ static MPP_RET put_buffer(MppBufferGroupImpl *group, MppBufferImpl *buffer,
     }
 
     list_del_init(&buffer->list_status);
+    list_del_init(&buffer->list_bucket);
 
     if (reuse) {
         if (buffer->used && group) {
             group->count_used--;
             list_add_tail(&buffer->list_status, &group->list_unused);
+            buf_bucket_add(group, buffer);
             group->count_unused++;
         } else {
             mpp_err_f("can not reuse unused buffer %d at group %p:%d\n",
@@ -324,6 +381,7 @@ static MPP_RET put_buffer(MppBufferGroupImpl *group, MppBufferImpl *buffer,
         mpp_dev_ioctl(dev, MPP_DEV_DETACH_FD, pos);
         mpp_dev_ioctl(dev, MPP_DEV_UNLOCK_MAP, NULL);
         mpp_mem_pool_put_f(caller, mpp_buf_map_node_pool, pos);
+        MppBufferService::get_instance()->inc_map_detach();
     }
 
     /* release buffer here */
@@ -358,6 +416,7 @@ static MPP_RET inc_buffer_ref(MppBufferImpl *buffer, const char *caller)
         if (group) {
             pthread_mutex_lock(&group->buf_lock);
             list_del_init(&buffer->list_status);
+            list_del_init(&buffer->list_bucket);
             list_add_tail(&buffer->list_status, &group->list_used);
             group->count_used++;
             group->count_unused--;
@@ -448,6 +507,7 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
     pthread_mutex_lock(&group->buf_lock);
     p->buffer_id = group->buffer_id++;
     INIT_LIST_HEAD(&p->list_status);
+    INIT_LIST_HEAD(&p->list_bucket);
     INIT_LIST_HEAD(&p->list_maps);
 
     if (buffer) {
@@ -458,6 +518,7 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
         *buffer = p;
     } else {
         list_add_tail(&p->list_status, &group->list_unused);
+        buf_bucket_add(group, p);
         group->count_unused++;
     }
 
@@ -573,6 +634,8 @@ void mpp_buffer_group_dump(MppBufferGroupImpl *group, const char *caller)
     }
 
     mpp_log("unused buffer count %d\n", group->count_unused);
+    mpp_log("unused lookup hit %u miss %u evict %u\n",
+            group->hit_count, group->miss_count, group->evict_count);
     list_for_each_entry_safe(pos, n, &group->list_unused, MppBufferImpl, list_status) {
         dump_buffer_info(pos);
     }
@@ -588,40 +651,45 @@ MppBufferImpl *mpp_buffer_get_unused(MppBufferGroupImpl *p, size_t size, const c
     MppBufferImpl *buffer = NULL;
 
     pthread_mutex_lock(&p->buf_lock);
-    if (!list_empty(&p->list_unused)) {
-        MppBufferImpl *pos, *n;
-        RK_S32 found = 0;
-        RK_S32 search_count = 0;
 
-        list_for_each_entry_safe(pos, n, &p->list_unused, MppBufferImpl, list_status) {
-            mpp_buf_dbg(MPP_BUF_DBG_CHECK_SIZE, "request size %d on buf idx %d size %d\n",
-                        size, pos->buffer_id, pos->info.size);
-            if (pos->info.size >= size) {
-                buffer = pos;
-                pthread_mutex_lock(&buffer->lock);
-                buffer->ref_count++;
-                buffer->used = 1;
-                buf_add_log(buffer, BUF_REF_INC, caller);
-                list_del_init(&buffer->list_status);
-                list_add_tail(&buffer->list_status, &p->list_used);
-                p->count_used++;
-                p->count_unused--;
-                pthread_mutex_unlock(&buffer->lock);
-                found = 1;
-                break;
-            } else {
-                if (MPP_BUFFER_INTERNAL == p->mode) {
-                    put_buffer(p, pos, 0, caller);
-                } else
-                    search_count++;
-            }
-        }
+    buffer = buf_bucket_find(p, size);
+    if (buffer) {
+        pthread_mutex_lock(&buffer->lock);
+        buffer->ref_count++;
+        buffer->used = 1;
+        buf_add_log(buffer, BUF_REF_INC, caller);
+        list_del_init(&buffer->list_status);
+        list_del_init(&buffer->list_bucket);
+        list_add_tail(&buffer->list_status, &p->list_used);
+        p->count_used++;
+        p->count_unused--;
+        pthread_mutex_unlock(&buffer->lock);
+        p->hit_count++;
+    } else {
+        p->miss_count++;
+
+        if (MPP_BUFFER_INTERNAL == p->mode) {
+            MppBufferImpl *pos, *n;
 
-        if (!found && search_count) {
+            /*
+             * All unused buffers are too small here. Keep them for later
+             * smaller request and only release the oldest ones when they
+             * block the new allocation or too many are cached.
+             */
+            list_for_each_entry_safe(pos, n, &p->list_unused, MppBufferImpl, list_status) {
+                if (!(p->limit_count && p->buffer_count >= p->limit_count) &&
+                    p->count_unused <= BUFFER_UNUSED_KEEP_MAX)
+                    break;
+
+                put_buffer(p, pos, 0, caller);
+                p->evict_count++;
+            }
+        } else if (p->count_unused) {
             mpp_err_f("can not found match buffer with size larger than %d\n", size);
             mpp_buffer_group_dump(p, caller);
         }
     }
+
     pthread_mutex_unlock(&p->buf_lock);
 
     MPP_BUF_FUNCTION_LEAVE();
@@ -659,6 +727,8 @@ static MppDevBufMapNode *mpp_buffer_attach_dev_lock(const char *caller, MppBuffe
     MppDevBufMapNode *node = NULL;
     MPP_RET ret = MPP_OK;
 
+    MppBufferService::get_instance()->inc_map_lookup();
+
     mpp_dev_ioctl(dev, MPP_DEV_LOCK_MAP, NULL);
     pthread_mutex_lock(&impl->lock);
 
@@ -683,6 +753,7 @@ static MppDevBufMapNode *mpp_buffer_attach_dev_lock(const char *caller, MppBuffe
     node->dev = dev;
     node->pool = mpp_buf_map_node_pool;
     node->buf_fd = impl->info.fd;
+    node->cache = NULL;
 
     ret = mpp_dev_ioctl(dev, MPP_DEV_ATTACH_FD, node);
     if (ret) {
@@ -691,6 +762,7 @@ static MppDevBufMapNode *mpp_buffer_attach_dev_lock(const char *caller, MppBuffe
         goto DONE;
     }
     list_add_tail(&node->list_buf, &impl->list_maps);
+    MppBufferService::get_instance()->inc_map_attach();
 
 DONE:
     pthread_mutex_unlock(&impl->lock);
@@ -721,6 +793,7 @@ MPP_RET mpp_buffer_detach_dev_f(const char *caller, MppBuffer buffer, MppDev dev
             list_del_init(&pos->list_buf);
             ret = mpp_dev_ioctl(dev, MPP_DEV_DETACH_FD, pos);
             mpp_mem_pool_put_f(caller, mpp_buf_map_node_pool, pos);
+            MppBufferService::get_instance()->inc_map_detach();
             break;
         }
     }
@@ -893,6 +966,9 @@ MppBufferService::MppBufferService()
       finished(0),
       total_size(0),
       total_max(0),
+      map_lookup(0),
+      map_attach(0),
+      map_detach(0),
       misc_count(0)
 {
     RK_S32 i, j;
@@ -1003,6 +1079,7 @@ MppBufferGroupImpl *MppBufferService::get_group(const char *tag, const char *cal
     MppBufferType buffer_type = (MppBufferType)(type & MPP_BUFFER_TYPE_MASK);
     MppBufferGroupImpl *p = NULL;
     RK_U32 flag = MPP_ALLOC_FLAG_NONE;
+    RK_S32 i;
 
     /* env update */
     mpp_env_get_u32("mpp_buffer_debug", &mpp_buffer_debug, mpp_buffer_debug);
@@ -1059,6 +1136,8 @@ MppBufferGroupImpl *MppBufferService::get_group(const char *tag, const char *cal
     INIT_LIST_HEAD(&p->list_used);
     INIT_LIST_HEAD(&p->list_unused);
     INIT_HLIST_NODE(&p->hlist);
+    for (i = 0; i < MPP_BUF_BUCKET_NUM; i++)
+        INIT_LIST_HEAD(&p->list_bucket[i]);
 
     p->log_runtime_en   = (mpp_buffer_debug & MPP_BUF_DBG_OPS_RUNTIME) ? (1) : (0);
     p->log_history_en   = (mpp_buffer_debug & MPP_BUF_DBG_OPS_HISTORY) ? (1) : (0);
@@ -1227,6 +1306,8 @@ void MppBufferService::dump(const char *info)
     RK_U32 key;
 
     mpp_log("dumping all buffer groups for %s\n", info);
+    mpp_log("buffer map lookup %u attach %u detach %u\n",
+            map_lookup, map_attach, map_detach);
 
     if (hash_empty(mHashGroup)) {
         mpp_log("no buffer group can be dumped\n");
@@ -598,7 +598,7 @@ private:
     MppClusterServer(const MppClusterServer &);
     MppClusterServer &operator=(const MppClusterServer &);
 
-    MppCluster  *mClusters[VPU_CLIENT_BUTT];
+    MppCluster  *mClusters[MPP_CLUSTER_CPU + 1];
 
 public:
     static MppClusterServer *single() {
@@ -623,7 +623,7 @@ MppClusterServer::~MppClusterServer()
 {
     RK_S32 i;
 
-    for (i = 0; i < VPU_CLIENT_BUTT; i++)
+    for (i = 0; i <= MPP_CLUSTER_CPU; i++)
         put((MppClientType)i);
 }
 
@@ -632,7 +632,7 @@ MppCluster *MppClusterServer::get(MppClientType client_type)
     RK_S32 i;
     MppCluster *p = NULL;
 
-    if (client_type >= VPU_CLIENT_BUTT)
+    if (client_type > MPP_CLUSTER_CPU)
         goto done;
 
     {
@@ -680,7 +680,7 @@ MPP_RET MppClusterServer::put(MppClientType client_type)
 {
     RK_S32 i;
 
-    if (client_type >= VPU_CLIENT_BUTT)
+    if (client_type > MPP_CLUSTER_CPU)
         return MPP_NOK;
 
     AutoMutex auto_lock(this);
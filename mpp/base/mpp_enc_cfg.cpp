@@ -139,6 +139,7 @@ public:
     ENTRY(rc,   fqp_max_i,      S32,        MPP_ENC_RC_CFG_CHANGE_FQP,              rc, fqp_max_i) \
     ENTRY(rc,   fqp_max_p,      S32,        MPP_ENC_RC_CFG_CHANGE_FQP,              rc, fqp_max_p) \
     ENTRY(rc,   cu_qp_delta_depth, S32,     MPP_ENC_RC_CFG_CHANGE_QPDD,             rc, cu_qp_delta_depth) \
+    ENTRY(rc,   lookahead,      S32,        MPP_ENC_RC_CFG_CHANGE_LOOKAHEAD,        rc, lookahead) \
     /* prep config */ \
     ENTRY(prep, width,          S32,        MPP_ENC_PREP_CFG_CHANGE_INPUT,          prep, width) \
     ENTRY(prep, height,         S32,        MPP_ENC_PREP_CFG_CHANGE_INPUT,          prep, height) \
@@ -431,6 +432,87 @@ ENC_CFG_GET_ACCESS(mpp_enc_cfg_get_u64, RK_U64, U64);
 ENC_CFG_GET_ACCESS(mpp_enc_cfg_get_ptr, void *, Ptr);
 ENC_CFG_GET_ACCESS(mpp_enc_cfg_get_st,  void  , St);
 
+MPP_RET mpp_enc_cfg_get_key(const char *name, MppEncCfgKey *key)
+{
+    if (NULL == name || NULL == key) {
+        mpp_err_f("invalid input name %p key %p\n", name, key);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MppTrieInfo *node = MppEncCfgService::get()->get_info(name);
+
+    *key = node;
+    if (NULL == node || NULL == node->ctx) {
+        mpp_err_f("cfg %s is invalid\n", name);
+        *key = NULL;
+        return MPP_NOK;
+    }
+
+    mpp_enc_cfg_dbg_info("name %s key %p\n", name, node);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_enc_cfg_set_kv(MppEncCfg cfg, const MppEncCfgKv *kv, RK_S32 count)
+{
+    MppEncCfgImpl *p = (MppEncCfgImpl *)cfg;
+    RK_S32 i;
+
+    if (NULL == cfg || (count && NULL == kv) || count < 0) {
+        mpp_err_f("invalid input cfg %p kv %p count %d\n", cfg, kv, count);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    /* check all keys before update to avoid partial update on error */
+    for (i = 0; i < count; i++) {
+        MppTrieInfo *node = (MppTrieInfo *)kv[i].key;
+        MppCfgInfo *info = (MppCfgInfo *)(node ? node->ctx : NULL);
+
+        if (NULL == info) {
+            mpp_err_f("invalid key %p at %d\n", node, i);
+            return MPP_NOK;
+        }
+        if (info->data_type == CFG_FUNC_TYPE_St && NULL == kv[i].val.ptr) {
+            mpp_err_f("cfg %s found NULL struct at %d\n", node->name, i);
+            return MPP_NOK;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        MppTrieInfo *node = (MppTrieInfo *)kv[i].key;
+        MppCfgInfo *info = (MppCfgInfo *)node->ctx;
+
+        mpp_enc_cfg_dbg_set("name %s type %s\n", node->name, strof_cfg_type(info->data_type));
+
+        switch (info->data_type) {
+        case CFG_FUNC_TYPE_S32 : {
+            MPP_CFG_SET_S32(info, &p->cfg, kv[i].val.s32);
+        } break;
+        case CFG_FUNC_TYPE_U32 : {
+            MPP_CFG_SET_U32(info, &p->cfg, kv[i].val.u32);
+        } break;
+        case CFG_FUNC_TYPE_S64 : {
+            MPP_CFG_SET_S64(info, &p->cfg, kv[i].val.s64);
+        } break;
+        case CFG_FUNC_TYPE_U64 : {
+            MPP_CFG_SET_U64(info, &p->cfg, kv[i].val.u64);
+        } break;
+        case CFG_FUNC_TYPE_St : {
+            MPP_CFG_SET_St(info, &p->cfg, kv[i].val.ptr);
+        } break;
+        case CFG_FUNC_TYPE_Ptr : {
+            MPP_CFG_SET_Ptr(info, &p->cfg, kv[i].val.ptr);
+        } break;
+        default : {
+            mpp_err_f("cfg %s found invalid cfg type %d\n", node->name, info->data_type);
+            return MPP_NOK;
+        } break;
+        }
+    }
+
+    return MPP_OK;
+}
+
 void mpp_enc_cfg_show(void)
 {
     MppEncCfgService *srv = MppEncCfgService::get();
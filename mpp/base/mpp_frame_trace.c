@@ -0,0 +1,346 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "mpp_frame_trace"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "mpp_mem.h"
+#include "mpp_log.h"
+#include "mpp_lock.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "mpp_frame_trace.h"
+
+/* in-flight frames are indexed by slot index or task sequence modulo this */
+#define TRACE_PENDING_MAX       64
+#define TRACE_INPUT_MAX         64
+#define TRACE_RING_MAX          (64 * 1024)
+
+typedef struct MppFrameTraceImpl_t {
+    spinlock_t          lock;
+    volatile RK_S32     enable;
+
+    /* committed records ring */
+    RK_S32              size;
+    RK_U32              total;
+    MppFrameTraceRecord *ring;
+
+    /* stamps of frames in pipeline */
+    MppFrameTraceRecord staging;
+    MppFrameTraceRecord pending[TRACE_PENDING_MAX];
+
+    /* input stamps of tasks in input port in enqueue order */
+    RK_S64              input[TRACE_INPUT_MAX];
+    RK_U32              input_put;
+    RK_U32              input_get;
+    RK_S64              input_cur;
+} MppFrameTraceImpl;
+
+/* name of the time span ending at each stage */
+static const char *trace_span_name[MPP_TRACE_STAGE_BUTT] = {
+    "input",
+    "input queue",
+    "prepare",
+    "slot wait",
+    "parse",
+    "buffer wait",
+    "reg gen",
+    "hw start",
+    "hardware",
+    "output queue",
+};
+
+static MppFrameTraceRecord *get_record(MppFrameTraceImpl *p, RK_S32 index)
+{
+    if (index < 0)
+        return &p->staging;
+
+    return &p->pending[index & (TRACE_PENDING_MAX - 1)];
+}
+
+MPP_RET mpp_frame_trace_init(MppFrameTrace *trace, RK_S32 size)
+{
+    MppFrameTraceImpl *p = NULL;
+
+    if (NULL == trace) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    *trace = NULL;
+
+    /* power of 2 ring size for index mask */
+    size = MPP_CLIP3(2, TRACE_RING_MAX, size);
+    size = 1 << mpp_ceil_log2(size);
+
+    p = mpp_calloc(MppFrameTraceImpl, 1);
+    if (p)
+        p->ring = mpp_calloc(MppFrameTraceRecord, size);
+
+    if (NULL == p || NULL == p->ring) {
+        mpp_err_f("failed to malloc trace ring size %d\n", size);
+        MPP_FREE(p);
+        return MPP_ERR_MALLOC;
+    }
+
+    mpp_spinlock_init(&p->lock);
+    p->size = size;
+    p->enable = 1;
+
+    *trace = p;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_frame_trace_deinit(MppFrameTrace trace)
+{
+    MppFrameTraceImpl *p = (MppFrameTraceImpl *)trace;
+
+    if (NULL == p)
+        return MPP_OK;
+
+    mpp_spinlock_deinit(&p->lock, MODULE_TAG);
+    MPP_FREE(p->ring);
+    mpp_free(p);
+
+    return MPP_OK;
+}
+
+void mpp_frame_trace_enable(MppFrameTrace trace, RK_S32 enable)
+{
+    MppFrameTraceImpl *p = (MppFrameTraceImpl *)trace;
+
+    if (NULL == p)
+        return;
+
+    /* tasks queued while disabled have no input stamp */
+    mpp_spinlock_lock(&p->lock);
+    p->input_get = p->input_put;
+    p->enable = enable;
+    mpp_spinlock_unlock(&p->lock);
+}
+
+void mpp_frame_trace_reset(MppFrameTrace trace)
+{
+    MppFrameTraceImpl *p = (MppFrameTraceImpl *)trace;
+
+    if (NULL == p)
+        return;
+
+    mpp_spinlock_lock(&p->lock);
+    memset(&p->staging, 0, sizeof(p->staging));
+    memset(p->pending, 0, sizeof(p->pending));
+    p->input_get = p->input_put;
+    p->input_cur = 0;
+    mpp_spinlock_unlock(&p->lock);
+}
+
+void mpp_frame_trace_input(MppFrameTrace trace)
+{
+    MppFrameTraceImpl *p = (MppFrameTraceImpl *)trace;
+
+    if (NULL == p || !p->enable)
+        return;
+
+    mpp_spinlock_lock(&p->lock);
+    p->input[p->input_put & (TRACE_INPUT_MAX - 1)] = mpp_time();
+    p->input_put++;
+    mpp_spinlock_unlock(&p->lock);
+}
+
+void mpp_frame_trace_start(MppFrameTrace trace, RK_S32 index, RK_S32 new_input)
+{
+    MppFrameTraceImpl *p = (MppFrameTraceImpl *)trace;
+    MppFrameTraceRecord *rec;
+
+    if (NULL == p || !p->enable)
+        return;
+
+    if (new_input) {
+        mpp_spinlock_lock(&p->lock);
+        /* the oldest stamps are overwritten when too many tasks queued */
+        if (p->input_put - p->input_get > TRACE_INPUT_MAX)
+            p->input_get = p->input_put - TRACE_INPUT_MAX;
+
+        if (p->input_get != p->input_put) {
+            p->input_cur = p->input[p->input_get & (TRACE_INPUT_MAX - 1)];
+            p->input_get++;
+        } else {
+            p->input_cur = 0;
+        }
+        mpp_spinlock_unlock(&p->lock);
+    }
+
+    rec = get_record(p, index);
+    memset(rec->stamp, 0, sizeof(rec->stamp));
+    rec->stamp[MPP_TRACE_INPUT] = p->input_cur;
+    rec->stamp[MPP_TRACE_START] = mpp_time();
+}
+
+void mpp_frame_trace_stamp(MppFrameTrace trace, RK_S32 index, MppFrameTraceStage stage)
+{
+    MppFrameTraceImpl *p = (MppFrameTraceImpl *)trace;
+
+    if (NULL == p || !p->enable || stage >= MPP_TRACE_STAGE_BUTT)
+        return;
+
+    get_record(p, index)->stamp[stage] = mpp_time();
+}
+
+void mpp_frame_trace_bind(MppFrameTrace trace, RK_S32 index)
+{
+    MppFrameTraceImpl *p = (MppFrameTraceImpl *)trace;
+    MppFrameTraceRecord *src;
+
+    if (NULL == p || !p->enable || index < 0)
+        return;
+
+    src = &p->staging;
+    memcpy(get_record(p, index)->stamp, src->stamp, sizeof(src->stamp));
+
+    /*
+     * keep input / start / prepare stamps for the following frames split
+     * from the same packet
+     */
+    memset(&src->stamp[MPP_TRACE_SLOT], 0,
+           sizeof(src->stamp[0]) * (MPP_TRACE_STAGE_BUTT - MPP_TRACE_SLOT));
+}
+
+void mpp_frame_trace_commit(MppFrameTrace trace, RK_S32 index, RK_S64 pts)
+{
+    MppFrameTraceImpl *p = (MppFrameTraceImpl *)trace;
+    MppFrameTraceRecord *rec;
+    MppFrameTraceRecord *dst;
+
+    if (NULL == p || !p->enable)
+        return;
+
+    rec = get_record(p, index);
+    /* frame never started in this pipeline like eos or reset leftover */
+    if (!rec->stamp[MPP_TRACE_START])
+        return;
+
+    rec->stamp[MPP_TRACE_OUTPUT] = mpp_time();
+
+    mpp_spinlock_lock(&p->lock);
+    dst = &p->ring[p->total & (p->size - 1)];
+    memcpy(dst->stamp, rec->stamp, sizeof(rec->stamp));
+    dst->seq = p->total++;
+    dst->index = index;
+    dst->pts = pts;
+    mpp_spinlock_unlock(&p->lock);
+
+    memset(rec->stamp, 0, sizeof(rec->stamp));
+}
+
+/* copy latest count records in output order and return copied count */
+static RK_S32 trace_copy(MppFrameTraceImpl *p, MppFrameTraceRecord *dst,
+                         RK_S32 count, RK_U32 *total)
+{
+    RK_U32 end;
+    RK_U32 start;
+    RK_U32 i;
+
+    mpp_spinlock_lock(&p->lock);
+    end = p->total;
+    count = MPP_MIN(count, (RK_S32)MPP_MIN(end, (RK_U32)p->size));
+    start = end - count;
+
+    for (i = start; i != end; i++)
+        *dst++ = p->ring[i & (p->size - 1)];
+    mpp_spinlock_unlock(&p->lock);
+
+    if (total)
+        *total = end;
+
+    return count;
+}
+
+MPP_RET mpp_frame_trace_get(MppFrameTrace trace, MppFrameTraceInfo *info)
+{
+    MppFrameTraceImpl *p = (MppFrameTraceImpl *)trace;
+
+    if (NULL == p || NULL == info || (info->count && NULL == info->records)) {
+        mpp_err_f("invalid trace %p info %p\n", trace, info);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    info->count = trace_copy(p, info->records, MPP_MAX(info->count, 0),
+                             &info->total);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_frame_trace_dump(MppFrameTrace trace, const char *path, const char *tag)
+{
+    MppFrameTraceImpl *p = (MppFrameTraceImpl *)trace;
+    MppFrameTraceRecord *records = NULL;
+    const char *sep = "";
+    RK_S32 count;
+    RK_S32 i;
+    RK_S32 j;
+    FILE *fp;
+
+    if (NULL == p || NULL == path) {
+        mpp_err_f("invalid trace %p path %p\n", trace, path);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    records = mpp_malloc(MppFrameTraceRecord, p->size);
+    if (NULL == records) {
+        mpp_err_f("failed to malloc %d records\n", p->size);
+        return MPP_ERR_MALLOC;
+    }
+
+    fp = fopen(path, "w");
+    if (NULL == fp) {
+        mpp_err_f("failed to open %s\n", path);
+        mpp_free(records);
+        return MPP_ERR_OPEN_FILE;
+    }
+
+    count = trace_copy(p, records, p->size, NULL);
+    tag = tag ? tag : "mpp";
+
+    fprintf(fp, "{\"traceEvents\":[\n");
+
+    /* one lane per stage so overlapped frames in pipeline are readable */
+    for (i = MPP_TRACE_START; i < MPP_TRACE_STAGE_BUTT; i++) {
+        fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+                "\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                sep, i, trace_span_name[i]);
+        sep = ",\n";
+    }
+
+    for (i = 0; i < count; i++) {
+        MppFrameTraceRecord *rec = &records[i];
+        RK_S64 last = rec->stamp[MPP_TRACE_INPUT];
+
+        for (j = MPP_TRACE_START; j < MPP_TRACE_STAGE_BUTT; j++) {
+            RK_S64 curr = rec->stamp[j];
+
+            if (!curr)
+                continue;
+
+            if (last) {
+                fprintf(fp, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+                        "\"pid\":0,\"tid\":%d,\"ts\":%lld,\"dur\":%lld,"
+                        "\"args\":{\"seq\":%u,\"index\":%d,\"pts\":%lld}}",
+                        sep, trace_span_name[j], tag, j, last, curr - last,
+                        rec->seq, rec->index, rec->pts);
+            }
+            last = curr;
+        }
+    }
+
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+    mpp_free(records);
+
+    return MPP_OK;
+}
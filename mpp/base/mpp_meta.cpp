@@ -38,6 +38,7 @@ static MppMetaDef meta_defs[] = {
     {   KEY_OUTPUT_FRAME,       TYPE_FRAME,     },
     {   KEY_INPUT_PACKET,       TYPE_PACKET,    },
     {   KEY_OUTPUT_PACKET,      TYPE_PACKET,    },
+    {   KEY_INPUT_PACKETS,      TYPE_PTR,       },
     /* buffer for motion detection */
     {   KEY_MOTION_INFO,        TYPE_BUFFER,    },
     /* buffer storing the HDR information for current frame*/
@@ -0,0 +1,230 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#include "mpp_startcode.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define STARTCODE_NEON      1
+#elif defined(__SSE2__) && defined(__GNUC__)
+#include <immintrin.h>
+#define STARTCODE_SSE2      1
+/* avx2 is built with target attribute and selected at runtime */
+#define STARTCODE_AVX2      1
+#endif
+
+/*
+ * All locators search for 00 00 xx with (xx & mask) == last:
+ * start code 00 00 01, emulation prevention 00 00 03 and nal end 00 00 0x
+ * where x is 0 or 1.
+ */
+typedef RK_S32 (*FindStartCodeFunc)(const RK_U8 *buf, RK_S32 size, RK_U8 mask, RK_U8 last);
+
+static RK_S32 find_startcode_c(const RK_U8 *buf, RK_S32 start, RK_S32 size,
+                               RK_U8 mask, RK_U8 last)
+{
+    RK_S32 i;
+
+    /* the prefix must fit in the buffer */
+    for (i = start; i + 2 < size; i++) {
+        RK_U8 tail = buf[i + 2];
+
+        /*
+         * When buf[i + 2] is neither 0 nor a match none of i, i + 1 and
+         * i + 2 can be a prefix start, so skip three bytes at once.
+         */
+        if (tail && (tail & mask) != last) {
+            i += 2;
+            continue;
+        }
+        if (!buf[i] && !buf[i + 1] && (tail & mask) == last)
+            return i;
+    }
+
+    return -1;
+}
+
+static RK_S32 find_startcode_scalar(const RK_U8 *buf, RK_S32 size, RK_U8 mask, RK_U8 last)
+{
+    return find_startcode_c(buf, 0, size, mask, last);
+}
+
+#if defined(STARTCODE_NEON)
+static RK_S32 find_startcode_neon(const RK_U8 *buf, RK_S32 size, RK_U8 mask, RK_U8 last)
+{
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t bits = vdupq_n_u8(mask);
+    const uint8x16_t tail = vdupq_n_u8(last);
+    RK_S32 i = 0;
+
+    /* each block checks the prefix starting at i .. i + 15 */
+    for (; i + 18 <= size; i += 16) {
+        uint8x16_t a = vceqq_u8(vld1q_u8(buf + i), zero);
+        uint8x16_t b = vceqq_u8(vld1q_u8(buf + i + 1), zero);
+        uint8x16_t c = vceqq_u8(vandq_u8(vld1q_u8(buf + i + 2), bits), tail);
+        uint8x16_t m = vandq_u8(vandq_u8(a, b), c);
+#if defined(__aarch64__)
+        RK_U32 hit = vmaxvq_u8(m);
+#else
+        uint64x2_t m64 = vreinterpretq_u64_u8(m);
+        RK_U64 hit = vgetq_lane_u64(m64, 0) | vgetq_lane_u64(m64, 1);
+#endif
+
+        if (hit)
+            return find_startcode_c(buf, i, i + 18, mask, last);
+    }
+
+    return find_startcode_c(buf, i, size, mask, last);
+}
+#endif
+
+#if defined(STARTCODE_SSE2)
+static RK_S32 find_startcode_sse2(const RK_U8 *buf, RK_S32 size, RK_U8 mask, RK_U8 last)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bits = _mm_set1_epi8(mask);
+    const __m128i tail = _mm_set1_epi8(last);
+    RK_S32 i = 0;
+
+    for (; i + 18 <= size; i += 16) {
+        __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(buf + i)), zero);
+        __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(buf + i + 1)), zero);
+        __m128i c = _mm_cmpeq_epi8(_mm_and_si128(_mm_loadu_si128((const __m128i *)(buf + i + 2)), bits), tail);
+        RK_U32 hit = _mm_movemask_epi8(_mm_and_si128(_mm_and_si128(a, b), c));
+
+        if (hit)
+            return i + __builtin_ctz(hit);
+    }
+
+    return find_startcode_c(buf, i, size, mask, last);
+}
+#endif
+
+#if defined(STARTCODE_AVX2)
+__attribute__((target("avx2")))
+static RK_S32 find_startcode_avx2(const RK_U8 *buf, RK_S32 size, RK_U8 mask, RK_U8 last)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i bits = _mm256_set1_epi8(mask);
+    const __m256i tail = _mm256_set1_epi8(last);
+    RK_S32 i = 0;
+
+    for (; i + 34 <= size; i += 32) {
+        __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(buf + i)), zero);
+        __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(buf + i + 1)), zero);
+        __m256i c = _mm256_cmpeq_epi8(_mm256_and_si256(_mm256_loadu_si256((const __m256i *)(buf + i + 2)), bits), tail);
+        RK_U32 hit = (RK_U32)_mm256_movemask_epi8(_mm256_and_si256(_mm256_and_si256(a, b), c));
+
+        if (hit)
+            return i + __builtin_ctz(hit);
+    }
+
+    return find_startcode_c(buf, i, size, mask, last);
+}
+#endif
+
+static FindStartCodeFunc find_startcode_func = NULL;
+
+static FindStartCodeFunc find_startcode_select(void)
+{
+    FindStartCodeFunc func = find_startcode_scalar;
+
+#if defined(STARTCODE_NEON)
+    func = find_startcode_neon;
+#elif defined(STARTCODE_SSE2)
+    func = find_startcode_sse2;
+#if defined(STARTCODE_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        func = find_startcode_avx2;
+#endif
+#endif
+
+    return func;
+}
+
+RK_S32 mpp_find_startcode(const RK_U8 *buf, RK_S32 size)
+{
+    /* selection is idempotent so the race on first call is harmless */
+    if (!find_startcode_func)
+        find_startcode_func = find_startcode_select();
+
+    return find_startcode_func(buf, size, 0xff, 0x01);
+}
+
+RK_S32 mpp_find_emulation(const RK_U8 *buf, RK_S32 size)
+{
+    if (!find_startcode_func)
+        find_startcode_func = find_startcode_select();
+
+    return find_startcode_func(buf, size, 0xff, 0x03);
+}
+
+RK_S32 mpp_find_nal_end(const RK_U8 *buf, RK_S32 size)
+{
+    if (!find_startcode_func)
+        find_startcode_func = find_startcode_select();
+
+    return find_startcode_func(buf, size, 0xfe, 0x00);
+}
+
+static RK_U64 startcode_state_update(RK_U64 state, const RK_U8 *buf, RK_S32 size)
+{
+    /* only the last 8 bytes survive in a 64bit shift register */
+    RK_S32 i = size > 8 ? size - 8 : 0;
+
+    for (; i < size; i++)
+        state = (state << 8) | buf[i];
+
+    return state;
+}
+
+RK_S32 mpp_startcode_scan(RK_U64 *state, const RK_U8 *buf, RK_S32 size)
+{
+    RK_U64 s = *state;
+    RK_S32 end;
+    RK_S32 pos;
+    RK_S32 i;
+
+    /* prefix straddling previous data can only end in the first two bytes */
+    for (i = 0; i < size && i < 2; i++) {
+        s = (s << 8) | buf[i];
+        if ((s & 0xFFFFFF) == MPP_START_CODE_PREFIX) {
+            *state = s;
+            return i + 1;
+        }
+    }
+
+    if (i >= size) {
+        *state = s;
+        return i;
+    }
+
+    /* prefix inside buf ends at pos + 2 which is always beyond i - 1 */
+    pos = mpp_find_startcode(buf, size);
+    end = (pos < 0) ? size : pos + 3;
+
+    *state = startcode_state_update(s, buf + i, end - i);
+
+    return end;
+}
+
+RK_S32 mpp_startcode_scan_c(RK_U64 *state, const RK_U8 *buf, RK_S32 size)
+{
+    RK_U64 s = *state;
+    RK_S32 i;
+
+    for (i = 0; i < size; i++) {
+        s = (s << 8) | buf[i];
+        if ((s & 0xFFFFFF) == MPP_START_CODE_PREFIX) {
+            i++;
+            break;
+        }
+    }
+
+    *state = s;
+
+    return i;
+}
@@ -16,11 +16,15 @@
 
 #define MODULE_TAG "mpp_task_impl"
 
+#include <errno.h>
 #include <string.h>
 
 #include "mpp_env.h"
 #include "mpp_mem.h"
+#include "mpp_lock.h"
+#include "mpp_time.h"
 #include "mpp_debug.h"
+#include "mpp_eventfd.h"
 
 #include "mpp_task_impl.h"
 #include "mpp_meta_impl.h"
@@ -41,6 +45,19 @@ typedef struct MppTaskStatusInfo_t {
     RK_S32              count;
     MppTaskStatus       status;
     Condition           *cond;
+
+    /*
+     * spsc mode ring on input_port / output_port status
+     * tail is only written by the enqueue side and head by the dequeue side
+     * waiting is set by the dequeue side before blocking on eventfd
+     */
+    MppTaskImpl         **slots;
+    RK_U32              mask;
+    volatile RK_U32     head;
+    volatile RK_U32     tail;
+    volatile RK_S32     waiting;
+    volatile RK_S32     awake;
+    RK_S32              fd;
 } MppTaskStatusInfo;
 
 typedef struct MppTaskQueueImpl_t {
@@ -48,7 +65,8 @@ typedef struct MppTaskQueueImpl_t {
     void                *mpp;
     Mutex               *lock;
     RK_S32              task_count;
-    RK_S32              ready;          // flag for deinit
+    volatile RK_S32     ready;          // flag for deinit
+    RK_S32              spsc;
 
     // two ports inside of task queue
     MppPort             input;
@@ -100,6 +118,39 @@ MPP_RET check_mpp_task_name(MppTask task)
     return MPP_NOK;
 }
 
+static inline RK_S32 ring_count(MppTaskStatusInfo *info)
+{
+    RK_S32 count = (RK_S32)(info->tail - info->head);
+
+    MPP_SYNC();
+    return count;
+}
+
+static void ring_push(MppTaskStatusInfo *info, MppTaskImpl *task)
+{
+    info->slots[info->tail & info->mask] = task;
+    MPP_SYNC();
+    info->tail++;
+    /* pairs with the barrier after waiting is set in poll */
+    MPP_SYNC();
+
+    if (info->waiting)
+        mpp_eventfd_write(info->fd, 1);
+}
+
+static MppTaskImpl *ring_pop(MppTaskStatusInfo *info)
+{
+    MppTaskImpl *task = NULL;
+
+    if (ring_count(info)) {
+        task = info->slots[info->head & info->mask];
+        MPP_SYNC();
+        info->head++;
+    }
+
+    return task;
+}
+
 static MPP_RET mpp_port_init(MppTaskQueueImpl *queue, MppPortType type, MppPort *port)
 {
     MppPortImpl *impl = mpp_malloc(MppPortImpl, 1);
@@ -138,11 +189,77 @@ static MPP_RET mpp_port_deinit(MppPort port)
     return MPP_OK;
 }
 
+static MPP_RET mpp_port_poll_spsc(const char *caller, MppPortImpl *port_impl,
+                                  MppPollType timeout)
+{
+    MppTaskQueueImpl *queue = port_impl->queue;
+    MppTaskStatusInfo *curr = &queue->info[port_impl->status_curr];
+    RK_S32 count = ring_count(curr);
+    RK_S64 deadline = 0;
+    RK_S64 wait = timeout;
+    MPP_RET ret = MPP_NOK;
+
+    if (count || !timeout)
+        return count ? (MPP_RET)count : MPP_NOK;
+
+    mpp_task_dbg_flow("mpp %p %s from %s poll %s port timeout %d wait start\n",
+                      queue->mpp, queue->name, caller,
+                      port_type_str[port_impl->type], timeout);
+
+    if (timeout > 0)
+        deadline = mpp_time() + (RK_S64)timeout * 1000;
+
+    curr->waiting = 1;
+    MPP_SYNC();
+
+    while (1) {
+        count = ring_count(curr);
+        if (count) {
+            ret = (MPP_RET)count;
+            break;
+        }
+        if (!queue->ready)
+            break;
+        if (MPP_BOOL_CAS(&curr->awake, 1, 0)) {
+            ret = MPP_OK;
+            break;
+        }
+        /*
+         * stale wakeup from an earlier enqueue just goes round again and
+         * waits for the rest of the timeout only
+         */
+        if (deadline) {
+            wait = (deadline - mpp_time() + 999) / 1000;
+            if (wait <= 0)
+                break;
+        }
+        if (ETIMEDOUT == mpp_eventfd_read(curr->fd, NULL, wait))
+            break;
+    }
+
+    curr->waiting = 0;
+
+    mpp_task_dbg_flow("mpp %p %s from %s poll %s port timeout %d ret %d\n",
+                      queue->mpp, queue->name, caller,
+                      port_type_str[port_impl->type], timeout, ret);
+
+    return ret;
+}
+
 MPP_RET _mpp_port_poll(const char *caller, MppPort port, MppPollType timeout)
 {
     MppPortImpl *port_impl = (MppPortImpl *)port;
     MppTaskQueueImpl *queue = port_impl->queue;
 
+    if (queue->spsc) {
+        if (!queue->ready) {
+            mpp_err("try to query when %s queue is not ready\n",
+                    port_type_str[port_impl->type]);
+            return MPP_NOK;
+        }
+        return mpp_port_poll_spsc(caller, port_impl, timeout);
+    }
+
     AutoMutex auto_lock(queue->lock);
     MppTaskStatusInfo *curr = NULL;
     MPP_RET ret = MPP_NOK;
@@ -212,6 +329,22 @@ MPP_RET _mpp_port_move(const char *caller, MppPort port, MppTask task,
     MppTaskStatusInfo *curr = NULL;
     MppTaskStatusInfo *next = NULL;
 
+    if (queue->spsc) {
+        /* task can only leave a ring by dequeue so only hold -> port is valid */
+        if (!queue->ready || task_impl->status != port_impl->next_on_dequeue ||
+            (status != MPP_INPUT_PORT && status != MPP_OUTPUT_PORT)) {
+            mpp_err("%s can not move task %p %s -> %s in spsc mode\n", caller,
+                    task, task_status_str[task_impl->status],
+                    task_status_str[status]);
+            return MPP_NOK;
+        }
+
+        check_mpp_task_name(task);
+        task_impl->status = status;
+        ring_push(&queue->info[status], task_impl);
+        return MPP_OK;
+    }
+
     AutoMutex auto_lock(queue->lock);
     MPP_RET ret = MPP_NOK;
 
@@ -260,6 +393,28 @@ MPP_RET _mpp_port_dequeue(const char *caller, MppPort port, MppTask *task)
     MppTaskImpl *task_impl = NULL;
     MppTask p = NULL;
 
+    if (queue->spsc) {
+        *task = NULL;
+        if (!queue->ready) {
+            mpp_err("try to dequeue when %s queue is not ready\n",
+                    port_type_str[port_impl->type]);
+            return MPP_NOK;
+        }
+
+        task_impl = ring_pop(&queue->info[port_impl->status_curr]);
+        if (NULL == task_impl)
+            return MPP_NOK;
+
+        check_mpp_task_name((MppTask)task_impl);
+        task_impl->status = port_impl->next_on_dequeue;
+
+        mpp_task_dbg_flow("mpp %p %s from %s dequeue %s port task %p done\n",
+                          queue->mpp, queue->name, caller,
+                          port_type_str[port_impl->type], task_impl);
+        *task = (MppTask)task_impl;
+        return MPP_OK;
+    }
+
     AutoMutex auto_lock(queue->lock);
     MPP_RET ret = MPP_NOK;
 
@@ -319,6 +474,26 @@ MPP_RET _mpp_port_enqueue(const char *caller, MppPort port, MppTask task)
     MppTaskStatusInfo *curr = NULL;
     MppTaskStatusInfo *next = NULL;
 
+    if (queue->spsc) {
+        if (!queue->ready) {
+            mpp_err("try to enqueue when %s queue is not ready\n",
+                    port_type_str[port_impl->type]);
+            return MPP_NOK;
+        }
+
+        check_mpp_task_name(task);
+        mpp_assert(task_impl->queue  == (MppTaskQueue)queue);
+        mpp_assert(task_impl->status == port_impl->next_on_dequeue);
+
+        mpp_task_dbg_flow("mpp %p %s from %s enqueue %s port task %p done\n",
+                          queue->mpp, queue->name, caller,
+                          port_type_str[port_impl->type], task_impl);
+
+        task_impl->status = port_impl->next_on_enqueue;
+        ring_push(&queue->info[port_impl->next_on_enqueue], task_impl);
+        return MPP_OK;
+    }
+
     AutoMutex auto_lock(queue->lock);
     MPP_RET ret = MPP_NOK;
 
@@ -368,7 +543,14 @@ MPP_RET _mpp_port_awake(const char *caller, MppPort port)
     MppPortImpl *port_impl = (MppPortImpl *)port;
     MppTaskQueueImpl *queue = port_impl->queue;
     MppTaskStatusInfo *curr = NULL;
-    if (queue) {
+    if (queue && queue->spsc) {
+        curr = &queue->info[port_impl->status_curr];
+        /* like condition signal the awake is dropped when nobody waits */
+        if (curr->waiting) {
+            curr->awake = 1;
+            mpp_eventfd_write(curr->fd, 1);
+        }
+    } else if (queue) {
         AutoMutex auto_lock(queue->lock);
         curr = &queue->info[port_impl->status_curr];
         if (curr) {
@@ -420,6 +602,7 @@ MPP_RET mpp_task_queue_init(MppTaskQueue *queue, void *mpp, const char *name)
         p->info[i].count  = 0;
         p->info[i].status = (MppTaskStatus)i;
         p->info[i].cond = cond[i];
+        p->info[i].fd = -1;
     }
 
     lock = new Mutex();
@@ -462,6 +645,71 @@ RET:
     return ret;
 }
 
+static void mpp_task_queue_spsc_deinit(MppTaskQueueImpl *queue)
+{
+    RK_S32 i;
+
+    for (i = 0; i < MPP_TASK_STATUS_BUTT; i++) {
+        MppTaskStatusInfo *info = &queue->info[i];
+
+        MPP_FREE(info->slots);
+        if (info->fd >= 0) {
+            mpp_eventfd_put(info->fd);
+            info->fd = -1;
+        }
+    }
+}
+
+static MPP_RET mpp_task_queue_spsc_init(MppTaskQueueImpl *queue, RK_S32 task_count)
+{
+    MppTaskStatus status[2] = { MPP_INPUT_PORT, MPP_OUTPUT_PORT };
+    RK_U32 size = 1;
+    RK_S32 i;
+
+    /* all tasks fit in either ring so push never checks for full */
+    while (size < (RK_U32)task_count)
+        size <<= 1;
+
+    for (i = 0; i < 2; i++) {
+        MppTaskStatusInfo *info = &queue->info[status[i]];
+
+        info->slots = mpp_calloc(MppTaskImpl *, size);
+        info->fd = mpp_eventfd_get(0);
+        if (NULL == info->slots || info->fd < 0) {
+            mpp_err_f("%s failed to init spsc ring\n", queue->name);
+            info->fd = -1;
+            mpp_task_queue_spsc_deinit(queue);
+            return MPP_NOK;
+        }
+        info->mask = size - 1;
+        info->head = 0;
+        info->tail = 0;
+    }
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_task_queue_set_spsc(MppTaskQueue queue, RK_S32 enable)
+{
+    MppTaskQueueImpl *impl = (MppTaskQueueImpl *)queue;
+
+    if (NULL == impl) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    AutoMutex auto_lock(impl->lock);
+
+    // NOTE: mode can only be changed before setup
+    if (impl->tasks) {
+        mpp_err_f("%s queue is already setup\n", impl->name);
+        return MPP_NOK;
+    }
+
+    impl->spsc = enable ? 1 : 0;
+    return MPP_OK;
+}
+
 MPP_RET mpp_task_queue_setup(MppTaskQueue queue, RK_S32 task_count)
 {
     MppTaskQueueImpl *impl = (MppTaskQueueImpl *)queue;
@@ -476,6 +724,11 @@ MPP_RET mpp_task_queue_setup(MppTaskQueue queue, RK_S32 task_count)
         return MPP_ERR_MALLOC;
     }
 
+    if (impl->spsc && mpp_task_queue_spsc_init(impl, task_count)) {
+        mpp_free(tasks);
+        return MPP_NOK;
+    }
+
     impl->tasks = tasks;
     impl->task_count = task_count;
 
@@ -489,9 +742,16 @@ MPP_RET mpp_task_queue_setup(MppTaskQueue queue, RK_S32 task_count)
         tasks[i].status = MPP_INPUT_PORT;
         mpp_meta_get(&tasks[i].meta);
 
+        if (impl->spsc) {
+            info->slots[i] = &tasks[i];
+            info->tail++;
+            continue;
+        }
+
         list_add_tail(&tasks[i].list, &info->list);
         info->count++;
     }
+    MPP_SYNC();
     impl->ready = 1;
     return MPP_OK;
 }
@@ -507,8 +767,15 @@ MPP_RET mpp_task_queue_deinit(MppTaskQueue queue)
     p->lock->lock();
 
     p->ready = 0;
+    MPP_SYNC();
     p->info[MPP_INPUT_PORT].cond->signal();
     p->info[MPP_OUTPUT_PORT].cond->signal();
+    if (p->spsc) {
+        if (p->info[MPP_INPUT_PORT].waiting)
+            mpp_eventfd_write(p->info[MPP_INPUT_PORT].fd, 1);
+        if (p->info[MPP_OUTPUT_PORT].waiting)
+            mpp_eventfd_write(p->info[MPP_OUTPUT_PORT].fd, 1);
+    }
     if (p->tasks) {
         for (RK_S32 i = 0; i < p->task_count; i++) {
             MppMeta meta = p->tasks[i].meta;
@@ -524,6 +791,7 @@ MPP_RET mpp_task_queue_deinit(MppTaskQueue queue)
         }
         mpp_free(p->tasks);
     }
+    mpp_task_queue_spsc_deinit(p);
 
     if (p->input) {
         mpp_port_deinit(p->input);
@@ -20,11 +20,19 @@
 #include <string.h>
 
 #include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
 #include "mpp_common.h"
 #include "mpp_bitread.h"
+#include "mpp_bitwrite.h"
 
 #define BIT_READ_BUFFER_SIZE        (1024)
 
+#define SLICE_HDR_COUNT             (1024)
+#define SLICE_HDR_SIZE              (96)
+#define SLICE_DATA_SIZE             (32)
+#define SLICE_HDR_LOOP              (200)
+
 typedef enum BitOpsType_e {
     BIT_GET,
     BIT_GET_UE,
@@ -328,6 +336,177 @@ __NORMAL:
     return ret;
 }
 
+/* H.264 P slice header syntax used for the throughput benchmark */
+static BitOps slice_ops[] = {
+    {BIT_GET,       8,  0,      "nal_unit_header"},
+    {BIT_GET_UE,    0,  0,      "first_mb_in_slice"},
+    {BIT_GET_UE,    0,  0,      "slice_type"},
+    {BIT_GET_UE,    0,  0,      "pic_parameter_set_id"},
+    {BIT_GET,       8,  0,      "frame_num"},
+    {BIT_GET,       8,  0,      "pic_order_cnt_lsb"},
+    {BIT_GET,       1,  0,      "num_ref_idx_active_override_flag"},
+    {BIT_GET_UE,    0,  0,      "num_ref_idx_l0_active_minus1"},
+    {BIT_GET,       1,  0,      "ref_pic_list_modification_flag_l0"},
+    {BIT_GET,       1,  0,      "adaptive_ref_pic_marking_mode_flag"},
+    {BIT_GET_UE,    0,  0,      "cabac_init_idc"},
+    {BIT_GET_SE,    0,  0,      "slice_qp_delta"},
+    {BIT_GET_UE,    0,  0,      "disable_deblocking_filter_idc"},
+    {BIT_GET_SE,    0,  0,      "slice_alpha_c0_offset_div2"},
+    {BIT_GET_SE,    0,  0,      "slice_beta_offset_div2"},
+    {BIT_GET,       16, 0,      "slice_data"},
+    {BIT_GET,       16, 0,      "slice_data"},
+};
+
+static RK_S32 gen_slice_val(BitOps *ops)
+{
+    /* keep many zero elements so emulation prevention bytes show up */
+    if (rand() & 1)
+        return 0;
+
+    switch (ops->type) {
+    case BIT_GET :
+        return rand() & ((1 << ops->len) - 1);
+    case BIT_GET_UE :
+        return rand() & 0x3ff;
+    case BIT_GET_SE :
+        return (rand() & 0x3f) - 32;
+    default :
+        break;
+    }
+
+    return 0;
+}
+
+/* write slice headers and return the emulation prevention byte count */
+static RK_S32 gen_slice_hdrs(RK_U8 *buf, RK_S32 *vals, RK_S32 *lens)
+{
+    RK_S32 ops_cnt = MPP_ARRAY_ELEMS(slice_ops);
+    RK_S32 emul_cnt = 0;
+    RK_S32 i, j;
+
+    for (i = 0; i < SLICE_HDR_COUNT; i++) {
+        RK_S32 *val = vals + i * ops_cnt;
+        MppWriteCtx writer;
+
+        mpp_writer_init(&writer, buf + i * SLICE_HDR_SIZE, SLICE_HDR_SIZE);
+
+        for (j = 0; j < ops_cnt; j++) {
+            val[j] = gen_slice_val(&slice_ops[j]);
+
+            switch (slice_ops[j].type) {
+            case BIT_GET :
+                mpp_writer_put_bits(&writer, val[j], slice_ops[j].len);
+                break;
+            case BIT_GET_UE :
+                mpp_writer_put_ue(&writer, val[j]);
+                break;
+            case BIT_GET_SE :
+                mpp_writer_put_se(&writer, val[j]);
+                break;
+            default :
+                break;
+            }
+        }
+        /* the rest of slice data after header */
+        for (j = 0; j < SLICE_DATA_SIZE; j++)
+            mpp_writer_put_bits(&writer, (rand() & 3) ? 0 : rand() & 0xff, 8);
+
+        mpp_writer_trailing(&writer);
+        lens[i] = mpp_writer_bytes(&writer);
+        emul_cnt += writer.emul_cnt;
+    }
+
+    return emul_cnt;
+}
+
+static MPP_RET parse_slice_hdr(BitReadCtx_t *ctx, RK_S32 *vals)
+{
+    RK_S32 ops_cnt = MPP_ARRAY_ELEMS(slice_ops);
+    RK_S32 val = 0;
+    RK_S32 i;
+
+    for (i = 0; i < ops_cnt; i++) {
+        switch (slice_ops[i].type) {
+        case BIT_GET :
+            READ_BITS(ctx, slice_ops[i].len, &val);
+            break;
+        case BIT_GET_UE :
+            READ_UE(ctx, &val);
+            break;
+        case BIT_GET_SE :
+            READ_SE(ctx, &val);
+            break;
+        default :
+            break;
+        }
+
+        if (val != vals[i]) {
+            mpp_err("slice syntax %s expect %d but %d\n",
+                    slice_ops[i].syntax, vals[i], val);
+            return MPP_NOK;
+        }
+    }
+
+    return MPP_OK;
+__BITREAD_ERR:
+    mpp_err("slice syntax %s read failed\n", slice_ops[i].syntax);
+    return ctx->ret;
+}
+
+static MPP_RET bench_slice_hdr(void)
+{
+    RK_S32 ops_cnt = MPP_ARRAY_ELEMS(slice_ops);
+    RK_U8 *buf = mpp_calloc(RK_U8, SLICE_HDR_COUNT * SLICE_HDR_SIZE);
+    RK_S32 *vals = mpp_calloc(RK_S32, SLICE_HDR_COUNT * ops_cnt);
+    RK_S32 *lens = mpp_calloc(RK_S32, SLICE_HDR_COUNT);
+    MPP_RET ret = MPP_NOK;
+    RK_S64 bits = 0;
+    RK_S64 time;
+    RK_S32 emul_cnt;
+    RK_S32 loop;
+    RK_S32 i;
+
+    if (!buf || !vals || !lens) {
+        mpp_err("failed to alloc slice header buffer\n");
+        goto DONE;
+    }
+
+    srand(0x264);
+    emul_cnt = gen_slice_hdrs(buf, vals, lens);
+
+    time = mpp_time();
+    for (loop = 0; loop < SLICE_HDR_LOOP; loop++) {
+        for (i = 0; i < SLICE_HDR_COUNT; i++) {
+            BitReadCtx_t reader;
+
+            mpp_set_bitread_ctx(&reader, buf + i * SLICE_HDR_SIZE, lens[i]);
+            mpp_set_bitread_pseudo_code_type(&reader, PSEUDO_CODE_H264_H265);
+
+            if (parse_slice_hdr(&reader, vals + i * ops_cnt)) {
+                mpp_err("slice header %d parse failed\n", i);
+                goto DONE;
+            }
+
+            bits += mpp_get_bits_count(&reader);
+        }
+    }
+    time = mpp_time() - time;
+
+    mpp_log("parsed %d slice headers %d times with %d emulation prevention bytes\n",
+            SLICE_HDR_COUNT, SLICE_HDR_LOOP, emul_cnt);
+    mpp_log("slice header %lld ns each, %.2f Mbit/s\n",
+            time * 1000 / (SLICE_HDR_COUNT * SLICE_HDR_LOOP),
+            (float)bits / MPP_MAX(time, 1));
+    ret = MPP_OK;
+
+DONE:
+    MPP_FREE(buf);
+    MPP_FREE(vals);
+    MPP_FREE(lens);
+
+    return ret;
+}
+
 int main()
 {
     BitReadCtx_t reader;
@@ -381,6 +560,11 @@ int main()
 
         tmp = 0;
     }
+
+    mpp_log("Reading H264 slice headers for throughput...");
+    if (bench_slice_hdr())
+        goto __READ_FAILED;
+
     mpp_log("mpp bit read test end\n");
     return 0;
 __READ_FAILED:
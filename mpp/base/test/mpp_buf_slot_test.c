@@ -0,0 +1,215 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "mpp_buf_slot_test"
+
+#include <sched.h>
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_thread.h"
+#include "mpp_buf_slot.h"
+
+/* large dpb plus display queue slack like av1 / hevc */
+#define SLOT_TEST_COUNT         32
+#define SLOT_TEST_DPB_SIZE      16
+#define SLOT_TEST_FRAME_COUNT   200000
+#define SLOT_TEST_LOOKUP_COUNT  64
+#define SLOT_TEST_LOOKUP_LOOP   200000
+
+typedef struct BufSlotTestCtx_t {
+    MppBufSlots     slots;
+    RK_S32          frame_count;
+    RK_S32          slot_frame[SLOT_TEST_COUNT];
+    RK_S32          displayed;
+    RK_S32          error;
+} BufSlotTestCtx;
+
+static RK_S32 slot_get_frame(MppBufSlots slots)
+{
+    RK_S32 index = -1;
+
+    /* display thread releases slot asynchronously */
+    while (mpp_slots_get_unused_count(slots) <= 0)
+        sched_yield();
+
+    mpp_buf_slot_get_unused(slots, &index);
+
+    return index;
+}
+
+static void *slot_dec_thread(void *arg)
+{
+    BufSlotTestCtx *ctx = (BufSlotTestCtx *)arg;
+    MppBufSlots slots = ctx->slots;
+    RK_S32 refs[SLOT_TEST_DPB_SIZE];
+    RK_S32 ref_pos = 0;
+    RK_S32 ref_cnt = 0;
+    RK_S32 i;
+
+    for (i = 0; i < ctx->frame_count; i++) {
+        RK_S32 index = slot_get_frame(slots);
+
+        if (index < 0) {
+            ctx->error = 1;
+            break;
+        }
+
+        /* codec reference and hardware output as decoder parser / hal do */
+        mpp_buf_slot_set_flag(slots, index, SLOT_CODEC_USE);
+        mpp_buf_slot_set_flag(slots, index, SLOT_HAL_OUTPUT);
+        ctx->slot_frame[index] = i;
+        mpp_buf_slot_set_flag(slots, index, SLOT_QUEUE_USE);
+        mpp_buf_slot_enqueue(slots, index, QUEUE_DISPLAY);
+        mpp_buf_slot_clr_flag(slots, index, SLOT_HAL_OUTPUT);
+
+        if (ref_cnt == SLOT_TEST_DPB_SIZE) {
+            mpp_buf_slot_clr_flag(slots, refs[ref_pos], SLOT_CODEC_USE);
+            ref_cnt--;
+        }
+        refs[ref_pos] = index;
+        ref_pos = (ref_pos + 1) % SLOT_TEST_DPB_SIZE;
+        ref_cnt++;
+    }
+
+    /* flush dpb */
+    while (ref_cnt) {
+        mpp_buf_slot_clr_flag(slots, refs[ref_pos], SLOT_CODEC_USE);
+        ref_pos = (ref_pos + 1) % SLOT_TEST_DPB_SIZE;
+        ref_cnt--;
+    }
+
+    return NULL;
+}
+
+static void *slot_disp_thread(void *arg)
+{
+    BufSlotTestCtx *ctx = (BufSlotTestCtx *)arg;
+    MppBufSlots slots = ctx->slots;
+
+    while (ctx->displayed < ctx->frame_count && !ctx->error) {
+        RK_S32 index = -1;
+
+        if (mpp_buf_slot_dequeue(slots, &index, QUEUE_DISPLAY)) {
+            sched_yield();
+            continue;
+        }
+
+        /* display queue must keep decoding order */
+        if (ctx->slot_frame[index] != ctx->displayed) {
+            mpp_err("display frame %d but expect %d\n",
+                    ctx->slot_frame[index], ctx->displayed);
+            ctx->error = 1;
+        }
+
+        mpp_buf_slot_clr_flag(slots, index, SLOT_QUEUE_USE);
+        ctx->displayed++;
+    }
+
+    return NULL;
+}
+
+static MPP_RET slot_test_pipeline(void)
+{
+    BufSlotTestCtx ctx;
+    pthread_t dec;
+    pthread_t disp;
+    RK_S64 time;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.frame_count = SLOT_TEST_FRAME_COUNT;
+
+    if (mpp_buf_slot_init(&ctx.slots))
+        return MPP_NOK;
+
+    mpp_buf_slot_setup(ctx.slots, SLOT_TEST_COUNT);
+
+    time = mpp_time();
+    pthread_create(&dec, NULL, slot_dec_thread, &ctx);
+    pthread_create(&disp, NULL, slot_disp_thread, &ctx);
+    pthread_join(dec, NULL);
+    pthread_join(disp, NULL);
+    time = mpp_time() - time;
+
+    if (!ctx.error && mpp_slots_get_used_count(ctx.slots)) {
+        mpp_err("found %d slot leaked\n", mpp_slots_get_used_count(ctx.slots));
+        ctx.error = 1;
+    }
+
+    mpp_log("pipeline %d frames %d slots in %lld us %.2f us/frame\n",
+            ctx.displayed, SLOT_TEST_COUNT, time,
+            (float)time / MPP_MAX(ctx.displayed, 1));
+
+    mpp_buf_slot_deinit(ctx.slots);
+
+    return ctx.error ? MPP_NOK : MPP_OK;
+}
+
+/* worst case for lookup: only the last slot is free */
+static MPP_RET slot_test_lookup(void)
+{
+    MppBufSlots slots = NULL;
+    RK_S32 index = -1;
+    RK_S64 time;
+    RK_S32 i;
+
+    if (mpp_buf_slot_init(&slots))
+        return MPP_NOK;
+
+    mpp_buf_slot_setup(slots, SLOT_TEST_LOOKUP_COUNT);
+
+    for (i = 0; i < SLOT_TEST_LOOKUP_COUNT - 1; i++) {
+        mpp_buf_slot_get_unused(slots, &index);
+        mpp_buf_slot_set_flag(slots, index, SLOT_CODEC_USE);
+    }
+
+    time = mpp_time();
+    for (i = 0; i < SLOT_TEST_LOOKUP_LOOP; i++) {
+        mpp_buf_slot_get_unused(slots, &index);
+        if (index != SLOT_TEST_LOOKUP_COUNT - 1) {
+            mpp_err("get unused slot %d but expect %d\n", index,
+                    SLOT_TEST_LOOKUP_COUNT - 1);
+            return MPP_NOK;
+        }
+        mpp_buf_slot_set_flag(slots, index, SLOT_CODEC_READY);
+        mpp_buf_slot_set_flag(slots, index, SLOT_CODEC_USE);
+        mpp_buf_slot_clr_flag(slots, index, SLOT_CODEC_USE);
+    }
+    time = mpp_time() - time;
+
+    mpp_log("lookup %d slots get / release %d times in %lld us %.3f us/loop\n",
+            SLOT_TEST_LOOKUP_COUNT, SLOT_TEST_LOOKUP_LOOP, time,
+            (float)time / SLOT_TEST_LOOKUP_LOOP);
+
+    for (i = 0; i < SLOT_TEST_LOOKUP_COUNT - 1; i++) {
+        mpp_buf_slot_set_flag(slots, i, SLOT_CODEC_READY);
+        mpp_buf_slot_clr_flag(slots, i, SLOT_CODEC_USE);
+    }
+
+    mpp_buf_slot_deinit(slots);
+
+    return MPP_OK;
+}
+
+int main()
+{
+    MPP_RET ret;
+
+    mpp_log("mpp_buf_slot_test start\n");
+
+    /* disable slot operation history to measure slot itself */
+    mpp_env_set_u32("buf_slot_debug", 0);
+
+    ret = slot_test_lookup();
+    if (!ret)
+        ret = slot_test_pipeline();
+
+    mpp_log("mpp_buf_slot_test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -26,6 +26,7 @@
 #include "mpp_common.h"
 #include "mpp_buffer.h"
 #include "mpp_allocator.h"
+#include "mpp_buffer_impl.h"
 
 #define MPP_BUFFER_TEST_DEBUG_FLAG      (0xf)
 #define MPP_BUFFER_TEST_SIZE            (SZ_1K*4)
@@ -239,6 +240,63 @@ int main()
         group = NULL;
     }
 
+    mpp_log("mpp_buffer_test best fit mode start\n");
+
+    ret = mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_NORMAL);
+    if (MPP_OK != ret) {
+        mpp_err("mpp_buffer_test mpp_buffer_group_get failed\n");
+        goto MPP_BUFFER_failed;
+    }
+
+    /* mixed size buffers: 4K 64K 16K 1M */
+    {
+        size_t sizes[4] = { SZ_4K, SZ_64K, SZ_16K, SZ_1M };
+        void *ptrs[4];
+        MppBufferGroupImpl *impl = (MppBufferGroupImpl *)group;
+
+        for (i = 0; i < 4; i++) {
+            ret = mpp_buffer_get(group, &normal_buffer[i], sizes[i]);
+            if (MPP_OK != ret) {
+                mpp_err("mpp_buffer_test mpp_buffer_get best fit failed\n");
+                goto MPP_BUFFER_failed;
+            }
+            ptrs[i] = mpp_buffer_get_ptr(normal_buffer[i]);
+        }
+
+        for (i = 0; i < 4; i++) {
+            mpp_buffer_put(normal_buffer[i]);
+            normal_buffer[i] = NULL;
+        }
+
+        /* 12K should take the 16K buffer and 40K the 64K one */
+        mpp_buffer_get(group, &normal_buffer[0], SZ_4K * 3);
+        mpp_buffer_get(group, &normal_buffer[1], SZ_1K * 40);
+        /* smaller buffer must be kept for small request */
+        mpp_buffer_get(group, &normal_buffer[2], SZ_1K);
+
+        if (mpp_buffer_get_ptr(normal_buffer[0]) != ptrs[2] ||
+            mpp_buffer_get_ptr(normal_buffer[1]) != ptrs[1] ||
+            mpp_buffer_get_ptr(normal_buffer[2]) != ptrs[0] ||
+            impl->hit_count != 3 || impl->evict_count) {
+            mpp_err("mpp_buffer_test best fit mismatch hit %d evict %d\n",
+                    impl->hit_count, impl->evict_count);
+            ret = MPP_NOK;
+            goto MPP_BUFFER_failed;
+        }
+
+        for (i = 0; i < 3; i++) {
+            mpp_buffer_put(normal_buffer[i]);
+            normal_buffer[i] = NULL;
+        }
+
+        mpp_buffer_group_dump(impl, __FUNCTION__);
+    }
+
+    mpp_buffer_group_put(group);
+    group = NULL;
+
+    mpp_log("mpp_buffer_test best fit mode success\n");
+
     mpp_log("mpp_buffer_test success\n");
 
     ret = mpp_buffer_get(NULL, &legacy_buffer, MPP_BUFFER_TEST_SIZE);
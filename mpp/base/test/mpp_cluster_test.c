@@ -16,12 +16,40 @@
 
 #define MODULE_TAG "mpp_cluster_test"
 
+#include <string.h>
+#include <dirent.h>
+#include <pthread.h>
+
+#include "mpp_mem.h"
 #include "mpp_log.h"
+#include "mpp_lock.h"
 #include "mpp_time.h"
 #include "mpp_common.h"
 
 #include "mpp_cluster.h"
 
+/* jobs per session and the table shared by all sessions like parser tables */
+#define BENCH_JOB_COUNT         256
+#define BENCH_JOB_LOOP          4096
+#define BENCH_TABLE_SIZE        (64 * 1024)
+
+typedef struct ClusterBenchSession_t {
+    MppNode         node;
+    pthread_t       thd;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    RK_S32          quit;
+    RK_S32          pending;
+    RK_S32          done;
+
+    /* jobs of one session must not run at the same time */
+    RK_S32          running;
+    RK_S32          overlap;
+    RK_U32          sum;
+} ClusterBenchSession;
+
+static RK_U8 bench_table[BENCH_TABLE_SIZE];
+
 typedef struct MppTestNode_t {
     MppNode         node;
 } MppTestNode;
@@ -39,6 +67,201 @@ static RK_S32 mpp_cluster_test_worker(void *param)
     return ret;
 }
 
+static RK_S32 bench_thread_count(void)
+{
+    RK_S32 count = 0;
+#if defined(__linux__)
+    DIR *dir = opendir("/proc/self/task");
+    struct dirent *ent;
+
+    if (NULL == dir)
+        return 0;
+
+    while ((ent = readdir(dir)) != NULL) {
+        if (ent->d_name[0] != '.')
+            count++;
+    }
+
+    closedir(dir);
+#endif
+    return count;
+}
+
+static void bench_job(ClusterBenchSession *s)
+{
+    RK_U32 sum = s->sum;
+    RK_S32 i;
+
+    if (MPP_FETCH_ADD(&s->running, 1))
+        s->overlap++;
+
+    for (i = 0; i < BENCH_JOB_LOOP; i++)
+        sum = sum * 31 + bench_table[(sum ^ i) & (BENCH_TABLE_SIZE - 1)];
+
+    s->sum = sum;
+    MPP_FETCH_SUB(&s->running, 1);
+}
+
+/* take one job and return remaining job count, -1 for no job */
+static RK_S32 bench_get_job(ClusterBenchSession *s, RK_S32 block)
+{
+    RK_S32 left = -1;
+
+    pthread_mutex_lock(&s->lock);
+    while (block && !s->pending && !s->quit)
+        pthread_cond_wait(&s->cond, &s->lock);
+
+    if (s->pending)
+        left = --s->pending;
+    pthread_mutex_unlock(&s->lock);
+
+    return left;
+}
+
+static void bench_put_job(ClusterBenchSession *s)
+{
+    pthread_mutex_lock(&s->lock);
+    s->done++;
+    pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+}
+
+static MPP_RET bench_node_proc(void *param)
+{
+    ClusterBenchSession *s = (ClusterBenchSession *)param;
+    RK_S32 left = bench_get_job(s, 0);
+
+    if (left < 0)
+        return MPP_OK;
+
+    bench_job(s);
+    bench_put_job(s);
+
+    /* one job per run and queue again behind other sessions */
+    if (left)
+        mpp_node_trigger(s->node, 1);
+
+    return MPP_OK;
+}
+
+static void *bench_session_thread(void *param)
+{
+    ClusterBenchSession *s = (ClusterBenchSession *)param;
+
+    while (bench_get_job(s, 1) >= 0) {
+        bench_job(s);
+        bench_put_job(s);
+    }
+
+    return NULL;
+}
+
+/* run the same serialized jobs on cpu cluster or on one thread per session */
+static MPP_RET bench_run(RK_S32 count, RK_S32 use_cluster)
+{
+    ClusterBenchSession *sessions = mpp_calloc(ClusterBenchSession, count);
+    MPP_RET ret = MPP_OK;
+    RK_S32 threads = 0;
+    RK_S64 time;
+    RK_S32 i, j;
+
+    if (NULL == sessions)
+        return MPP_ERR_MALLOC;
+
+    for (i = 0; i < count; i++) {
+        ClusterBenchSession *s = &sessions[i];
+
+        pthread_mutex_init(&s->lock, NULL);
+        pthread_cond_init(&s->cond, NULL);
+        s->sum = i;
+
+        if (use_cluster) {
+            mpp_node_init(&s->node);
+            mpp_node_set_func(s->node, bench_node_proc, s);
+            mpp_node_attach(s->node, MPP_CLUSTER_CPU);
+        } else {
+            pthread_create(&s->thd, NULL, bench_session_thread, s);
+        }
+    }
+
+    threads = bench_thread_count();
+    time = mpp_time();
+
+    for (j = 0; j < BENCH_JOB_COUNT; j++) {
+        for (i = 0; i < count; i++) {
+            ClusterBenchSession *s = &sessions[i];
+
+            pthread_mutex_lock(&s->lock);
+            s->pending++;
+            pthread_cond_signal(&s->cond);
+            pthread_mutex_unlock(&s->lock);
+
+            if (use_cluster)
+                mpp_node_trigger(s->node, 1);
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        ClusterBenchSession *s = &sessions[i];
+
+        pthread_mutex_lock(&s->lock);
+        while (s->done < BENCH_JOB_COUNT)
+            pthread_cond_wait(&s->cond, &s->lock);
+        pthread_mutex_unlock(&s->lock);
+    }
+
+    time = mpp_time() - time;
+
+    for (i = 0; i < count; i++) {
+        ClusterBenchSession *s = &sessions[i];
+
+        if (use_cluster) {
+            mpp_node_detach(s->node);
+            mpp_node_deinit(s->node);
+        } else {
+            pthread_mutex_lock(&s->lock);
+            s->quit = 1;
+            pthread_cond_signal(&s->cond);
+            pthread_mutex_unlock(&s->lock);
+            pthread_join(s->thd, NULL);
+        }
+
+        if (s->overlap || s->done != BENCH_JOB_COUNT) {
+            mpp_err("session %d overlap %d done %d\n", i, s->overlap, s->done);
+            ret = MPP_NOK;
+        }
+
+        pthread_cond_destroy(&s->cond);
+        pthread_mutex_destroy(&s->lock);
+    }
+
+    mpp_log("%-7s sessions %2d threads %3d time %7lld us %6.2f us/job\n",
+            use_cluster ? "cluster" : "thread", count, threads, time,
+            (float)time / (count * BENCH_JOB_COUNT));
+
+    mpp_free(sessions);
+
+    return ret;
+}
+
+static MPP_RET mpp_cluster_bench(void)
+{
+    RK_S32 counts[] = { 1, 16, 64 };
+    MPP_RET ret = MPP_OK;
+    RK_U32 i;
+
+    for (i = 0; i < BENCH_TABLE_SIZE; i++)
+        bench_table[i] = (RK_U8)(i * 2654435761u >> 24);
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(counts) && !ret; i++) {
+        ret = bench_run(counts[i], 0);
+        if (!ret)
+            ret = bench_run(counts[i], 1);
+    }
+
+    return ret;
+}
+
 int main()
 {
     MPP_RET ret = MPP_OK;
@@ -97,6 +320,14 @@ int main()
 
     mpp_log("mpp_cluster_test deinit done\n");
 
+    mpp_log("mpp_cluster_test bench start\n");
+
+    ret = mpp_cluster_bench();
+    if (ret) {
+        mpp_err("mpp_cluster_bench failed ret %d\n", ret);
+        goto DONE;
+    }
+
 DONE:
     mpp_log("mpp_cluster_test done %s\n", ret ? "failed" : "success");
     return ret;
@@ -16,6 +16,8 @@
 
 #define MODULE_TAG "mpp_enc_cfg_test"
 
+#include <string.h>
+
 #include "mpp_log.h"
 #include "mpp_mem.h"
 #include "mpp_time.h"
@@ -24,6 +26,103 @@
 #include "rk_venc_cfg.h"
 #include "mpp_enc_cfg_impl.h"
 
+#define KV_LOOP_CNT     10000
+
+static const char *kv_names[] = {
+    "rc:mode",
+    "rc:bps_target",
+    "rc:bps_max",
+    "rc:bps_min",
+    "rc:fps_in_num",
+    "rc:fps_out_num",
+    "rc:gop",
+    "rc:qp_init",
+    "rc:qp_min",
+    "rc:qp_max",
+    "rc:qp_min_i",
+    "rc:qp_max_i",
+};
+
+#define KV_CNT          MPP_ARRAY_ELEMS(kv_names)
+
+static RK_S32 kv_value(RK_S32 loop, RK_S32 idx)
+{
+    /* change part of the values on each loop like a bitrate controller */
+    return (idx == 0) ? 1 : (idx < 4) ? 1000000 + (loop & 7) * 1000 :
+           (idx < 7) ? 30 : 20 + (loop & 3) + idx;
+}
+
+/* compare name based setter with key based batched setter */
+static MPP_RET test_cfg_kv(void)
+{
+    MppEncCfg cfg_name = NULL;
+    MppEncCfg cfg_kv = NULL;
+    MppEncCfgKv kv[KV_CNT];
+    RK_S64 time_name;
+    RK_S64 time_kv;
+    RK_S64 start;
+    MPP_RET ret = MPP_NOK;
+    RK_S32 i, j;
+
+    mpp_enc_cfg_init(&cfg_name);
+    mpp_enc_cfg_init(&cfg_kv);
+    if (NULL == cfg_name || NULL == cfg_kv)
+        goto DONE;
+
+    start = mpp_time();
+    for (i = 0; i < (RK_S32)KV_CNT; i++) {
+        if (mpp_enc_cfg_get_key(kv_names[i], &kv[i].key))
+            goto DONE;
+    }
+    mpp_log("get %d keys time %lld us\n", KV_CNT, mpp_time() - start);
+
+    start = mpp_time();
+    for (j = 0; j < KV_LOOP_CNT; j++) {
+        for (i = 0; i < (RK_S32)KV_CNT; i++)
+            mpp_enc_cfg_set_s32(cfg_name, kv_names[i], kv_value(j, i));
+    }
+    time_name = mpp_time() - start;
+
+    start = mpp_time();
+    for (j = 0; j < KV_LOOP_CNT; j++) {
+        for (i = 0; i < (RK_S32)KV_CNT; i++)
+            kv[i].val.s32 = kv_value(j, i);
+
+        mpp_enc_cfg_set_kv(cfg_kv, kv, KV_CNT);
+    }
+    time_kv = mpp_time() - start;
+
+    mpp_log("set %d cfg %d times by name %lld us by kv %lld us speed up %.2f\n",
+            KV_CNT, KV_LOOP_CNT, time_name, time_kv,
+            time_kv ? (double)time_name / time_kv : 0.0);
+
+    /* both setters give the same values and change flags */
+    if (memcmp(&((MppEncCfgImpl *)cfg_name)->cfg, &((MppEncCfgImpl *)cfg_kv)->cfg,
+               sizeof(MppEncCfgSet))) {
+        mpp_err("kv setter result mismatch with name setter\n");
+        goto DONE;
+    }
+
+    /* invalid key is rejected without partial update */
+    kv[KV_CNT - 1].key = NULL;
+    kv[0].val.s32 = 0;
+    if (MPP_OK == mpp_enc_cfg_set_kv(cfg_kv, kv, KV_CNT) ||
+        ((MppEncCfgImpl *)cfg_kv)->cfg.rc.rc_mode != 1) {
+        mpp_err("invalid kv is not rejected\n");
+        goto DONE;
+    }
+
+    ret = MPP_OK;
+
+DONE:
+    if (cfg_name)
+        mpp_enc_cfg_deinit(cfg_name);
+    if (cfg_kv)
+        mpp_enc_cfg_deinit(cfg_kv);
+
+    return ret;
+}
+
 int main()
 {
     MPP_RET ret = MPP_OK;
@@ -103,6 +202,12 @@ int main()
         goto DONE;
     }
 
+    ret = test_cfg_kv();
+    if (ret) {
+        mpp_err("test_cfg_kv failed\n");
+        goto DONE;
+    }
+
 DONE:
     mpp_log("mpp_enc_cfg_test done %s\n", ret ? "failed" : "success");
     return ret;
@@ -0,0 +1,197 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "mpp_startcode_test"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_startcode.h"
+
+#define STREAM_SIZE         (4 * 1024 * 1024)
+#define NALU_AVG_SIZE       (64 * 1024)
+#define BENCH_LOOP          (16)
+
+/* generate random stream with sparse start code like real slice data */
+static void gen_stream(RK_U8 *buf, RK_S32 size, RK_S32 nalu_size)
+{
+    RK_S32 i;
+
+    for (i = 0; i < size; i++) {
+        RK_U8 val = rand() & 0xff;
+
+        /* keep some zero runs to stress the prefix check */
+        if (!(rand() & 63))
+            val = 0;
+
+        buf[i] = val;
+    }
+
+    for (i = 0; i + 4 < size; i += rand() % nalu_size + 4) {
+        buf[i + 0] = 0;
+        buf[i + 1] = 0;
+        buf[i + 2] = 1;
+        buf[i + 3] = rand() & 0xff;
+    }
+}
+
+static RK_S32 check_scan(RK_U8 *buf, RK_S32 size)
+{
+    RK_U64 state_ref = -1;
+    RK_U64 state = -1;
+    RK_S32 pos_ref = 0;
+    RK_S32 pos = 0;
+    RK_S32 found = 0;
+
+    while (pos < size) {
+        /* random chunk length to cover prefix across packet boundary */
+        RK_S32 chunk = MPP_MIN(rand() % 4096 + 1, size - pos);
+        RK_S32 done = 0;
+
+        while (done < chunk) {
+            RK_S32 len_ref = mpp_startcode_scan_c(&state_ref, buf + pos_ref, chunk - done);
+            RK_S32 len = mpp_startcode_scan(&state, buf + pos, chunk - done);
+
+            if (len != len_ref || state != state_ref) {
+                mpp_err("mismatch at %d len %d vs %d state %llx vs %llx\n",
+                        pos, len, len_ref, state, state_ref);
+                return -1;
+            }
+
+            if ((state & 0xFFFFFF) == MPP_START_CODE_PREFIX)
+                found++;
+
+            pos += len;
+            pos_ref += len_ref;
+            done += len;
+        }
+    }
+
+    mpp_log("scan check pass, %d start code found in %d bytes\n", found, size);
+
+    return 0;
+}
+
+/* reference for mpp_find_emulation and mpp_find_nal_end */
+static RK_S32 find_seq_ref(const RK_U8 *buf, RK_S32 size, RK_U8 mask, RK_U8 last)
+{
+    RK_S32 i;
+
+    for (i = 0; i + 2 < size; i++) {
+        if (!buf[i] && !buf[i + 1] && (buf[i + 2] & mask) == last)
+            return i;
+    }
+
+    return -1;
+}
+
+static RK_S32 check_find(RK_U8 *buf, RK_S32 size)
+{
+    RK_S32 loop;
+
+    for (loop = 0; loop < 4096; loop++) {
+        RK_S32 pos = rand() % size;
+        RK_S32 len = MPP_MIN(rand() % 1024, size - pos);
+        RK_S32 ref_epb = find_seq_ref(buf + pos, len, 0xff, 0x03);
+        RK_S32 ref_end = find_seq_ref(buf + pos, len, 0xfe, 0x00);
+        RK_S32 epb = mpp_find_emulation(buf + pos, len);
+        RK_S32 end = mpp_find_nal_end(buf + pos, len);
+
+        if (epb != ref_epb || end != ref_end) {
+            mpp_err("find mismatch at %d len %d epb %d vs %d end %d vs %d\n",
+                    pos, len, epb, ref_epb, end, ref_end);
+            return -1;
+        }
+    }
+
+    mpp_log("find check pass\n");
+
+    return 0;
+}
+
+static RK_S64 bench_scan(RK_U8 *buf, RK_S32 size, RK_S32 use_simd, RK_S32 *count)
+{
+    RK_S64 start = mpp_time();
+    RK_S32 found = 0;
+    RK_S32 loop;
+
+    for (loop = 0; loop < BENCH_LOOP; loop++) {
+        RK_U64 state = -1;
+        RK_S32 pos = 0;
+
+        while (pos < size) {
+            if (use_simd)
+                pos += mpp_startcode_scan(&state, buf + pos, size - pos);
+            else
+                pos += mpp_startcode_scan_c(&state, buf + pos, size - pos);
+
+            if ((state & 0xFFFFFF) == MPP_START_CODE_PREFIX)
+                found++;
+        }
+    }
+
+    *count = found;
+
+    return mpp_time() - start;
+}
+
+int main()
+{
+    RK_U8 *buf = mpp_malloc(RK_U8, STREAM_SIZE);
+    RK_S64 time_c;
+    RK_S64 time_simd;
+    RK_S32 count_c = 0;
+    RK_S32 count_simd = 0;
+    RK_S32 ret = 0;
+
+    mpp_log("mpp startcode test start\n");
+
+    if (!buf) {
+        mpp_err("failed to alloc stream buffer\n");
+        return -1;
+    }
+
+    srand(0x1234);
+    gen_stream(buf, STREAM_SIZE, NALU_AVG_SIZE);
+
+    ret = check_scan(buf, STREAM_SIZE);
+    if (ret)
+        goto DONE;
+
+    /* dense start code stream like small slices / sps / pps */
+    gen_stream(buf, STREAM_SIZE, 64);
+    ret = check_scan(buf, STREAM_SIZE);
+    if (ret)
+        goto DONE;
+
+    ret = check_find(buf, STREAM_SIZE);
+    if (ret)
+        goto DONE;
+
+    gen_stream(buf, STREAM_SIZE, NALU_AVG_SIZE);
+    time_c = bench_scan(buf, STREAM_SIZE, 0, &count_c);
+    time_simd = bench_scan(buf, STREAM_SIZE, 1, &count_simd);
+
+    if (count_c != count_simd) {
+        mpp_err("start code count mismatch %d vs %d\n", count_c, count_simd);
+        ret = -1;
+        goto DONE;
+    }
+
+    mpp_log("byte loop : %6lld us %7.2f MB/s\n", time_c,
+            (float)STREAM_SIZE * BENCH_LOOP / MPP_MAX(time_c, 1));
+    mpp_log("locator   : %6lld us %7.2f MB/s\n", time_simd,
+            (float)STREAM_SIZE * BENCH_LOOP / MPP_MAX(time_simd, 1));
+
+DONE:
+    mpp_free(buf);
+    mpp_log("mpp startcode test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -6,9 +6,11 @@
 #include "mpp_task_impl.h"
 
 #define MAX_TASK_LOOP   10000
+#define PING_PONG_LOOP  20000
 
 static MppTaskQueue input  = NULL;
 static MppTaskQueue output = NULL;
+static MppTaskQueue pingpong = NULL;
 
 void *task_input(void *arg)
 {
@@ -191,7 +193,75 @@ void serial_task(void)
     }
 }
 
-int main()
+void *task_pong(void *arg)
+{
+    RK_S32 i;
+    MppTask task = NULL;
+    MPP_RET ret = MPP_OK;
+    MppPort port = mpp_task_queue_get_port(pingpong, MPP_PORT_OUTPUT);
+
+    for (i = 0; i < PING_PONG_LOOP; i++) {
+        ret = mpp_port_poll(port, MPP_POLL_BLOCK);
+        mpp_assert(ret >= 0);
+
+        ret = mpp_port_dequeue(port, &task);
+        mpp_assert(!ret);
+        mpp_assert(task);
+
+        ret = mpp_port_enqueue(port, task);
+        mpp_assert(!ret);
+    }
+
+    (void)arg;
+    return NULL;
+}
+
+/*
+ * One task bounces between user thread and worker thread so every round
+ * trip has two blocking poll and two wakeups like a low latency session.
+ */
+static RK_S64 ping_pong_test(RK_S32 spsc)
+{
+    RK_S32 i;
+    MppTask task = NULL;
+    MPP_RET ret = MPP_OK;
+    MppPort port;
+    pthread_t thread_pong;
+    RK_S64 time_start, time_end;
+
+    mpp_task_queue_init(&pingpong, NULL, "test_pingpong");
+    mpp_task_queue_set_spsc(pingpong, spsc);
+    mpp_task_queue_setup(pingpong, 1);
+    port = mpp_task_queue_get_port(pingpong, MPP_PORT_INPUT);
+
+    pthread_create(&thread_pong, NULL, task_pong, NULL);
+
+    time_start = mpp_time();
+    for (i = 0; i < PING_PONG_LOOP; i++) {
+        ret = mpp_port_poll(port, MPP_POLL_BLOCK);
+        mpp_assert(ret >= 0);
+
+        ret = mpp_port_dequeue(port, &task);
+        mpp_assert(!ret);
+        mpp_assert(task);
+
+        ret = mpp_port_enqueue(port, task);
+        mpp_assert(!ret);
+    }
+
+    pthread_join(thread_pong, NULL);
+    /* wait the last task back to measure complete round trips */
+    ret = mpp_port_poll(port, MPP_POLL_BLOCK);
+    mpp_assert(ret > 0);
+    time_end = mpp_time();
+
+    mpp_task_queue_deinit(pingpong);
+    pingpong = NULL;
+
+    return time_end - time_start;
+}
+
+static void queue_test(RK_S32 spsc)
 {
     RK_S64 time_start, time_end;
 
@@ -202,10 +272,12 @@ int main()
     pthread_attr_t attr;
     void *dummy;
 
-    mpp_log("mpp task test start\n");
+    mpp_log("mpp task queue test in %s mode\n", spsc ? "spsc" : "mutex");
 
     mpp_task_queue_init(&input, NULL, "test_input");
     mpp_task_queue_init(&output, NULL, "test_output");
+    mpp_task_queue_set_spsc(input, spsc);
+    mpp_task_queue_set_spsc(output, spsc);
     mpp_task_queue_setup(input, 4);
     mpp_task_queue_setup(output, 4);
 
@@ -244,6 +316,25 @@ int main()
 
     mpp_task_queue_deinit(input);
     mpp_task_queue_deinit(output);
+}
+
+int main()
+{
+    RK_S64 time_mutex;
+    RK_S64 time_spsc;
+
+    mpp_log("mpp task test start\n");
+
+    queue_test(0);
+    queue_test(1);
+
+    time_mutex = ping_pong_test(0);
+    time_spsc = ping_pong_test(1);
+
+    mpp_log("ping-pong mutex : %6lld ns per round trip\n",
+            time_mutex * 1000 / PING_PONG_LOOP);
+    mpp_log("ping-pong spsc  : %6lld ns per round trip\n",
+            time_spsc * 1000 / PING_PONG_LOOP);
 
     mpp_log("mpp task test done\n");
 
@@ -21,6 +21,7 @@
 
 #include "mpp_mem.h"
 #include "mpp_packet_impl.h"
+#include "mpp_startcode.h"
 #include "hal_dec_task.h"
 
 #include "avsd_api.h"
@@ -652,6 +653,23 @@ MPP_RET avsd_fill_parameters(AvsdCtx_t *p_dec, AvsdSyntax_t *syn)
 
     return MPP_OK;
 }
+/*
+ * copy src to dst until the end of the next 00 00 01 prefix and return the
+ * bytes consumed, p->state is updated like the byte-wise shift register
+ */
+static RK_U32 avsd_copy_to_prefix(AvsdCtx_t *p, RK_U8 *dst_buf, RK_U32 *dst_len,
+                                  RK_U8 *src, RK_U32 size)
+{
+    RK_U64 state = p->state;
+    RK_S32 len = mpp_startcode_scan(&state, src, (RK_S32)size);
+
+    memcpy(dst_buf + *dst_len, src, len);
+    *dst_len += len;
+    p->state = (RK_U32)state;
+
+    return len;
+}
+
 /*!
 ***********************************************************************
 * \brief
@@ -682,6 +700,11 @@ MPP_RET avsd_parser_split(AvsdCtx_t *p, MppPacket *dst, MppPacket *src)
             dst_len = 3;
         }
         while (src_pos < src_len) {
+            if ((p->state & 0x00FFFFFF) != 0x000001) {
+                src_pos += avsd_copy_to_prefix(p, dst_buf, &dst_len, src_buf + src_pos,
+                                               src_len - src_pos);
+                continue;
+            }
             p->state = (p->state << 8) | src_buf[src_pos];
             dst_buf[dst_len++] = src_buf[src_pos++];
             if (p->state == I_PICUTRE_START_CODE ||
@@ -696,8 +719,8 @@ MPP_RET avsd_parser_split(AvsdCtx_t *p, MppPacket *dst, MppPacket *src)
     // find the end of the vop
     if (p->vop_header_found) {
         while (src_pos < src_len) {
-            p->state = (p->state << 8) | src_buf[src_pos];
-            dst_buf[dst_len++] = src_buf[src_pos++];
+            src_pos += avsd_copy_to_prefix(p, dst_buf, &dst_len, src_buf + src_pos,
+                                           src_len - src_pos);
             if ((p->state & 0x00FFFFFF) == 0x000001) {
                 if (src_buf[src_pos] > (SLICE_MAX_START_CODE & 0xFF) &&
                     src_buf[src_pos] != (USER_DATA_CODE & 0xFF)) {
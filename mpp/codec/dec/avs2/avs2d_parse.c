@@ -22,6 +22,7 @@
 #include "mpp_mem.h"
 #include "mpp_log.h"
 #include "mpp_packet_impl.h"
+#include "mpp_startcode.h"
 #include "hal_task.h"
 
 #include "avs2d_api.h"
@@ -41,7 +42,8 @@
 /**
  * @brief Find start code 00 00 01 xx
  *
- * Search 01 first and check the previous 2 bytes and the following 1 bytes.
+ * Locate the 00 00 01 prefix with mpp_find_startcode and check the
+ * following 1 byte is still inside the buffer.
  * If it is start code, return the value of start code at U32 as 0x000001xx.
  *
  * @param buf_start the start of input buffer
@@ -51,31 +53,19 @@
  */
 static RK_U32 avs2_find_start_code(RK_U8 *buf_start, RK_U8* buf_end, RK_U8 **pos)
 {
-    RK_U8 *buf_ptr = NULL;
-    RK_U8 *ptr = buf_start;
-    RK_U32 remain_size = buf_end - buf_start + 1;
+    RK_S32 offset;
 
-    while (ptr < buf_end) {
-        buf_ptr = memchr(ptr, 0x01, remain_size);
+    if (buf_end <= buf_start)
+        return 0;
 
-        if (!buf_ptr) {
-            return 0;
-        }
-
-        //check the position of "01"
-        if ((buf_ptr < buf_end) && (buf_ptr - buf_start > 1) &&
-            (*(buf_ptr - 1) == 0) && (*(buf_ptr - 2) == 0)) {
-            //found 00 00 01 xx
-            *pos = buf_ptr + 1;
-            return (AVS2_START_CODE | *(buf_ptr + 1));
-        } else {
-            // keep search at remaining buffer
-            remain_size = remain_size - (buf_ptr - ptr + 1);
-            ptr = buf_ptr + 1;
-        }
-    }
+    // the prefix must end before buf_end so that xx is inside the buffer
+    offset = mpp_find_startcode(buf_start, (RK_S32)(buf_end - buf_start));
+    if (offset < 0)
+        return 0;
 
-    return 0;
+    //found 00 00 01 xx
+    *pos = buf_start + offset + 3;
+    return (AVS2_START_CODE | *(buf_start + offset + 3));
 }
 
 static MPP_RET avs2_add_nalu_header(Avs2dCtx_t *p_dec, RK_U32 header)
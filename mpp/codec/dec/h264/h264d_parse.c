@@ -22,6 +22,7 @@
 
 #include "mpp_mem.h"
 #include "mpp_packet_impl.h"
+#include "mpp_startcode.h"
 #include "hal_dec_task.h"
 
 #include "h264d_global.h"
@@ -148,6 +149,41 @@ static void find_prefix_code(RK_U8 *p_data, H264dCurStream_t *p_strm)
     }
 }
 
+/*!
+***********************************************************************
+* \brief
+*    consume input until the next start code prefix in one pass
+*    equal to the byte-wise prefixdata loop but without per byte copy
+***********************************************************************
+*/
+static MPP_RET scan_nalu_data(H264dInputCtx_t *p_Inp, H264dCurStream_t *p_strm,
+                              MppPacketImpl *pkt_impl)
+{
+    MPP_RET ret = MPP_ERR_UNKNOW;
+    RK_U8 *src = &p_Inp->in_buf[p_strm->nalu_offset];
+    RK_U64 state = p_strm->prefixdata;
+    RK_S32 len = mpp_startcode_scan(&state, src, (RK_S32)pkt_impl->length);
+
+    if (p_strm->startcode_found) {
+        if (p_strm->nalu_len + len >= p_strm->nalu_max_size) {
+            RK_U32 add_size = p_strm->nalu_len + len + 1 - p_strm->nalu_max_size;
+
+            FUN_CHECK(ret = realloc_buffer(&p_strm->nalu_buf, &p_strm->nalu_max_size,
+                                           MPP_MAX(NALU_BUF_ADD_SIZE, add_size)));
+        }
+        memcpy(&p_strm->nalu_buf[p_strm->nalu_len], src, len);
+        p_strm->nalu_len += len;
+    }
+    p_strm->curdata = src + len - 1;
+    p_strm->nalu_offset += len;
+    p_strm->prefixdata = (RK_U32)state;
+    pkt_impl->length -= len;
+
+    return ret = MPP_OK;
+__FAILED:
+    return ret;
+}
+
 static MPP_RET parser_nalu_header(H264_SLICE_t *currSlice)
 {
     MPP_RET ret = MPP_ERR_UNKNOW;
@@ -671,10 +707,12 @@ MPP_RET parse_prepare(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
     }
 
     while (pkt_impl->length > 0) {
-        p_strm->curdata = &p_Inp->in_buf[p_strm->nalu_offset++];
-        pkt_impl->length--;
-        p_strm->prefixdata = (p_strm->prefixdata << 8) | (*p_strm->curdata);
-        if (p_strm->startcode_found) {
+        if (!p_strm->startcode_found || p_strm->nalu_len >= NALU_TYPE_EXT_LENGTH) {
+            FUN_CHECK(ret = scan_nalu_data(p_Inp, p_strm, pkt_impl));
+        } else {
+            p_strm->curdata = &p_Inp->in_buf[p_strm->nalu_offset++];
+            pkt_impl->length--;
+            p_strm->prefixdata = (p_strm->prefixdata << 8) | (*p_strm->curdata);
             if (p_strm->nalu_len >= p_strm->nalu_max_size) {
                 FUN_CHECK(ret = realloc_buffer(&p_strm->nalu_buf, &p_strm->nalu_max_size, NALU_BUF_ADD_SIZE));
             }
@@ -753,15 +791,17 @@ MPP_RET parse_prepare_fast(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
     p_Inp->task_valid = 0;
 
     while (pkt_impl->length > 0) {
-        p_strm->curdata = &p_Inp->in_buf[p_strm->nalu_offset++];
-        pkt_impl->length--;
-        p_strm->prefixdata = (p_strm->prefixdata << 8) | (*p_strm->curdata);
-        if (p_strm->startcode_found) {
+        if (!p_strm->startcode_found || p_strm->nalu_len >= NALU_TYPE_NORMAL_LENGTH) {
+            FUN_CHECK(ret = scan_nalu_data(p_Inp, p_strm, pkt_impl));
+        } else {
+            p_strm->curdata = &p_Inp->in_buf[p_strm->nalu_offset++];
+            pkt_impl->length--;
+            p_strm->prefixdata = (p_strm->prefixdata << 8) | (*p_strm->curdata);
             if (p_strm->nalu_len >= p_strm->nalu_max_size) {
                 FUN_CHECK(ret = realloc_buffer(&p_strm->nalu_buf, &p_strm->nalu_max_size, NALU_BUF_ADD_SIZE));
             }
             p_strm->nalu_buf[p_strm->nalu_len++] = *p_strm->curdata;
-            if (p_strm->nalu_len == 1) {
+            if (p_strm->nalu_len == NALU_TYPE_NORMAL_LENGTH) {
                 p_strm->nalu_type = p_strm->nalu_buf[0] & 0x1F;
 
                 if (p_strm->nalu_type == H264_NALU_TYPE_SLICE
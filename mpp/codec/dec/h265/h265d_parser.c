@@ -30,6 +30,7 @@
 #include "mpp_env.h"
 #include "mpp_mem.h"
 #include "mpp_bitread.h"
+#include "mpp_startcode.h"
 #include "mpp_packet_impl.h"
 #include "rk_hdr_meta_com.h"
 
@@ -56,8 +57,21 @@ static RK_S32 hevc_find_frame_end(SplitContext_t *sc, const RK_U8 *buf,
     RK_S32 i;
 
     for (i = 0; i < buf_size; i++) {
+        RK_U64 state = sc->state64;
         int nut, layer_id;
 
+        /*
+         * The decision below is made on the byte right after the two byte
+         * nal header. When no prefix is pending in the last three bytes jump
+         * to the end of the next start code prefix directly.
+         */
+        if ((state & 0xFFFFFF) != START_CODE &&
+            ((state >> 8) & 0xFFFFFF) != START_CODE &&
+            ((state >> 16) & 0xFFFFFF) != START_CODE) {
+            i += mpp_startcode_scan(&sc->state64, buf + i, buf_size - i) - 1;
+            continue;
+        }
+
         sc->state64 = (sc->state64 << 8) | buf[i];
 
         if (((sc->state64 >> 3 * 8) & 0xFFFFFF) != START_CODE)
@@ -1504,60 +1518,30 @@ fail:
 }
 
 
-typedef union {
-    RK_U32  u32;
-    RK_U16  u16[2];
-    RK_U8   u8 [4];
-    float   f32;
-} mpp_alias32;
-
-#define MPP_FAST_UNALIGNED 1
-
-
-#ifndef MPP_RN32A
-#define MPP_RN32A(p) (((const mpp_alias32*)(p))->u32)
-#endif
+/*
+ * Find the nal end and keep the nal data for the parser.
+ *
+ * Slice nal is left in place. h265d_syntax_fill_slice copies it into the
+ * hardware stream buffer anyway and points nal->data to that copy, so the
+ * slice header is parsed from there and the slice payload is never copied
+ * for software. Other nal units are small and copied to rbsp_buffer as the
+ * input buffer may be gone when they are parsed.
+ */
 RK_S32 mpp_hevc_extract_rbsp(HEVCContext *s, const RK_U8 *src, int length,
                              HEVCNAL *nal)
 {
-    RK_S32 i;
+    RK_S32 end = mpp_find_nal_end(src, length);
 
     s->skipped_bytes = 0;
 
-#define STARTCODE_TEST                                              \
-    if (i + 2 < length && src[i + 1] == 0 && src[i + 2] < 2) {      \
-            /* startcode, so we must be past the end */             \
-        length = i;                                                 \
-        break;                                                      \
-    }
-
-#if MPP_FAST_UNALIGNED
-#define FIND_FIRST_ZERO                                             \
-    if (i > 0 && !src[i])                                           \
-        i--;                                                        \
-    while (src[i])                                                  \
-        i++
-
-    for (i = 0; i + 1 < length; i += 5) {
-        if (!((~MPP_RN32A(src + i) &
-               (MPP_RN32A(src + i) - 0x01000101U)) &
-              0x80008080U))
-            continue;
-
-        FIND_FIRST_ZERO;
+    if (end >= 0)
+        length = end;
 
-        STARTCODE_TEST;
-        i -= 3;
+    if (length > 0 && ((src[0] >> 1) & 0x3f) < NAL_VPS) {
+        nal->data = src;
+        nal->size = length;
+        return length;
     }
-#else
-    for (i = 0; i + 1 < length; i += 2) {
-        if (src[i])
-            continue;
-        if (i > 0 && src[i - 1] == 0)
-            i--;
-        STARTCODE_TEST;
-    }
-#endif
 
     if (length + MPP_INPUT_BUFFER_PADDING_SIZE > nal->rbsp_buffer_size) {
         RK_S32 min_size = length + MPP_INPUT_BUFFER_PADDING_SIZE;
@@ -358,6 +358,7 @@ RK_S32 h265d_syntax_fill_slice(void *ctx, RK_S32 input_index)
     RK_U8 *ptr = NULL;
     RK_U8 *current = NULL;
     RK_U32 size = 0, length = 0;
+    RK_S32 saved = 0;
     // mpp_err("input_index = %d",input_index);
     if (-1 != input_index) {
         mpp_buf_slot_get_prop(h->packet_slots, input_index, SLOT_BUFFER, &streambuf);
@@ -424,10 +425,18 @@ RK_S32 h265d_syntax_fill_slice(void *ctx, RK_S32 input_index)
         // mpp_log("h->nals[%d].size = %d", i, h->nals[i].size);
         fill_slice_short(&ctx_pic->slice_short[count], position, h->nals[i].size);
         init_slice_cut_param(&ctx_pic->slice_cut_param[count]);
+        /*
+         * slice nal is left in input buffer by mpp_hevc_extract_rbsp so parse
+         * the slice header from this copy which lives until next prepare
+         */
+        h->nals[i].data = current;
+        saved += h->nals[i].size;
         current += h->nals[i].size;
         position += h->nals[i].size;
         count++;
     }
+    h265d_dbg(H265D_DBG_GLOBAL, "slice count %d rbsp copy saved %d bytes\n",
+              count, saved);
     ctx_pic->slice_count    = count;
     ctx_pic->bitstream_size = position;
     if (-1 != input_index) {
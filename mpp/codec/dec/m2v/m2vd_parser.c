@@ -22,6 +22,7 @@
 #include "mpp_env.h"
 #include "mpp_debug.h"
 #include "mpp_packet_impl.h"
+#include "mpp_startcode.h"
 
 #include "m2vd_parser.h"
 #include "m2vd_codec.h"
@@ -393,6 +394,23 @@ MPP_RET m2vd_parser_control(void *ctx, MpiCmd cmd_type, void *param)
     return ret;
 }
 
+/*
+ * copy src to dst until the end of the next 00 00 01 prefix and return the
+ * bytes consumed, p->state is updated like the byte-wise shift register
+ */
+static RK_U32 m2vd_copy_to_prefix(M2VDParserContext *p, RK_U8 *dst_buf, RK_U32 *dst_len,
+                                  RK_U8 *src, RK_U32 size)
+{
+    RK_U64 state = p->state;
+    RK_S32 len = mpp_startcode_scan(&state, src, (RK_S32)size);
+
+    memcpy(dst_buf + *dst_len, src, len);
+    *dst_len += len;
+    p->state = (RK_U32)state;
+
+    return len;
+}
+
 /*!
 ***********************************************************************
 * \brief
@@ -420,6 +438,12 @@ MPP_RET mpp_m2vd_parser_split(M2VDParserContext *ctx, MppPacket dst, MppPacket s
         }
 
         while (src_pos < src_len) {
+            if ((p->state & 0x00FFFFFF) != 0x000001) {
+                src_pos += m2vd_copy_to_prefix(p, dst_buf, &dst_len, src_buf + src_pos,
+                                               src_len - src_pos);
+                continue;
+            }
+
             p->state = (p->state << 8) | src_buf[src_pos];
             dst_buf[dst_len++] = src_buf[src_pos++];
 
@@ -438,8 +462,8 @@ MPP_RET mpp_m2vd_parser_split(M2VDParserContext *ctx, MppPacket dst, MppPacket s
 
     if (p->vop_header_found) {
         while (src_pos < src_len) {
-            p->state = (p->state << 8) | src_buf[src_pos];
-            dst_buf[dst_len++] = src_buf[src_pos++];
+            src_pos += m2vd_copy_to_prefix(p, dst_buf, &dst_len, src_buf + src_pos,
+                                           src_len - src_pos);
 
             if (((p->state & 0x00FFFFFF) == 0x000001) && (src_pos < src_len) &&
                 (src_buf[src_pos] == (SEQUENCE_HEADER_CODE & 0xFF) ||
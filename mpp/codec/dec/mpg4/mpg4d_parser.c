@@ -23,6 +23,7 @@
 #include "mpp_mem.h"
 #include "mpp_debug.h"
 #include "mpp_bitread.h"
+#include "mpp_startcode.h"
 
 #include "mpg4d_parser.h"
 #include "mpg4d_syntax.h"
@@ -1173,6 +1174,23 @@ MPP_RET mpp_mpg4_parser_reset(Mpg4dParser ctx)
     return MPP_OK;
 }
 
+/*
+ * copy src to dst until the end of the next 00 00 01 prefix and return the
+ * bytes consumed, p->state is updated like the byte-wise shift register
+ */
+static RK_U32 mpg4d_copy_to_prefix(Mpg4dParserImpl *p, RK_U8 *dst_buf, RK_U32 *dst_len,
+                                   RK_U8 *src, RK_U32 size)
+{
+    RK_U64 state = p->state;
+    RK_S32 len = mpp_startcode_scan(&state, src, (RK_S32)size);
+
+    memcpy(dst_buf + *dst_len, src, len);
+    *dst_len += len;
+    p->state = (RK_U32)state;
+
+    return len;
+}
+
 MPP_RET mpp_mpg4_parser_split(Mpg4dParser ctx, MppPacket dst, MppPacket src)
 {
     MPP_RET ret = MPP_NOK;
@@ -1198,25 +1216,28 @@ MPP_RET mpp_mpg4_parser_split(Mpg4dParser ctx, MppPacket dst, MppPacket src)
             dst_len = 3;
         }
         while (src_pos < src_len) {
-            p->state = (p->state << 8) | src_buf[src_pos];
-            dst_buf[dst_len++] = src_buf[src_pos++];
-            if (p->state == MPG4_VOP_STARTCODE) {
-                p->vop_header_found = 1;
-                mpp_packet_set_pts(dst, src_pts);
-                break;
+            // check the startcode byte after prefix
+            if ((p->state & 0x00FFFFFF) == 0x000001) {
+                p->state = (p->state << 8) | src_buf[src_pos];
+                dst_buf[dst_len++] = src_buf[src_pos++];
+                if (p->state == MPG4_VOP_STARTCODE) {
+                    p->vop_header_found = 1;
+                    mpp_packet_set_pts(dst, src_pts);
+                    break;
+                }
+                continue;
             }
+            src_pos += mpg4d_copy_to_prefix(p, dst_buf, &dst_len, src_buf + src_pos, src_len - src_pos);
         }
     }
     // find the end of the vop
     if (p->vop_header_found) {
-        while (src_pos < src_len) {
-            p->state = (p->state << 8) | src_buf[src_pos];
-            dst_buf[dst_len++] = src_buf[src_pos++];
+        if (src_pos < src_len) {
+            src_pos += mpg4d_copy_to_prefix(p, dst_buf, &dst_len, src_buf + src_pos, src_len - src_pos);
             if ((p->state & 0x00FFFFFF) == 0x000001) {
                 dst_len -= 3;
                 p->vop_header_found = 0;
                 ret = MPP_OK; // split complete
-                break;
             }
         }
     }
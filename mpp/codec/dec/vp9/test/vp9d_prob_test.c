@@ -0,0 +1,204 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "vp9d_prob_test"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "vp9d_prob.h"
+
+/* same size as the coefficient probabilities of one frame context */
+#define PROB_NUM            (4 * 2 * 2 * 6 * 6 * 3)
+#define BENCH_LOOP          (2000)
+
+typedef struct ProbCase_t {
+    RK_S32  max_count;
+    RK_S32  update_factor;
+} ProbCase;
+
+/* coefficient update with key frame and inter frame factor and mode update */
+static const ProbCase cases[] = {
+    { 24, 112 },
+    { 24, 128 },
+    { 20, 128 },
+};
+
+/* counts from small to huge to cover the 32-bit wrap of the reference */
+static RK_U32 gen_count(void)
+{
+    switch (rand() & 7) {
+    case 0 :
+        return 0;
+    case 1 :
+    case 2 :
+        return rand() % 32;
+    case 3 :
+    case 4 :
+        return rand() % 4096;
+    case 5 :
+        return rand() % (1 << 20);
+    case 6 :
+        return 0xffffffff - rand() % 4096;
+    default :
+        return ((RK_U32)rand() << 16) ^ rand();
+    }
+}
+
+static void gen_data(RK_U8 *prob, RK_U32 *ct0, RK_U32 *ct1, RK_S32 n)
+{
+    RK_S32 i;
+
+    for (i = 0; i < n; i++) {
+        prob[i] = rand() & 0xff;
+        ct0[i] = gen_count();
+        ct1[i] = gen_count();
+    }
+}
+
+static RK_S32 check_prob(const RK_U8 *prob, const RK_U32 *ct0, const RK_U32 *ct1,
+                         RK_S32 n, const ProbCase *c)
+{
+    RK_U8 ref[PROB_NUM];
+    RK_U8 out[PROB_NUM];
+    RK_S32 i;
+
+    memcpy(ref, prob, n);
+    memcpy(out, prob, n);
+
+    vp9d_adapt_prob_batch_ref(ref, ct0, ct1, n, c->max_count, c->update_factor);
+    vp9d_adapt_prob_batch(out, ct0, ct1, n, c->max_count, c->update_factor);
+
+    for (i = 0; i < n; i++) {
+        if (ref[i] != out[i]) {
+            mpp_err("mismatch at %d prob %d ct %u:%u max %d uf %d -> %d vs %d\n",
+                    i, prob[i], ct0[i], ct1[i], c->max_count,
+                    c->update_factor, out[i], ref[i]);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* all small counts and probs where the weight is below max_count */
+static RK_S32 check_small(const ProbCase *c)
+{
+    RK_U8 prob[PROB_NUM];
+    RK_U32 ct0[PROB_NUM];
+    RK_U32 ct1[PROB_NUM];
+    RK_S32 n = 0;
+    RK_S32 p, a, b;
+
+    for (p = 0; p < 256; p++) {
+        for (a = 0; a <= 32; a++) {
+            for (b = 0; b <= 32; b++) {
+                prob[n] = p;
+                ct0[n] = a;
+                ct1[n] = b;
+                if (++n < PROB_NUM)
+                    continue;
+
+                if (check_prob(prob, ct0, ct1, n, c))
+                    return -1;
+                n = 0;
+            }
+        }
+    }
+
+    return n ? check_prob(prob, ct0, ct1, n, c) : 0;
+}
+
+static RK_S32 check_random(const ProbCase *c)
+{
+    RK_U8 prob[PROB_NUM];
+    RK_U32 ct0[PROB_NUM];
+    RK_U32 ct1[PROB_NUM];
+    RK_S32 loop;
+
+    for (loop = 0; loop < 256; loop++) {
+        /* odd length leaves a tail for the scalar path */
+        RK_S32 n = PROB_NUM - rand() % 16;
+
+        gen_data(prob, ct0, ct1, n);
+        if (check_prob(prob, ct0, ct1, n, c))
+            return -1;
+    }
+
+    return 0;
+}
+
+static RK_S64 bench_prob(RK_U8 *prob, const RK_U32 *ct0, const RK_U32 *ct1,
+                         RK_S32 use_ref)
+{
+    RK_S64 start = mpp_time();
+    RK_S32 loop;
+
+    for (loop = 0; loop < BENCH_LOOP; loop++) {
+        if (use_ref)
+            vp9d_adapt_prob_batch_ref(prob, ct0, ct1, PROB_NUM, 24, 128);
+        else
+            vp9d_adapt_prob_batch(prob, ct0, ct1, PROB_NUM, 24, 128);
+    }
+
+    return mpp_time() - start;
+}
+
+int main()
+{
+    RK_U8 prob[PROB_NUM];
+    RK_U32 *ct0 = mpp_malloc(RK_U32, PROB_NUM);
+    RK_U32 *ct1 = mpp_malloc(RK_U32, PROB_NUM);
+    RK_S64 time_ref;
+    RK_S64 time_batch;
+    RK_S32 ret = 0;
+    RK_U32 i;
+
+    mpp_log("vp9d prob test start\n");
+
+    if (!ct0 || !ct1) {
+        mpp_err("failed to alloc count buffer\n");
+        ret = -1;
+        goto DONE;
+    }
+
+    srand(0x1234);
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(cases); i++) {
+        ret = check_small(&cases[i]);
+        if (!ret)
+            ret = check_random(&cases[i]);
+        if (ret)
+            goto DONE;
+    }
+
+    mpp_log("bit exact check pass\n");
+
+    /* typical hardware counts of one frame */
+    for (i = 0; i < PROB_NUM; i++) {
+        prob[i] = rand() & 0xff;
+        ct0[i] = rand() % 2048;
+        ct1[i] = rand() % 2048;
+    }
+
+    time_ref = bench_prob(prob, ct0, ct1, 1);
+    time_batch = bench_prob(prob, ct0, ct1, 0);
+
+    mpp_log("reference : %6lld us %6.2f us per frame\n", time_ref,
+            (float)time_ref / BENCH_LOOP);
+    mpp_log("batch     : %6lld us %6.2f us per frame\n", time_batch,
+            (float)time_batch / BENCH_LOOP);
+
+DONE:
+    MPP_FREE(ct0);
+    MPP_FREE(ct1);
+    mpp_log("vp9d prob test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -27,6 +27,7 @@
 #include "mpp_compat_impl.h"
 
 #include "vp9data.h"
+#include "vp9d_prob.h"
 #include "vp9d_codec.h"
 #include "vp9d_parser.h"
 #include "mpp_frame_impl.h"
@@ -55,48 +56,6 @@ static RK_S32 dec_num = 0;
 static RK_S32 count = 0;
 #endif
 
-#ifndef FASTDIV
-#   define FASTDIV(a,b) ((RK_U32)((((RK_U64)a) * vpx_inverse[b]) >> 32))
-#endif /* FASTDIV */
-
-/* a*inverse[b]>>32 == a/b for all 0<=a<=16909558 && 2<=b<=256
- * for a>16909558, is an overestimate by less than 1 part in 1<<24 */
-const RK_U32 vpx_inverse[257] = {
-    0, 4294967295U, 2147483648U, 1431655766, 1073741824,  858993460,  715827883,  613566757,
-    536870912,  477218589,  429496730,  390451573,  357913942,  330382100,  306783379,  286331154,
-    268435456,  252645136,  238609295,  226050911,  214748365,  204522253,  195225787,  186737709,
-    178956971,  171798692,  165191050,  159072863,  153391690,  148102321,  143165577,  138547333,
-    134217728,  130150525,  126322568,  122713352,  119304648,  116080198,  113025456,  110127367,
-    107374183,  104755300,  102261127,   99882961,   97612894,   95443718,   93368855,   91382283,
-    89478486,   87652394,   85899346,   84215046,   82595525,   81037119,   79536432,   78090315,
-    76695845,   75350304,   74051161,   72796056,   71582789,   70409300,   69273667,   68174085,
-    67108864,   66076420,   65075263,   64103990,   63161284,   62245903,   61356676,   60492498,
-    59652324,   58835169,   58040099,   57266231,   56512728,   55778797,   55063684,   54366675,
-    53687092,   53024288,   52377650,   51746594,   51130564,   50529028,   49941481,   49367441,
-    48806447,   48258060,   47721859,   47197443,   46684428,   46182445,   45691142,   45210183,
-    44739243,   44278014,   43826197,   43383509,   42949673,   42524429,   42107523,   41698712,
-    41297763,   40904451,   40518560,   40139882,   39768216,   39403370,   39045158,   38693400,
-    38347923,   38008561,   37675152,   37347542,   37025581,   36709123,   36398028,   36092163,
-    35791395,   35495598,   35204650,   34918434,   34636834,   34359739,   34087043,   33818641,
-    33554432,   33294321,   33038210,   32786010,   32537632,   32292988,   32051995,   31814573,
-    31580642,   31350127,   31122952,   30899046,   30678338,   30460761,   30246249,   30034737,
-    29826162,   29620465,   29417585,   29217465,   29020050,   28825284,   28633116,   28443493,
-    28256364,   28071682,   27889399,   27709467,   27531842,   27356480,   27183338,   27012373,
-    26843546,   26676816,   26512144,   26349493,   26188825,   26030105,   25873297,   25718368,
-    25565282,   25414008,   25264514,   25116768,   24970741,   24826401,   24683721,   24542671,
-    24403224,   24265352,   24129030,   23994231,   23860930,   23729102,   23598722,   23469767,
-    23342214,   23216040,   23091223,   22967740,   22845571,   22724695,   22605092,   22486740,
-    22369622,   22253717,   22139007,   22025474,   21913099,   21801865,   21691755,   21582751,
-    21474837,   21367997,   21262215,   21157475,   21053762,   20951060,   20849356,   20748635,
-    20648882,   20550083,   20452226,   20355296,   20259280,   20164166,   20069941,   19976593,
-    19884108,   19792477,   19701685,   19611723,   19522579,   19434242,   19346700,   19259944,
-    19173962,   19088744,   19004281,   18920561,   18837576,   18755316,   18673771,   18592933,
-    18512791,   18433337,   18354562,   18276457,   18199014,   18122225,   18046082,   17970575,
-    17895698,   17821442,   17747799,   17674763,   17602325,   17530479,   17459217,   17388532,
-    17318417,   17248865,   17179870,   17111424,   17043522,   16976156,   16909321,   16843010,
-    16777216
-};
-
 static void split_parse_frame(SplitContext_t *ctx, RK_U8 *buf, RK_S32 size)
 {
     VP9ParseContext *s = (VP9ParseContext *)ctx->priv_data;
@@ -367,6 +326,7 @@ MPP_RET vp9d_parser_init(Vp9CodecContext *vp9_ctx, ParserCfg *init)
     mpp_buf_slot_setup(s->slots, 25);
 
     mpp_env_get_u32("vp9d_debug", &vp9d_debug, 0);
+    mpp_env_get_u32("vp9d_prob_ref", &s->prob_ref, 0);
 
     return MPP_OK;
 }
@@ -1380,54 +1340,92 @@ static RK_S32 decode_parser_header(Vp9CodecContext *ctx,
     return (RK_S32)((data2 - data) + size2);
 }
 
-static void adapt_prob(RK_U8 *p, RK_U32 ct0, RK_U32 ct1,
-                       RK_S32 max_count, RK_S32 update_factor)
+/*
+ * Mode and mv probabilities are scattered in prob_context so they are
+ * gathered into a flat list, adapted in one batch and written back.
+ */
+#define VP9D_MODE_PROB_MAX  320
+#define VP9D_COEF_PROB_NUM  (4 * 2 * 2 * 6 * 6 * 3)
+
+typedef struct Vp9dProbList_t {
+    RK_U8   *dst[VP9D_MODE_PROB_MAX];
+    RK_U8   prob[VP9D_MODE_PROB_MAX];
+    RK_U32  ct0[VP9D_MODE_PROB_MAX];
+    RK_U32  ct1[VP9D_MODE_PROB_MAX];
+    RK_S32  count;
+} Vp9dProbList;
+
+static void adapt_prob(Vp9dProbList *list, RK_U8 *p, RK_U32 ct0, RK_U32 ct1)
 {
-    RK_U32 ct = ct0 + ct1, p2, p1;
+    RK_S32 i = list->count++;
 
-    if (!ct)
-        return;
+    mpp_assert(i < VP9D_MODE_PROB_MAX);
+    list->dst[i] = p;
+    list->prob[i] = *p;
+    list->ct0[i] = ct0;
+    list->ct1[i] = ct1;
+}
 
-    p1 = *p;
-    p2 = ((ct0 << 8) + (ct >> 1)) / ct;
-    p2 = mpp_clip(p2, 1, 255);
-    ct = MPP_MIN(ct, (RK_U32)max_count);
-    update_factor = FASTDIV(update_factor * ct, max_count);
+static void adapt_prob_batch(VP9Context *s, RK_U8 *p, const RK_U32 *ct0,
+                             const RK_U32 *ct1, RK_S32 n, RK_S32 max_count,
+                             RK_S32 update_factor)
+{
+    if (s->prob_ref)
+        vp9d_adapt_prob_batch_ref(p, ct0, ct1, n, max_count, update_factor);
+    else
+        vp9d_adapt_prob_batch(p, ct0, ct1, n, max_count, update_factor);
+}
+
+static void adapt_prob_flush(VP9Context *s, Vp9dProbList *list)
+{
+    RK_S32 i;
 
-    // (p1 * (256 - update_factor) + p2 * update_factor + 128) >> 8
-    *p = p1 + (((p2 - p1) * update_factor + 128) >> 8);
+    adapt_prob_batch(s, list->prob, list->ct0, list->ct1, list->count, 20, 128);
+
+    for (i = 0; i < list->count; i++)
+        *list->dst[i] = list->prob[i];
+
+    list->count = 0;
 }
 
 static void adapt_probs(VP9Context *s)
 {
-    RK_S32 i, j, k, l, m;
+    RK_S32 i, j, l, m;
     prob_context *p = &s->prob_ctx[s->framectxid].p;
     RK_S32 uf = (s->keyframe || s->intraonly || !s->last_keyframe) ? 112 : 128;
+    RK_U32 coef_ct0[VP9D_COEF_PROB_NUM];
+    RK_U32 coef_ct1[VP9D_COEF_PROB_NUM];
+    Vp9dProbList list;
 
-    // coefficients
-    for (i = 0; i < 4; i++)
-        for (j = 0; j < 2; j++)
-            for (k = 0; k < 2; k++)
-                for (l = 0; l < 6; l++)
-                    for (m = 0; m < 6; m++) {
-                        RK_U8 *pp = s->prob_ctx[s->framectxid].coef[i][j][k][l][m];
-                        RK_U32 *e = s->counts.eob[i][j][k][l][m];
-                        RK_U32 *c = s->counts.coef[i][j][k][l][m];
-
-                        if (l == 0 && m >= 3) // dc only has 3 pt
-                            break;
-                        /*  if(i == 0 && j == 0 && k== 1 && l == 0){
-                             mpp_log("e[0] = 0x%x e[1] = 0x%x c[0] = 0x%x c[1] = 0x%x c[2] = 0x%x \n",
-                             e[0],e[1],c[0],c[1],c[2]);
-                             mpp_log("pp[0] = 0x%x pp[1] = 0x%x pp[2] = 0x%x",pp[0],pp[1],pp[2]);
-                          }*/
-                        adapt_prob(&pp[0], e[0], e[1], 24, uf);
-                        adapt_prob(&pp[1], c[0], c[1] + c[2], 24, uf);
-                        adapt_prob(&pp[2], c[1], c[2], 24, uf);
-                        /* if(i == 0 && j == 0 && k== 1 && l == 0){
-                            mpp_log("after pp[0] = 0x%x pp[1] = 0x%x pp[2] = 0x%x",pp[0],pp[1],pp[2]);
-                         }*/
-                    }
+    list.count = 0;
+
+    // coefficients, 3 probs of each [i][j][k][l][m] are flat in coef
+    {
+        RK_U32 *e = s->counts.eob[0][0][0][0][0];
+        RK_U32 *c = s->counts.coef[0][0][0][0][0];
+
+        for (i = 0; i < VP9D_COEF_PROB_NUM; i += 3, e += 2, c += 3) {
+            l = (i / 18) % 6;
+            m = (i / 3) % 6;
+
+            // dc only has 3 pt, zero count keeps the prob
+            if (l == 0 && m >= 3) {
+                memset(&coef_ct0[i], 0, 3 * sizeof(coef_ct0[0]));
+                memset(&coef_ct1[i], 0, 3 * sizeof(coef_ct1[0]));
+                continue;
+            }
+
+            coef_ct0[i] = e[0];
+            coef_ct1[i] = e[1];
+            coef_ct0[i + 1] = c[0];
+            coef_ct1[i + 1] = c[1] + c[2];
+            coef_ct0[i + 2] = c[1];
+            coef_ct1[i + 2] = c[2];
+        }
+
+        adapt_prob_batch(s, s->prob_ctx[s->framectxid].coef[0][0][0][0][0],
+                         coef_ct0, coef_ct1, VP9D_COEF_PROB_NUM, 24, uf);
+    }
 #ifdef dump
     fwrite(&s->counts, 1, sizeof(s->counts), vp9_p_fp);
     fflush(vp9_p_fp);
@@ -1443,23 +1441,23 @@ static void adapt_probs(VP9Context *s)
 
     // skip flag
     for (i = 0; i < 3; i++)
-        adapt_prob(&p->skip[i], s->counts.skip[i][0], s->counts.skip[i][1], 20, 128);
+        adapt_prob(&list, &p->skip[i], s->counts.skip[i][0], s->counts.skip[i][1]);
 
     // intra/inter flag
     for (i = 0; i < 4; i++)
-        adapt_prob(&p->intra[i], s->counts.intra[i][0], s->counts.intra[i][1], 20, 128);
+        adapt_prob(&list, &p->intra[i], s->counts.intra[i][0], s->counts.intra[i][1]);
 
     // comppred flag
     if (s->comppredmode == PRED_SWITCHABLE) {
         for (i = 0; i < 5; i++)
-            adapt_prob(&p->comp[i], s->counts.comp[i][0], s->counts.comp[i][1], 20, 128);
+            adapt_prob(&list, &p->comp[i], s->counts.comp[i][0], s->counts.comp[i][1]);
     }
 
     // reference frames
     if (s->comppredmode != PRED_SINGLEREF) {
         for (i = 0; i < 5; i++)
-            adapt_prob(&p->comp_ref[i], s->counts.comp_ref[i][0],
-                       s->counts.comp_ref[i][1], 20, 128);
+            adapt_prob(&list, &p->comp_ref[i], s->counts.comp_ref[i][0],
+                       s->counts.comp_ref[i][1]);
     }
 
     if (s->comppredmode != PRED_COMPREF) {
@@ -1467,8 +1465,8 @@ static void adapt_probs(VP9Context *s)
             RK_U8 *pp = p->single_ref[i];
             RK_U32 (*c)[2] = s->counts.single_ref[i];
 
-            adapt_prob(&pp[0], c[0][0], c[0][1], 20, 128);
-            adapt_prob(&pp[1], c[1][0], c[1][1], 20, 128);
+            adapt_prob(&list, &pp[0], c[0][0], c[0][1]);
+            adapt_prob(&list, &pp[1], c[1][0], c[1][1]);
         }
     }
 
@@ -1479,9 +1477,9 @@ static void adapt_probs(VP9Context *s)
             RK_U32 *c = s->counts.partition[i][j];
             // mpp_log("befor pp[0] = 0x%x pp[1] = 0x%x pp[2] = 0x%x",pp[0],pp[1],pp[2]);
             // mpp_log("befor c[0] = 0x%x c[1] = 0x%x c[2] = 0x%x",c[0],c[1],c[2]);
-            adapt_prob(&pp[0], c[0], c[1] + c[2] + c[3], 20, 128);
-            adapt_prob(&pp[1], c[1], c[2] + c[3], 20, 128);
-            adapt_prob(&pp[2], c[2], c[3], 20, 128);
+            adapt_prob(&list, &pp[0], c[0], c[1] + c[2] + c[3]);
+            adapt_prob(&list, &pp[1], c[1], c[2] + c[3]);
+            adapt_prob(&list, &pp[2], c[2], c[3]);
             // mpp_log(" after pp[0] = 0x%x pp[1] = 0x%x pp[2] = 0x%x",pp[0],pp[1],pp[2]);
         }
 
@@ -1490,12 +1488,12 @@ static void adapt_probs(VP9Context *s)
         for (i = 0; i < 2; i++) {
             RK_U32 *c16 = s->counts.tx16p[i], *c32 = s->counts.tx32p[i];
 
-            adapt_prob(&p->tx8p[i], s->counts.tx8p[i][0], s->counts.tx8p[i][1], 20, 128);
-            adapt_prob(&p->tx16p[i][0], c16[0], c16[1] + c16[2], 20, 128);
-            adapt_prob(&p->tx16p[i][1], c16[1], c16[2], 20, 128);
-            adapt_prob(&p->tx32p[i][0], c32[0], c32[1] + c32[2] + c32[3], 20, 128);
-            adapt_prob(&p->tx32p[i][1], c32[1], c32[2] + c32[3], 20, 128);
-            adapt_prob(&p->tx32p[i][2], c32[2], c32[3], 20, 128);
+            adapt_prob(&list, &p->tx8p[i], s->counts.tx8p[i][0], s->counts.tx8p[i][1]);
+            adapt_prob(&list, &p->tx16p[i][0], c16[0], c16[1] + c16[2]);
+            adapt_prob(&list, &p->tx16p[i][1], c16[1], c16[2]);
+            adapt_prob(&list, &p->tx32p[i][0], c32[0], c32[1] + c32[2] + c32[3]);
+            adapt_prob(&list, &p->tx32p[i][1], c32[1], c32[2] + c32[3]);
+            adapt_prob(&list, &p->tx32p[i][2], c32[2], c32[3]);
         }
     }
 
@@ -1505,8 +1503,8 @@ static void adapt_probs(VP9Context *s)
             RK_U8 *pp = p->filter[i];
             RK_U32 *c = s->counts.filter[i];
 
-            adapt_prob(&pp[0], c[0], c[1] + c[2], 20, 128);
-            adapt_prob(&pp[1], c[1], c[2], 20, 128);
+            adapt_prob(&list, &pp[0], c[0], c[1] + c[2]);
+            adapt_prob(&list, &pp[1], c[1], c[2]);
         }
     }
 
@@ -1515,9 +1513,9 @@ static void adapt_probs(VP9Context *s)
         RK_U8 *pp = p->mv_mode[i];
         RK_U32 *c = s->counts.mv_mode[i];
 
-        adapt_prob(&pp[0], c[2], c[1] + c[0] + c[3], 20, 128);
-        adapt_prob(&pp[1], c[0], c[1] + c[3], 20, 128);
-        adapt_prob(&pp[2], c[1], c[3], 20, 128);
+        adapt_prob(&list, &pp[0], c[2], c[1] + c[0] + c[3]);
+        adapt_prob(&list, &pp[1], c[0], c[1] + c[3]);
+        adapt_prob(&list, &pp[2], c[1], c[3]);
     }
 
     // mv joints
@@ -1525,9 +1523,9 @@ static void adapt_probs(VP9Context *s)
         RK_U8 *pp = p->mv_joint;
         RK_U32 *c = s->counts.mv_joint;
 
-        adapt_prob(&pp[0], c[0], c[1] + c[2] + c[3], 20, 128);
-        adapt_prob(&pp[1], c[1], c[2] + c[3], 20, 128);
-        adapt_prob(&pp[2], c[2], c[3], 20, 128);
+        adapt_prob(&list, &pp[0], c[0], c[1] + c[2] + c[3]);
+        adapt_prob(&list, &pp[1], c[1], c[2] + c[3]);
+        adapt_prob(&list, &pp[2], c[2], c[3]);
     }
 
     // mv components
@@ -1535,52 +1533,50 @@ static void adapt_probs(VP9Context *s)
         RK_U8 *pp;
         RK_U32 *c, (*c2)[2], sum;
 
-        adapt_prob(&p->mv_comp[i].sign, s->counts.sign[i][0],
-                   s->counts.sign[i][1], 20, 128);
+        adapt_prob(&list, &p->mv_comp[i].sign, s->counts.sign[i][0], s->counts.sign[i][1]);
 
         pp = p->mv_comp[i].classes;
         c = s->counts.classes[i];
         sum = c[1] + c[2] + c[3] + c[4] + c[5] + c[6] + c[7] + c[8] + c[9] + c[10];
-        adapt_prob(&pp[0], c[0], sum, 20, 128);
+        adapt_prob(&list, &pp[0], c[0], sum);
         sum -= c[1];
-        adapt_prob(&pp[1], c[1], sum, 20, 128);
+        adapt_prob(&list, &pp[1], c[1], sum);
         sum -= c[2] + c[3];
-        adapt_prob(&pp[2], c[2] + c[3], sum, 20, 128);
-        adapt_prob(&pp[3], c[2], c[3], 20, 128);
+        adapt_prob(&list, &pp[2], c[2] + c[3], sum);
+        adapt_prob(&list, &pp[3], c[2], c[3]);
         sum -= c[4] + c[5];
-        adapt_prob(&pp[4], c[4] + c[5], sum, 20, 128);
-        adapt_prob(&pp[5], c[4], c[5], 20, 128);
+        adapt_prob(&list, &pp[4], c[4] + c[5], sum);
+        adapt_prob(&list, &pp[5], c[4], c[5]);
         sum -= c[6];
-        adapt_prob(&pp[6], c[6], sum, 20, 128);
-        adapt_prob(&pp[7], c[7] + c[8], c[9] + c[10], 20, 128);
-        adapt_prob(&pp[8], c[7], c[8], 20, 128);
-        adapt_prob(&pp[9], c[9], c[10], 20, 128);
+        adapt_prob(&list, &pp[6], c[6], sum);
+        adapt_prob(&list, &pp[7], c[7] + c[8], c[9] + c[10]);
+        adapt_prob(&list, &pp[8], c[7], c[8]);
+        adapt_prob(&list, &pp[9], c[9], c[10]);
 
-        adapt_prob(&p->mv_comp[i].class0, s->counts.class0[i][0],
-                   s->counts.class0[i][1], 20, 128);
+        adapt_prob(&list, &p->mv_comp[i].class0, s->counts.class0[i][0],
+                   s->counts.class0[i][1]);
         pp = p->mv_comp[i].bits;
         c2 = s->counts.bits[i];
         for (j = 0; j < 10; j++)
-            adapt_prob(&pp[j], c2[j][0], c2[j][1], 20, 128);
+            adapt_prob(&list, &pp[j], c2[j][0], c2[j][1]);
 
         for (j = 0; j < 2; j++) {
             pp = p->mv_comp[i].class0_fp[j];
             c = s->counts.class0_fp[i][j];
-            adapt_prob(&pp[0], c[0], c[1] + c[2] + c[3], 20, 128);
-            adapt_prob(&pp[1], c[1], c[2] + c[3], 20, 128);
-            adapt_prob(&pp[2], c[2], c[3], 20, 128);
+            adapt_prob(&list, &pp[0], c[0], c[1] + c[2] + c[3]);
+            adapt_prob(&list, &pp[1], c[1], c[2] + c[3]);
+            adapt_prob(&list, &pp[2], c[2], c[3]);
         }
         pp = p->mv_comp[i].fp;
         c = s->counts.fp[i];
-        adapt_prob(&pp[0], c[0], c[1] + c[2] + c[3], 20, 128);
-        adapt_prob(&pp[1], c[1], c[2] + c[3], 20, 128);
-        adapt_prob(&pp[2], c[2], c[3], 20, 128);
+        adapt_prob(&list, &pp[0], c[0], c[1] + c[2] + c[3]);
+        adapt_prob(&list, &pp[1], c[1], c[2] + c[3]);
+        adapt_prob(&list, &pp[2], c[2], c[3]);
 
         if (s->highprecisionmvs) {
-            adapt_prob(&p->mv_comp[i].class0_hp, s->counts.class0_hp[i][0],
-                       s->counts.class0_hp[i][1], 20, 128);
-            adapt_prob(&p->mv_comp[i].hp, s->counts.hp[i][0],
-                       s->counts.hp[i][1], 20, 128);
+            adapt_prob(&list, &p->mv_comp[i].class0_hp, s->counts.class0_hp[i][0],
+                       s->counts.class0_hp[i][1]);
+            adapt_prob(&list, &p->mv_comp[i].hp, s->counts.hp[i][0], s->counts.hp[i][1]);
         }
     }
 
@@ -1590,22 +1586,22 @@ static void adapt_probs(VP9Context *s)
         RK_U32 *c = s->counts.y_mode[i], sum, s2;
 
         sum = c[0] + c[1] + c[3] + c[4] + c[5] + c[6] + c[7] + c[8] + c[9];
-        adapt_prob(&pp[0], c[DC_PRED], sum, 20, 128);
+        adapt_prob(&list, &pp[0], c[DC_PRED], sum);
         sum -= c[TM_VP8_PRED];
-        adapt_prob(&pp[1], c[TM_VP8_PRED], sum, 20, 128);
+        adapt_prob(&list, &pp[1], c[TM_VP8_PRED], sum);
         sum -= c[VERT_PRED];
-        adapt_prob(&pp[2], c[VERT_PRED], sum, 20, 128);
+        adapt_prob(&list, &pp[2], c[VERT_PRED], sum);
         s2 = c[HOR_PRED] + c[DIAG_DOWN_RIGHT_PRED] + c[VERT_RIGHT_PRED];
         sum -= s2;
-        adapt_prob(&pp[3], s2, sum, 20, 128);
+        adapt_prob(&list, &pp[3], s2, sum);
         s2 -= c[HOR_PRED];
-        adapt_prob(&pp[4], c[HOR_PRED], s2, 20, 128);
-        adapt_prob(&pp[5], c[DIAG_DOWN_RIGHT_PRED], c[VERT_RIGHT_PRED], 20, 128);
+        adapt_prob(&list, &pp[4], c[HOR_PRED], s2);
+        adapt_prob(&list, &pp[5], c[DIAG_DOWN_RIGHT_PRED], c[VERT_RIGHT_PRED]);
         sum -= c[DIAG_DOWN_LEFT_PRED];
-        adapt_prob(&pp[6], c[DIAG_DOWN_LEFT_PRED], sum, 20, 128);
+        adapt_prob(&list, &pp[6], c[DIAG_DOWN_LEFT_PRED], sum);
         sum -= c[VERT_LEFT_PRED];
-        adapt_prob(&pp[7], c[VERT_LEFT_PRED], sum, 20, 128);
-        adapt_prob(&pp[8], c[HOR_DOWN_PRED], c[HOR_UP_PRED], 20, 128);
+        adapt_prob(&list, &pp[7], c[VERT_LEFT_PRED], sum);
+        adapt_prob(&list, &pp[8], c[HOR_DOWN_PRED], c[HOR_UP_PRED]);
     }
 
     // uv intra modes
@@ -1614,23 +1610,26 @@ static void adapt_probs(VP9Context *s)
         RK_U32 *c = s->counts.uv_mode[i], sum, s2;
 
         sum = c[0] + c[1] + c[3] + c[4] + c[5] + c[6] + c[7] + c[8] + c[9];
-        adapt_prob(&pp[0], c[DC_PRED], sum, 20, 128);
+        adapt_prob(&list, &pp[0], c[DC_PRED], sum);
         sum -= c[TM_VP8_PRED];
-        adapt_prob(&pp[1], c[TM_VP8_PRED], sum, 20, 128);
+        adapt_prob(&list, &pp[1], c[TM_VP8_PRED], sum);
         sum -= c[VERT_PRED];
-        adapt_prob(&pp[2], c[VERT_PRED], sum, 20, 128);
+        adapt_prob(&list, &pp[2], c[VERT_PRED], sum);
         s2 = c[HOR_PRED] + c[DIAG_DOWN_RIGHT_PRED] + c[VERT_RIGHT_PRED];
         sum -= s2;
-        adapt_prob(&pp[3], s2, sum, 20, 128);
+        adapt_prob(&list, &pp[3], s2, sum);
         s2 -= c[HOR_PRED];
-        adapt_prob(&pp[4], c[HOR_PRED], s2, 20, 128);
-        adapt_prob(&pp[5], c[DIAG_DOWN_RIGHT_PRED], c[VERT_RIGHT_PRED], 20, 128);
+        adapt_prob(&list, &pp[4], c[HOR_PRED], s2);
+        adapt_prob(&list, &pp[5], c[DIAG_DOWN_RIGHT_PRED], c[VERT_RIGHT_PRED]);
         sum -= c[DIAG_DOWN_LEFT_PRED];
-        adapt_prob(&pp[6], c[DIAG_DOWN_LEFT_PRED], sum, 20, 128);
+        adapt_prob(&list, &pp[6], c[DIAG_DOWN_LEFT_PRED], sum);
         sum -= c[VERT_LEFT_PRED];
-        adapt_prob(&pp[7], c[VERT_LEFT_PRED], sum, 20, 128);
-        adapt_prob(&pp[8], c[HOR_DOWN_PRED], c[HOR_UP_PRED], 20, 128);
+        adapt_prob(&list, &pp[7], c[VERT_LEFT_PRED], sum);
+        adapt_prob(&list, &pp[8], c[HOR_DOWN_PRED], c[HOR_UP_PRED]);
     }
+
+    adapt_prob_flush(s, &list);
+
 #if 0 //def dump
     fwrite(s->counts.y_mode, 1, sizeof(s->counts.y_mode), vp9_p_fp1);
     fwrite(s->counts.uv_mode, 1, sizeof(s->counts.uv_mode), vp9_p_fp1);
@@ -1797,12 +1796,19 @@ MPP_RET vp9d_paser_reset(Vp9CodecContext *ctx)
     }
     return MPP_OK;
 }
+/*
+ * syntax index of each intra mode in hardware count order
+ *
+ *     hardware    dc v  h  d45 d135 d117 d153 d207 d63  tm
+ *     syntax      v  h  dc d45 d135 d117 d153 d63  d207 tm
+ */
+static const RK_U8 vp9_hw_mode_map[10] = { 2, 0, 1, 3, 4, 5, 6, 8, 7, 9 };
+
 static void inv_count_data(VP9Context *s)
 {
     RK_U32 partition_probs[4][4][4];
     RK_U32 count_uv[10][10];
     RK_U32 count_y_mode[4][10];
-    RK_U32 *dst_uv = NULL;
     RK_S32 i, j;
 
     /*
@@ -1814,83 +1820,25 @@ static void inv_count_data(VP9Context *s)
      */
 
     memcpy(&partition_probs, s->counts.partition, sizeof(s->counts.partition));
-    j = 0;
-    for (i = 3; i >= 0; i--) {
-        memcpy(&s->counts.partition[j], &partition_probs[i], 64);
-        j++;
-    }
-    if (!(s->keyframe || s->intraonly)) {
-        memcpy(count_y_mode, s->counts.y_mode, sizeof(s->counts.y_mode));
-        for (i = 0; i < 4; i++) {
-            RK_U32 value = 0;
-            for (j = 0; j < 10; j++) {
-                value = count_y_mode[i][j];
-                if (j == 0)
-                    s->counts.y_mode[i][2] = value;
-                else if (j == 1)
-                    s->counts.y_mode[i][0] = value;
-                else if (j == 2)
-                    s->counts.y_mode[i][1] = value;
-                else if (j == 7)
-                    s->counts.y_mode[i][8] = value;
-                else if (j == 8)
-                    s->counts.y_mode[i][7] = value;
-                else
-                    s->counts.y_mode[i][j] = value;
+    for (i = 0; i < 4; i++)
+        memcpy(&s->counts.partition[i], &partition_probs[3 - i], sizeof(partition_probs[0]));
 
-            }
-        }
+    if (s->keyframe || s->intraonly)
+        return;
 
+    memcpy(count_y_mode, s->counts.y_mode, sizeof(s->counts.y_mode));
+    memcpy(count_uv, s->counts.uv_mode, sizeof(s->counts.uv_mode));
 
-        memcpy(count_uv, s->counts.uv_mode, sizeof(s->counts.uv_mode));
-
-        /*change uv_mode to hardware need style*/
-        /*
-              syntax              hardware
-         *+++++ v   ++++*     *++++ dc   ++++*
-         *+++++ h   ++++*     *++++ v   ++++*
-         *+++++ dc  ++++*     *++++ h  ++++*
-         *+++++ d45 ++++*     *++++ d45 ++++*
-         *+++++ d135++++*     *++++ d135++++*
-         *+++++ d117++++*     *++++ d117++++*
-         *+++++ d153++++*     *++++ d153++++*
-         *+++++ d63 ++++*     *++++ d207++++*
-         *+++++ d207 ++++*    *++++ d63 ++++*
-         *+++++ tm  ++++*     *++++ tm  ++++*
-        */
-        for (i = 0; i < 10; i++) {
-            RK_U32 *src_uv = (RK_U32 *)(count_uv[i]);
-            RK_U32 value = 0;
-            if (i == 0) {
-                dst_uv = s->counts.uv_mode[2]; //dc
-            } else if ( i == 1) {
-                dst_uv = s->counts.uv_mode[0]; //h
-            }  else if ( i == 2) {
-                dst_uv = s->counts.uv_mode[1]; //h
-            }  else if ( i == 7) {
-                dst_uv = s->counts.uv_mode[8]; //d207
-            } else if (i == 8) {
-                dst_uv = s->counts.uv_mode[7]; //d63
-            } else {
-                dst_uv = s->counts.uv_mode[i];
-            }
-            for (j = 0; j < 10; j++) {
-                value = src_uv[j];
-                if (j == 0)
-                    dst_uv[2] = value;
-                else if (j == 1)
-                    dst_uv[0] = value;
-                else if (j == 2)
-                    dst_uv[1] = value;
-                else if (j == 7)
-                    dst_uv[8] = value;
-                else if (j == 8)
-                    dst_uv[7] = value;
-                else
-                    dst_uv[j] = value;
-            }
+    for (i = 0; i < 4; i++)
+        for (j = 0; j < 10; j++)
+            s->counts.y_mode[i][vp9_hw_mode_map[j]] = count_y_mode[i][j];
 
-        }
+    /* uv counts are also indexed by y mode */
+    for (i = 0; i < 10; i++) {
+        RK_U32 *dst_uv = s->counts.uv_mode[vp9_hw_mode_map[i]];
+
+        for (j = 0; j < 10; j++)
+            dst_uv[vp9_hw_mode_map[j]] = count_uv[i][j];
     }
 }
 
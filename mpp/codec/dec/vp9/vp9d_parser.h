@@ -261,6 +261,8 @@ typedef struct VP9Context {
     RK_S32 eos;       ///< current packet contains an EOS/EOB NAL
     RK_S64 pts;
     RK_S32 upprobe_num;
+    /* adapt probabilities with the scalar reference code */
+    RK_U32 prob_ref;
     RK_S32 outframe_num;
     RK_U32 cur_poc;
 } VP9Context;
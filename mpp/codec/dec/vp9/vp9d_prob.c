@@ -0,0 +1,278 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#include "mpp_common.h"
+
+#include "vp9d_prob.h"
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define VP9D_PROB_NEON      1
+#elif defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define VP9D_PROB_SSE2      1
+#endif
+
+#ifndef FASTDIV
+#   define FASTDIV(a,b) ((RK_U32)((((RK_U64)a) * vpx_inverse[b]) >> 32))
+#endif /* FASTDIV */
+
+/* a*inverse[b]>>32 == a/b for all 0<=a<=16909558 && 2<=b<=256
+ * for a>16909558, is an overestimate by less than 1 part in 1<<24 */
+static const RK_U32 vpx_inverse[257] = {
+    0, 4294967295U, 2147483648U, 1431655766, 1073741824,  858993460,  715827883,  613566757,
+    536870912,  477218589,  429496730,  390451573,  357913942,  330382100,  306783379,  286331154,
+    268435456,  252645136,  238609295,  226050911,  214748365,  204522253,  195225787,  186737709,
+    178956971,  171798692,  165191050,  159072863,  153391690,  148102321,  143165577,  138547333,
+    134217728,  130150525,  126322568,  122713352,  119304648,  116080198,  113025456,  110127367,
+    107374183,  104755300,  102261127,   99882961,   97612894,   95443718,   93368855,   91382283,
+    89478486,   87652394,   85899346,   84215046,   82595525,   81037119,   79536432,   78090315,
+    76695845,   75350304,   74051161,   72796056,   71582789,   70409300,   69273667,   68174085,
+    67108864,   66076420,   65075263,   64103990,   63161284,   62245903,   61356676,   60492498,
+    59652324,   58835169,   58040099,   57266231,   56512728,   55778797,   55063684,   54366675,
+    53687092,   53024288,   52377650,   51746594,   51130564,   50529028,   49941481,   49367441,
+    48806447,   48258060,   47721859,   47197443,   46684428,   46182445,   45691142,   45210183,
+    44739243,   44278014,   43826197,   43383509,   42949673,   42524429,   42107523,   41698712,
+    41297763,   40904451,   40518560,   40139882,   39768216,   39403370,   39045158,   38693400,
+    38347923,   38008561,   37675152,   37347542,   37025581,   36709123,   36398028,   36092163,
+    35791395,   35495598,   35204650,   34918434,   34636834,   34359739,   34087043,   33818641,
+    33554432,   33294321,   33038210,   32786010,   32537632,   32292988,   32051995,   31814573,
+    31580642,   31350127,   31122952,   30899046,   30678338,   30460761,   30246249,   30034737,
+    29826162,   29620465,   29417585,   29217465,   29020050,   28825284,   28633116,   28443493,
+    28256364,   28071682,   27889399,   27709467,   27531842,   27356480,   27183338,   27012373,
+    26843546,   26676816,   26512144,   26349493,   26188825,   26030105,   25873297,   25718368,
+    25565282,   25414008,   25264514,   25116768,   24970741,   24826401,   24683721,   24542671,
+    24403224,   24265352,   24129030,   23994231,   23860930,   23729102,   23598722,   23469767,
+    23342214,   23216040,   23091223,   22967740,   22845571,   22724695,   22605092,   22486740,
+    22369622,   22253717,   22139007,   22025474,   21913099,   21801865,   21691755,   21582751,
+    21474837,   21367997,   21262215,   21157475,   21053762,   20951060,   20849356,   20748635,
+    20648882,   20550083,   20452226,   20355296,   20259280,   20164166,   20069941,   19976593,
+    19884108,   19792477,   19701685,   19611723,   19522579,   19434242,   19346700,   19259944,
+    19173962,   19088744,   19004281,   18920561,   18837576,   18755316,   18673771,   18592933,
+    18512791,   18433337,   18354562,   18276457,   18199014,   18122225,   18046082,   17970575,
+    17895698,   17821442,   17747799,   17674763,   17602325,   17530479,   17459217,   17388532,
+    17318417,   17248865,   17179870,   17111424,   17043522,   16976156,   16909321,   16843010,
+    16777216
+};
+
+/* reference per-entry adaptation as in libvpx */
+static void adapt_prob(RK_U8 *p, RK_U32 ct0, RK_U32 ct1,
+                       RK_S32 max_count, RK_S32 update_factor)
+{
+    RK_U32 ct = ct0 + ct1, p2, p1;
+
+    if (!ct)
+        return;
+
+    p1 = *p;
+    p2 = ((ct0 << 8) + (ct >> 1)) / ct;
+    p2 = mpp_clip(p2, 1, 255);
+    ct = MPP_MIN(ct, (RK_U32)max_count);
+    update_factor = FASTDIV(update_factor * ct, max_count);
+
+    // (p1 * (256 - update_factor) + p2 * update_factor + 128) >> 8
+    *p = p1 + (((p2 - p1) * update_factor + 128) >> 8);
+}
+
+void vp9d_adapt_prob_batch_ref(RK_U8 *p, const RK_U32 *ct0, const RK_U32 *ct1,
+                               RK_S32 n, RK_S32 max_count, RK_S32 update_factor)
+{
+    RK_S32 i;
+
+    for (i = 0; i < n; i++)
+        adapt_prob(&p[i], ct0[i], ct1[i], max_count, update_factor);
+}
+
+/*
+ * (a * recip) >> 16 with recip = ceil(65536 / max_count) equals
+ * a / max_count while a * (recip * max_count - 65536) < 65536, which holds
+ * for a = update_factor * min(ct, max_count) with max_count up to 24.
+ * update_factor up to 128 also keeps the vector products in 16 bits.
+ */
+static RK_U32 get_recip(RK_S32 max_count)
+{
+    return (65536 + max_count - 1) / max_count;
+}
+
+static void adapt_prob_c(RK_U8 *p, RK_U32 ct0, RK_U32 ct1, RK_U32 max_count,
+                         RK_U32 update_factor, RK_U32 recip)
+{
+    RK_U32 ct = ct0 + ct1;
+    RK_S32 p1 = *p;
+    RK_S32 p2;
+    RK_S32 factor;
+
+    if (!ct)
+        return;
+
+    /* keep the 32-bit wrap and signed clip of the reference for huge counts */
+    p2 = mpp_clip(((ct0 << 8) + (ct >> 1)) / ct, 1, 255);
+    factor = (update_factor * MPP_MIN(ct, max_count) * recip) >> 16;
+
+    /* the low 8 bits are the same as the unsigned math of the reference */
+    *p = (RK_U8)(p1 + (((p2 - p1) * factor + 128) >> 8));
+}
+
+#if defined(VP9D_PROB_SSE2)
+/* u32 lanes to double, cvtepi32_pd is signed so bias by 2^31 */
+static __m128d u32_to_pd(__m128i v)
+{
+    const __m128i bias = _mm_set1_epi32((RK_S32)0x80000000);
+
+    return _mm_add_pd(_mm_cvtepi32_pd(_mm_xor_si128(v, bias)),
+                      _mm_set1_pd(2147483648.0));
+}
+
+/*
+ * clip(num / ct, 1, 255) for four u32 lanes. Division of 32-bit integers
+ * in double is exact after truncation. The reference clips the quotient as
+ * signed so quotients from 2^31 go to 1. Zero ct lanes divide by one and
+ * are dropped later by their zero weight.
+ */
+static __m128d clip_pd(__m128d q)
+{
+    const __m128d lo = _mm_set1_pd(1.0);
+    const __m128d hi = _mm_set1_pd(255.0);
+    __m128d neg = _mm_cmpge_pd(q, _mm_set1_pd(2147483648.0));
+
+    q = _mm_min_pd(_mm_max_pd(q, lo), hi);
+
+    return _mm_or_pd(_mm_and_pd(neg, lo), _mm_andnot_pd(neg, q));
+}
+
+static __m128i div_clip_sse2(__m128i num, __m128i ct)
+{
+    __m128i den = _mm_sub_epi32(ct, _mm_cmpeq_epi32(ct, _mm_setzero_si128()));
+    __m128d q0 = _mm_div_pd(u32_to_pd(num), u32_to_pd(den));
+    __m128d q1 = _mm_div_pd(u32_to_pd(_mm_srli_si128(num, 8)),
+                            u32_to_pd(_mm_srli_si128(den, 8)));
+
+    q0 = clip_pd(q0);
+    q1 = clip_pd(q1);
+
+    return _mm_unpacklo_epi64(_mm_cvttpd_epi32(q0), _mm_cvttpd_epi32(q1));
+}
+
+/* unsigned min(ct, max_count) for four u32 lanes */
+static __m128i min_count_sse2(__m128i ct, __m128i max_count)
+{
+    const __m128i bias = _mm_set1_epi32((RK_S32)0x80000000);
+    __m128i gt = _mm_cmpgt_epi32(_mm_xor_si128(ct, bias),
+                                 _mm_xor_si128(max_count, bias));
+
+    return _mm_or_si128(_mm_and_si128(gt, max_count), _mm_andnot_si128(gt, ct));
+}
+
+static RK_S32 adapt_prob_sse2(RK_U8 *p, const RK_U32 *ct0, const RK_U32 *ct1,
+                              RK_S32 n, RK_U32 max_count, RK_U32 update_factor,
+                              RK_U32 recip)
+{
+    const __m128i max_ct = _mm_set1_epi32(max_count);
+    const __m128i uf = _mm_set1_epi16(update_factor);
+    const __m128i rcp = _mm_set1_epi16(recip);
+    const __m128i round = _mm_set1_epi16(128);
+    const __m128i mask = _mm_set1_epi16(0xff);
+    const __m128i zero = _mm_setzero_si128();
+    RK_S32 i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m128i a0 = _mm_loadu_si128((const __m128i *)(ct0 + i));
+        __m128i a1 = _mm_loadu_si128((const __m128i *)(ct0 + i + 4));
+        __m128i c0 = _mm_add_epi32(a0, _mm_loadu_si128((const __m128i *)(ct1 + i)));
+        __m128i c1 = _mm_add_epi32(a1, _mm_loadu_si128((const __m128i *)(ct1 + i + 4)));
+        __m128i n0 = _mm_add_epi32(_mm_slli_epi32(a0, 8), _mm_srli_epi32(c0, 1));
+        __m128i n1 = _mm_add_epi32(_mm_slli_epi32(a1, 8), _mm_srli_epi32(c1, 1));
+        __m128i p2 = _mm_packs_epi32(div_clip_sse2(n0, c0), div_clip_sse2(n1, c1));
+        __m128i ct = _mm_packs_epi32(min_count_sse2(c0, max_ct),
+                                     min_count_sse2(c1, max_ct));
+        __m128i factor = _mm_mulhi_epu16(_mm_mullo_epi16(ct, uf), rcp);
+        __m128i p1 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(p + i)), zero);
+        __m128i d = _mm_mullo_epi16(_mm_sub_epi16(p2, p1), factor);
+        __m128i r = _mm_add_epi16(p1, _mm_srai_epi16(_mm_add_epi16(d, round), 8));
+
+        r = _mm_and_si128(r, mask);
+        _mm_storel_epi64((__m128i *)(p + i), _mm_packus_epi16(r, r));
+    }
+
+    return i;
+}
+#endif
+
+#if defined(VP9D_PROB_NEON)
+/* clip(num / ct, 1, 255) for four u32 lanes, see div_clip_sse2 */
+static float64x2_t clip_f64(float64x2_t q)
+{
+    const float64x2_t lo = vdupq_n_f64(1.0);
+    const float64x2_t hi = vdupq_n_f64(255.0);
+    uint64x2_t neg = vcgeq_f64(q, vdupq_n_f64(2147483648.0));
+
+    return vbslq_f64(neg, lo, vminq_f64(vmaxq_f64(q, lo), hi));
+}
+
+static uint32x4_t div_clip_neon(uint32x4_t num, uint32x4_t ct)
+{
+    uint32x4_t den = vmaxq_u32(ct, vdupq_n_u32(1));
+    float64x2_t q0 = vdivq_f64(vcvtq_f64_u64(vmovl_u32(vget_low_u32(num))),
+                               vcvtq_f64_u64(vmovl_u32(vget_low_u32(den))));
+    float64x2_t q1 = vdivq_f64(vcvtq_f64_u64(vmovl_u32(vget_high_u32(num))),
+                               vcvtq_f64_u64(vmovl_u32(vget_high_u32(den))));
+
+    q0 = clip_f64(q0);
+    q1 = clip_f64(q1);
+
+    return vcombine_u32(vmovn_u64(vcvtq_u64_f64(q0)), vmovn_u64(vcvtq_u64_f64(q1)));
+}
+
+static RK_S32 adapt_prob_neon(RK_U8 *p, const RK_U32 *ct0, const RK_U32 *ct1,
+                              RK_S32 n, RK_U32 max_count, RK_U32 update_factor,
+                              RK_U32 recip)
+{
+    const uint32x4_t max_ct = vdupq_n_u32(max_count);
+    const uint16x8_t uf = vdupq_n_u16(update_factor);
+    const uint16x4_t rcp = vdup_n_u16(recip);
+    const int16x8_t round = vdupq_n_s16(128);
+    RK_S32 i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        uint32x4_t a0 = vld1q_u32(ct0 + i);
+        uint32x4_t a1 = vld1q_u32(ct0 + i + 4);
+        uint32x4_t c0 = vaddq_u32(a0, vld1q_u32(ct1 + i));
+        uint32x4_t c1 = vaddq_u32(a1, vld1q_u32(ct1 + i + 4));
+        uint32x4_t n0 = vaddq_u32(vshlq_n_u32(a0, 8), vshrq_n_u32(c0, 1));
+        uint32x4_t n1 = vaddq_u32(vshlq_n_u32(a1, 8), vshrq_n_u32(c1, 1));
+        uint16x8_t p2 = vcombine_u16(vmovn_u32(div_clip_neon(n0, c0)),
+                                     vmovn_u32(div_clip_neon(n1, c1)));
+        uint16x8_t ct = vcombine_u16(vmovn_u32(vminq_u32(c0, max_ct)),
+                                     vmovn_u32(vminq_u32(c1, max_ct)));
+        uint16x8_t w = vmulq_u16(ct, uf);
+        uint16x8_t factor = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(w), rcp), 16),
+                                         vshrn_n_u32(vmull_u16(vget_high_u16(w), rcp), 16));
+        int16x8_t p1 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p + i)));
+        int16x8_t d = vmulq_s16(vsubq_s16(vreinterpretq_s16_u16(p2), p1),
+                                vreinterpretq_s16_u16(factor));
+        int16x8_t r = vaddq_s16(p1, vshrq_n_s16(vaddq_s16(d, round), 8));
+
+        vst1_u8(p + i, vmovn_u16(vreinterpretq_u16_s16(r)));
+    }
+
+    return i;
+}
+#endif
+
+void vp9d_adapt_prob_batch(RK_U8 *p, const RK_U32 *ct0, const RK_U32 *ct1,
+                           RK_S32 n, RK_S32 max_count, RK_S32 update_factor)
+{
+    RK_U32 recip = get_recip(max_count);
+    RK_S32 i = 0;
+
+#if defined(VP9D_PROB_SSE2)
+    i = adapt_prob_sse2(p, ct0, ct1, n, max_count, update_factor, recip);
+#elif defined(VP9D_PROB_NEON)
+    i = adapt_prob_neon(p, ct0, ct1, n, max_count, update_factor, recip);
+#endif
+
+    for (; i < n; i++)
+        adapt_prob_c(&p[i], ct0[i], ct1[i], max_count, update_factor, recip);
+}
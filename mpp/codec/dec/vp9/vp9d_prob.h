@@ -0,0 +1,36 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef __VP9D_PROB_H__
+#define __VP9D_PROB_H__
+
+#include "rk_type.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Backward adaptation of n binary probabilities stored in a flat array.
+ * Each p[i] moves toward ct0[i] / (ct0[i] + ct1[i]) with a weight which
+ * grows with the total count up to max_count. Entries with zero total
+ * count are kept.
+ *
+ * vp9d_adapt_prob_batch uses NEON / SSE2 when available. It replaces the
+ * 32-bit inverse table of the reference with a 16-bit reciprocal which is
+ * exact for max_count up to 24 and update_factor up to 128 as used by VP9.
+ * vp9d_adapt_prob_batch_ref is the original per-entry code and both give
+ * the same result.
+ */
+void vp9d_adapt_prob_batch(RK_U8 *p, const RK_U32 *ct0, const RK_U32 *ct1,
+                           RK_S32 n, RK_S32 max_count, RK_S32 update_factor);
+void vp9d_adapt_prob_batch_ref(RK_U8 *p, const RK_U32 *ct0, const RK_U32 *ct1,
+                               RK_S32 n, RK_S32 max_count, RK_S32 update_factor);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __VP9D_PROB_H__ */
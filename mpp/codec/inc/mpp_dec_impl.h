@@ -26,6 +26,7 @@
 #include "mpp_dec_cfg.h"
 #include "mpp_callback.h"
 
+#include "mpp_cluster.h"
 #include "mpp_parser.h"
 #include "mpp_hal.h"
 
@@ -76,6 +77,9 @@ struct MppDecImpl_t {
     // worker thread
     MppThread           *thread_parser;
     MppThread           *thread_hal;
+    /* parser on shared cluster: the node and the task kept between runs */
+    MppNode             parser_node;
+    struct DecTask_t    *parser_task;
 
     // common resource
     MppBufSlots         frame_slots;
@@ -123,22 +127,35 @@ struct MppDecImpl_t {
 
     RK_U32              hal_reset_post;
     RK_U32              hal_reset_done;
+    /* parser has posted hal reset and not got it done yet */
+    RK_U32              hal_reset_wait;
     sem_t               parser_reset;
     sem_t               hal_reset;
 
     // work mode flags
     RK_U32              parser_fast_mode;
+    /*
+     * parse ahead on non fast mode: when previous task has no parser
+     * callback the next frame is parsed while hardware decodes previous one
+     */
+    RK_U32              parser_run_ahead;
+    RK_U32              parser_prev_async;
     RK_U32              disable_error;
     RK_U32              enable_deinterlace;
 
     // dec parser thread runtime resource context
     MppPacket           mpp_pkt_in;
+    /* packets left in the input task from decode_put_packets */
+    MppPacket           *mpp_pkt_batch;
+    RK_S32              mpp_pkt_batch_pos;
     void                *mpp;
     void                *vproc;
 
     // statistics data
     RK_U32              statistics_en;
     MppClock            clocks[DEC_TIMING_BUTT];
+    /* session metrics owned by mpp */
+    MppMetrics          metrics;
 
     // query data
     RK_U32              dec_in_pkt_count;
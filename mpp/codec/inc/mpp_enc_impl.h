@@ -22,8 +22,10 @@
 #include "mpp_enc_ref.h"
 #include "mpp_enc_refs.h"
 #include "mpp_device.h"
+#include "mpp_metrics.h"
 
 #include "rc.h"
+#include "rc_lookahead.h"
 #include "hal_info.h"
 
 #define HDR_ADDED_MASK  0xe
@@ -45,6 +47,12 @@ typedef struct RcApiStatus_t {
     RK_U32              rc_api_user_cfg : 1;
 } RcApiStatus;
 
+/* finished rc task waiting for feedback in encoding order */
+typedef struct EncRcFeedback_t {
+    RK_U32              seq_idx;
+    EncRcTask           rc;
+} EncRcFeedback;
+
 typedef struct MppEncImpl_t {
     MppCodingType       coding;
     EncImpl             impl;
@@ -67,11 +75,25 @@ typedef struct MppEncImpl_t {
     RcApiBrief          rc_brief;
     RcCtx               rc_ctx;
 
+    /*
+     * Frame parallel rate control on async encoding with task_cnt tasks
+     * and look-ahead enabled. The feedback of a finished task is queued and
+     * applied before the rc start of the task task_cnt frames later.
+     */
+    RK_S32              task_cnt;
+    EncRcFeedback       *rc_fb;
+    RK_S32              rc_fb_rd;
+    RK_S32              rc_fb_cnt;
+    RK_S32              rc_rt_bits;
+    RcLookahead         lookahead;
+
     /*
      * thread input / output context
      */
     MppThread           *thread_enc;
     void                *mpp;
+    /* session metrics owned by mpp */
+    MppMetrics          metrics;
 
     MppPort             input;
     MppPort             output;
@@ -0,0 +1,55 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef __RC_LOOKAHEAD_H__
+#define __RC_LOOKAHEAD_H__
+
+#include "mpp_frame.h"
+#include "mpp_rc_defs.h"
+
+/* max frame number in look-ahead window */
+#define RC_LOOKAHEAD_MAX        16
+
+typedef void* RcLookahead;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Encoder look-ahead window
+ *
+ * Input frames are held for depth frames before they are encoded. Each frame
+ * is analysed once when it enters the window. Luma is point sampled on a 4x4
+ * grid and each 16x16 block costs the smaller one of the absolute deviation
+ * from the block mean (like madi) and the absolute difference to the same
+ * block in the previous frame (like madp). Hardware madi / madp are only
+ * ready after encoding so they can not be used ahead of the encoder.
+ *
+ * A frame is popped in input order when the window is full or when an eos
+ * frame is in the window. The frame cost and the mean cost of the window are
+ * returned in EncRcTaskInfo la_cost / la_cost_avg for rate control. Both only
+ * depend on the input sequence. Non 8bit planar yuv input has zero cost.
+ */
+MPP_RET rc_lookahead_init(RcLookahead *ctx);
+MPP_RET rc_lookahead_deinit(RcLookahead ctx);
+
+/* depth 0 passes frames through without analysis */
+MPP_RET rc_lookahead_set_depth(RcLookahead ctx, RK_S32 depth);
+
+/* return 1 when the window needs more input frames before next pop */
+RK_S32  rc_lookahead_need_frame(RcLookahead ctx);
+/* analyse one input frame and append it to the window */
+MPP_RET rc_lookahead_push(RcLookahead ctx, MppFrame frame);
+/* get the oldest frame with its statistics, MPP_NOK when it is not ready */
+MPP_RET rc_lookahead_pop(RcLookahead ctx, MppFrame *frame, EncRcTaskInfo *info);
+/* get the oldest frame regardless of the window state, used on reset */
+MPP_RET rc_lookahead_flush(RcLookahead ctx, MppFrame *frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RC_LOOKAHEAD_H__ */
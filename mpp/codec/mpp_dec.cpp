@@ -331,6 +331,14 @@ void mpp_dec_put_frame(Mpp *mpp, RK_S32 index, HalDecTaskFlag flags)
                    (NULL == mpp_frame_get_buffer(frame)) ? (-1) :
                    mpp_buffer_get_fd(mpp_frame_get_buffer(frame)));
 
+    if (index >= 0 && !change)
+        mpp_frame_trace_commit(mpp->mTrace, index, mpp_frame_get_pts(frame));
+
+    mpp_metrics_add(dec->metrics, MPP_STATS_FRM_OUT, 1);
+    if (mpp->mFrameGroup)
+        mpp_metrics_max(dec->metrics, MPP_STATS_BUF_HIGH_WATER,
+                        mpp_buffer_group_usage(mpp->mFrameGroup));
+
     if (dec->vproc) {
         HalTaskGroup group = dec->vproc_tasks;
         HalTaskHnd hnd = NULL;
@@ -626,6 +634,7 @@ MPP_RET mpp_dec_init(MppDec *dec, MppDecInitCfg *cfg)
     }
 
     p->mpp = mpp;
+    p->metrics = mpp->mMetrics;
     coding = cfg->coding;
     dec_cfg = &p->cfg;
 
@@ -692,6 +701,13 @@ MPP_RET mpp_dec_init(MppDec *dec, MppDecInitCfg *cfg)
             dec_cfg->base.fast_parse = 0;
             p->parser_fast_mode = 0;
         }
+
+        /*
+         * vp9 / av1 hal only calls back to parser on frames with wait_done
+         * flag so the frames after others can be parsed ahead
+         */
+        p->parser_run_ahead = (coding == MPP_VIDEO_CodingVP9 ||
+                               coding == MPP_VIDEO_CodingAV1) ? 1 : 0;
         dec_cfg->status.hal_support_fast_mode = support_fast_mode;
         dec_cfg->status.hal_task_count = hal_task_count;
 
@@ -701,7 +717,8 @@ MPP_RET mpp_dec_init(MppDec *dec, MppDecInitCfg *cfg)
             break;
         }
 
-        mpp_buf_slot_setup(packet_slots, hal_task_count);
+        /* one more packet slot for the frame parsed ahead on fast mode */
+        mpp_buf_slot_setup(packet_slots, hal_task_count + (p->parser_fast_mode ? 1 : 0));
 
         p->hw_info = hal_cfg.hw_info;
         p->dev = hal_cfg.dev;
@@ -892,6 +909,9 @@ MPP_RET mpp_dec_stop(MppDec ctx)
 
     dec_dbg_func("%p in\n", dec);
 
+    if (dec->api && dec->api->stop)
+        dec->api->stop(dec);
+
     if (dec->thread_parser)
         dec->thread_parser->stop();
 
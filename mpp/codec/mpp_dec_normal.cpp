@@ -18,6 +18,7 @@
 
 #include <string.h>
 
+#include "mpp_env.h"
 #include "mpp_buffer_impl.h"
 
 #include "mpp_dec_debug.h"
@@ -83,9 +84,18 @@ static MPP_RET check_task_wait(MppDecImpl *dec, DecTask *task)
     return ret;
 }
 
+static void dec_free_packet_batch(MppPacket *batch, RK_S32 pos)
+{
+    for (; batch[pos]; pos++)
+        mpp_packet_deinit(&batch[pos]);
+
+    mpp_free(batch);
+}
+
 static MPP_RET dec_release_task_in_port(MppPort port)
 {
     MPP_RET ret = MPP_OK;
+    MppPacket *batch = NULL;
     MppPacket packet = NULL;
     MppFrame frame = NULL;
     MppTask mpp_task;
@@ -106,11 +116,17 @@ static MPP_RET dec_release_task_in_port(MppPort port)
             mpp_frame_deinit(&frame);
             frame = NULL;
         }
+        /* input packet is always an internal copy */
         ret = mpp_task_meta_get_packet(mpp_task, KEY_INPUT_PACKET, &packet);
-        if (packet && NULL == mpp_packet_get_buffer(packet)) {
+        if (packet) {
             mpp_packet_deinit(&packet);
             packet = NULL;
         }
+        mpp_task_meta_get_ptr(mpp_task, KEY_INPUT_PACKETS, (void **)&batch, NULL);
+        if (batch) {
+            dec_free_packet_batch(batch, 0);
+            batch = NULL;
+        }
 
         mpp_port_enqueue(port, mpp_task);
         mpp_task = NULL;
@@ -123,15 +139,28 @@ static void dec_release_input_packet(MppDecImpl *dec, RK_S32 force)
 {
     if (dec->mpp_pkt_in) {
         if (force || 0 == mpp_packet_get_length(dec->mpp_pkt_in)) {
-            mpp_packet_deinit(&dec->mpp_pkt_in);
-
+            /* notify before deinit so that the callback can still check the packet */
             mpp_dec_callback(dec, MPP_DEC_EVENT_ON_PKT_RELEASE, dec->mpp_pkt_in);
+            mpp_packet_deinit(&dec->mpp_pkt_in);
             dec->mpp_pkt_in = NULL;
         }
     }
 }
 
-static RK_U32 reset_parser_thread(Mpp *mpp, DecTask *task)
+static void dec_release_input_batch(MppDecImpl *dec)
+{
+    if (dec->mpp_pkt_batch) {
+        dec_free_packet_batch(dec->mpp_pkt_batch, dec->mpp_pkt_batch_pos);
+        dec->mpp_pkt_batch = NULL;
+        dec->mpp_pkt_batch_pos = 0;
+    }
+}
+
+/*
+ * Parser on shared cluster does not wait for hal reset. It returns MPP_NOK
+ * and the hal thread schedules the parser node again when reset is done.
+ */
+static MPP_RET reset_parser_thread(Mpp *mpp, DecTask *task, RK_S32 block)
 {
     MppDecImpl *dec = (MppDecImpl *)mpp->mDec;
     MppThread *hal = dec->thread_hal;
@@ -140,19 +169,27 @@ static RK_U32 reset_parser_thread(Mpp *mpp, DecTask *task)
     MppBufSlots packet_slots = dec->packet_slots;
     HalDecTask *task_dec = &task->info.dec;
 
-    dec_dbg_reset("reset: parser reset start\n");
-    dec_dbg_reset("reset: parser wait hal proc reset start\n");
+    if (!dec->hal_reset_wait) {
+        dec_dbg_reset("reset: parser reset start\n");
+        dec_dbg_reset("reset: parser wait hal proc reset start\n");
 
-    dec_release_task_in_port(mpp->mMppInPort);
+        dec_release_task_in_port(mpp->mMppInPort);
+
+        mpp_assert(hal);
 
-    mpp_assert(hal);
+        hal->lock();
+        dec->hal_reset_wait = 1;
+        dec->hal_reset_post++;
+        hal->signal();
+        hal->unlock();
+    }
 
-    hal->lock();
-    dec->hal_reset_post++;
-    hal->signal();
-    hal->unlock();
+    if (block)
+        sem_wait(&dec->hal_reset);
+    else if (sem_trywait(&dec->hal_reset))
+        return MPP_NOK;
 
-    sem_wait(&dec->hal_reset);
+    dec->hal_reset_wait = 0;
 
     dec_dbg_reset("reset: parser check hal proc task empty start\n");
 
@@ -192,6 +229,7 @@ static RK_U32 reset_parser_thread(Mpp *mpp, DecTask *task)
         }
 
         dec_release_input_packet(dec, 1);
+        dec_release_input_batch(dec);
 
         while (MPP_OK == mpp_buf_slot_dequeue(frame_slots, &index, QUEUE_DISPLAY)) {
             /* release extra ref in slot's MppBuffer */
@@ -228,6 +266,7 @@ static RK_U32 reset_parser_thread(Mpp *mpp, DecTask *task)
         // IMPORTANT: clear flag in MppDec context
         dec->parser_status_flag = 0;
         dec->parser_wait_flag = 0;
+        dec->parser_prev_async = 0;
     }
 
     dec_task_init(task);
@@ -280,6 +319,20 @@ static void reset_hal_thread(Mpp *mpp)
     dec->thread_hal->unlock(THREAD_OUTPUT);
 }
 
+static MppPacket dec_get_batch_packet(MppDecImpl *dec)
+{
+    MppPacket *batch = dec->mpp_pkt_batch;
+    MppPacket packet = batch[dec->mpp_pkt_batch_pos++];
+
+    if (NULL == batch[dec->mpp_pkt_batch_pos]) {
+        mpp_free(batch);
+        dec->mpp_pkt_batch = NULL;
+        dec->mpp_pkt_batch_pos = 0;
+    }
+
+    return packet;
+}
+
 static MPP_RET try_get_input_packet(Mpp *mpp, DecTask *task)
 {
     MppDecImpl *dec = (MppDecImpl *)mpp->mDec;
@@ -288,6 +341,13 @@ static MPP_RET try_get_input_packet(Mpp *mpp, DecTask *task)
     MppPacket packet = NULL;
     MPP_RET ret = MPP_OK;
 
+    /* split the packets from decode_put_packets without touching the port */
+    if (dec->mpp_pkt_batch) {
+        packet = dec_get_batch_packet(dec);
+        mpp_frame_trace_start(mpp->mTrace, MPP_TRACE_STAGING, 0);
+        goto DONE;
+    }
+
     ret = mpp_port_poll(input, MPP_POLL_NON_BLOCK);
     if (ret < 0) {
         task->wait.dec_pkt_in = 1;
@@ -297,12 +357,23 @@ static MPP_RET try_get_input_packet(Mpp *mpp, DecTask *task)
     ret = mpp_port_dequeue(input, &mpp_task);
     mpp_assert(ret == MPP_OK && mpp_task);
     mpp_task_meta_get_packet(mpp_task, KEY_INPUT_PACKET, &packet);
+    if (NULL == packet) {
+        mpp_task_meta_get_ptr(mpp_task, KEY_INPUT_PACKETS,
+                              (void **)&dec->mpp_pkt_batch, NULL);
+        dec->mpp_pkt_batch_pos = 0;
+        if (dec->mpp_pkt_batch)
+            packet = dec_get_batch_packet(dec);
+    }
     mpp_assert(packet);
 
-    /* when it is copy buffer return packet right here */
-    if (NULL == mpp_packet_get_buffer(packet))
-        mpp_port_enqueue(input, mpp_task);
+    /*
+     * packet in task is always created by put_packet with copied data so the
+     * task can be returned right here
+     */
+    mpp_port_enqueue(input, mpp_task);
+    mpp_frame_trace_start(mpp->mTrace, MPP_TRACE_STAGING, 1);
 
+DONE:
     dec->mpp_pkt_in = packet;
     mpp->mPacketGetCount++;
     dec->dec_in_pkt_count++;
@@ -313,10 +384,41 @@ static MPP_RET try_get_input_packet(Mpp *mpp, DecTask *task)
     return MPP_OK;
 }
 
+/* take the previous task back from hal when it is done on non fast mode */
+static MPP_RET check_prev_task_done(MppDecImpl *dec, DecTask *task)
+{
+    HalTaskHnd task_prev = NULL;
+
+    if (task->status.prev_task_rdy)
+        return MPP_OK;
+
+    hal_task_get_hnd(dec->tasks, TASK_PROC_DONE, &task_prev);
+    if (NULL == task_prev) {
+        task->wait.prev_task = 1;
+        return MPP_NOK;
+    }
+
+    task->status.prev_task_rdy = 1;
+    task->wait.prev_task = 0;
+    hal_task_hnd_set_status(task_prev, TASK_IDLE);
+
+    return MPP_OK;
+}
+
+static MPP_RET dec_get_task_hnd(MppDecImpl *dec, DecTask *task)
+{
+    if (task->hnd)
+        return MPP_OK;
+
+    hal_task_get_hnd(dec->tasks, TASK_IDLE, &task->hnd);
+    task->wait.task_hnd = (NULL == task->hnd);
+
+    return (task->hnd) ? MPP_OK : MPP_NOK;
+}
+
 static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
 {
     MppDecImpl *dec = (MppDecImpl *)mpp->mDec;
-    HalTaskGroup tasks  = dec->tasks;
     MppBufSlots frame_slots = dec->frame_slots;
     MppBufSlots packet_slots = dec->packet_slots;
     HalDecTask  *task_dec = &task->info.dec;
@@ -327,16 +429,13 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
 
     /*
      * 1. get task handle from hal for parsing one frame
+     *
+     *    On fast mode the handle is taken after parsing at step 8.1. Then
+     *    next frame is split and parsed while all hal tasks are in use and
+     *    it can be sent to hardware once a hal task is done.
      */
-    if (!task->hnd) {
-        hal_task_get_hnd(tasks, TASK_IDLE, &task->hnd);
-        if (task->hnd) {
-            task->wait.task_hnd = 0;
-        } else {
-            task->wait.task_hnd = 1;
-            return MPP_NOK;
-        }
-    }
+    if (!dec->parser_fast_mode && dec_get_task_hnd(dec, task))
+        return MPP_NOK;
 
     /*
      * 2. get packet for parser preparing
@@ -378,26 +477,36 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
      *
      */
     if (!task->status.curr_task_rdy) {
+        /* eos task may be sent to hal without parsing */
+        if (mpp_packet_get_eos(dec->mpp_pkt_in) && dec_get_task_hnd(dec, task))
+            return MPP_NOK;
+
         mpp_dbg_pts("input packet pts %lld\n", mpp_packet_get_pts(dec->mpp_pkt_in));
 
         mpp_clock_start(dec->clocks[DEC_PRS_PREPARE]);
         mpp_parser_prepare(dec->parser, dec->mpp_pkt_in, task_dec);
         mpp_clock_pause(dec->clocks[DEC_PRS_PREPARE]);
+        if (task_dec->valid)
+            mpp_frame_trace_stamp(mpp->mTrace, MPP_TRACE_STAGING, MPP_TRACE_PREPARE);
         if (dec->cfg.base.sort_pts && task_dec->valid) {
             task->ts_cur.pts = mpp_packet_get_pts(dec->mpp_pkt_in);
             task->ts_cur.dts = mpp_packet_get_dts(dec->mpp_pkt_in);
         }
-        dec_release_input_packet(dec, 0);
-    }
+        /* parser passes input packet through will release it after step 6 */
+        if (!task_dec->valid || task_dec->input_packet != dec->mpp_pkt_in)
+            dec_release_input_packet(dec, 0);
 
-    task->status.curr_task_rdy = task_dec->valid;
-    /*
-    * We may find eos in prepare step and there will be no anymore vaild task generated.
-    * So here we try push eos task to hal, hal will push all frame to display then
-    * push a eos frame to tell all frame decoded
-    */
-    if (task_dec->flags.eos && !task_dec->valid)
-        mpp_dec_put_task(mpp, task);
+        task->status.curr_task_rdy = task_dec->valid;
+        /*
+        * We may find eos in prepare step and there will be no anymore vaild task generated.
+        * So here we try push eos task to hal, hal will push all frame to display then
+        * push a eos frame to tell all frame decoded
+        */
+        if (task_dec->flags.eos && !task_dec->valid) {
+            mpp_assert(task->hnd);
+            mpp_dec_put_task(mpp, task);
+        }
+    }
 
     if (!task->status.curr_task_rdy)
         return MPP_NOK;
@@ -446,52 +555,52 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
         size_t length = mpp_packet_get_length(task_dec->input_packet);
 
         mpp_buffer_write(hal_buf_in, 0, src, length);
+
         mpp_buffer_sync_partial_end(hal_buf_in, 0, length);
         mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_CODEC_READY);
         mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
         task->status.dec_pkt_copy_rdy = 1;
-    }
 
-    /* 7.1 if not fast mode wait previous task done here */
-    if (!dec->parser_fast_mode) {
-        // wait previous task done
-        if (!task->status.prev_task_rdy) {
-            HalTaskHnd task_prev = NULL;
-            hal_task_get_hnd(tasks, TASK_PROC_DONE, &task_prev);
-            if (task_prev) {
-                task->status.prev_task_rdy  = 1;
-                task->wait.prev_task = 0;
-                hal_task_hnd_set_status(task_prev, TASK_IDLE);
-                task_prev = NULL;
-            } else {
-                task->wait.prev_task = 1;
-                return MPP_NOK;
-            }
-        }
+        /* input packet passed through by parser is consumed by the copy */
+        if (task_dec->input_packet == dec->mpp_pkt_in)
+            dec_release_input_packet(dec, 0);
     }
 
-    // for vp9 only wait all task is processed
-    if (task->wait.dec_all_done) {
-        if (!hal_task_check_empty(dec->tasks, TASK_PROCESSING))
-            task->wait.dec_all_done = 0;
-        else
+    /*
+     * 7.1 if not fast mode wait previous task done here
+     *     When previous task feeds nothing back to parser the wait moves to
+     *     step 11.1 so that parsing overlaps the hardware decoding.
+     */
+    if (!dec->parser_fast_mode && !dec->parser_prev_async) {
+        if (check_prev_task_done(dec, task))
             return MPP_NOK;
     }
 
-    dec_dbg_detail("detail: %p check prev task pass\n", dec);
+    /* checks below are for parsing and a parsed task only waits for hal */
+    if (!task->status.task_parsed_rdy) {
+        // for vp9 only wait all task is processed
+        if (task->wait.dec_all_done) {
+            if (!hal_task_check_empty(dec->tasks, TASK_PROCESSING))
+                task->wait.dec_all_done = 0;
+            else
+                return MPP_NOK;
+        }
 
-    /* too many frame delay in dispaly queue */
-    if (mpp->mFrmOut) {
-        task->wait.dis_que_full = (mpp->mFrmOut->list_size() > 4) ? 1 : 0;
-        if (task->wait.dis_que_full)
-            return MPP_ERR_DISPLAY_FULL;
-    }
-    dec_dbg_detail("detail: %p check mframes pass\n", dec);
+        dec_dbg_detail("detail: %p check prev task pass\n", dec);
 
-    /* 7.3 wait for a unused slot index for decoder parse operation */
-    task->wait.dec_slot_idx = (mpp_slots_get_unused_count(frame_slots)) ? (0) : (1);
-    if (task->wait.dec_slot_idx)
-        return MPP_ERR_BUFFER_FULL;
+        /* too many frame delay in dispaly queue */
+        if (mpp->mFrmOut) {
+            task->wait.dis_que_full = (mpp->mFrmOut->list_size() > 4) ? 1 : 0;
+            if (task->wait.dis_que_full)
+                return MPP_ERR_DISPLAY_FULL;
+        }
+        dec_dbg_detail("detail: %p check mframes pass\n", dec);
+
+        /* 7.3 wait for a unused slot index for decoder parse operation */
+        task->wait.dec_slot_idx = (mpp_slots_get_unused_count(frame_slots)) ? (0) : (1);
+        if (task->wait.dec_slot_idx)
+            return MPP_ERR_BUFFER_FULL;
+    }
 
     /*
      * 8. send packet data to parser
@@ -508,10 +617,19 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
      *    4. detect whether output index has MppBuffer and task valid
      */
     if (!task->status.task_parsed_rdy) {
+        RK_S64 time = mpp_time();
+
+        mpp_frame_trace_stamp(mpp->mTrace, MPP_TRACE_STAGING, MPP_TRACE_SLOT);
         mpp_clock_start(dec->clocks[DEC_PRS_PARSE]);
         mpp_parser_parse(dec->parser, task_dec);
         mpp_clock_pause(dec->clocks[DEC_PRS_PARSE]);
+        mpp_metrics_time(dec->metrics, MPP_STATS_PARSE_TIME, mpp_time() - time);
         task->status.task_parsed_rdy = 1;
+
+        if (task_dec->valid && task_dec->output >= 0) {
+            mpp_frame_trace_stamp(mpp->mTrace, MPP_TRACE_STAGING, MPP_TRACE_PARSE);
+            mpp_frame_trace_bind(mpp->mTrace, task_dec->output);
+        }
     }
 
     if (task_dec->output < 0 || !task_dec->valid) {
@@ -522,8 +640,11 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
          * used to inform that all frame have decoded
          */
         if (task_dec->flags.eos) {
+            if (dec_get_task_hnd(dec, task))
+                return MPP_NOK;
+
             mpp_dec_put_task(mpp, task);
-        } else {
+        } else if (task->hnd) {
             hal_task_hnd_set_status(task->hnd, TASK_IDLE);
             task->hnd = NULL;
         }
@@ -539,6 +660,10 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
     }
     dec_dbg_detail("detail: %p check output index pass\n", dec);
 
+    /* 8.1 parsed task waits for hal task handle on fast mode */
+    if (dec_get_task_hnd(dec, task))
+        return MPP_NOK;
+
     /*
      * 9. parse local task and slot to check whether new buffer or info change is needed.
      *
@@ -646,6 +771,10 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
     if (task->wait.dec_pic_match)
         return MPP_NOK;
 
+    /* 11.1 parse ahead task waits previous task done before using hal */
+    if (!dec->parser_fast_mode && check_prev_task_done(dec, task))
+        return MPP_NOK;
+
     if (dec->cfg.base.sort_pts) {
         MppFrame frame = NULL;
         MppPktTs *pkt_ts = (MppPktTs *)mpp_mem_pool_get(dec->ts_pool);
@@ -664,14 +793,17 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
     }
 
     /* generating registers table */
+    mpp_frame_trace_stamp(mpp->mTrace, output, MPP_TRACE_READY);
     mpp_clock_start(dec->clocks[DEC_HAL_GEN_REG]);
     mpp_hal_reg_gen(dec->hal, &task->info);
     mpp_clock_pause(dec->clocks[DEC_HAL_GEN_REG]);
+    mpp_frame_trace_stamp(mpp->mTrace, output, MPP_TRACE_REG_GEN);
 
     /* send current register set to hardware */
     mpp_clock_start(dec->clocks[DEC_HW_START]);
     mpp_hal_hw_start(dec->hal, &task->info);
     mpp_clock_pause(dec->clocks[DEC_HW_START]);
+    mpp_frame_trace_stamp(mpp->mTrace, output, MPP_TRACE_HW_START);
 
     /*
      * 12. send dxva output information and buffer information to hal thread
@@ -682,6 +814,10 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
     task->wait.dec_all_done = (dec->parser_fast_mode &&
                                task_dec->flags.wait_done) ? 1 : 0;
 
+    /* without parser callback next task does not depend on this one */
+    dec->parser_prev_async = (dec->parser_run_ahead &&
+                              !task_dec->flags.wait_done) ? 1 : 0;
+
     task->status.dec_pkt_copy_rdy  = 0;
     task->status.curr_task_rdy  = 0;
     task->status.task_parsed_rdy = 0;
@@ -693,86 +829,155 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
     return MPP_OK;
 }
 
-void *mpp_dec_parser_thread(void *data)
+typedef enum DecParserRet_e {
+    DEC_PARSER_IDLE,            /* wait for next notify */
+    DEC_PARSER_AGAIN,           /* run the parser loop again */
+    DEC_PARSER_DEFER,           /* wait for control or hal reset to be ready */
+} DecParserRet;
+
+/*
+ * One loop of parser. In thread mode the parser waits for notify and goes on
+ * working. On shared cluster it returns DEC_PARSER_IDLE instead of waiting
+ * and the node is scheduled again on notify. The semaphores from control and
+ * hal reset are not waited on shared cluster either. DEC_PARSER_DEFER is
+ * returned and the node is scheduled again after the semaphore is posted.
+ */
+static DecParserRet mpp_dec_parser_proc(Mpp *mpp, DecTask *task, RK_S32 block)
 {
-    Mpp *mpp = (Mpp*)data;
     MppDecImpl *dec = (MppDecImpl *)mpp->mDec;
     MppThread *parser = dec->thread_parser;
-    MppBufSlots packet_slots = dec->packet_slots;
 
-    DecTask task;
-    HalDecTask  *task_dec = &task.info.dec;
-
-    dec_task_init(&task);
-
-    mpp_clock_start(dec->clocks[DEC_PRS_TOTAL]);
+    {
+        AutoMutex autolock(parser->mutex());
+        if (MPP_THREAD_RUNNING != parser->get_status())
+            return DEC_PARSER_IDLE;
 
-    while (1) {
-        {
-            AutoMutex autolock(parser->mutex());
-            if (MPP_THREAD_RUNNING != parser->get_status())
-                break;
+        /*
+         * parser thread need to wait at cases below:
+         * 1. no task slot for output
+         * 2. no packet for parsing
+         * 3. info change on progress
+         * 3. no buffer on analyzing output task
+         */
+        if (check_task_wait(dec, task)) {
+            if (!block)
+                return DEC_PARSER_IDLE;
 
-            /*
-             * parser thread need to wait at cases below:
-             * 1. no task slot for output
-             * 2. no packet for parsing
-             * 3. info change on progress
-             * 3. no buffer on analyzing output task
-             */
-            if (check_task_wait(dec, &task)) {
-                mpp_clock_start(dec->clocks[DEC_PRS_WAIT]);
-                parser->wait();
-                mpp_clock_pause(dec->clocks[DEC_PRS_WAIT]);
-            }
+            mpp_clock_start(dec->clocks[DEC_PRS_WAIT]);
+            parser->wait();
+            mpp_clock_pause(dec->clocks[DEC_PRS_WAIT]);
         }
+    }
 
-        // process user control
-        if (dec->cmd_send != dec->cmd_recv) {
-            dec_dbg_detail("ctrl proc %d cmd %08x\n", dec->cmd_recv, dec->cmd);
+    // process user control
+    if (dec->cmd_send != dec->cmd_recv) {
+        if (block)
             sem_wait(&dec->cmd_start);
-            *dec->cmd_ret = mpp_dec_proc_cfg(dec, dec->cmd, dec->param);
-            dec->cmd_recv++;
-            dec_dbg_detail("ctrl proc %d done send %d\n", dec->cmd_recv,
-                           dec->cmd_send);
-            mpp_assert(dec->cmd_send == dec->cmd_send);
-            dec->param = NULL;
-            dec->cmd = (MpiCmd)0;
-            dec->cmd_ret = NULL;
-            sem_post(&dec->cmd_done);
-            continue;
-        }
-
-        if (dec->reset_flag) {
-            reset_parser_thread(mpp, &task);
+        else if (sem_trywait(&dec->cmd_start))
+            return DEC_PARSER_DEFER;
+
+        dec_dbg_detail("ctrl proc %d cmd %08x\n", dec->cmd_recv, dec->cmd);
+        *dec->cmd_ret = mpp_dec_proc_cfg(dec, dec->cmd, dec->param);
+        dec->cmd_recv++;
+        dec_dbg_detail("ctrl proc %d done send %d\n", dec->cmd_recv,
+                       dec->cmd_send);
+        mpp_assert(dec->cmd_send == dec->cmd_send);
+        dec->param = NULL;
+        dec->cmd = (MpiCmd)0;
+        dec->cmd_ret = NULL;
+        sem_post(&dec->cmd_done);
+        return DEC_PARSER_AGAIN;
+    }
 
-            AutoMutex autolock(parser->mutex(THREAD_CONTROL));
-            dec->reset_flag = 0;
-            sem_post(&dec->parser_reset);
-            continue;
-        }
+    if (dec->reset_flag) {
+        if (reset_parser_thread(mpp, task, block))
+            return DEC_PARSER_DEFER;
 
-        // NOTE: ignore return value here is to fast response to reset.
-        // Otherwise we can loop all dec task until it is failed.
-        mpp_clock_start(dec->clocks[DEC_PRS_PROC]);
-        try_proc_dec_task(mpp, &task);
-        mpp_clock_pause(dec->clocks[DEC_PRS_PROC]);
+        AutoMutex autolock(parser->mutex(THREAD_CONTROL));
+        dec->reset_flag = 0;
+        sem_post(&dec->parser_reset);
+        return DEC_PARSER_AGAIN;
     }
 
-    mpp_clock_pause(dec->clocks[DEC_PRS_TOTAL]);
+    // NOTE: ignore return value here is to fast response to reset.
+    // Otherwise we can loop all dec task until it is failed.
+    mpp_clock_start(dec->clocks[DEC_PRS_PROC]);
+    try_proc_dec_task(mpp, task);
+    mpp_clock_pause(dec->clocks[DEC_PRS_PROC]);
+
+    return DEC_PARSER_AGAIN;
+}
+
+static void mpp_dec_parser_exit(Mpp *mpp, DecTask *task)
+{
+    MppDecImpl *dec = (MppDecImpl *)mpp->mDec;
+    MppBufSlots packet_slots = dec->packet_slots;
+    HalDecTask  *task_dec = &task->info.dec;
 
     mpp_dbg_info("mpp_dec_parser_thread is going to exit\n");
-    if (task.hnd && task_dec->valid) {
+    /* parsed task on fast mode may not have a hal task handle yet */
+    if (task_dec->valid && task_dec->input >= 0) {
         mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_CODEC_READY);
         mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
         mpp_buf_slot_clr_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
     }
     mpp_buffer_group_clear(mpp->mPacketGroup);
+    dec_release_input_packet(dec, 1);
+    dec_release_input_batch(dec);
     dec_release_task_in_port(mpp->mMppInPort);
     mpp_dbg_info("mpp_dec_parser_thread exited\n");
+}
+
+void *mpp_dec_parser_thread(void *data)
+{
+    Mpp *mpp = (Mpp*)data;
+    MppDecImpl *dec = (MppDecImpl *)mpp->mDec;
+    DecTask task;
+
+    dec_task_init(&task);
+
+    mpp_clock_start(dec->clocks[DEC_PRS_TOTAL]);
+
+    /* only return idle on thread quit */
+    while (DEC_PARSER_IDLE != mpp_dec_parser_proc(mpp, &task, 1));
+
+    mpp_clock_pause(dec->clocks[DEC_PRS_TOTAL]);
+
+    mpp_dec_parser_exit(mpp, &task);
     return NULL;
 }
 
+/* parser loops for one run on shared cluster before yielding to other nodes */
+#define PARSER_NODE_LOOP_MAX    8
+
+/* parser on shared cluster */
+static MPP_RET mpp_dec_parser_work(void *data)
+{
+    Mpp *mpp = (Mpp*)data;
+    MppDecImpl *dec = (MppDecImpl *)mpp->mDec;
+    RK_S32 i;
+
+    mpp_clock_start(dec->clocks[DEC_PRS_TOTAL]);
+
+    /* on idle or defer the node is triggered again by the one it waits for */
+    for (i = 0; i < PARSER_NODE_LOOP_MAX; i++) {
+        if (DEC_PARSER_AGAIN != mpp_dec_parser_proc(mpp, dec->parser_task, 0))
+            break;
+    }
+
+    /* still have work then queue the node again behind other sessions */
+    if (i == PARSER_NODE_LOOP_MAX) {
+        dec->thread_parser->lock();
+        if (dec->parser_node)
+            mpp_node_trigger(dec->parser_node, 1);
+        dec->thread_parser->unlock();
+    }
+
+    mpp_clock_pause(dec->clocks[DEC_PRS_TOTAL]);
+
+    return MPP_OK;
+}
+
 void *mpp_dec_hal_thread(void *data)
 {
     Mpp *mpp = (Mpp*)data;
@@ -785,6 +990,7 @@ void *mpp_dec_hal_thread(void *data)
     HalTaskHnd  task = NULL;
     HalTaskInfo task_info;
     HalDecTask  *task_dec = &task_info.dec;
+    RK_S64 time = 0;
 
     mpp_clock_start(dec->clocks[DEC_HAL_TOTAL]);
 
@@ -803,6 +1009,11 @@ void *mpp_dec_hal_thread(void *data)
                     dec_dbg_reset("reset: hal reset done\n");
                     dec->hal_reset_done++;
                     sem_post(&dec->hal_reset);
+                    /* parser on shared cluster is deferred on hal reset */
+                    dec->thread_parser->lock();
+                    if (dec->parser_node)
+                        mpp_node_trigger(dec->parser_node, 1);
+                    dec->thread_parser->unlock();
                     continue;
                 }
 
@@ -862,9 +1073,13 @@ void *mpp_dec_hal_thread(void *data)
                 continue;
             }
 
+            time = mpp_time();
             mpp_clock_start(dec->clocks[DEC_HW_WAIT]);
             mpp_hal_hw_wait(dec->hal, &task_info);
             mpp_clock_pause(dec->clocks[DEC_HW_WAIT]);
+            mpp_frame_trace_stamp(mpp->mTrace, task_dec->output, MPP_TRACE_HW_DONE);
+            mpp_metrics_time(dec->metrics, MPP_STATS_HW_WAIT_TIME, mpp_time() - time);
+            mpp_metrics_add(dec->metrics, MPP_STATS_HW_RUN, 1);
             dec->dec_hw_run_count++;
 
             /*
@@ -1109,12 +1324,42 @@ void *mpp_dec_advanced_thread(void *data)
     return NULL;
 }
 
+static MPP_RET mpp_dec_start_parser_node(MppDecImpl *dec)
+{
+    MppThread *parser = dec->thread_parser;
+
+    dec->parser_task = mpp_calloc(DecTask, 1);
+    if (NULL == dec->parser_task)
+        return MPP_ERR_MALLOC;
+
+    if (mpp_node_init(&dec->parser_node)) {
+        MPP_FREE(dec->parser_task);
+        return MPP_NOK;
+    }
+
+    dec_task_init(dec->parser_task);
+    mpp_node_set_func(dec->parser_node, mpp_dec_parser_work, dec->mpp);
+
+    /* the thread is not started and only provides lock and status */
+    parser->lock();
+    parser->set_status(MPP_THREAD_RUNNING);
+    parser->unlock();
+
+    return mpp_node_attach(dec->parser_node, MPP_CLUSTER_CPU);
+}
+
 MPP_RET mpp_dec_start_normal(MppDecImpl *dec)
 {
     if (dec->coding != MPP_VIDEO_CodingMJPEG) {
+        RK_U32 parser_pool = 0;
+
+        mpp_env_get_u32("mpp_dec_parser_pool", &parser_pool, 0);
+
         dec->thread_parser = new MppThread(mpp_dec_parser_thread,
                                            dec->mpp, "mpp_dec_parser");
-        dec->thread_parser->start();
+        /* parser runs on shared cpu cluster instead of own thread */
+        if (!parser_pool || mpp_dec_start_parser_node(dec))
+            dec->thread_parser->start();
         dec->thread_hal = new MppThread(mpp_dec_hal_thread,
                                         dec->mpp, "mpp_dec_hal");
 
@@ -1128,6 +1373,40 @@ MPP_RET mpp_dec_start_normal(MppDecImpl *dec)
     return MPP_OK;
 }
 
+MPP_RET mpp_dec_stop_normal(MppDecImpl *dec)
+{
+    MppThread *parser = dec->thread_parser;
+    MppNode node = NULL;
+
+    if (NULL == parser)
+        return MPP_OK;
+
+    /*
+     * hal thread and notify trigger the node under parser lock so clear the
+     * node under the same lock before it is detached and freed
+     */
+    parser->lock();
+    node = dec->parser_node;
+    dec->parser_node = NULL;
+    if (node)
+        parser->set_status(MPP_THREAD_STOPPING);
+    parser->unlock();
+
+    if (NULL == node)
+        return MPP_OK;
+
+    /* node is not running after detach then parser exits on this thread */
+    mpp_node_detach(node);
+    mpp_node_deinit(node);
+
+    mpp_dec_parser_exit((Mpp *)dec->mpp, dec->parser_task);
+    MPP_FREE(dec->parser_task);
+
+    parser->set_status(MPP_THREAD_UNINITED);
+
+    return MPP_OK;
+}
+
 MPP_RET mpp_dec_reset_normal(MppDecImpl *dec)
 {
     MppThread *parser = dec->thread_parser;
@@ -1175,6 +1454,8 @@ MPP_RET mpp_dec_notify_normal(MppDecImpl *dec, RK_U32 flag)
         dec_dbg_notify("%p status %08x notify control signal\n", dec,
                        dec->parser_wait_flag, dec->parser_notify_flag);
         thd_dec->signal();
+        if (dec->parser_node)
+            mpp_node_trigger(dec->parser_node, 1);
     }
     thd_dec->unlock();
 
@@ -1189,13 +1470,17 @@ MPP_RET mpp_dec_control_normal(MppDecImpl *dec, MpiCmd cmd, void *param)
     dec->cmd = cmd;
     dec->param = param;
     dec->cmd_ret = &ret;
+    /*
+     * post start before send count then parser on shared cluster never
+     * finds the command without start and the notify schedules it again
+     */
+    sem_post(&dec->cmd_start);
     dec->cmd_send++;
 
     dec_dbg_detail("detail: %p control cmd %08x param %p start disable_thread %d \n",
                    dec, cmd, param, dec->cfg.base.disable_thread);
 
     mpp_dec_notify_normal(dec, MPP_DEC_CONTROL);
-    sem_post(&dec->cmd_start);
     sem_wait(&dec->cmd_done);
 
     return ret;
@@ -1203,7 +1488,7 @@ MPP_RET mpp_dec_control_normal(MppDecImpl *dec, MpiCmd cmd, void *param)
 
 MppDecModeApi dec_api_normal = {
     mpp_dec_start_normal,
-    NULL,
+    mpp_dec_stop_normal,
     mpp_dec_reset_normal,
     mpp_dec_notify_normal,
     mpp_dec_control_normal,
@@ -686,6 +686,9 @@ MPP_RET mpp_enc_proc_rc_cfg(MppCodingType coding, MppEncRcCfg *dst, MppEncRcCfg
         if (change & MPP_ENC_RC_CFG_CHANGE_QPDD)
             dst->cu_qp_delta_depth = src->cu_qp_delta_depth;
 
+        if (change & MPP_ENC_RC_CFG_CHANGE_LOOKAHEAD)
+            dst->lookahead = src->lookahead;
+
         // parameter checking
         if (dst->rc_mode >= MPP_ENC_RC_MODE_BUTT) {
             mpp_err("invalid rc mode %d should be RC_MODE_VBR or RC_MODE_CBR\n",
@@ -767,6 +770,11 @@ MPP_RET mpp_enc_proc_rc_cfg(MppCodingType coding, MppEncRcCfg *dst, MppEncRcCfg
                     dst->qp_max_step, bak.qp_max_step);
             dst->qp_max_step = bak.qp_max_step;
         }
+        if (dst->lookahead < 0 || dst->lookahead > RC_LOOKAHEAD_MAX) {
+            mpp_err("invalid lookahead %d restore to %d\n",
+                    dst->lookahead, bak.lookahead);
+            dst->lookahead = bak.lookahead;
+        }
         if (dst->stats_time && dst->stats_time > 60) {
             mpp_err("warning: bitrate statistic time %d is larger than 60s\n",
                     dst->stats_time);
@@ -1793,6 +1801,7 @@ static MPP_RET mpp_enc_normal(Mpp *mpp, EncAsyncTaskInfo *task)
     EncFrmStatus *frm = &rc_task->frm;
     HalEncTask *hal_task = &task->task;
     MPP_RET ret = MPP_OK;
+    RK_S64 time = 0;
     EncAsyncStatus *status = &task->status;
 
     if (enc->support_hw_deflicker && enc->cfg.rc.debreath_en) {
@@ -1825,6 +1834,7 @@ static MPP_RET mpp_enc_normal(Mpp *mpp, EncAsyncTaskInfo *task)
     enc_dbg_detail("task %d enc proc dpb\n", frm->seq_idx);
     mpp_enc_refs_get_cpb(enc->refs, cpb);
 
+    time = mpp_time();
     enc_dbg_frm_status("frm %d start ***********************************\n", cpb->curr.seq_idx);
     ENC_RUN_FUNC2(enc_impl_proc_dpb, impl, hal_task, mpp, ret);
 
@@ -1840,6 +1850,7 @@ static MPP_RET mpp_enc_normal(Mpp *mpp, EncAsyncTaskInfo *task)
 
     enc_dbg_detail("task %d rc frame start\n", frm->seq_idx);
     ENC_RUN_FUNC2(rc_frm_start, enc->rc_ctx, rc_task, mpp, ret);
+    mpp_frame_trace_stamp(mpp->mTrace, frm->seq_idx, MPP_TRACE_PARSE);
 
     // 16. generate header before hardware stream
     mpp_enc_add_sw_header(enc, hal_task);
@@ -1852,17 +1863,25 @@ static MPP_RET mpp_enc_normal(Mpp *mpp, EncAsyncTaskInfo *task)
 
     enc_dbg_detail("task %d rc hal start\n", frm->seq_idx);
     ENC_RUN_FUNC2(rc_hal_start, enc->rc_ctx, rc_task, mpp, ret);
+    mpp_frame_trace_stamp(mpp->mTrace, frm->seq_idx, MPP_TRACE_READY);
 
     enc_dbg_detail("task %d hal generate reg\n", frm->seq_idx);
     ENC_RUN_FUNC2(mpp_enc_hal_gen_regs, hal, hal_task, mpp, ret);
+    mpp_frame_trace_stamp(mpp->mTrace, frm->seq_idx, MPP_TRACE_REG_GEN);
+    mpp_metrics_time(enc->metrics, MPP_STATS_PARSE_TIME, mpp_time() - time);
 
     hal_task->segment_nb = mpp_packet_get_segment_nb(hal_task->packet);
     mpp_stopwatch_record(hal_task->stopwatch, "encode hal start");
     enc_dbg_detail("task %d hal start\n", frm->seq_idx);
     ENC_RUN_FUNC2(mpp_enc_hal_start, hal, hal_task, mpp, ret);
+    mpp_frame_trace_stamp(mpp->mTrace, frm->seq_idx, MPP_TRACE_HW_START);
 
+    time = mpp_time();
     enc_dbg_detail("task %d hal wait\n", frm->seq_idx);
     ENC_RUN_FUNC2(mpp_enc_hal_wait,  hal, hal_task, mpp, ret);
+    mpp_frame_trace_stamp(mpp->mTrace, frm->seq_idx, MPP_TRACE_HW_DONE);
+    mpp_metrics_time(enc->metrics, MPP_STATS_HW_WAIT_TIME, mpp_time() - time);
+    mpp_metrics_add(enc->metrics, MPP_STATS_HW_RUN, 1);
 
     mpp_stopwatch_record(hal_task->stopwatch, "encode hal finish");
 
@@ -2038,6 +2057,7 @@ static void mpp_enc_terminate_task(MppEncImpl *enc, EncAsyncTaskInfo *task)
 
 static MPP_RET try_get_enc_task(MppEncImpl *enc, EncAsyncTaskInfo *task, EncAsyncWait *wait)
 {
+    Mpp *mpp = (Mpp *)enc->mpp;
     EncRcTask *rc_task = &task->rc;
     EncFrmStatus *frm = &rc_task->frm;
     MppEncRefFrmUsrCfg *frm_cfg = &task->usr;
@@ -2125,6 +2145,7 @@ static MPP_RET try_get_enc_task(MppEncImpl *enc, EncAsyncTaskInfo *task, EncAsyn
         hal_task->stopwatch = stopwatch;
 
         frm->seq_idx = task->seq_idx++;
+        mpp_frame_trace_start(mpp->mTrace, frm->seq_idx, 1);
         rc_task->frame = enc->frame;
         enc_dbg_detail("task seq idx %d start\n", frm->seq_idx);
     }
@@ -2133,6 +2154,7 @@ static MPP_RET try_get_enc_task(MppEncImpl *enc, EncAsyncTaskInfo *task, EncAsyn
     if (!status->rc_check_frm_drop) {
         ENC_RUN_FUNC2(rc_frm_check_drop, enc->rc_ctx, rc_task, enc->mpp, ret);
         status->rc_check_frm_drop = 1;
+        mpp_frame_trace_stamp(mpp->mTrace, frm->seq_idx, MPP_TRACE_PREPARE);
         enc_dbg_detail("task %d drop %d\n", frm->seq_idx, frm->drop);
 
         hal_task->valid = 1;
@@ -2160,6 +2182,7 @@ static MPP_RET try_get_enc_task(MppEncImpl *enc, EncAsyncTaskInfo *task, EncAsyn
     if (!status->pkt_buf_rdy) {
         mpp_enc_check_pkt_buf(enc);
         status->pkt_buf_rdy = 1;
+        mpp_frame_trace_stamp(mpp->mTrace, frm->seq_idx, MPP_TRACE_SLOT);
 
         hal_task->output = enc->pkt_buf;
     }
@@ -2265,6 +2288,7 @@ static MPP_RET try_proc_low_deley_task(Mpp *mpp, EncAsyncTaskInfo *task, EncAsyn
 
     enc_dbg_detail("task %d rc frame start\n", frm->seq_idx);
     ENC_RUN_FUNC2(rc_frm_start, enc->rc_ctx, rc_task, mpp, ret);
+    mpp_frame_trace_stamp(mpp->mTrace, frm->seq_idx, MPP_TRACE_PARSE);
 
     // 16. generate header before hardware stream
     mpp_enc_add_sw_header(enc, hal_task);
@@ -2277,9 +2301,11 @@ static MPP_RET try_proc_low_deley_task(Mpp *mpp, EncAsyncTaskInfo *task, EncAsyn
 
     enc_dbg_detail("task %d rc hal start\n", frm->seq_idx);
     ENC_RUN_FUNC2(rc_hal_start, enc->rc_ctx, rc_task, mpp, ret);
+    mpp_frame_trace_stamp(mpp->mTrace, frm->seq_idx, MPP_TRACE_READY);
 
     enc_dbg_detail("task %d hal generate reg\n", frm->seq_idx);
     ENC_RUN_FUNC2(mpp_enc_hal_gen_regs, hal, hal_task, mpp, ret);
+    mpp_frame_trace_stamp(mpp->mTrace, frm->seq_idx, MPP_TRACE_REG_GEN);
 
     hal_task->part_first = 0;
     hal_task->part_last = 0;
@@ -2358,6 +2384,7 @@ static MPP_RET try_proc_low_deley_task(Mpp *mpp, EncAsyncTaskInfo *task, EncAsyn
             hal_task->part_count++;
         }
     } while (!hal_task->part_last);
+    mpp_frame_trace_stamp(mpp->mTrace, frm->seq_idx, MPP_TRACE_HW_DONE);
 
 TASK_DONE:
     /* output last task */
@@ -2393,6 +2420,8 @@ TASK_DONE:
                        frm->seq_idx, enc->task_pts, hal_task->part_count);
         mpp_task_meta_set_packet(enc->task_out, KEY_OUTPUT_PACKET, packet);
         mpp_port_enqueue(enc->output, enc->task_out);
+        mpp_frame_trace_commit(mpp->mTrace, frm->seq_idx, enc->task_pts);
+        mpp_metrics_add(enc->metrics, MPP_STATS_PKT_OUT, 1);
         enc->task_out = NULL;
         hal_task->part_count = 0;
     }
@@ -2494,6 +2523,7 @@ static MPP_RET try_proc_normal_task(MppEncImpl *enc, EncAsyncTaskInfo *task)
 
     // 18. drop, force pskip and reencode  process
     while (frm->reencode && frm->reencode_times < enc->cfg.rc.max_reenc_times) {
+        mpp_metrics_add(enc->metrics, MPP_STATS_REENC, 1);
         hal_task->length -= hal_task->hw_length;
         hal_task->hw_length = 0;
 
@@ -2552,6 +2582,11 @@ TASK_DONE:
 
     mpp_task_meta_set_packet(enc->task_out, KEY_OUTPUT_PACKET, packet);
     mpp_port_enqueue(enc->output, enc->task_out);
+    mpp_frame_trace_commit(mpp->mTrace, frm->seq_idx, enc->task_pts);
+    mpp_metrics_add(enc->metrics, MPP_STATS_PKT_OUT, 1);
+    if (mpp->mPacketGroup)
+        mpp_metrics_max(enc->metrics, MPP_STATS_BUF_HIGH_WATER,
+                        mpp_buffer_group_usage(mpp->mPacketGroup));
 
     enc_dbg_detail("task %d enqueue frame pts %lld\n", frm->seq_idx, enc->task_pts);
 
@@ -2720,17 +2755,13 @@ static void async_task_terminate(MppEncImpl *enc, EncAsyncTaskInfo *async)
     async_task_reset(async);
 }
 
-static void async_task_skip(MppEncImpl *enc)
+static void async_task_skip(MppEncImpl *enc, MppFrame frm)
 {
     Mpp *mpp = (Mpp*)enc->mpp;
     MppStopwatch stopwatch = NULL;
     MppMeta meta = NULL;
-    MppFrame frm = NULL;
     MppPacket pkt = NULL;
 
-    mpp->mFrmIn->del_at_head(&frm, sizeof(frm));
-    mpp->mFrameGetCount++;
-
     mpp_assert(frm);
 
     enc_dbg_detail("skip input frame start\n");
@@ -2849,6 +2880,114 @@ static MPP_RET check_async_pkt_buf(MppEncImpl *enc, EncAsyncTaskInfo *async)
     return MPP_OK;
 }
 
+static MppFrame async_get_input_frame(MppEncImpl *enc)
+{
+    Mpp *mpp = (Mpp *)enc->mpp;
+    mpp_list *frm_in = mpp->mFrmIn;
+    MppFrame frame = NULL;
+    AutoMutex autolock(frm_in->mutex());
+
+    if (frm_in->list_size()) {
+        frm_in->del_at_head(&frame, sizeof(frame));
+        frm_in->signal();
+        mpp->mFrameGetCount++;
+
+        mpp_assert(frame);
+    }
+
+    return frame;
+}
+
+static MppFrame async_get_lookahead_frame(MppEncImpl *enc, EncRcTaskInfo *info)
+{
+    RcLookahead la = enc->lookahead;
+    MppFrame frame = NULL;
+
+    /* analysis is done out of input list lock */
+    while (rc_lookahead_need_frame(la)) {
+        frame = async_get_input_frame(enc);
+        if (NULL == frame)
+            break;
+
+        rc_lookahead_push(la, frame);
+    }
+
+    frame = NULL;
+    rc_lookahead_pop(la, &frame, info);
+
+    return frame;
+}
+
+static void async_lookahead_update(MppEncImpl *enc)
+{
+    RK_S32 depth = enc->cfg.rc.lookahead;
+
+    if (depth && NULL == enc->lookahead)
+        rc_lookahead_init(&enc->lookahead);
+
+    if (enc->lookahead)
+        rc_lookahead_set_depth(enc->lookahead, depth);
+
+    /*
+     * The delayed rc feedback only runs with look-ahead on multi-task
+     * encoding. The queue is empty here as it is flushed on sync point.
+     */
+    if (depth && enc->task_cnt > 1 && NULL == enc->rc_fb) {
+        enc->rc_fb = mpp_calloc(EncRcFeedback, enc->task_cnt);
+        if (NULL == enc->rc_fb)
+            mpp_err_f("failed to malloc rc feedback queue\n");
+    } else if (!depth && enc->rc_fb) {
+        MPP_FREE(enc->rc_fb);
+    }
+
+    enc->rc_fb_rd = 0;
+    enc->rc_fb_cnt = 0;
+}
+
+/*
+ * Apply the rc feedback of finished tasks in encoding order. The task with
+ * seq_idx only sees the feedback of the tasks task_cnt frames before it so the
+ * rc result does not depend on which core finishes first or when the input
+ * frame comes. Flush applies all queued feedback on sync point.
+ */
+static void async_rc_fb_apply(MppEncImpl *enc, RK_U32 seq_idx, RK_S32 flush)
+{
+    while (enc->rc_fb_cnt) {
+        EncRcFeedback *fb = &enc->rc_fb[enc->rc_fb_rd];
+
+        if (!flush && (RK_S32)(seq_idx - fb->seq_idx) < enc->task_cnt)
+            break;
+
+        enc_dbg_detail("task %d rc feedback on task %d\n", fb->seq_idx, seq_idx);
+        rc_hal_end(enc->rc_ctx, &fb->rc);
+        rc_frm_end(enc->rc_ctx, &fb->rc);
+        enc->rc_rt_bits = fb->rc.info.rt_bits;
+
+        enc->rc_fb_rd = (enc->rc_fb_rd + 1) % enc->task_cnt;
+        enc->rc_fb_cnt--;
+    }
+}
+
+static void async_rc_fb_push(MppEncImpl *enc, RK_U32 seq_idx, EncRcTask *rc_task)
+{
+    EncRcFeedback *fb = NULL;
+
+    /* tasks finish in order so the queue never holds more than task_cnt */
+    if (enc->rc_fb_cnt >= enc->task_cnt) {
+        mpp_err_f("rc feedback queue overflow on task %d\n", seq_idx);
+        async_rc_fb_apply(enc, seq_idx, 1);
+    }
+
+    fb = &enc->rc_fb[(enc->rc_fb_rd + enc->rc_fb_cnt) % enc->task_cnt];
+    fb->seq_idx = seq_idx;
+    fb->rc = *rc_task;
+    /* input frame may be released before the feedback is applied */
+    fb->rc.frame = NULL;
+    enc->rc_fb_cnt++;
+
+    rc_task->info.rt_bits = enc->rc_rt_bits;
+}
+
 static MPP_RET try_get_async_task(MppEncImpl *enc, EncAsyncWait *wait)
 {
     Mpp *mpp = (Mpp *)enc->mpp;
@@ -2891,16 +3030,12 @@ static MPP_RET try_get_async_task(MppEncImpl *enc, EncAsyncWait *wait)
 
     if (NULL == frame) {
         if (mpp->mFrmIn) {
-            mpp_list *frm_in = mpp->mFrmIn;
-            AutoMutex autolock(frm_in->mutex());
-
-            if (frm_in->list_size()) {
-                frm_in->del_at_head(&frame, sizeof(frame));
-                frm_in->signal();
-                mpp->mFrameGetCount++;
-
-                mpp_assert(frame);
+            if (enc->lookahead)
+                frame = async_get_lookahead_frame(enc, &rc_task->info);
+            else
+                frame = async_get_input_frame(enc);
 
+            if (frame) {
                 status->task_in_rdy = 1;
                 wait->enc_frm_in = 0;
 
@@ -2947,6 +3082,7 @@ static MPP_RET try_get_async_task(MppEncImpl *enc, EncAsyncWait *wait)
      */
     if (!status->frm_pkt_rdy) {
         async->seq_idx = enc->task_idx++;
+        mpp_frame_trace_start(mpp->mTrace, async->seq_idx, 1);
         async->pts = mpp_frame_get_pts(hal_task->frame);
 
         hal_task->stopwatch = stopwatch;
@@ -2975,6 +3111,7 @@ static MPP_RET try_get_async_task(MppEncImpl *enc, EncAsyncWait *wait)
 
         ENC_RUN_FUNC2(rc_frm_check_drop, enc->rc_ctx, rc_task, enc->mpp, ret);
         status->rc_check_frm_drop = 1;
+        mpp_frame_trace_stamp(mpp->mTrace, seq_idx, MPP_TRACE_PREPARE);
         enc_dbg_detail("task %d drop %d\n", seq_idx, frm->drop);
 
         // when the frame should be dropped just return empty packet
@@ -2998,6 +3135,7 @@ static MPP_RET try_get_async_task(MppEncImpl *enc, EncAsyncWait *wait)
     if (!status->pkt_buf_rdy) {
         check_async_pkt_buf(enc, async);
         status->pkt_buf_rdy = 1;
+        mpp_frame_trace_stamp(mpp->mTrace, seq_idx, MPP_TRACE_SLOT);
 
         enc_dbg_detail("task %d check pkt buffer success\n", seq_idx);
     }
@@ -3100,12 +3238,16 @@ static MPP_RET proc_async_task(MppEncImpl *enc, EncAsyncWait *wait)
     EncFrmStatus *frm = &rc_task->frm;
     RK_U32 seq_idx = async->seq_idx;
     MPP_RET ret = MPP_OK;
+    RK_S64 time = 0;
 
     mpp_assert(hal_task->valid);
 
     if (hal_task->flags.drop_by_fps)
         goto SEND_TASK_INFO;
 
+    if (enc->rc_fb)
+        async_rc_fb_apply(enc, seq_idx, 0);
+
     if (!status->check_frm_pskip) {
         RK_S32 force_pskip = 0;
         status->check_frm_pskip = 1;
@@ -3133,6 +3275,8 @@ static MPP_RET proc_async_task(MppEncImpl *enc, EncAsyncWait *wait)
         if (two_pass_en) {
             /* wait all tasks done */
             while (MPP_OK == try_proc_processing_task(enc, wait));
+            if (enc->rc_fb)
+                async_rc_fb_apply(enc, seq_idx, 1);
 
             ret = mpp_enc_proc_two_pass(mpp, async);
             if (ret)
@@ -3143,11 +3287,13 @@ static MPP_RET proc_async_task(MppEncImpl *enc, EncAsyncWait *wait)
     enc_dbg_detail("task %d enc proc dpb\n", seq_idx);
     mpp_enc_refs_get_cpb(enc->refs, cpb);
 
+    time = mpp_time();
     enc_dbg_frm_status("frm %d start ***********************************\n", seq_idx);
     ENC_RUN_FUNC2(enc_impl_proc_dpb, impl, hal_task, mpp, ret);
 
     enc_dbg_detail("task %d rc frame start\n", frm->seq_idx);
     ENC_RUN_FUNC2(rc_frm_start, enc->rc_ctx, rc_task, mpp, ret);
+    mpp_frame_trace_stamp(mpp->mTrace, seq_idx, MPP_TRACE_PARSE);
 
     // 16. generate header before hardware stream
     mpp_enc_add_sw_header(enc, hal_task);
@@ -3160,13 +3306,17 @@ static MPP_RET proc_async_task(MppEncImpl *enc, EncAsyncWait *wait)
 
     enc_dbg_detail("task %d rc hal start\n", frm->seq_idx);
     ENC_RUN_FUNC2(rc_hal_start, enc->rc_ctx, rc_task, mpp, ret);
+    mpp_frame_trace_stamp(mpp->mTrace, seq_idx, MPP_TRACE_READY);
 
     enc_dbg_detail("task %d hal generate reg\n", frm->seq_idx);
     ENC_RUN_FUNC2(mpp_enc_hal_gen_regs, hal, hal_task, mpp, ret);
+    mpp_frame_trace_stamp(mpp->mTrace, seq_idx, MPP_TRACE_REG_GEN);
+    mpp_metrics_time(enc->metrics, MPP_STATS_PARSE_TIME, mpp_time() - time);
 
     mpp_stopwatch_record(hal_task->stopwatch, "encode hal start");
     enc_dbg_detail("task %d hal start\n", frm->seq_idx);
     ENC_RUN_FUNC2(mpp_enc_hal_start, hal, hal_task, mpp, ret);
+    mpp_frame_trace_stamp(mpp->mTrace, seq_idx, MPP_TRACE_HW_START);
 
 SEND_TASK_INFO:
     status->enc_done = 0;
@@ -3234,23 +3384,35 @@ static MPP_RET enc_async_wait_task(MppEncImpl *enc, EncAsyncTaskInfo *info)
     EncFrmStatus *frm = &info->rc.frm;
     MppPacket pkt = hal_task->packet;
     MPP_RET ret = MPP_OK;
+    RK_S64 time = 0;
 
     if (hal_task->flags.drop_by_fps || hal_task->frm_cfg->force_pskip)
         goto TASK_DONE;
 
+    time = mpp_time();
     enc_dbg_detail("task %d hal wait\n", frm->seq_idx);
     ENC_RUN_FUNC2(mpp_enc_hal_wait, hal, hal_task, mpp, ret);
+    mpp_frame_trace_stamp(mpp->mTrace, info->seq_idx, MPP_TRACE_HW_DONE);
+    mpp_metrics_time(enc->metrics, MPP_STATS_HW_WAIT_TIME, mpp_time() - time);
+    mpp_metrics_add(enc->metrics, MPP_STATS_HW_RUN, 1);
 
     mpp_stopwatch_record(hal_task->stopwatch, "encode hal finish");
 
-    enc_dbg_detail("task %d rc hal end\n", frm->seq_idx);
-    ENC_RUN_FUNC2(rc_hal_end, enc->rc_ctx, rc_task, mpp, ret);
+    if (!enc->rc_fb) {
+        enc_dbg_detail("task %d rc hal end\n", frm->seq_idx);
+        ENC_RUN_FUNC2(rc_hal_end, enc->rc_ctx, rc_task, mpp, ret);
+    }
 
     enc_dbg_detail("task %d hal ret task\n", frm->seq_idx);
     ENC_RUN_FUNC2(mpp_enc_hal_ret_task, hal, hal_task, mpp, ret);
 
-    enc_dbg_detail("task %d rc frame end\n", frm->seq_idx);
-    ENC_RUN_FUNC2(rc_frm_end, enc->rc_ctx, rc_task, mpp, ret);
+    if (enc->rc_fb) {
+        enc_dbg_detail("task %d rc feedback queued\n", frm->seq_idx);
+        async_rc_fb_push(enc, info->seq_idx, rc_task);
+    } else {
+        enc_dbg_detail("task %d rc frame end\n", frm->seq_idx);
+        ENC_RUN_FUNC2(rc_frm_end, enc->rc_ctx, rc_task, mpp, ret);
+    }
 
 TASK_DONE:
     if (!mpp_packet_is_partition(pkt)) {
@@ -3290,6 +3452,8 @@ TASK_DONE:
         AutoMutex autoLock(pkt_out->mutex());
 
         pkt_out->add_at_tail(&pkt, sizeof(pkt));
+        mpp_frame_trace_commit(mpp->mTrace, info->seq_idx, info->pts);
+        mpp_metrics_add(enc->metrics, MPP_STATS_PKT_OUT, 1);
         mpp->mPacketPutCount++;
         pkt_out->signal();
     }
@@ -3334,6 +3498,8 @@ void *mpp_enc_async_thread(void *data)
 
             // wait all tasks done
             while (MPP_OK == try_proc_processing_task(enc, &wait));
+            if (enc->rc_fb)
+                async_rc_fb_apply(enc, 0, 1);
 
             if (enc->cmd_send != enc->cmd_recv) {
                 sem_wait(&enc->cmd_start);
@@ -3354,15 +3520,28 @@ void *mpp_enc_async_thread(void *data)
 
                 /* NOTE: here will clear change flag of rc and prep cfg */
                 mpp_enc_proc_rc_update(enc);
+                async_lookahead_update(enc);
                 goto SYNC_DONE;
             }
 
             if (enc->reset_flag) {
                 enc_dbg_detail("thread reset start\n");
 
-                /* skip the frames in input queue */
-                while (frm_in->list_size())
-                    async_task_skip(enc);
+                /* skip the frames in look-ahead window and input queue */
+                if (enc->lookahead) {
+                    MppFrame frm = NULL;
+
+                    while (MPP_OK == rc_lookahead_flush(enc->lookahead, &frm))
+                        async_task_skip(enc, frm);
+                }
+
+                while (frm_in->list_size()) {
+                    MppFrame frm = NULL;
+
+                    frm_in->del_at_head(&frm, sizeof(frm));
+                    mpp->mFrameGetCount++;
+                    async_task_skip(enc, frm);
+                }
 
                 {
                     AutoMutex autolock(thd_enc->mutex());
@@ -3398,6 +3577,16 @@ void *mpp_enc_async_thread(void *data)
     }
     /* wait all task done */
     while (MPP_OK == try_proc_processing_task(enc, &wait));
+    if (enc->rc_fb)
+        async_rc_fb_apply(enc, 0, 1);
+
+    /* return the frames held in look-ahead window */
+    if (enc->lookahead) {
+        MppFrame frm = NULL;
+
+        while (MPP_OK == rc_lookahead_flush(enc->lookahead, &frm))
+            async_task_skip(enc, frm);
+    }
 
     enc_dbg_func("thread finish\n");
 
@@ -107,7 +107,9 @@ MPP_RET mpp_enc_init_v2(MppEnc *enc, MppEncInitCfg *cfg)
     p->enc_hal  = enc_hal;
     p->dev      = enc_hal_cfg.dev;
     p->mpp      = cfg->mpp;
+    p->metrics  = ((Mpp *)cfg->mpp)->mMetrics;
     p->tasks    = enc_hal_cfg.tasks;
+    p->task_cnt = cfg->task_cnt;
     p->sei_mode = MPP_ENC_SEI_MODE_ONE_SEQ;
     p->version_info = get_mpp_version();
     p->version_length = strlen(p->version_info);
@@ -195,6 +197,13 @@ MPP_RET mpp_enc_deinit_v2(MppEnc ctx)
         enc->rc_ctx = NULL;
     }
 
+    if (enc->lookahead) {
+        rc_lookahead_deinit(enc->lookahead);
+        enc->lookahead = NULL;
+    }
+
+    MPP_FREE(enc->rc_fb);
+
     MPP_FREE(enc->rc_cfg_info);
     enc->rc_cfg_size = 0;
     enc->rc_cfg_length = 0;
@@ -0,0 +1,272 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "rc_lookahead"
+
+#include <string.h>
+
+#include "mpp_mem.h"
+#include "mpp_common.h"
+#include "mpp_buffer.h"
+
+#include "rc_debug.h"
+#include "rc_lookahead.h"
+
+#define LA_BLK_SIZE             16
+#define LA_SMP_STEP             4
+#define LA_SMP_CNT              ((LA_BLK_SIZE / LA_SMP_STEP) * (LA_BLK_SIZE / LA_SMP_STEP))
+#define LA_WIN_SIZE             (RC_LOOKAHEAD_MAX + 1)
+
+typedef struct RcLaFrame_t {
+    MppFrame        frame;
+    RK_S32          cost;
+} RcLaFrame;
+
+typedef struct RcLookaheadImpl_t {
+    RK_S32          depth;
+
+    /* frame window in input order */
+    RcLaFrame       win[LA_WIN_SIZE];
+    RK_S32          rd;
+    RK_S32          count;
+    RK_S32          eos_cnt;
+
+    /* luma samples of the previous analysed frame */
+    RK_U8           *prev;
+    RK_S32          prev_size;
+    RK_S32          prev_valid;
+} RcLookaheadImpl;
+
+static RK_S32 la_fmt_support(MppFrameFormat fmt)
+{
+    MppFrameFormat base = (MppFrameFormat)(fmt & MPP_FRAME_FMT_MASK);
+
+    if (!MPP_FRAME_FMT_IS_YUV(fmt) || MPP_FRAME_FMT_IS_YUV_10BIT(fmt) ||
+        MPP_FRAME_FMT_IS_FBC(fmt) || MPP_FRAME_FMT_IS_TILE(fmt))
+        return 0;
+
+    /* luma of packed yuv422 is interleaved with chroma */
+    if (base >= MPP_FMT_YUV422_YUYV && base <= MPP_FMT_YUV422_VYUY)
+        return 0;
+
+    return 1;
+}
+
+static RK_S32 la_frame_cost(RcLookaheadImpl *p, MppFrame frame)
+{
+    MppBuffer buf = mpp_frame_get_buffer(frame);
+    RK_S32 stride = mpp_frame_get_hor_stride(frame);
+    RK_S32 blk_w = mpp_frame_get_width(frame) / LA_BLK_SIZE;
+    RK_S32 blk_h = mpp_frame_get_height(frame) / LA_BLK_SIZE;
+    RK_S32 size = blk_w * blk_h * LA_SMP_CNT;
+    RK_U8 *src = NULL;
+    RK_U8 *prev = NULL;
+    RK_S64 total = 0;
+    RK_S32 bx, by;
+
+    if (NULL == buf || !la_fmt_support(mpp_frame_get_fmt(frame)) || !size)
+        goto FAILED;
+
+    src = (RK_U8 *)mpp_buffer_get_ptr(buf);
+    if (NULL == src)
+        goto FAILED;
+
+    src += mpp_frame_get_offset_y(frame) * stride + mpp_frame_get_offset_x(frame);
+
+    if (size != p->prev_size) {
+        MPP_FREE(p->prev);
+        p->prev = mpp_malloc(RK_U8, size);
+        p->prev_size = p->prev ? size : 0;
+        p->prev_valid = 0;
+        if (NULL == p->prev)
+            goto FAILED;
+    }
+
+    mpp_buffer_sync_ro_begin(buf);
+
+    prev = p->prev;
+    for (by = 0; by < blk_h; by++) {
+        RK_U8 *row = src + by * LA_BLK_SIZE * stride + LA_SMP_STEP / 2 * (stride + 1);
+
+        for (bx = 0; bx < blk_w; bx++, prev += LA_SMP_CNT) {
+            RK_U8 smp[LA_SMP_CNT];
+            RK_S32 intra = 0;
+            RK_S32 inter = 0;
+            RK_S32 mean = 0;
+            RK_S32 i, j, k;
+
+            for (j = 0, k = 0; j < LA_BLK_SIZE; j += LA_SMP_STEP) {
+                RK_U8 *pix = row + j * stride + bx * LA_BLK_SIZE;
+
+                for (i = 0; i < LA_BLK_SIZE; i += LA_SMP_STEP, k++) {
+                    smp[k] = pix[i];
+                    mean += smp[k];
+                }
+            }
+
+            mean = (mean + LA_SMP_CNT / 2) / LA_SMP_CNT;
+
+            for (k = 0; k < LA_SMP_CNT; k++) {
+                intra += MPP_ABS(smp[k] - mean);
+                inter += MPP_ABS(smp[k] - prev[k]);
+            }
+
+            total += (p->prev_valid) ? MPP_MIN(intra, inter) : intra;
+            memcpy(prev, smp, sizeof(smp));
+        }
+    }
+
+    mpp_buffer_sync_ro_end(buf);
+
+    p->prev_valid = 1;
+
+    /* scale 16 sum per block with one offset to keep zero for invalid cost */
+    return (RK_S32)((total << 4) / (blk_w * blk_h)) + 1;
+
+FAILED:
+    p->prev_valid = 0;
+    return 0;
+}
+
+MPP_RET rc_lookahead_init(RcLookahead *ctx)
+{
+    RcLookaheadImpl *p = NULL;
+
+    if (NULL == ctx) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    p = mpp_calloc(RcLookaheadImpl, 1);
+    *ctx = p;
+
+    if (NULL == p) {
+        mpp_err_f("failed to malloc context\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    return MPP_OK;
+}
+
+MPP_RET rc_lookahead_deinit(RcLookahead ctx)
+{
+    RcLookaheadImpl *p = (RcLookaheadImpl *)ctx;
+
+    if (NULL == p)
+        return MPP_OK;
+
+    /* frames should be flushed by encoder before deinit */
+    if (p->count)
+        mpp_err_f("found %d frames left in window\n", p->count);
+
+    while (p->count) {
+        MppFrame frame = NULL;
+
+        rc_lookahead_flush(p, &frame);
+        mpp_frame_deinit(&frame);
+    }
+
+    MPP_FREE(p->prev);
+    mpp_free(p);
+
+    return MPP_OK;
+}
+
+MPP_RET rc_lookahead_set_depth(RcLookahead ctx, RK_S32 depth)
+{
+    RcLookaheadImpl *p = (RcLookaheadImpl *)ctx;
+
+    if (NULL == p || depth < 0 || depth > RC_LOOKAHEAD_MAX) {
+        mpp_err_f("invalid ctx %p depth %d\n", p, depth);
+        return MPP_ERR_VALUE;
+    }
+
+    p->depth = depth;
+    return MPP_OK;
+}
+
+RK_S32 rc_lookahead_need_frame(RcLookahead ctx)
+{
+    RcLookaheadImpl *p = (RcLookaheadImpl *)ctx;
+
+    return !p->eos_cnt && p->count <= p->depth;
+}
+
+MPP_RET rc_lookahead_push(RcLookahead ctx, MppFrame frame)
+{
+    RcLookaheadImpl *p = (RcLookaheadImpl *)ctx;
+    RcLaFrame *slot = NULL;
+
+    if (p->count >= LA_WIN_SIZE) {
+        mpp_err_f("window overflow with %d frames\n", p->count);
+        return MPP_NOK;
+    }
+
+    slot = &p->win[(p->rd + p->count) % LA_WIN_SIZE];
+    slot->frame = frame;
+    slot->cost = 0;
+
+    if (p->depth)
+        slot->cost = la_frame_cost(p, frame);
+    else
+        p->prev_valid = 0;
+
+    if (mpp_frame_get_eos(frame))
+        p->eos_cnt++;
+
+    p->count++;
+
+    rc_dbg_rc("push frame %p cost %d count %d\n", frame, slot->cost, p->count);
+
+    return MPP_OK;
+}
+
+MPP_RET rc_lookahead_pop(RcLookahead ctx, MppFrame *frame, EncRcTaskInfo *info)
+{
+    RcLookaheadImpl *p = (RcLookaheadImpl *)ctx;
+    RcLaFrame *slot = &p->win[p->rd];
+    RK_S64 sum = 0;
+    RK_S32 cnt = 0;
+    RK_S32 i;
+
+    if (!p->count || (!p->eos_cnt && p->count <= p->depth))
+        return MPP_NOK;
+
+    for (i = 0; i < p->count; i++) {
+        RcLaFrame *f = &p->win[(p->rd + i) % LA_WIN_SIZE];
+
+        if (f->cost) {
+            sum += f->cost;
+            cnt++;
+        }
+    }
+
+    info->la_cost = slot->cost;
+    info->la_cost_avg = (slot->cost && cnt) ? (RK_S32)(sum / cnt) : 0;
+
+    rc_dbg_rc("pop frame %p cost %d avg %d in %d frames\n", slot->frame,
+              info->la_cost, info->la_cost_avg, p->count);
+
+    return rc_lookahead_flush(p, frame);
+}
+
+MPP_RET rc_lookahead_flush(RcLookahead ctx, MppFrame *frame)
+{
+    RcLookaheadImpl *p = (RcLookaheadImpl *)ctx;
+    RcLaFrame *slot = &p->win[p->rd];
+
+    if (!p->count)
+        return MPP_NOK;
+
+    *frame = slot->frame;
+    if (mpp_frame_get_eos(slot->frame))
+        p->eos_cnt--;
+
+    slot->frame = NULL;
+    p->rd = (p->rd + 1) % LA_WIN_SIZE;
+    p->count--;
+
+    return MPP_OK;
+}
@@ -1379,6 +1379,31 @@ MPP_RET rc_model_v2_deinit(void *ctx)
     return MPP_OK;
 }
 
+/*
+ * Scale P frame target bits by the look-ahead complexity of the frame against
+ * the mean of the window. The mean of the scaled targets over the window stays
+ * at the model target so the long term bitrate is kept by the bps and water
+ * level feedback while the qp does not react to the complexity change that
+ * has been allocated ahead.
+ */
+static void bits_model_lookahead(EncRcTaskInfo *info)
+{
+    RK_S32 ratio;
+
+    if (!info->la_cost || !info->la_cost_avg ||
+        info->frame_type != INTER_P_FRAME)
+        return;
+
+    ratio = (RK_S64)info->la_cost * 256 / info->la_cost_avg;
+    ratio = mpp_clip(ratio, 128, 512);
+
+    rc_dbg_rc("lookahead cost %d avg %d bit_target %d -> %d\n",
+              info->la_cost, info->la_cost_avg, info->bit_target,
+              (RK_S32)((RK_S64)info->bit_target * ratio >> 8));
+
+    info->bit_target = (RK_S64)info->bit_target * ratio >> 8;
+}
+
 MPP_RET rc_model_v2_start(void *ctx, EncRcTask *task)
 {
     RcModelV2Ctx *p = (RcModelV2Ctx*)ctx;
@@ -1455,6 +1480,9 @@ MPP_RET rc_model_v2_start(void *ctx, EncRcTask *task)
         info->quality_min = usr_cfg->min_quality;
     }
 
+    if (!p->first_frm_flg)
+        bits_model_lookahead(info);
+
     bits_model_preset(p, info);
 
     rc_dbg_rc("seq_idx %d intra %d\n", frm->seq_idx, frm->is_intra);
@@ -1573,6 +1601,9 @@ MPP_RET rc_model_v2_hal_start(void *ctx, EncRcTask *task)
     rc_dbg_func("enter p %p task %p\n", p, task);
     rc_dbg_rc("seq_idx %d intra %d\n", frm->seq_idx, frm->is_intra);
 
+    /* hal_end / end of this task may run after next task hal_start */
+    info->scale_qp = p->cur_scale_qp;
+
     if (force->force_flag & ENC_RC_FORCE_QP) {
         RK_S32 qp = force->force_qp;
         info->quality_target = qp;
@@ -1704,6 +1735,7 @@ MPP_RET rc_model_v2_hal_start(void *ctx, EncRcTask *task)
     else
         p->start_qp = mpp_clip(p->start_qp, usr_cfg->fqp_min_p, usr_cfg->fqp_max_p);
     info->quality_target = p->start_qp;
+    info->scale_qp = p->cur_scale_qp;
 
     rc_dbg_rc("bitrate [%d : %d : %d] -> [%d : %d : %d]\n",
               bit_min, bit_target, bit_max,
@@ -1719,13 +1751,14 @@ MPP_RET rc_model_v2_hal_end(void *ctx, EncRcTask *task)
 {
     RcModelV2Ctx *p = (RcModelV2Ctx *)ctx;
     EncFrmStatus *frm = &task->frm;
+    EncRcTaskInfo *info = &task->info;
 
     rc_dbg_func("enter ctx %p task %p\n", ctx, task);
 
     if (frm->is_intra)
-        p->pre_i_qp = p->cur_scale_qp >> 6;
+        p->pre_i_qp = info->scale_qp >> 6;
     else
-        p->pre_p_qp = p->cur_scale_qp >> 6;
+        p->pre_p_qp = info->scale_qp >> 6;
 
     rc_dbg_func("leave %p\n", ctx);
     return MPP_OK;
@@ -1817,11 +1850,11 @@ MPP_RET rc_model_v2_end(void *ctx, EncRcTask *task)
     }
 
     p->gop_frm_cnt++;
-    p->gop_qp_sum += p->start_qp;
+    p->gop_qp_sum += cfg->quality_target;
 
     p->pre_mean_qp = cfg->quality_real;
     p->pre_iblk4_prop = cfg->iblk4_prop;
-    p->scale_qp = p->cur_scale_qp;
+    p->scale_qp = cfg->scale_qp;
     p->prev_md_prop = 0;
     p->pre_target_bits = cfg->bit_target;
     p->pre_target_bits_fix = cfg->bit_target_fix;
@@ -0,0 +1,143 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "rc_lookahead_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_buffer.h"
+
+#include "rc_lookahead.h"
+
+#define LA_TEST_WIDTH       320
+#define LA_TEST_HEIGHT      240
+#define LA_TEST_FRAMES      24
+#define LA_TEST_SCENE_CUT   12
+#define LA_TEST_DEPTH       4
+
+/* smooth frames before scene cut and noisy frames after it */
+static MppFrame la_test_frame(MppBufferGroup group, RK_S32 idx)
+{
+    RK_S32 size = LA_TEST_WIDTH * LA_TEST_HEIGHT * 3 / 2;
+    MppBuffer buf = NULL;
+    MppFrame frame = NULL;
+    RK_U8 *ptr;
+    RK_U32 seed = 0x1234 + idx;
+    RK_S32 x, y;
+
+    mpp_buffer_get(group, &buf, size);
+    if (NULL == buf)
+        return NULL;
+
+    ptr = (RK_U8 *)mpp_buffer_get_ptr(buf);
+    for (y = 0; y < LA_TEST_HEIGHT; y++) {
+        for (x = 0; x < LA_TEST_WIDTH; x++) {
+            if (idx < LA_TEST_SCENE_CUT) {
+                ptr[y * LA_TEST_WIDTH + x] = (RK_U8)((x + y) / 3);
+            } else {
+                seed = seed * 1103515245 + 12345;
+                ptr[y * LA_TEST_WIDTH + x] = (RK_U8)(seed >> 16);
+            }
+        }
+    }
+    memset(ptr + LA_TEST_WIDTH * LA_TEST_HEIGHT, 128, size - LA_TEST_WIDTH * LA_TEST_HEIGHT);
+
+    mpp_frame_init(&frame);
+    mpp_frame_set_width(frame, LA_TEST_WIDTH);
+    mpp_frame_set_height(frame, LA_TEST_HEIGHT);
+    mpp_frame_set_hor_stride(frame, LA_TEST_WIDTH);
+    mpp_frame_set_ver_stride(frame, LA_TEST_HEIGHT);
+    mpp_frame_set_fmt(frame, MPP_FMT_YUV420SP);
+    mpp_frame_set_pts(frame, idx);
+    mpp_frame_set_buffer(frame, buf);
+    mpp_frame_set_eos(frame, idx == LA_TEST_FRAMES - 1);
+    mpp_buffer_put(buf);
+
+    return frame;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+    MppBufferGroup group = NULL;
+    RcLookahead la = NULL;
+    EncRcTaskInfo info[LA_TEST_FRAMES];
+    RK_S32 pushed = 0;
+    RK_S32 popped = 0;
+
+    mpp_log("rc lookahead test start\n");
+
+    memset(info, 0, sizeof(info));
+
+    mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_NORMAL);
+    rc_lookahead_init(&la);
+    if (NULL == group || NULL == la)
+        goto DONE;
+
+    rc_lookahead_set_depth(la, LA_TEST_DEPTH);
+
+    while (popped < LA_TEST_FRAMES) {
+        EncRcTaskInfo tmp;
+        MppFrame frame = NULL;
+
+        while (pushed < LA_TEST_FRAMES && rc_lookahead_need_frame(la)) {
+            frame = la_test_frame(group, pushed);
+            if (NULL == frame)
+                goto DONE;
+
+            rc_lookahead_push(la, frame);
+            pushed++;
+        }
+
+        memset(&tmp, 0, sizeof(tmp));
+        frame = NULL;
+        if (rc_lookahead_pop(la, &frame, &tmp)) {
+            mpp_err("pop failed with %d frames pushed %d popped\n", pushed, popped);
+            goto DONE;
+        }
+
+        /* frames come out in input order after the window is filled */
+        if (mpp_frame_get_pts(frame) != popped ||
+            (pushed < LA_TEST_FRAMES && pushed - popped != LA_TEST_DEPTH + 1)) {
+            mpp_err("frame %lld popped at %d with %d frames pushed\n",
+                    mpp_frame_get_pts(frame), popped, pushed);
+            mpp_frame_deinit(&frame);
+            goto DONE;
+        }
+
+        info[popped++] = tmp;
+        mpp_log("frame %2d cost %6d window avg %6d\n", popped - 1,
+                tmp.la_cost, tmp.la_cost_avg);
+        mpp_frame_deinit(&frame);
+    }
+
+    ret = MPP_OK;
+
+    /* static frames are cheap and noisy frames are expensive */
+    if (info[LA_TEST_SCENE_CUT - 1].la_cost * 16 > info[LA_TEST_SCENE_CUT].la_cost) {
+        mpp_err("scene cut cost %d is not larger than static cost %d\n",
+                info[LA_TEST_SCENE_CUT].la_cost, info[LA_TEST_SCENE_CUT - 1].la_cost);
+        ret = MPP_NOK;
+    }
+
+    /* window before scene cut sees the coming expensive frames */
+    if (info[LA_TEST_SCENE_CUT - 1].la_cost_avg <= info[LA_TEST_SCENE_CUT - 1].la_cost ||
+        info[LA_TEST_SCENE_CUT - LA_TEST_DEPTH - 1].la_cost_avg !=
+        info[LA_TEST_SCENE_CUT - LA_TEST_DEPTH - 1].la_cost) {
+        mpp_err("window mean does not cover %d frames\n", LA_TEST_DEPTH);
+        ret = MPP_NOK;
+    }
+
+DONE:
+    if (la)
+        rc_lookahead_deinit(la);
+    if (group)
+        mpp_buffer_group_put(group);
+
+    mpp_log("rc lookahead test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -0,0 +1,116 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "rc_vp8_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_common.h"
+
+#include "rc.h"
+
+#define VP8_TEST_WIDTH      1280
+#define VP8_TEST_HEIGHT     720
+#define VP8_TEST_GOP        30
+#define VP8_TEST_FRAMES     (VP8_TEST_GOP * 4)
+/* qp change allowed between the last P frame and the next I frame */
+#define VP8_TEST_QP_STEP    12
+
+static void vp8_test_cfg(RcCfg *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+
+    cfg->width = VP8_TEST_WIDTH;
+    cfg->height = VP8_TEST_HEIGHT;
+    cfg->mode = RC_CBR;
+    cfg->fps.fps_in_num = 30;
+    cfg->fps.fps_in_denom = 1;
+    cfg->fps.fps_out_num = 30;
+    cfg->fps.fps_out_denom = 1;
+    cfg->igop = VP8_TEST_GOP;
+    cfg->bps_target = 2 * 1024 * 1024;
+    cfg->bps_max = cfg->bps_target * 17 / 16;
+    cfg->bps_min = cfg->bps_target * 15 / 16;
+    cfg->stats_time = 3;
+    cfg->layer_bit_prop[0] = 256;
+
+    /* same qp setup as mpi_enc_test on vp8 */
+    cfg->init_quality = 40;
+    cfg->max_quality = 127;
+    cfg->min_quality = 0;
+    cfg->max_i_quality = 127;
+    cfg->min_i_quality = 0;
+    cfg->fqp_min_i = 0;
+    cfg->fqp_min_p = 0;
+    cfg->fqp_max_i = 127;
+    cfg->fqp_max_p = 127;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+    RcCtx ctx = NULL;
+    RcCfg cfg;
+    RK_S32 last_p_qp = -1;
+    RK_S32 i;
+
+    mpp_log("rc vp8 test start\n");
+
+    if (rc_init(&ctx, MPP_VIDEO_CodingVP8, NULL))
+        goto DONE;
+
+    vp8_test_cfg(&cfg);
+    rc_update_usr_cfg(ctx, &cfg);
+
+    for (i = 0; i < VP8_TEST_FRAMES; i++) {
+        EncRcTask task;
+        EncFrmStatus *frm = &task.frm;
+        EncRcTaskInfo *info = &task.info;
+        RK_S32 qp;
+
+        /* each task comes with a clean rc info like a new async task */
+        memset(&task, 0, sizeof(task));
+        frm->valid = 1;
+        frm->seq_idx = i;
+        frm->is_intra = !(i % VP8_TEST_GOP);
+        frm->is_idr = frm->is_intra;
+
+        rc_frm_start(ctx, &task);
+        rc_hal_start(ctx, &task);
+        qp = info->quality_target;
+
+        /* encoder hits the target exactly on a steady scene */
+        info->bit_real = info->bit_target;
+        info->quality_real = qp;
+
+        rc_hal_end(ctx, &task);
+        rc_frm_end(ctx, &task);
+
+        if (frm->is_intra)
+            mpp_log("frame %3d I qp %3d last P qp %3d\n", i, qp, last_p_qp);
+
+        /* I frame qp starts from the qp kept on previous frames */
+        if (frm->is_intra && last_p_qp >= 0 &&
+            MPP_ABS(qp - last_p_qp) > VP8_TEST_QP_STEP) {
+            mpp_err("frame %d I qp %d is far from last P qp %d\n",
+                    i, qp, last_p_qp);
+            goto DONE;
+        }
+
+        if (!frm->is_intra)
+            last_p_qp = qp;
+    }
+
+    ret = MPP_OK;
+
+DONE:
+    if (ctx)
+        rc_deinit(ctx);
+
+    mpp_log("rc vp8 test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
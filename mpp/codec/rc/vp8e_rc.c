@@ -72,6 +72,9 @@ MPP_RET rc_model_v2_vp8_hal_start(void *ctx, EncRcTask *task)
 
     rc_dbg_rc("seq_idx %d intra %d\n", frm->seq_idx, frm->is_intra);
 
+    /* hal_end / end of this task may run after next task hal_start */
+    info->scale_qp = p->cur_scale_qp;
+
     if (force->force_flag & ENC_RC_FORCE_QP) {
         RK_S32 qp = force->force_qp;
         info->quality_target = qp;
@@ -140,6 +143,7 @@ MPP_RET rc_model_v2_vp8_hal_start(void *ctx, EncRcTask *task)
 
     p->start_qp = mpp_clip(p->start_qp, info->quality_min, info->quality_max);
     info->quality_target = p->start_qp;
+    info->scale_qp = p->cur_scale_qp;
 
     rc_dbg_rc("bitrate [%d : %d : %d] -> [%d : %d : %d]\n",
               bit_min, bit_target, bit_max,
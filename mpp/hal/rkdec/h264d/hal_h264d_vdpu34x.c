@@ -129,6 +129,16 @@ typedef struct h264d_rkv_buf_t {
     Vdpu34xH264dRegSet  *regs;
 } H264dRkvBuf_t;
 
+/* tables last copied to the dma buffer of one register set */
+typedef struct Vdpu34xH264dTblCache_t {
+    RK_U32              spspps_valid;
+    RK_U32              rps_valid;
+    RK_U32              sclst_valid;
+    RK_U8               spspps[48];
+    RK_U8               rps[VDPU34X_RPS_SIZE];
+    RK_U8               sclst[VDPU34X_SCALING_LIST_SIZE];
+} Vdpu34xH264dTblCache;
+
 typedef struct Vdpu34xH264dRegCtx_t {
     RK_U8               spspps[48];
     RK_U8               rps[VDPU34X_RPS_SIZE];
@@ -144,6 +154,7 @@ typedef struct Vdpu34xH264dRegCtx_t {
     RK_U32              offset_sclst[VDPU34X_FAST_REG_SET_CNT];
 
     H264dRkvBuf_t       reg_buf[VDPU34X_FAST_REG_SET_CNT];
+    Vdpu34xH264dTblCache tbl_cache[VDPU34X_FAST_REG_SET_CNT];
 
     RK_U32              spspps_offset;
     RK_U32              rps_offset;
@@ -529,6 +540,42 @@ static MPP_RET prepare_scanlist(H264dHalCtx_t *p_hal, RK_U8 *data, RK_U32 len)
     return MPP_OK;
 }
 
+/*
+ * Copy the tables to the dma buffer of current register set. Most frames only
+ * change the dpb flags at the end of spspps and some of rps so the unchanged
+ * parts are skipped by comparing with the last copy of the same set.
+ */
+static void update_tables(Vdpu34xH264dRegCtx *ctx, Vdpu34xH264dTblCache *cache,
+                          RK_U32 sclst_en)
+{
+    RK_U8 *spspps = (RK_U8 *)ctx->bufs_ptr + ctx->spspps_offset;
+    RK_U32 len = VDPU34X_SPS_PPS_LEN; //!< sps+pps data length
+    RK_U32 i = 0;
+
+    if (!cache->spspps_valid || memcmp(cache->spspps, ctx->spspps, len)) {
+        for (i = 0; i < 256; i++)
+            memcpy(spspps + sizeof(ctx->spspps) * i, ctx->spspps, sizeof(ctx->spspps));
+    } else if (memcmp(cache->spspps + len, ctx->spspps + len, sizeof(ctx->spspps) - len)) {
+        for (i = 0; i < 256; i++)
+            memcpy(spspps + sizeof(ctx->spspps) * i + len, ctx->spspps + len,
+                   sizeof(ctx->spspps) - len);
+    }
+    memcpy(cache->spspps, ctx->spspps, sizeof(ctx->spspps));
+    cache->spspps_valid = 1;
+
+    if (!cache->rps_valid || memcmp(cache->rps, ctx->rps, sizeof(ctx->rps))) {
+        memcpy((RK_U8 *)ctx->bufs_ptr + ctx->rps_offset, ctx->rps, sizeof(ctx->rps));
+        memcpy(cache->rps, ctx->rps, sizeof(ctx->rps));
+        cache->rps_valid = 1;
+    }
+
+    if (sclst_en && (!cache->sclst_valid || memcmp(cache->sclst, ctx->sclst, sizeof(ctx->sclst)))) {
+        memcpy((RK_U8 *)ctx->bufs_ptr + ctx->sclst_offset, ctx->sclst, sizeof(ctx->sclst));
+        memcpy(cache->sclst, ctx->sclst, sizeof(ctx->sclst));
+        cache->sclst_valid = 1;
+    }
+}
+
 static MPP_RET set_registers(H264dHalCtx_t *p_hal, Vdpu34xH264dRegSet *regs, HalTaskInfo *task)
 {
     DXVA_PicParams_H264_MVC *pp = p_hal->pp;
@@ -958,21 +1005,8 @@ MPP_RET vdpu34x_h264d_gen_regs(void *hal, HalTaskInfo *task)
     set_registers(p_hal, regs, task);
 
     //!< copy datas
-    RK_U32 i = 0;
-    if (!p_hal->fast_mode && !p_hal->pp->spspps_update) {
-        RK_U32 offset = 0;
-        RK_U32 len = VDPU34X_SPS_PPS_LEN; //!< sps+pps data length
-        for (i = 0; i < 256; i++) {
-            offset = ctx->spspps_offset + (sizeof(ctx->spspps) * i) + len;
-            memcpy((char *)ctx->bufs_ptr + offset, (char *)ctx->spspps + len, sizeof(ctx->spspps) - len);
-        }
-    } else {
-        RK_U32 offset = 0;
-        for (i = 0; i < 256; i++) {
-            offset = ctx->spspps_offset + (sizeof(ctx->spspps) * i);
-            memcpy((char *)ctx->bufs_ptr + offset, (void *)ctx->spspps, sizeof(ctx->spspps));
-        }
-    }
+    update_tables(ctx, &ctx->tbl_cache[p_hal->fast_mode ? task->dec.reg_index : 0],
+                  p_hal->pp->scaleing_list_enable_flag);
 
     regs->h264d_addr.pps_base = ctx->bufs_fd;
     MppDevRegOffsetCfg trans_cfg;
@@ -980,7 +1014,6 @@ MPP_RET vdpu34x_h264d_gen_regs(void *hal, HalTaskInfo *task)
     trans_cfg.offset = ctx->spspps_offset;
     mpp_dev_ioctl(p_hal->dev, MPP_DEV_REG_OFFSET, &trans_cfg);
 
-    memcpy((char *)ctx->bufs_ptr + ctx->rps_offset, (void *)ctx->rps, sizeof(ctx->rps));
     regs->h264d_addr.rps_base = ctx->bufs_fd;
     trans_cfg.reg_idx = 163;
     trans_cfg.offset = ctx->rps_offset;
@@ -988,7 +1021,6 @@ MPP_RET vdpu34x_h264d_gen_regs(void *hal, HalTaskInfo *task)
 
     regs->common.reg012.scanlist_addr_valid_en = 1;
     if (p_hal->pp->scaleing_list_enable_flag) {
-        memcpy((char *)ctx->bufs_ptr + ctx->sclst_offset, (void *)ctx->sclst, sizeof(ctx->sclst));
         regs->h264d_addr.scanlist_addr = ctx->bufs_fd;
         trans_cfg.reg_idx = 180;
         trans_cfg.offset = ctx->sclst_offset;
@@ -690,38 +690,58 @@ __BITREAD_ERR:
     return  MPP_ERR_STREAM;
 }
 
-void hal_h265d_output_scalinglist_packet(void *hal, void *ptr, void *dxva)
+RK_U32 hal_h265d_update_scalinglist(void *hal, void *dxva)
 {
     scalingList_t sl;
     RK_U32 i, j, pos;
     h265d_dxva2_picture_context_t *dxva_cxt = (h265d_dxva2_picture_context_t*)dxva;
     HalH265dCtx *reg_ctx = ( HalH265dCtx *)hal;
-    if (!dxva_cxt->pp.scaling_list_enabled_flag) {
-        return;
-    }
-    if (memcmp((void*)&dxva_cxt->qm, reg_ctx->scaling_qm, sizeof(DXVA_Qmatrix_HEVC))) {
-        memset(&sl, 0, sizeof(scalingList_t));
-        for (i = 0; i < 6; i++) {
-            for (j = 0; j < 16; j++) {
-                pos = 4 * hal_hevc_diag_scan4x4_y[j] + hal_hevc_diag_scan4x4_x[j];
-                sl.sl[0][i][pos] = dxva_cxt->qm.ucScalingLists0[i][j];
-            }
 
-            for (j = 0; j < 64; j++) {
-                pos = 8 * hal_hevc_diag_scan8x8_y[j] + hal_hevc_diag_scan8x8_x[j];
-                sl.sl[1][i][pos] =  dxva_cxt->qm.ucScalingLists1[i][j];
-                sl.sl[2][i][pos] =  dxva_cxt->qm.ucScalingLists2[i][j];
+    /* scaling factors only change with the scaling list in pps or sps */
+    if (reg_ctx->scaling_ver &&
+        !memcmp((void*)&dxva_cxt->qm, reg_ctx->scaling_qm, sizeof(DXVA_Qmatrix_HEVC)))
+        return reg_ctx->scaling_ver;
 
-                if (i < 2)
-                    sl.sl[3][i][pos] =  dxva_cxt->qm.ucScalingLists3[i][j];
-            }
+    memset(&sl, 0, sizeof(scalingList_t));
+    for (i = 0; i < 6; i++) {
+        for (j = 0; j < 16; j++) {
+            pos = 4 * hal_hevc_diag_scan4x4_y[j] + hal_hevc_diag_scan4x4_x[j];
+            sl.sl[0][i][pos] = dxva_cxt->qm.ucScalingLists0[i][j];
+        }
+
+        for (j = 0; j < 64; j++) {
+            pos = 8 * hal_hevc_diag_scan8x8_y[j] + hal_hevc_diag_scan8x8_x[j];
+            sl.sl[1][i][pos] =  dxva_cxt->qm.ucScalingLists1[i][j];
+            sl.sl[2][i][pos] =  dxva_cxt->qm.ucScalingLists2[i][j];
 
-            sl.sl_dc[0][i] =  dxva_cxt->qm.ucScalingListDCCoefSizeID2[i];
             if (i < 2)
-                sl.sl_dc[1][i] =  dxva_cxt->qm.ucScalingListDCCoefSizeID3[i];
+                sl.sl[3][i][pos] =  dxva_cxt->qm.ucScalingLists3[i][j];
         }
-        hal_record_scaling_list((scalingFactor_t *)reg_ctx->scaling_rk, &sl);
+
+        sl.sl_dc[0][i] =  dxva_cxt->qm.ucScalingListDCCoefSizeID2[i];
+        if (i < 2)
+            sl.sl_dc[1][i] =  dxva_cxt->qm.ucScalingListDCCoefSizeID3[i];
+    }
+    hal_record_scaling_list((scalingFactor_t *)reg_ctx->scaling_rk, &sl);
+    memcpy(reg_ctx->scaling_qm, &dxva_cxt->qm, sizeof(DXVA_Qmatrix_HEVC));
+
+    reg_ctx->scaling_ver++;
+    if (!reg_ctx->scaling_ver)
+        reg_ctx->scaling_ver = 1;
+
+    return reg_ctx->scaling_ver;
+}
+
+void hal_h265d_output_scalinglist_packet(void *hal, void *ptr, void *dxva)
+{
+    h265d_dxva2_picture_context_t *dxva_cxt = (h265d_dxva2_picture_context_t*)dxva;
+    HalH265dCtx *reg_ctx = ( HalH265dCtx *)hal;
+
+    if (!dxva_cxt->pp.scaling_list_enabled_flag) {
+        return;
     }
+
+    hal_h265d_update_scalinglist(hal, dxva);
     memcpy(ptr, reg_ctx->scaling_rk, sizeof(scalingFactor_t));
 }
 
@@ -151,6 +151,8 @@ RK_U32 hevc_hor_align(RK_U32 val);
 void hal_record_scaling_list(scalingFactor_t *pScalingFactor_out, scalingList_t *pScalingList);
 RK_S32 hal_h265d_slice_hw_rps(void *dxva, void *rps_buf, void* sw_rps_buf, RK_U32 fast_mode);
 RK_S32 hal_h265d_slice_output_rps(void *dxva, void *rps_buf);
+/* rebuild scaling_rk when the scaling list changes and return its version */
+RK_U32 hal_h265d_update_scalinglist(void *hal, void *dxva);
 void hal_h265d_output_scalinglist_packet(void *hal, void *ptr, void *dxva);
 
 #ifdef __cplusplus
@@ -86,6 +86,16 @@ typedef struct HalH265dCtx_t {
     RK_U32          sclst_offset;
     void            *pps_buf;
     void            *sw_rps_buf;
+    /*
+     * versions of pps_buf / scaling_rk and the versions last copied to the
+     * dma buffer of each register set, zero for nothing copied
+     */
+    RK_U32          buf_idx;
+    RK_U32          pps_ver;
+    RK_U32          scaling_ver;
+    RK_U32          pps_ver_set[MAX_GEN_REG];
+    RK_U32          sclst_ver_set[MAX_GEN_REG];
+    RK_U32          sclst_addr_set[MAX_GEN_REG];
     HalBufs         origin_bufs;
     MppBuffer       missing_ref_buf;
     RK_U32          missing_ref_buf_size;
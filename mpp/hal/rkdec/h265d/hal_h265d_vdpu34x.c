@@ -228,6 +228,8 @@ static RK_S32 hal_h265d_v345_output_pps_packet(void *hal, void *dxva)
     HalH265dCtx *reg_ctx = ( HalH265dCtx *)hal;
     Vdpu34xH265dRegSet *hw_reg = (Vdpu34xH265dRegSet*)(reg_ctx->hw_regs);
     h265d_dxva2_picture_context_t *dxva_cxt = (h265d_dxva2_picture_context_t*)dxva;
+    RK_U32 idx = reg_ctx->buf_idx;
+    RK_U32 ver;
     BitputCtx_t bp;
 
     if (NULL == reg_ctx || dxva_cxt == NULL) {
@@ -408,6 +410,10 @@ static RK_S32 hal_h265d_v345_output_pps_packet(void *hal, void *dxva)
         mpp_put_bits(&bp, 0, 32);
         mpp_put_bits(&bp, 0, 70);
         mpp_put_align(&bp, 64, 0xf);//128
+
+        reg_ctx->pps_ver++;
+        if (!reg_ctx->pps_ver)
+            reg_ctx->pps_ver = 1;
     }
 
     if (dxva_cxt->pp.scaling_list_enabled_flag) {
@@ -422,7 +428,13 @@ static RK_S32 hal_h265d_v345_output_pps_packet(void *hal, void *dxva)
             addr = 80 * 1360;
         }
 
-        hal_h265d_output_scalinglist_packet(hal, ptr_scaling + addr, dxva);
+        /* scaling list at the same addr of this set may be still valid */
+        ver = hal_h265d_update_scalinglist(hal, dxva);
+        if (reg_ctx->sclst_ver_set[idx] != ver || reg_ctx->sclst_addr_set[idx] != addr) {
+            memcpy(ptr_scaling + addr, reg_ctx->scaling_rk, sizeof(scalingFactor_t));
+            reg_ctx->sclst_ver_set[idx] = ver;
+            reg_ctx->sclst_addr_set[idx] = addr;
+        }
 
         hw_reg->h265d_addr.reg180_scanlist_addr = reg_ctx->bufs_fd;
         hw_reg->common.reg012.scanlist_addr_valid_en = 1;
@@ -433,8 +445,11 @@ static RK_S32 hal_h265d_v345_output_pps_packet(void *hal, void *dxva)
         mpp_dev_ioctl(reg_ctx->dev, MPP_DEV_REG_OFFSET, &trans_cfg);
     }
 
-    for (i = 0; i < 64; i++)
-        memcpy(pps_ptr + i * 112, reg_ctx->pps_buf, 112);
+    if (reg_ctx->pps_ver_set[idx] != reg_ctx->pps_ver) {
+        for (i = 0; i < 64; i++)
+            memcpy(pps_ptr + i * 112, reg_ctx->pps_buf, 112);
+        reg_ctx->pps_ver_set[idx] = reg_ctx->pps_ver;
+    }
 #ifdef dump
     fwrite(pps_ptr, 1, 80 * 64, fp);
     RK_U32 *tmp = (RK_U32 *)pps_ptr;
@@ -454,6 +469,7 @@ static RK_S32 hal_h265d_output_pps_packet(void *hal, void *dxva)
     RK_S32 width, height;
     HalH265dCtx *reg_ctx = ( HalH265dCtx *)hal;
     h265d_dxva2_picture_context_t *dxva_cxt = (h265d_dxva2_picture_context_t*)dxva;
+    RK_U32 idx = reg_ctx->buf_idx;
     BitputCtx_t bp;
 
     if (NULL == reg_ctx || dxva_cxt == NULL) {
@@ -655,9 +671,15 @@ static RK_S32 hal_h265d_output_pps_packet(void *hal, void *dxva)
         }
         for (i = 0; i < 64; i++)
             memcpy(pps_ptr + i * 80, reg_ctx->pps_buf, 80);
-    } else if (reg_ctx->fast_mode) {
+
+        reg_ctx->pps_ver++;
+        if (!reg_ctx->pps_ver)
+            reg_ctx->pps_ver = 1;
+        reg_ctx->pps_ver_set[idx] = reg_ctx->pps_ver;
+    } else if (reg_ctx->fast_mode && reg_ctx->pps_ver_set[idx] != reg_ctx->pps_ver) {
         for (i = 0; i < 64; i++)
             memcpy(pps_ptr + i * 80, reg_ctx->pps_buf, 80);
+        reg_ctx->pps_ver_set[idx] = reg_ctx->pps_ver;
     }
 
 #ifdef dump
@@ -874,6 +896,7 @@ static MPP_RET hal_h265d_vdpu34x_gen_regs(void *hal,  HalTaskInfo *syn)
             if (!reg_ctx->g_buf[i].use_flag) {
                 syn->dec.reg_index = i;
 
+                reg_ctx->buf_idx = i;
                 reg_ctx->spspps_offset = reg_ctx->offset_spspps[i];
                 reg_ctx->rps_offset = reg_ctx->offset_rps[i];
                 reg_ctx->sclst_offset = reg_ctx->offset_sclst[i];
@@ -0,0 +1,387 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "hal_h265d_vdpu34x_test"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mpp_mem.h"
+#include "mpp_debug.h"
+#include "mpp_common.h"
+#include "mpp_frame.h"
+#include "mpp_buffer.h"
+#include "mpp_buf_slot.h"
+#include "mpp_dec_cfg.h"
+
+#include "h265d_syntax.h"
+#include "hal_h265d_ctx.h"
+#include "hal_h265d_com.h"
+#include "hal_h265d_vdpu34x.h"
+
+#define TEST_WIDTH          1920
+#define TEST_HEIGHT         1088
+#define TEST_FRAMES         600
+/* sps / pps are sent again on each segment */
+#define TEST_SEGMENT        40
+/* pps entry size and scaling list step in the dma buffer on vdpu34x */
+#define TEST_PPS_SIZE       112
+#define TEST_PPS_COUNT      64
+#define TEST_SCALING_STEP   1360
+
+/*
+ * Two hal contexts decode the same synthetic frames. The cached one skips
+ * the tables already in the dma buffer of its register set. The full one
+ * drops its cache records before each frame so that it rebuilds and copies
+ * all tables like before the cache was added.
+ */
+typedef struct HalTestCtx_t {
+    HalH265dCtx     *hal;
+    RK_S32          full;
+    RK_S64          time;
+    /* register sets still used by hardware in fast mode */
+    RK_S32          busy[MAX_GEN_REG];
+    RK_S32          busy_cnt;
+} HalTestCtx;
+
+static RK_S64 hal_test_cpu_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (RK_S64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static MPP_RET hal_test_init(HalTestCtx *ctx, RK_S32 full, MppBufSlots slots,
+                             MppBufSlots packet_slots, MppDecCfgSet *cfg)
+{
+    HalH265dCtx *p = mpp_calloc(HalH265dCtx, 1);
+    MppHalCfg hal_cfg;
+
+    memset(ctx, 0, sizeof(*ctx));
+    if (NULL == p)
+        return MPP_ERR_MALLOC;
+
+    ctx->hal = p;
+    ctx->full = full;
+
+    if (mpp_dev_init(&p->dev, VPU_CLIENT_RKVDEC))
+        return MPP_NOK;
+
+    p->api = &hal_h265d_vdpu34x;
+    p->cfg = cfg;
+    p->slots = slots;
+    p->packet_slots = packet_slots;
+    p->fast_mode = 1;
+    p->is_v34x = 1;
+
+    memset(&hal_cfg, 0, sizeof(hal_cfg));
+    hal_cfg.frame_slots = slots;
+    hal_cfg.packet_slots = packet_slots;
+    hal_cfg.cfg = cfg;
+    hal_cfg.dev = p->dev;
+
+    return p->api->init(p, &hal_cfg);
+}
+
+static void hal_test_deinit(HalTestCtx *ctx)
+{
+    HalH265dCtx *p = ctx->hal;
+
+    if (NULL == p)
+        return;
+
+    if (p->api)
+        p->api->deinit(p);
+    if (p->dev)
+        mpp_dev_deinit(p->dev);
+    mpp_free(p);
+    ctx->hal = NULL;
+}
+
+static MPP_RET hal_test_gen(HalTestCtx *ctx, HalTaskInfo *task, RK_S32 depth)
+{
+    HalH265dCtx *p = ctx->hal;
+    RK_S64 start;
+    MPP_RET ret;
+
+    /* hardware returns the oldest register sets */
+    while (ctx->busy_cnt >= depth) {
+        p->g_buf[ctx->busy[0]].use_flag = 0;
+        memmove(ctx->busy, ctx->busy + 1, --ctx->busy_cnt * sizeof(ctx->busy[0]));
+    }
+
+    if (ctx->full) {
+        memset(p->pps_ver_set, 0, sizeof(p->pps_ver_set));
+        memset(p->sclst_ver_set, 0, sizeof(p->sclst_ver_set));
+        p->scaling_ver = 0;
+    }
+
+    start = hal_test_cpu_time();
+    ret = p->api->reg_gen(p, task);
+    ctx->time += hal_test_cpu_time() - start;
+    if (ret)
+        return ret;
+
+    ctx->busy[ctx->busy_cnt++] = task->dec.reg_index;
+
+    return MPP_OK;
+}
+
+static void hal_test_set_qm(DXVA_Qmatrix_HEVC *qm, RK_U32 seed)
+{
+    RK_U8 *val = (RK_U8 *)qm;
+    RK_U32 i;
+
+    for (i = 0; i < sizeof(*qm); i++)
+        val[i] = 1 + (seed * 37 + i * 11) % 255;
+}
+
+/* parser only sends ps_update_flag when sps / pps / scaling list change */
+static void hal_test_set_frame(h265d_dxva2_picture_context_t *dxva, RK_S32 idx,
+                               RK_S32 frame)
+{
+    DXVA_PicParams_HEVC *pp = &dxva->pp;
+    RK_S32 seg = frame / TEST_SEGMENT;
+    RK_U32 i;
+
+    pp->ps_update_flag = (!(frame % TEST_SEGMENT) || frame % 13 == 5);
+    if (pp->ps_update_flag) {
+        pp->chroma_format_idc = 1;
+        pp->log2_min_luma_coding_block_size_minus3 = 0;
+        pp->log2_diff_max_min_luma_coding_block_size = 3;
+        pp->PicWidthInMinCbsY = TEST_WIDTH >> 3;
+        pp->PicHeightInMinCbsY = TEST_HEIGHT >> 3;
+        pp->sps_id = seg % 2;
+        pp->pps_id = seg % 4;
+        pp->init_qp_minus26 = seg % 5 - 2;
+        pp->scaling_list_enabled_flag = (seg % 3 != 0);
+        pp->scaling_list_data_present_flag = seg & 1;
+        /* a scaling list change may come with a pps resent unchanged */
+        hal_test_set_qm(&dxva->qm, seg + (frame % TEST_SEGMENT > 20));
+    }
+
+    pp->CurrPic.Index7Bits = idx;
+    pp->IntraPicFlag = 1;
+    pp->IdrPicFlag = !(frame % TEST_SEGMENT);
+    pp->CurrPicOrderCntVal = frame % TEST_SEGMENT;
+    for (i = 0; i < MPP_ARRAY_ELEMS(pp->RefPicList); i++)
+        pp->RefPicList[i].bPicEntry = 0xff;
+
+    dxva->slice_count = 0;
+    dxva->bitstream = NULL;
+    dxva->bitstream_size = 0;
+}
+
+static MPP_RET hal_test_cmp(HalTestCtx *cached, HalTestCtx *full,
+                            h265d_dxva2_picture_context_t *dxva, RK_S32 idx,
+                            RK_S32 frame)
+{
+    HalH265dCtx *a = cached->hal;
+    HalH265dCtx *b = full->hal;
+    RK_U8 *buf_a = (RK_U8 *)mpp_buffer_get_ptr(a->bufs);
+    RK_U8 *buf_b = (RK_U8 *)mpp_buffer_get_ptr(b->bufs);
+    RK_U32 addr;
+
+    if (memcmp(buf_a + a->offset_spspps[idx], buf_b + b->offset_spspps[idx],
+               TEST_PPS_SIZE * TEST_PPS_COUNT)) {
+        mpp_err("frame %d set %d pps mismatch\n", frame, idx);
+        return MPP_NOK;
+    }
+
+    if (!dxva->pp.scaling_list_enabled_flag)
+        return MPP_OK;
+
+    addr = dxva->pp.scaling_list_data_present_flag ?
+           (dxva->pp.pps_id + 16) * TEST_SCALING_STEP :
+           dxva->pp.sps_id * TEST_SCALING_STEP;
+
+    if (memcmp(buf_a + a->offset_sclst[idx] + addr, buf_b + b->offset_sclst[idx] + addr,
+               sizeof(scalingFactor_t))) {
+        mpp_err("frame %d set %d scaling list mismatch\n", frame, idx);
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+/* rkv and vdpu382 hal copy the scaling list from hal_h265d_output_scalinglist_packet */
+static MPP_RET hal_test_scalinglist(void)
+{
+    HalH265dCtx ctx[2];
+    h265d_dxva2_picture_context_t dxva;
+    RK_U8 out[2][sizeof(scalingFactor_t)];
+    MPP_RET ret = MPP_NOK;
+    RK_S32 i, j;
+
+    memset(ctx, 0, sizeof(ctx));
+    memset(&dxva, 0, sizeof(dxva));
+
+    for (i = 0; i < 2; i++) {
+        ctx[i].scaling_qm = mpp_calloc(DXVA_Qmatrix_HEVC, 1);
+        ctx[i].scaling_rk = mpp_calloc(scalingFactor_t, 1);
+        if (NULL == ctx[i].scaling_qm || NULL == ctx[i].scaling_rk)
+            goto DONE;
+    }
+
+    dxva.pp.scaling_list_enabled_flag = 1;
+    for (i = 0; i < TEST_FRAMES; i++) {
+        hal_test_set_qm(&dxva.qm, i / 7);
+
+        /* the second one rebuilds on every frame */
+        ctx[1].scaling_ver = 0;
+        for (j = 0; j < 2; j++)
+            hal_h265d_output_scalinglist_packet(&ctx[j], out[j], &dxva);
+
+        if (memcmp(out[0], out[1], sizeof(out[0]))) {
+            mpp_err("frame %d scaling factor mismatch\n", i);
+            goto DONE;
+        }
+    }
+
+    ret = MPP_OK;
+DONE:
+    for (i = 0; i < 2; i++) {
+        MPP_FREE(ctx[i].scaling_qm);
+        MPP_FREE(ctx[i].scaling_rk);
+    }
+
+    return ret;
+}
+
+int main()
+{
+    HalTestCtx cached;
+    HalTestCtx full;
+    MppDecCfgSet *cfg = NULL;
+    MppBufSlots slots = NULL;
+    MppBufSlots packet_slots = NULL;
+    MppBufferGroup group = NULL;
+    MppBuffer frm_buf = NULL;
+    MppBuffer pkt_buf = NULL;
+    MppFrame frame = NULL;
+    h265d_dxva2_picture_context_t dxva;
+    RK_S32 idx = -1;
+    RK_S32 pkt_idx = -1;
+    RK_S32 i;
+    MPP_RET ret = MPP_NOK;
+
+    /* the hal runs on the null device without hardware */
+    setenv("mpp_device_null", "1", 0);
+
+    mpp_log("hal h265d vdpu34x test start\n");
+
+    memset(&cached, 0, sizeof(cached));
+    memset(&full, 0, sizeof(full));
+    memset(&dxva, 0, sizeof(dxva));
+
+    cfg = mpp_calloc(MppDecCfgSet, 1);
+    if (NULL == cfg)
+        goto DONE;
+
+    mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_ION);
+    mpp_buffer_get(group, &frm_buf, SZ_4K);
+    mpp_buffer_get(group, &pkt_buf, SZ_4K);
+    if (NULL == frm_buf || NULL == pkt_buf)
+        goto DONE;
+
+    mpp_buf_slot_init(&slots);
+    mpp_buf_slot_setup(slots, 4);
+    mpp_buf_slot_init(&packet_slots);
+    mpp_buf_slot_setup(packet_slots, 2);
+
+    /* hal only needs the strides and the fd of the output frame */
+    mpp_frame_init(&frame);
+    mpp_frame_set_width(frame, TEST_WIDTH);
+    mpp_frame_set_height(frame, TEST_HEIGHT);
+    mpp_frame_set_hor_stride(frame, TEST_WIDTH);
+    mpp_frame_set_ver_stride(frame, TEST_HEIGHT);
+    mpp_frame_set_fmt(frame, MPP_FMT_YUV420SP);
+    mpp_buf_slot_get_unused(slots, &idx);
+    mpp_buf_slot_set_prop(slots, idx, SLOT_FRAME, frame);
+    mpp_buf_slot_set_prop(slots, idx, SLOT_BUFFER, frm_buf);
+    mpp_buf_slot_set_flag(slots, idx, SLOT_CODEC_USE);
+    /* stream buffer is hold by hal input like on decoder */
+    mpp_buf_slot_get_unused(packet_slots, &pkt_idx);
+    mpp_buf_slot_set_prop(packet_slots, pkt_idx, SLOT_BUFFER, pkt_buf);
+    mpp_buf_slot_set_flag(packet_slots, pkt_idx, SLOT_CODEC_READY);
+    mpp_buf_slot_set_flag(packet_slots, pkt_idx, SLOT_HAL_INPUT);
+
+    if (hal_test_init(&cached, 0, slots, packet_slots, cfg) ||
+        hal_test_init(&full, 1, slots, packet_slots, cfg)) {
+        mpp_err("failed to init hal\n");
+        goto DONE;
+    }
+
+    for (i = 0; i < TEST_FRAMES; i++) {
+        HalTaskInfo task_cached;
+        HalTaskInfo task_full;
+        /* one to three tasks on hardware rotate the register sets */
+        RK_S32 depth = 1 + (i / 7) % MAX_GEN_REG;
+
+        hal_test_set_frame(&dxva, idx, i);
+
+        memset(&task_cached, 0, sizeof(task_cached));
+        task_cached.dec.syntax.data = &dxva;
+        task_cached.dec.input = pkt_idx;
+        task_full = task_cached;
+
+        /* swap the order on each frame to share the cache warm up */
+        if (i & 1) {
+            ret = hal_test_gen(&full, &task_full, depth);
+            if (!ret)
+                ret = hal_test_gen(&cached, &task_cached, depth);
+        } else {
+            ret = hal_test_gen(&cached, &task_cached, depth);
+            if (!ret)
+                ret = hal_test_gen(&full, &task_full, depth);
+        }
+        if (ret) {
+            mpp_err("frame %d failed to gen regs\n", i);
+            goto DONE;
+        }
+
+        mpp_assert(task_cached.dec.reg_index == task_full.dec.reg_index);
+        ret = hal_test_cmp(&cached, &full, &dxva, task_cached.dec.reg_index, i);
+        if (ret)
+            goto DONE;
+    }
+
+    mpp_log("gen regs cpu time cached %lld ns full %lld ns per frame\n",
+            cached.time / TEST_FRAMES, full.time / TEST_FRAMES);
+
+    ret = hal_test_scalinglist();
+
+DONE:
+    hal_test_deinit(&cached);
+    hal_test_deinit(&full);
+
+    if (frame)
+        mpp_frame_deinit(&frame);
+    if (slots) {
+        if (idx >= 0) {
+            mpp_buf_slot_set_flag(slots, idx, SLOT_CODEC_READY);
+            mpp_buf_slot_clr_flag(slots, idx, SLOT_CODEC_USE);
+        }
+        mpp_buf_slot_deinit(slots);
+    }
+    if (packet_slots) {
+        if (pkt_idx >= 0)
+            mpp_buf_slot_clr_flag(packet_slots, pkt_idx, SLOT_HAL_INPUT);
+        mpp_buf_slot_deinit(packet_slots);
+    }
+    if (frm_buf)
+        mpp_buffer_put(frm_buf);
+    if (pkt_buf)
+        mpp_buffer_put(pkt_buf);
+    if (group)
+        mpp_buffer_group_put(group);
+    MPP_FREE(cfg);
+
+    mpp_log("hal h265d vdpu34x test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
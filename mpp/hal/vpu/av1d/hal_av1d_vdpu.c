@@ -1871,6 +1871,10 @@ MPP_RET vdpu_av1d_gen_regs(void *hal, HalTaskInfo *task)
 
     ctx->refresh_frame_flags = dxva->refresh_frame_flags;
 
+    // whether need update cdfs
+    if (!dxva->coding.disable_frame_end_update_cdf)
+        task->dec.flags.wait_done = 1;
+
     if (task->dec.flags.parse_err ||
         task->dec.flags.ref_err) {
         mpp_err_f("parse err %d ref err %d\n",
@@ -2337,7 +2341,7 @@ MPP_RET vdpu_av1d_wait(void *hal, HalTaskInfo *task)
 #endif
 
 __SKIP_HARD:
-    if (p_hal->dec_cb) {
+    if (p_hal->dec_cb && task->dec.flags.wait_done) {
         DecCbHalDone m_ctx;
         RK_U32 *prob_out = (RK_U32*)mpp_buffer_get_ptr(reg_ctx->prob_tbl_out_base);
 
@@ -23,6 +23,8 @@
 #include "mpp_dec.h"
 #include "mpp_enc.h"
 #include "mpp_impl.h"
+#include "mpp_frame_trace.h"
+#include "mpp_metrics.h"
 
 #define MPP_DBG_FUNCTION                    (0x00000001)
 #define MPP_DBG_PACKET                      (0x00000002)
@@ -115,6 +117,7 @@ public:
     MPP_RET resume();
 
     MPP_RET put_packet(MppPacket packet);
+    MPP_RET put_packets(MppPacket *packets, RK_S32 count);
     MPP_RET get_frame(MppFrame *frame);
     MPP_RET get_frame_noblock(MppFrame *frame);
 
@@ -196,6 +199,10 @@ public:
 
     /* dump info for debug */
     MppDump         mDump;
+    /* per-frame stage trace, NULL until enabled */
+    MppFrameTrace   mTrace;
+    /* always-on counters for MPP_GET_STATS */
+    MppMetrics      mMetrics;
 
 private:
     void clear();
@@ -216,6 +223,10 @@ private:
     /* backup extra packet for seek */
     MppPacket       mExtraPacket;
 
+    /* input task handshake shared by put_packet and put_packets */
+    MPP_RET get_input_task(RK_U32 eos, MppTask *task);
+    void reserve_input_task();
+
     MPP_RET control_mpp(MpiCmd cmd, MppParam param);
     MPP_RET control_osal(MpiCmd cmd, MppParam param);
     MPP_RET control_codec(MpiCmd cmd, MppParam param);
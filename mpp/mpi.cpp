@@ -24,6 +24,7 @@
 #include "mpp_mem.h"
 #include "mpp_debug.h"
 #include "mpp_common.h"
+#include "mpp_metrics.h"
 
 #include "mpi_impl.h"
 #include "mpp_info.h"
@@ -148,6 +149,41 @@ static MPP_RET mpi_decode_put_packet(MppCtx ctx, MppPacket packet)
     return ret;
 }
 
+static MPP_RET mpi_decode_put_packets(MppCtx ctx, MppPacket *packets, RK_S32 count)
+{
+    MPP_RET ret = MPP_NOK;
+    MpiImpl *p = (MpiImpl *)ctx;
+    RK_S32 i;
+
+    mpi_dbg_func("enter ctx %p packets %p count %d\n", ctx, packets, count);
+    do {
+        ret = check_mpp_ctx(p);
+        if (ret)
+            break;
+
+        if (NULL == packets || count <= 0) {
+            mpp_err_f("found invalid input packets %p count %d\n", packets, count);
+            ret = MPP_ERR_NULL_PTR;
+            break;
+        }
+
+        for (i = 0; i < count; i++) {
+            if (NULL == packets[i]) {
+                mpp_err_f("found NULL input packet at %d\n", i);
+                ret = MPP_ERR_NULL_PTR;
+                break;
+            }
+        }
+        if (ret)
+            break;
+
+        ret = p->ctx->put_packets(packets, count);
+    } while (0);
+
+    mpi_dbg_func("leave ctx %p ret %d\n", ctx, ret);
+    return ret;
+}
+
 static MPP_RET mpi_decode_get_frame(MppCtx ctx, MppFrame *frame)
 {
     MPP_RET ret = MPP_NOK;
@@ -406,6 +442,7 @@ static MppApi mpp_api = {
     mpi_enqueue,
     mpi_reset,
     mpi_control,
+    mpi_decode_put_packets,
     {0},
 };
 
@@ -578,3 +615,8 @@ void mpp_show_color_format()
                 info->format, info->format, info->name);
     }
 }
+
+MPP_RET mpp_get_stats(MppStats *stats)
+{
+    return mpp_metrics_snapshot(NULL, stats);
+}
@@ -23,6 +23,7 @@
 
 #include "mpp_mem.h"
 #include "mpp_env.h"
+#include "mpp_lock.h"
 #include "mpp_time.h"
 #include "mpp_impl.h"
 #include "mpp_2str.h"
@@ -120,6 +121,8 @@ Mpp::Mpp(MppCtx ctx)
       mIoMode(MPP_IO_MODE_DEFAULT),
       mDisableThread(0),
       mDump(NULL),
+      mTrace(NULL),
+      mMetrics(NULL),
       mType(MPP_CTX_BUTT),
       mCoding(MPP_VIDEO_CodingUnused),
       mInitDone(0),
@@ -134,6 +137,15 @@ Mpp::Mpp(MppCtx ctx)
     mDecInitcfg.base.change  |= MPP_DEC_CFG_CHANGE_ENABLE_VPROC;
 
     mpp_dump_init(&mDump);
+    mpp_metrics_init(&mMetrics);
+
+    {
+        RK_U32 trace_size = 0;
+
+        mpp_env_get_u32("mpp_frame_trace", &trace_size, 0);
+        if (trace_size)
+            mpp_frame_trace_init(&mTrace, trace_size);
+    }
 }
 
 MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
@@ -176,6 +188,12 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
             mpp_buffer_group_get_internal(&mPacketGroup, MPP_BUFFER_TYPE_ION | MPP_BUFFER_FLAGS_CACHABLE);
             mpp_buffer_group_limit_config(mPacketGroup, 0, 3);
 
+            /*
+             * input tasks are only put by put_packet on user thread and only
+             * taken by the parser thread. Advanced mode on mjpeg also lets
+             * the parser thread release the user ports so it stays on mutex.
+             */
+            mpp_task_queue_set_spsc(mInputTaskQueue, 1);
             mpp_task_queue_setup(mInputTaskQueue, 4);
             mpp_task_queue_setup(mOutputTaskQueue, 4);
         } else {
@@ -200,6 +218,9 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
         ret = mpp_dec_init(&mDec, &cfg);
         if (ret)
             break;
+        /* one more packet buffer for the task parsed ahead on fast mode */
+        if (mPacketGroup && mDecInitcfg.base.fast_parse)
+            mpp_buffer_group_limit_config(mPacketGroup, 0, 4);
         ret = mpp_dec_start(mDec);
         if (ret)
             break;
@@ -274,6 +295,9 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
 Mpp::~Mpp ()
 {
     clear();
+
+    mpp_metrics_deinit(mMetrics);
+    mMetrics = NULL;
 }
 
 void Mpp::clear()
@@ -344,6 +368,11 @@ void Mpp::clear()
     }
 
     mpp_dump_deinit(&mDump);
+
+    if (mTrace) {
+        mpp_frame_trace_deinit(mTrace);
+        mTrace = NULL;
+    }
 }
 
 MPP_RET Mpp::start()
@@ -366,43 +395,27 @@ MPP_RET Mpp::resume()
     return MPP_OK;
 }
 
-MPP_RET Mpp::put_packet(MppPacket packet)
+MPP_RET Mpp::get_input_task(RK_U32 eos, MppTask *task)
 {
-    if (!mInitDone)
-        return MPP_ERR_INIT;
-
-    MPP_RET ret = MPP_NOK;
-    MppPollType timeout = mInputTimeout;
+    MPP_RET ret = MPP_OK;
     MppTask task_dequeue = NULL;
-    RK_U32 pkt_copy = 0;
-
-    if (mDisableThread) {
-        mpp_err_f("no thread decoding case MUST use mpi_decode interface\n");
-        return ret;
-    }
 
-    if (mExtraPacket) {
-        MppPacket extra = mExtraPacket;
-
-        mExtraPacket = NULL;
-        put_packet(extra);
-    }
+    *task = NULL;
 
     if (!mEosTask) {
         /* handle eos packet on block mode */
         ret = poll(MPP_PORT_INPUT, MPP_POLL_BLOCK);
         if (ret < 0)
-            goto RET;
+            return ret;
 
         dequeue(MPP_PORT_INPUT, &mEosTask);
         if (NULL == mEosTask) {
             mpp_err_f("fail to reserve eos task\n", ret);
-            ret = MPP_NOK;
-            goto RET;
+            return MPP_NOK;
         }
     }
 
-    if (mpp_packet_get_eos(packet)) {
+    if (eos) {
         mpp_assert(mEosTask);
         task_dequeue = mEosTask;
         mEosTask = NULL;
@@ -415,35 +428,92 @@ MPP_RET Mpp::put_packet(MppPacket packet)
     }
 
     if (NULL == task_dequeue) {
-        ret = poll(MPP_PORT_INPUT, timeout);
-        if (ret < 0) {
-            ret = MPP_ERR_BUFFER_FULL;
-            goto RET;
-        }
+        ret = poll(MPP_PORT_INPUT, mInputTimeout);
+        if (ret < 0)
+            return MPP_ERR_BUFFER_FULL;
 
         /* do not pull here to avoid block wait */
         dequeue(MPP_PORT_INPUT, &task_dequeue);
         if (NULL == task_dequeue) {
             mpp_err_f("fail to get task on poll ret %d\n", ret);
-            ret = MPP_NOK;
-            goto RET;
+            return MPP_NOK;
         }
     }
 
-    if (NULL == mpp_packet_get_buffer(packet)) {
-        /* packet copy path */
-        MppPacket pkt_in = NULL;
+    *task = task_dequeue;
 
-        mpp_packet_copy_init(&pkt_in, packet);
-        mpp_packet_set_length(packet, 0);
-        pkt_copy = 1;
-        packet = pkt_in;
-        ret = MPP_OK;
-    } else {
-        /* packet zero copy path */
-        mpp_log_f("not support zero copy path\n");
-        timeout = MPP_POLL_BLOCK;
+    return MPP_OK;
+}
+
+void Mpp::reserve_input_task()
+{
+    /* wait enqueued task finished */
+    if (NULL == mInputTask) {
+        MPP_RET cnt = poll(MPP_PORT_INPUT, MPP_POLL_NON_BLOCK);
+        /* reserve one task for eos block mode */
+        if (cnt >= 0) {
+            dequeue(MPP_PORT_INPUT, &mInputTask);
+            mpp_assert(mInputTask);
+        }
     }
+}
+
+/*
+ * Input packet is always copied to internal memory, also when it carries an
+ * MppBuffer. The task can be returned as soon as the parser takes the packet,
+ * and caller can write its buffer again right after put_packet returns.
+ */
+static MPP_RET dec_copy_input_packet(MppPacket *dst, MppPacket src)
+{
+    MppBuffer buffer = mpp_packet_get_buffer(src);
+    MppPacketImpl *impl = (MppPacketImpl *)src;
+    MPP_RET ret;
+
+    if (NULL == buffer)
+        return mpp_packet_copy_init(dst, src);
+
+    /* copy the data instead of taking a new buffer reference */
+    impl->buffer = NULL;
+    ret = mpp_packet_copy_init(dst, src);
+    impl->buffer = buffer;
+
+    return ret;
+}
+
+MPP_RET Mpp::put_packet(MppPacket packet)
+{
+    if (!mInitDone)
+        return MPP_ERR_INIT;
+
+    MPP_RET ret = MPP_NOK;
+    MppTask task_dequeue = NULL;
+    MppPacket pkt_in = NULL;
+
+    if (mDisableThread) {
+        mpp_err_f("no thread decoding case MUST use mpi_decode interface\n");
+        return ret;
+    }
+
+    if (mExtraPacket) {
+        MppPacket extra = mExtraPacket;
+
+        mExtraPacket = NULL;
+        put_packet(extra);
+    }
+
+    ret = get_input_task(mpp_packet_get_eos(packet), &task_dequeue);
+    if (ret)
+        goto RET;
+
+    ret = dec_copy_input_packet(&pkt_in, packet);
+    if (ret) {
+        mpp_err_f("failed to init input packet ret %d\n", ret);
+        /* keep current task for next */
+        mInputTask = task_dequeue;
+        goto RET;
+    }
+    mpp_packet_set_length(packet, 0);
+    packet = pkt_in;
 
     /* setup task */
     ret = mpp_task_meta_set_packet(task_dequeue, KEY_INPUT_PACKET, packet);
@@ -464,21 +534,107 @@ MPP_RET Mpp::put_packet(MppPacket packet)
     }
 
     mPacketPutCount++;
-
-    if (timeout && !pkt_copy)
-        ret = poll(MPP_PORT_INPUT, timeout);
+    mpp_metrics_add(mMetrics, MPP_STATS_PKT_IN, 1);
 
 RET:
-    /* wait enqueued task finished */
-    if (NULL == mInputTask) {
-        MPP_RET cnt = poll(MPP_PORT_INPUT, MPP_POLL_NON_BLOCK);
-        /* reserve one task for eos block mode */
-        if (cnt >= 0) {
-            dequeue(MPP_PORT_INPUT, &mInputTask);
-            mpp_assert(mInputTask);
+    reserve_input_task();
+
+    return ret;
+}
+
+MPP_RET Mpp::put_packets(MppPacket *packets, RK_S32 count)
+{
+    if (!mInitDone)
+        return MPP_ERR_INIT;
+
+    MPP_RET ret = MPP_NOK;
+    MppTask task_dequeue = NULL;
+    MppPacket *batch = NULL;
+    RK_S32 i;
+
+    if (mDisableThread) {
+        mpp_err_f("no thread decoding case MUST use mpi_decode interface\n");
+        return ret;
+    }
+
+    /* mjpeg advanced task flow needs one output frame per input packet */
+    if (count == 1 || mCoding == MPP_VIDEO_CodingMJPEG) {
+        for (i = 0; i < count; i++) {
+            ret = put_packet(packets[i]);
+            if (ret)
+                break;
+        }
+        return ret;
+    }
+
+    for (i = 0; i < count - 1; i++) {
+        if (mpp_packet_get_eos(packets[i])) {
+            mpp_err_f("only the last packet can be eos, found eos at %d\n", i);
+            return MPP_ERR_VALUE;
+        }
+    }
+
+    if (mExtraPacket) {
+        MppPacket extra = mExtraPacket;
+
+        mExtraPacket = NULL;
+        put_packet(extra);
+    }
+
+    ret = get_input_task(mpp_packet_get_eos(packets[count - 1]), &task_dequeue);
+    if (ret)
+        goto RET;
+
+    /* decoder thread owns the array and the packets after enqueue */
+    batch = mpp_calloc(MppPacket, count + 1);
+    if (NULL == batch) {
+        mpp_err_f("failed to alloc %d packets\n", count);
+        ret = MPP_ERR_MALLOC;
+        mInputTask = task_dequeue;
+        goto RET;
+    }
+
+    /* same copy rule as put_packet */
+    for (i = 0; i < count; i++) {
+        ret = dec_copy_input_packet(&batch[i], packets[i]);
+        if (ret) {
+            mpp_err_f("failed to init input packet %d ret %d\n", i, ret);
+            break;
         }
     }
 
+    if (!ret)
+        ret = mpp_task_meta_set_ptr(task_dequeue, KEY_INPUT_PACKETS, batch);
+
+    if (ret) {
+        for (i = 0; i < count; i++) {
+            if (batch[i])
+                mpp_packet_deinit(&batch[i]);
+        }
+        MPP_FREE(batch);
+        /* keep current task for next */
+        mInputTask = task_dequeue;
+        goto RET;
+    }
+
+    for (i = 0; i < count; i++) {
+        mpp_packet_set_length(packets[i], 0);
+        mpp_ops_dec_put_pkt(mDump, batch[i]);
+    }
+
+    /* enqueue valid task to decoder */
+    ret = enqueue(MPP_PORT_INPUT, task_dequeue);
+    if (ret) {
+        mpp_err_f("enqueue ret %d\n", ret);
+        goto RET;
+    }
+
+    mPacketPutCount += count;
+    mpp_metrics_add(mMetrics, MPP_STATS_PKT_IN, count);
+
+RET:
+    reserve_input_task();
+
     return ret;
 }
 
@@ -721,6 +877,7 @@ MPP_RET Mpp::put_frame(MppFrame frame)
     }
 
     mInputTask = NULL;
+    mpp_metrics_add(mMetrics, MPP_STATS_FRM_IN, 1);
     /* wait enqueued task finished */
     mpp_stopwatch_record(stopwatch, "input port user poll");
     ret = poll(MPP_PORT_INPUT, mInputTimeout);
@@ -829,6 +986,8 @@ MPP_RET Mpp::put_frame_async(MppFrame frame)
 
     mFrmIn->add_at_tail(&frame, sizeof(frame));
     mFramePutCount++;
+    mpp_frame_trace_input(mTrace);
+    mpp_metrics_add(mMetrics, MPP_STATS_FRM_IN, 1);
 
     notify(MPP_INPUT_ENQUEUE);
     mFrmIn->unlock();
@@ -974,8 +1133,12 @@ MPP_RET Mpp::enqueue(MppPortType type, MppTask task)
     if (port) {
         ret = mpp_port_enqueue(port, task);
         // if enqueue success wait up thread
-        if (MPP_OK == ret)
+        if (MPP_OK == ret) {
+            if (type == MPP_PORT_INPUT)
+                mpp_frame_trace_input(mTrace);
+
             notify(notify_flag);
+        }
     }
 
     return ret;
@@ -1100,6 +1263,8 @@ MPP_RET Mpp::reset()
         mpp_enc_reset_v2(mEnc);
     }
 
+    mpp_frame_trace_reset(mTrace);
+
     return MPP_OK;
 }
 
@@ -1132,6 +1297,36 @@ MPP_RET Mpp::control_mpp(MpiCmd cmd, MppParam param)
         mDisableThread = 1;
     } break;
 
+    case MPP_SET_FRAME_TRACE: {
+        RK_U32 size = (param) ? *((RK_U32 *)param) : 0;
+
+        /*
+         * the trace is kept until deinit once created as the codec threads
+         * access it without lock, ring size can not be changed afterwards
+         */
+        if (mTrace) {
+            mpp_frame_trace_enable(mTrace, size > 0);
+        } else if (size) {
+            MppFrameTrace trace = NULL;
+
+            ret = mpp_frame_trace_init(&trace, size);
+            MPP_SYNC();
+            mTrace = trace;
+        }
+    } break;
+    case MPP_GET_FRAME_TRACE: {
+        ret = mpp_frame_trace_get(mTrace, (MppFrameTraceInfo *)param);
+    } break;
+    case MPP_GET_STATS: {
+        ret = mpp_metrics_snapshot(mMetrics, (MppStats *)param);
+    } break;
+    case MPP_DUMP_FRAME_TRACE: {
+        const char *tag = (mType == MPP_CTX_DEC) ? "dec" :
+                          (mType == MPP_CTX_ENC) ? "enc" : NULL;
+
+        ret = mpp_frame_trace_dump(mTrace, (const char *)param, tag);
+    } break;
+
     case MPP_SET_INPUT_TIMEOUT:
     case MPP_SET_OUTPUT_TIMEOUT: {
         MppPollType timeout = (param) ? *((MppPollType *)param) : MPP_POLL_NON_BLOCK;
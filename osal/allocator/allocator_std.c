@@ -15,8 +15,11 @@
  */
 
 #include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "os_mem.h"
+#include "mpp_env.h"
 #include "mpp_mem.h"
 #include "mpp_debug.h"
 
@@ -26,8 +29,20 @@ typedef struct {
     size_t              alignment;
     MppAllocFlagType    flags;
     RK_S32              fd_count;
+    /* buffers get unique fds of /dev/null for the null device */
+    RK_U32              null_device;
 } allocator_ctx;
 
+static RK_S32 allocator_std_null_fd(void)
+{
+    RK_S32 fd = open("/dev/null", O_RDWR | O_CLOEXEC);
+
+    if (fd < 0)
+        mpp_err_f("failed to open /dev/null\n");
+
+    return fd;
+}
+
 static MPP_RET allocator_std_open(void **ctx, size_t alignment, MppAllocFlagType flags)
 {
     allocator_ctx *p = NULL;
@@ -44,6 +59,7 @@ static MPP_RET allocator_std_open(void **ctx, size_t alignment, MppAllocFlagType
         p->alignment = alignment;
         p->flags = flags;
         p->fd_count = 0;
+        mpp_env_get_u32("mpp_device_null", &p->null_device, 0);
     }
 
     *ctx = p;
@@ -52,22 +68,44 @@ static MPP_RET allocator_std_open(void **ctx, size_t alignment, MppAllocFlagType
 
 static MPP_RET allocator_std_alloc(void *ctx, MppBufferInfo *info)
 {
+    allocator_ctx *p = (allocator_ctx *)ctx;
+
     if (NULL == ctx) {
         mpp_err_f("found NULL context input\n");
         return MPP_ERR_NULL_PTR;
     }
 
-    mpp_err_f("Warning: std allocator should be used on simulation mode only\n");
-    (void)info;
+    if (!p->null_device) {
+        mpp_err_f("Warning: std allocator should be used on simulation mode only\n");
+        return MPP_NOK;
+    }
 
-    return MPP_NOK;
+    /* system memory for simulation with null device */
+    if (os_malloc(&info->ptr, p->alignment, info->size)) {
+        mpp_err_f("failed to malloc size %d\n", (RK_S32)info->size);
+        info->ptr = NULL;
+        return MPP_ERR_MALLOC;
+    }
+
+    info->hnd   = NULL;
+    info->fd    = allocator_std_null_fd();
+    if (info->fd < 0) {
+        os_free(info->ptr);
+        info->ptr = NULL;
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
 }
 
 static MPP_RET allocator_std_free(void *ctx, MppBufferInfo *info)
 {
-    (void) ctx;
+    allocator_ctx *p = (allocator_ctx *)ctx;
+
     if (info->ptr)
         os_free(info->ptr);
+    if (p->null_device && info->fd >= 0)
+        close(info->fd);
     return MPP_OK;
 }
 
@@ -78,15 +116,18 @@ static MPP_RET allocator_std_import(void *ctx, MppBufferInfo *info)
     mpp_assert(info->ptr);
     mpp_assert(info->size);
     info->hnd   = NULL;
-    info->fd    = p->fd_count++;
-    return MPP_OK;
+    info->fd    = p->null_device ? allocator_std_null_fd() : p->fd_count++;
+    return p->null_device && info->fd < 0 ? MPP_NOK : MPP_OK;
 }
 
 static MPP_RET allocator_std_release(void *ctx, MppBufferInfo *info)
 {
-    (void) ctx;
+    allocator_ctx *p = (allocator_ctx *)ctx;
+
     mpp_assert(info->ptr);
     mpp_assert(info->size);
+    if (p->null_device && info->fd >= 0)
+        close(info->fd);
     info->ptr   = NULL;
     info->size  = 0;
     info->hnd   = NULL;
@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef __MPP_IOVA_CACHE_H__
+#define __MPP_IOVA_CACHE_H__
+
+#include "rk_type.h"
+#include "mpp_err.h"
+
+typedef void* MppIovaCache;
+
+/*
+ * Send attach and release of fds in one request. Iova of each attached fd is
+ * returned in place. Releases are sent before attaches.
+ */
+typedef MPP_RET (*MppIovaCacheFunc)(void *ctx, RK_S32 *attach, RK_S32 attach_cnt,
+                                    RK_S32 *release, RK_S32 release_cnt);
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Iova cache
+ *
+ * Map dma-buf inode to the iova attached on one device. A dma-buf imported
+ * again with a new fd hits the entry attached before. The entry keeps a dup
+ * fd of the dma-buf so that its release still reaches the same buffer after
+ * the user fd is closed. Entries no longer used are kept in lru order up to
+ * idle_max and their releases are sent in batch with the next attach.
+ */
+MPP_RET mpp_iova_cache_init(MppIovaCache *cache, RK_S32 idle_max,
+                            MppIovaCacheFunc func, void *ctx);
+/* release all entries, entries in use are released as well */
+MPP_RET mpp_iova_cache_deinit(MppIovaCache cache);
+
+/* entry is NULL when fd can not be cached and caller attaches fd itself */
+MPP_RET mpp_iova_cache_get(MppIovaCache cache, RK_S32 fd, RK_U32 *iova, void **entry);
+MPP_RET mpp_iova_cache_put(MppIovaCache cache, void *entry);
+void    mpp_iova_cache_dump(MppIovaCache cache, const char *info);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __MPP_IOVA_CACHE_H__ */
@@ -21,6 +21,7 @@
 
 #include "mpp_device.h"
 #include "mpp_service.h"
+#include "mpp_iova_cache.h"
 
 #define MAX_REG_OFFSET          64
 #define MAX_RCB_OFFSET          32
@@ -71,6 +72,8 @@ typedef struct MppDevMppService_t {
 
     pthread_mutex_t     lock_bufs;
     struct list_head    list_bufs;
+    /* attached dma-buf kept by inode, protected by lock_bufs */
+    MppIovaCache        iova_cache;
 } MppDevMppService;
 
 #ifdef  __cplusplus
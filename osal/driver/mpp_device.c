@@ -26,6 +26,7 @@
 #include "mpp_device_debug.h"
 #include "mpp_service_api.h"
 #include "vcodec_service_api.h"
+#include "mpp_null_device_api.h"
 
 typedef struct MppDevImpl_t {
     MppClientType   type;
@@ -47,27 +48,36 @@ MPP_RET mpp_dev_init(MppDev *ctx, MppClientType type)
 
     *ctx = NULL;
 
-    RK_U32 codec_type = mpp_get_vcodec_type();
-    if (!(codec_type & (1 << type))) {
-        mpp_err_f("found unsupported client type %d in platform %x\n",
-                  type, codec_type);
-        return MPP_ERR_VALUE;
-    }
-
-    MppIoctlVersion ioctl_version = mpp_get_ioctl_version();
+    RK_U32 null_device = 0;
     const MppDevApi *api = NULL;
 
-    switch (ioctl_version) {
-    case IOCTL_VCODEC_SERVICE : {
-        api = &vcodec_service_api;
-    } break;
-    case IOCTL_MPP_SERVICE_V1 : {
-        api = &mpp_service_api;
-    } break;
-    default : {
-        mpp_err_f("invalid ioctl verstion %d\n", ioctl_version);
-        return MPP_NOK;
-    } break;
+    mpp_env_get_u32("mpp_device_null", &null_device, 0);
+
+    if (null_device) {
+        /* null device accepts all client types without hardware */
+        api = &mpp_null_device_api;
+    } else {
+        RK_U32 codec_type = mpp_get_vcodec_type();
+        if (!(codec_type & (1 << type))) {
+            mpp_err_f("found unsupported client type %d in platform %x\n",
+                      type, codec_type);
+            return MPP_ERR_VALUE;
+        }
+
+        MppIoctlVersion ioctl_version = mpp_get_ioctl_version();
+
+        switch (ioctl_version) {
+        case IOCTL_VCODEC_SERVICE : {
+            api = &vcodec_service_api;
+        } break;
+        case IOCTL_MPP_SERVICE_V1 : {
+            api = &mpp_service_api;
+        } break;
+        default : {
+            mpp_err_f("invalid ioctl verstion %d\n", ioctl_version);
+            return MPP_NOK;
+        } break;
+        }
     }
 
     MppDevImpl *impl = mpp_calloc(MppDevImpl, 1);
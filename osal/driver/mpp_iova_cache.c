@@ -0,0 +1,245 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "mpp_iova_cache"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "mpp_mem.h"
+#include "mpp_list.h"
+#include "mpp_common.h"
+#include "mpp_hash.h"
+#include "mpp_debug.h"
+
+#include "mpp_iova_cache.h"
+
+#define IOVA_CACHE_BITS         6
+/* kernel limits fd count of one trans / release request */
+#define IOVA_CACHE_BATCH        16
+
+typedef struct MppIovaEntry_t {
+    struct hlist_node   hlist;
+    /* link to idle list when no one uses it */
+    struct list_head    list;
+    RK_U64              ino;
+    /* dup fd keeps the dma-buf until release */
+    RK_S32              fd;
+    RK_U32              iova;
+    RK_S32              ref;
+} MppIovaEntry;
+
+typedef struct MppIovaCacheImpl_t {
+    DECLARE_HASHTABLE(hash, IOVA_CACHE_BITS);
+    struct list_head    list_idle;
+    RK_S32              idle_cnt;
+    RK_S32              idle_max;
+
+    MppIovaCacheFunc    func;
+    void                *ctx;
+    RK_S32              release[IOVA_CACHE_BATCH];
+    RK_S32              release_cnt;
+
+    /* statistic */
+    RK_U32              hit;
+    RK_U32              miss;
+    RK_U32              reqs;
+    RK_U32              attached;
+    RK_U32              released;
+} MppIovaCacheImpl;
+
+static MPP_RET iova_cache_send(MppIovaCacheImpl *p, RK_S32 *attach, RK_S32 attach_cnt)
+{
+    MPP_RET ret;
+    RK_S32 i;
+
+    ret = p->func(p->ctx, attach, attach_cnt, p->release, p->release_cnt);
+    if (ret)
+        mpp_err_f("attach %d release %d fds failed ret %d\n",
+                  attach_cnt, p->release_cnt, ret);
+
+    p->reqs++;
+    p->attached += attach_cnt;
+    p->released += p->release_cnt;
+
+    for (i = 0; i < p->release_cnt; i++)
+        close(p->release[i]);
+    p->release_cnt = 0;
+
+    return ret;
+}
+
+static void iova_cache_release(MppIovaCacheImpl *p, MppIovaEntry *entry)
+{
+    hash_del(&entry->hlist);
+    list_del_init(&entry->list);
+
+    if (p->release_cnt >= IOVA_CACHE_BATCH)
+        iova_cache_send(p, NULL, 0);
+
+    p->release[p->release_cnt++] = entry->fd;
+    mpp_free(entry);
+}
+
+MPP_RET mpp_iova_cache_init(MppIovaCache *cache, RK_S32 idle_max,
+                            MppIovaCacheFunc func, void *ctx)
+{
+    MppIovaCacheImpl *p = NULL;
+    RK_U32 i;
+
+    if (NULL == cache || NULL == func) {
+        mpp_err_f("invalid NULL input cache %p func %p\n", cache, func);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    p = mpp_calloc(MppIovaCacheImpl, 1);
+    *cache = p;
+    if (NULL == p) {
+        mpp_err_f("failed to malloc context\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    for (i = 0; i < HASH_SIZE(p->hash); i++)
+        INIT_HLIST_HEAD(&p->hash[i]);
+    INIT_LIST_HEAD(&p->list_idle);
+    p->idle_max = idle_max;
+    p->func = func;
+    p->ctx = ctx;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_iova_cache_deinit(MppIovaCache cache)
+{
+    MppIovaCacheImpl *p = (MppIovaCacheImpl *)cache;
+    MppIovaEntry *pos;
+    struct hlist_node *n;
+    RK_U32 i;
+
+    if (NULL == p)
+        return MPP_OK;
+
+    hash_for_each_safe(p->hash, i, n, pos, hlist) {
+        if (pos->ref)
+            mpp_err_f("release fd %d iova %x still used by %d\n",
+                      pos->fd, pos->iova, pos->ref);
+
+        iova_cache_release(p, pos);
+    }
+
+    if (p->release_cnt)
+        iova_cache_send(p, NULL, 0);
+
+    mpp_free(p);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_iova_cache_get(MppIovaCache cache, RK_S32 fd, RK_U32 *iova, void **entry)
+{
+    MppIovaCacheImpl *p = (MppIovaCacheImpl *)cache;
+    MppIovaEntry *pos = NULL;
+    struct stat st;
+    RK_S32 dup_fd;
+    MPP_RET ret;
+
+    *entry = NULL;
+
+    /*
+     * dma-buf without its own inode shares the anonymous inode of size zero
+     * and can not be told apart from others
+     */
+    if (NULL == p || fstat(fd, &st) || st.st_size <= 0)
+        return MPP_OK;
+
+    hash_for_each_possible(p->hash, pos, hlist, (RK_U64)st.st_ino) {
+        if (pos->ino != (RK_U64)st.st_ino)
+            continue;
+
+        if (!pos->ref++) {
+            list_del_init(&pos->list);
+            p->idle_cnt--;
+        }
+        p->hit++;
+
+        *iova = pos->iova;
+        *entry = pos;
+        return MPP_OK;
+    }
+
+    p->miss++;
+
+    dup_fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (dup_fd < 0)
+        return MPP_OK;
+
+    pos = mpp_calloc(MppIovaEntry, 1);
+    if (NULL == pos) {
+        close(dup_fd);
+        return MPP_OK;
+    }
+
+    /* attach the dup fd as the kernel finds the same dma-buf by either fd */
+    pos->fd = dup_fd;
+    pos->iova = (RK_U32)dup_fd;
+    ret = iova_cache_send(p, (RK_S32 *)&pos->iova, 1);
+    if (ret) {
+        close(dup_fd);
+        mpp_free(pos);
+        *iova = (RK_U32)(-1);
+        return ret;
+    }
+
+    INIT_HLIST_NODE(&pos->hlist);
+    INIT_LIST_HEAD(&pos->list);
+    pos->ino = (RK_U64)st.st_ino;
+    pos->ref = 1;
+    hash_add(p->hash, &pos->hlist, pos->ino);
+
+    *iova = pos->iova;
+    *entry = pos;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_iova_cache_put(MppIovaCache cache, void *entry)
+{
+    MppIovaCacheImpl *p = (MppIovaCacheImpl *)cache;
+    MppIovaEntry *pos = (MppIovaEntry *)entry;
+
+    if (NULL == p || NULL == pos) {
+        mpp_err_f("invalid NULL input cache %p entry %p\n", p, pos);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    mpp_assert(pos->ref > 0);
+    if (--pos->ref)
+        return MPP_OK;
+
+    list_add_tail(&pos->list, &p->list_idle);
+    p->idle_cnt++;
+
+    /* release the least recently used one */
+    if (p->idle_cnt > p->idle_max) {
+        MppIovaEntry *lru = list_first_entry(&p->list_idle, MppIovaEntry, list);
+
+        iova_cache_release(p, lru);
+        p->idle_cnt--;
+    }
+
+    return MPP_OK;
+}
+
+void mpp_iova_cache_dump(MppIovaCache cache, const char *info)
+{
+    MppIovaCacheImpl *p = (MppIovaCacheImpl *)cache;
+
+    if (NULL == p)
+        return;
+
+    mpp_log("%s iova cache hit %u miss %u idle %d requests %u attach %u release %u\n",
+            info, p->hit, p->miss, p->idle_cnt, p->reqs, p->attached, p->released);
+}
@@ -0,0 +1,408 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "mpp_null_device"
+
+#include <unistd.h>
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_list.h"
+#include "mpp_time.h"
+#include "mpp_debug.h"
+#include "mpp_common.h"
+
+#include "mpp_device_debug.h"
+#include "mpp_null_device_api.h"
+
+/* register space covered by the shadow registers in byte */
+#define NULL_DEV_REG_SIZE       (256 * 1024)
+#define NULL_DEV_TASK_MAX       16
+#define NULL_DEV_READ_MAX       MPP_MAX_REG_TRANS_NUM
+#define NULL_DEV_IOVA_BASE      0x10000000
+#define NULL_DEV_IOVA_STEP      0x01000000
+
+typedef struct NullDevStatus_t {
+    MppClientType   type;
+    RK_U32          offset;
+    RK_U32          value;
+} NullDevStatus;
+
+typedef struct NullDevTask_t {
+    RK_S32          rd_count;
+    MppDevRegRdCfg  rd[NULL_DEV_READ_MAX];
+    RK_S64          done;
+} NullDevTask;
+
+typedef struct MppDevNull_t {
+    MppClientType   type;
+    RK_S64          latency;
+
+    /*
+     * lock for registers and task ring. hal sends on parser thread and polls
+     * on hal thread.
+     */
+    pthread_mutex_t lock_task;
+
+    /* all written registers are kept for read back */
+    RK_U32          *regs;
+
+    /* tasks are finished one by one like a single hardware core */
+    NullDevTask     tasks[NULL_DEV_TASK_MAX];
+    RK_U32          task_put;
+    RK_U32          task_get;
+    RK_S64          last_done;
+
+    RK_U32          iova;
+    struct list_head list_bufs;
+    pthread_mutex_t lock_bufs;
+} MppDevNull;
+
+/*
+ * Interrupt status returned on poll so the hal sees a finished task without
+ * error. Other registers read back the last written value or zero.
+ */
+static const NullDevStatus null_dev_status[] = {
+    /* vdpu34x / vdpu382 reg224: dec_irq | dec_rdy_sta */
+    {   VPU_CLIENT_RKVDEC,      224 * sizeof(RK_U32),   0x00000005  },
+    {   VPU_CLIENT_HEVC_DEC,    224 * sizeof(RK_U32),   0x00000005  },
+    /* rkjpegd reg1: dec_irq | dec_rdy_sta */
+    {   VPU_CLIENT_JPEG_DEC,    1 * sizeof(RK_U32),     0x00000300  },
+    /* vepu541 / vepu540 int_sta: enc_done_sta */
+    {   VPU_CLIENT_RKVENC,      0x1c,                   0x00000001  },
+    /* vepu580 / vepu540c / vepu510 int_sta: enc_done_sta */
+    {   VPU_CLIENT_RKVENC,      0x2c,                   0x00000001  },
+};
+
+static NullDevTask *null_dev_curr_task(MppDevNull *p)
+{
+    return &p->tasks[p->task_put & (NULL_DEV_TASK_MAX - 1)];
+}
+
+static MPP_RET mpp_null_dev_init(void *ctx, MppClientType type)
+{
+    MppDevNull *p = (MppDevNull *)ctx;
+    RK_U32 latency = 0;
+
+    mpp_env_get_u32("mpp_null_dev_latency", &latency, 0);
+
+    p->type = type;
+    p->latency = latency;
+    p->iova = NULL_DEV_IOVA_BASE;
+    p->regs = mpp_calloc(RK_U32, NULL_DEV_REG_SIZE / sizeof(RK_U32));
+    if (NULL == p->regs) {
+        mpp_err("create shadow registers failed\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    pthread_mutex_init(&p->lock_task, NULL);
+
+    INIT_LIST_HEAD(&p->list_bufs);
+    {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&p->lock_bufs, &attr);
+        pthread_mutexattr_destroy(&attr);
+    }
+
+    mpp_dev_dbg_probe("client %d latency %d us\n", type, latency);
+
+    return MPP_OK;
+}
+
+static MPP_RET mpp_null_dev_deinit(void *ctx)
+{
+    MppDevNull *p = (MppDevNull *)ctx;
+    MppDevBufMapNode *pos, *n;
+
+    pthread_mutex_lock(&p->lock_bufs);
+    list_for_each_entry_safe(pos, n, &p->list_bufs, MppDevBufMapNode, list_dev) {
+        pthread_mutex_t *lock_buf = pos->lock_buf;
+
+        mpp_assert(pos->lock_buf && pos->lock_dev);
+        mpp_assert(pos->lock_dev == &p->lock_bufs);
+
+        pthread_mutex_lock(lock_buf);
+
+        list_del_init(&pos->list_dev);
+        list_del_init(&pos->list_buf);
+        pos->lock_buf = NULL;
+        pos->lock_dev = NULL;
+        pos->iova = (RK_U32)(-1);
+        mpp_mem_pool_put_f(__FUNCTION__, pos->pool, pos);
+
+        pthread_mutex_unlock(lock_buf);
+    }
+    pthread_mutex_unlock(&p->lock_bufs);
+    pthread_mutex_destroy(&p->lock_bufs);
+
+    if (p->task_put != p->task_get)
+        mpp_err_f("client %d has %d tasks not polled\n", p->type,
+                  p->task_put - p->task_get);
+
+    pthread_mutex_destroy(&p->lock_task);
+    MPP_FREE(p->regs);
+
+    return MPP_OK;
+}
+
+static MPP_RET mpp_null_dev_reg_wr(void *ctx, MppDevRegWrCfg *cfg)
+{
+    MppDevNull *p = (MppDevNull *)ctx;
+
+    if (cfg->offset >= NULL_DEV_REG_SIZE ||
+        cfg->size > NULL_DEV_REG_SIZE - cfg->offset) {
+        mpp_err_f("invalid register write offset %x size %d\n",
+                  cfg->offset, cfg->size);
+        return MPP_ERR_VALUE;
+    }
+
+    mpp_dev_dbg_reg("write offset %x size %d\n", cfg->offset, cfg->size);
+    pthread_mutex_lock(&p->lock_task);
+    memcpy((RK_U8 *)p->regs + cfg->offset, cfg->reg, cfg->size);
+    pthread_mutex_unlock(&p->lock_task);
+
+    return MPP_OK;
+}
+
+static MPP_RET mpp_null_dev_reg_rd(void *ctx, MppDevRegRdCfg *cfg)
+{
+    MppDevNull *p = (MppDevNull *)ctx;
+    NullDevTask *task;
+    MPP_RET ret = MPP_OK;
+
+    if (cfg->offset >= NULL_DEV_REG_SIZE ||
+        cfg->size > NULL_DEV_REG_SIZE - cfg->offset) {
+        mpp_err_f("invalid register read offset %x size %d\n",
+                  cfg->offset, cfg->size);
+        return MPP_ERR_VALUE;
+    }
+
+    pthread_mutex_lock(&p->lock_task);
+    task = null_dev_curr_task(p);
+    if (task->rd_count >= NULL_DEV_READ_MAX) {
+        mpp_err_f("too many register read %d\n", task->rd_count);
+        ret = MPP_NOK;
+    } else {
+        task->rd[task->rd_count++] = *cfg;
+    }
+    pthread_mutex_unlock(&p->lock_task);
+
+    return ret;
+}
+
+static MPP_RET mpp_null_dev_reg_offset(void *ctx, MppDevRegOffsetCfg *cfg)
+{
+    MppDevNull *p = (MppDevNull *)ctx;
+    RK_U32 offset = cfg->reg_idx * sizeof(RK_U32);
+
+    /* patch the address register like the kernel does on fd translation */
+    if (offset < NULL_DEV_REG_SIZE) {
+        pthread_mutex_lock(&p->lock_task);
+        p->regs[cfg->reg_idx] += cfg->offset;
+        pthread_mutex_unlock(&p->lock_task);
+    }
+
+    return MPP_OK;
+}
+
+static MPP_RET mpp_null_dev_reg_offsets(void *ctx, MppDevRegOffCfgs *cfgs)
+{
+    RK_S32 i;
+
+    for (i = 0; i < cfgs->count; i++)
+        mpp_null_dev_reg_offset(ctx, &cfgs->cfgs[i]);
+
+    return MPP_OK;
+}
+
+static MPP_RET mpp_null_dev_rcb_info(void *ctx, MppDevRcbInfoCfg *cfg)
+{
+    (void)ctx;
+    (void)cfg;
+
+    return MPP_OK;
+}
+
+static MPP_RET mpp_null_dev_set_info(void *ctx, MppDevInfoCfg *cfg)
+{
+    (void)ctx;
+    (void)cfg;
+
+    return MPP_OK;
+}
+
+static MPP_RET mpp_null_dev_lock_map(void *ctx)
+{
+    MppDevNull *p = (MppDevNull *)ctx;
+
+    pthread_mutex_lock(&p->lock_bufs);
+    return MPP_OK;
+}
+
+static MPP_RET mpp_null_dev_unlock_map(void *ctx)
+{
+    MppDevNull *p = (MppDevNull *)ctx;
+
+    pthread_mutex_unlock(&p->lock_bufs);
+    return MPP_OK;
+}
+
+static MPP_RET mpp_null_dev_attach_fd(void *ctx, MppDevBufMapNode *node)
+{
+    MppDevNull *p = (MppDevNull *)ctx;
+
+    mpp_assert(node->buffer);
+    mpp_assert(node->lock_buf);
+
+    /* fake iova in separated windows so address registers look valid */
+    node->lock_dev = &p->lock_bufs;
+    node->dev_fd = 0;
+    node->iova = p->iova;
+    p->iova += NULL_DEV_IOVA_STEP;
+    if (p->iova < NULL_DEV_IOVA_BASE)
+        p->iova = NULL_DEV_IOVA_BASE;
+
+    list_add_tail(&node->list_dev, &p->list_bufs);
+
+    mpp_dev_dbg_buf("node %p attach fd %d iova %x\n", node, node->buf_fd, node->iova);
+
+    return MPP_OK;
+}
+
+static MPP_RET mpp_null_dev_detach_fd(void *ctx, MppDevBufMapNode *node)
+{
+    MppDevNull *p = (MppDevNull *)ctx;
+
+    mpp_assert(node->buffer);
+    mpp_assert(node->lock_buf);
+    mpp_assert(node->lock_dev == &p->lock_bufs);
+
+    mpp_dev_dbg_buf("node %p detach fd %d iova %x\n", node, node->buf_fd, node->iova);
+
+    node->dev = NULL;
+    node->dev_fd = -1;
+    node->lock_dev = NULL;
+    node->iova = (RK_U32)(-1);
+    list_del_init(&node->list_dev);
+
+    return MPP_OK;
+}
+
+static MPP_RET mpp_null_dev_cmd_send(void *ctx)
+{
+    MppDevNull *p = (MppDevNull *)ctx;
+    NullDevTask *task;
+    RK_S64 now = mpp_time();
+    RK_S64 done;
+
+    pthread_mutex_lock(&p->lock_task);
+    if (p->task_put - p->task_get >= NULL_DEV_TASK_MAX) {
+        pthread_mutex_unlock(&p->lock_task);
+        mpp_err_f("client %d task queue full\n", p->type);
+        return MPP_NOK;
+    }
+
+    task = null_dev_curr_task(p);
+
+    /* the task starts when the previous one is finished */
+    done = MPP_MAX(now, p->last_done) + p->latency;
+    task->done = done;
+    p->last_done = done;
+    p->task_put++;
+
+    /* clear the read config slot for the next task */
+    null_dev_curr_task(p)->rd_count = 0;
+    pthread_mutex_unlock(&p->lock_task);
+
+    mpp_dev_dbg_time("client %d send task done at %lld\n", p->type, done);
+
+    return MPP_OK;
+}
+
+static void null_dev_fill_status(MppDevNull *p, MppDevRegRdCfg *rd)
+{
+    RK_U32 i;
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(null_dev_status); i++) {
+        const NullDevStatus *status = &null_dev_status[i];
+
+        if (status->type != p->type || status->offset < rd->offset ||
+            status->offset + sizeof(RK_U32) > rd->offset + rd->size)
+            continue;
+
+        memcpy((RK_U8 *)rd->reg + status->offset - rd->offset,
+               &status->value, sizeof(RK_U32));
+    }
+}
+
+static MPP_RET mpp_null_dev_cmd_poll(void *ctx, MppDevPollCfg *cfg)
+{
+    MppDevNull *p = (MppDevNull *)ctx;
+    NullDevTask *task;
+    RK_S64 wait;
+    RK_S32 i;
+
+    pthread_mutex_lock(&p->lock_task);
+    if (p->task_put == p->task_get) {
+        pthread_mutex_unlock(&p->lock_task);
+        mpp_err_f("client %d poll without task\n", p->type);
+        return MPP_NOK;
+    }
+
+    task = &p->tasks[p->task_get & (NULL_DEV_TASK_MAX - 1)];
+    wait = task->done - mpp_time();
+    pthread_mutex_unlock(&p->lock_task);
+
+    /* do not block send on the other thread while the task is running */
+    if (wait > 0)
+        usleep(wait);
+
+    pthread_mutex_lock(&p->lock_task);
+    for (i = 0; i < task->rd_count; i++) {
+        MppDevRegRdCfg *rd = &task->rd[i];
+
+        memcpy(rd->reg, (RK_U8 *)p->regs + rd->offset, rd->size);
+        null_dev_fill_status(p, rd);
+    }
+    task->rd_count = 0;
+    p->task_get++;
+    pthread_mutex_unlock(&p->lock_task);
+
+    /* whole frame finished in one slice */
+    if (cfg && cfg->count_max) {
+        cfg->count_ret = 1;
+        cfg->slice_info[0].val = 0;
+        cfg->slice_info[0].last = 1;
+    }
+
+    return MPP_OK;
+}
+
+const MppDevApi mpp_null_device_api = {
+    "mpp_null_device",
+    sizeof(MppDevNull),
+    mpp_null_dev_init,
+    mpp_null_dev_deinit,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    mpp_null_dev_reg_wr,
+    mpp_null_dev_reg_rd,
+    mpp_null_dev_reg_offset,
+    mpp_null_dev_reg_offsets,
+    mpp_null_dev_rcb_info,
+    mpp_null_dev_set_info,
+    NULL,
+    mpp_null_dev_lock_map,
+    mpp_null_dev_unlock_map,
+    mpp_null_dev_attach_fd,
+    mpp_null_dev_detach_fd,
+    mpp_null_dev_cmd_send,
+    mpp_null_dev_cmd_poll,
+};
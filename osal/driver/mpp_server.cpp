@@ -36,8 +36,12 @@
 #define MAX_SESSION_TASK    4
 #define MAX_REQ_SEND_CNT    MAX_REQ_NUM
 #define MAX_REQ_WAIT_CNT    2
+/* range of fill window in ms which is also the server timer period */
+#define MIN_FILL_WINDOW     1
+#define MAX_FILL_WINDOW     10
 
 #define MPP_SERVER_DBG_FLOW             (0x00000001)
+#define MPP_SERVER_DBG_STATS            (0x00000002)
 
 #define mpp_serv_dbg(flag, fmt, ...)    _mpp_dbg(mpp_server_debug, flag, fmt, ## __VA_ARGS__)
 #define mpp_serv_dbg_f(flag, fmt, ...)  _mpp_dbg_f(mpp_server_debug, flag, fmt, ## __VA_ARGS__)
@@ -85,6 +89,9 @@ struct MppDevTask_t {
 
     MppReqV1            *req;
     RK_S32              req_cnt;
+
+    /* time of send_task */
+    RK_S64              time_pending;
 };
 
 struct MppDevBatTask_t {
@@ -110,6 +117,10 @@ struct MppDevBatTask_t {
     RK_S32              fill_full;
     RK_S32              fill_timeout;
     RK_S32              poll_cnt;
+
+    /* time of first task filled and batch sent */
+    RK_S64              time_fill;
+    RK_S64              time_send;
 };
 
 struct MppDevSession_t {
@@ -130,6 +141,9 @@ struct MppDevSession_t {
     RK_S32              task_wait;
     RK_S32              task_done;
 
+    /* lock by cond */
+    MppServerSessionStats stats;
+
     MppDevTask          tasks[MAX_SESSION_TASK];
 };
 
@@ -160,10 +174,69 @@ struct MppDevBatServ_t {
     /* link to all pending tasks */
     struct list_head    pending_task;
     RK_S32              pending_count;
+
+    /*
+     * adaptive batch window
+     * batch_target is the count of tasks arriving during one hardware run and
+     * fill_window is the longest time a partial batch waits for more tasks.
+     * last_arrival and arrival_us are lock by server lock.
+     */
+    RK_S64              last_arrival;
+    RK_S64              arrival_us;
+    RK_S64              hw_us;
+    RK_S32              batch_target;
+    RK_S32              fill_window;
+
+    /* lock by server lock */
+    MppServerStats      stats;
 };
 
 RK_U32 mpp_server_debug = 0;
 
+/* moving average with 1/8 weight on new sample */
+#define EWMA_UPDATE(avg, val) \
+    do { \
+        if (avg) \
+            avg += ((val) - (avg)) / 8; \
+        else \
+            avg = (val); \
+    } while (0)
+
+static RK_S32 hist_bin(RK_S64 val)
+{
+    RK_S32 bin = (val > 1) ? mpp_log2((RK_U32)MPP_MIN(val, 0x7fffffff)) : 0;
+
+    return MPP_MIN(bin, MPP_SERVER_HIST_BINS - 1);
+}
+
+static void server_update_window(MppDevBatServ *server)
+{
+    RK_S32 target = server->max_task_in_batch;
+    RK_S32 window = MAX_FILL_WINDOW;
+    RK_S64 arrival = server->arrival_us;
+    RK_S64 hw = server->hw_us;
+
+    if (arrival > 0 && hw > 0) {
+        /* more tasks than one hardware run can gather only add latency */
+        target = (RK_S32)MPP_CLIP3(1, server->max_task_in_batch,
+                                   (hw + arrival / 2) / arrival);
+        /* wait no longer than the time to gather the target count */
+        window = (RK_S32)MPP_CLIP3(MIN_FILL_WINDOW, MAX_FILL_WINDOW,
+                                   (arrival * (target - 1) + 999) / 1000);
+    }
+
+    if (target != server->batch_target || window != server->fill_window)
+        mpp_serv_dbg_flow("batch window target %d -> %d window %d -> %d ms arrival %lld hw %lld us\n",
+                          server->batch_target, target, server->fill_window,
+                          window, arrival, hw);
+
+    server->batch_target = target;
+    if (window != server->fill_window) {
+        server->fill_window = window;
+        mpp_timer_set_timing(server->timer, window, window);
+    }
+}
+
 static void batch_reset(MppDevBatTask *batch)
 {
     mpp_assert(list_empty(&batch->link_tasks));
@@ -234,6 +307,33 @@ void batch_send(MppDevBatServ *server, MppDevBatTask *batch)
     server->batch_run++;
     mpp_serv_dbg_flow("batch %d -> send %d for %s\n", batch->batch_id,
                       batch->fill_cnt, batch->fill_timeout ? "timeout" : "ready");
+
+    {
+        MppServerStats *stats = &server->stats;
+        RK_S64 now = mpp_time();
+        MppDevTask *task;
+
+        batch->time_send = now;
+
+        server->lock->lock();
+        stats->batch_count++;
+        stats->task_count += batch->fill_cnt;
+        if (batch->fill_full)
+            stats->batch_full++;
+        else if (batch->fill_timeout)
+            stats->batch_timeout++;
+        else
+            stats->batch_idle++;
+
+        list_for_each_entry(task, &batch->link_tasks, MppDevTask, link_batch) {
+            RK_S64 delay = now - task->time_pending;
+
+            stats->queue_delay_sum += delay;
+            stats->queue_delay_max = MPP_MAX(stats->queue_delay_max, delay);
+            stats->queue_delay_hist[hist_bin(delay)]++;
+        }
+        server->lock->unlock();
+    }
 }
 
 void process_task(void *p)
@@ -279,12 +379,18 @@ void process_task(void *p)
                     continue;
                 }
                 if (ret == 0) {
+                    RK_S64 wait = mpp_time() - task->time_pending;
+
                     list_del_init(&task->link_batch);
                     task->batch = NULL;
 
                     mpp_serv_dbg_flow("batch %d:%d session %d ready and remove\n",
                                       batch->batch_id, task->batch_slot_id, session->client);
                     session->cond->lock();
+                    session->stats.task_count++;
+                    session->stats.wait_sum += wait;
+                    session->stats.wait_max = MPP_MAX(session->stats.wait_max, wait);
+                    session->stats.wait_hist[hist_bin(wait)]++;
                     session->task_done++;
                     session->cond->signal();
                     session->cond->unlock();
@@ -301,6 +407,7 @@ void process_task(void *p)
 
             if (batch->poll_cnt == batch->fill_cnt) {
                 mpp_serv_dbg_flow("batch %d poll done\n", batch->batch_id);
+                EWMA_UPDATE(server->hw_us, mpp_time() - batch->time_send);
                 list_del_init(&batch->link_server);
                 list_add_tail(&batch->link_server, &server->list_batch_free);
                 server->batch_run--;
@@ -321,6 +428,7 @@ void process_task(void *p)
 
     /* 2. get prending task to fill */
     lock->lock();
+    server_update_window(server);
     pending = server->pending_count;
     if (!pending && !server->batch_run && !server->session_count) {
         mpp_timer_set_enable(server->timer, 0);
@@ -358,9 +466,21 @@ try_proc_pending_task:
             return;
         }
 
-        /* send one timeout task */
-        if (batch->fill_cnt)
-            batch_send(server, batch);
+        /*
+         * send the partial batch when hardware is idle, target is reached or
+         * it has waited for the whole fill window
+         */
+        if (batch->fill_cnt) {
+            if (batch->fill_cnt >= server->batch_target) {
+                batch->fill_full = 1;
+                batch_send(server, batch);
+            } else if (!server->batch_run) {
+                batch_send(server, batch);
+            } else if (mpp_time() - batch->time_fill >= server->fill_window * 1000) {
+                batch->fill_timeout = 1;
+                batch_send(server, batch);
+            }
+        }
 
         mpp_serv_dbg_flow("finish for no pending task\n");
         return;
@@ -387,14 +507,16 @@ try_proc_pending_task:
     pending--;
 
     /* first task and setup new batch id */
-    if (!batch->fill_cnt)
+    if (!batch->fill_cnt) {
         batch->batch_id = server->batch_id++;
+        batch->time_fill = mpp_time();
+    }
 
     task->batch = batch;
     task->batch_slot_id = batch->fill_cnt++;
     mpp_assert(task->batch_slot_id < server->max_task_in_batch);
     list_add_tail(&task->link_batch, &batch->link_tasks);
-    if (batch->fill_cnt >= server->max_task_in_batch)
+    if (batch->fill_cnt >= server->batch_target)
         batch->fill_full = 1;
 
     session = task->session;
@@ -488,6 +610,12 @@ MPP_RET send_task(MppDevMppService *ctx)
     session->cond->unlock();
 
     server->lock->lock();
+    task->time_pending = mpp_time();
+    /* an idle gap is not an arrival rate so clip it to 100ms */
+    if (server->last_arrival)
+        EWMA_UPDATE(server->arrival_us,
+                    MPP_MIN(task->time_pending - server->last_arrival, 100000));
+    server->last_arrival = task->time_pending;
     task->task_id = server->task_id++;
     list_del_init(&task->link_server);
     list_add_tail(&task->link_server, &server->pending_task);
@@ -571,6 +699,8 @@ public:
     MPP_RET attach(MppDevMppService *ctx);
     MPP_RET detach(MppDevMppService *ctx);
 
+    MPP_RET get_stats(MppClientType client_type, MppServerStats *stats);
+
     MPP_RET check_status(void);
 };
 
@@ -697,8 +827,8 @@ MppDevBatServ *MppDevServer::bat_server_get(MppClientType client_type)
     }
 
     mpp_timer_set_callback(server->timer, mpp_server_thread, server);
-    /* 10ms */
-    mpp_timer_set_timing(server->timer, 10, 10);
+    /* start from the widest window and adapt on load */
+    mpp_timer_set_timing(server->timer, MAX_FILL_WINDOW, MAX_FILL_WINDOW);
 
     INIT_LIST_HEAD(&server->session_list);
     INIT_LIST_HEAD(&server->list_batch);
@@ -707,6 +837,8 @@ MppDevBatServ *MppDevServer::bat_server_get(MppClientType client_type)
 
     server->batch_pool = mBatchPool;
     server->max_task_in_batch = mMaxTaskInBatch;
+    server->batch_target = mMaxTaskInBatch;
+    server->fill_window = MAX_FILL_WINDOW;
 
     mBatServer[client_type] = server;
     return server;
@@ -741,6 +873,21 @@ MPP_RET MppDevServer::bat_server_put(MppClientType client_type)
         return MPP_OK;
 
     server = mBatServer[client_type];
+
+    if (mpp_server_debug & MPP_SERVER_DBG_STATS) {
+        MppServerStats stats;
+
+        get_stats(client_type, &stats);
+        mpp_log("%s batch %lld full %lld idle %lld timeout %lld task %lld fill %d%%\n",
+                strof_client_type(client_type), stats.batch_count,
+                stats.batch_full, stats.batch_idle, stats.batch_timeout,
+                stats.task_count, stats.fill_ratio);
+        mpp_log("%s queue delay avg %lld max %lld us\n",
+                strof_client_type(client_type),
+                stats.task_count ? stats.queue_delay_sum / stats.task_count : 0,
+                stats.queue_delay_max);
+    }
+
     mBatServer[client_type] = NULL;
 
     mpp_assert(server->batch_run == 0);
@@ -811,6 +958,8 @@ MPP_RET MppDevServer::attach(MppDevMppService *ctx)
     session->cond = new MppMutexCond();
     session->task_wait = 0;
     session->task_done = 0;
+    memset(&session->stats, 0, sizeof(session->stats));
+    session->stats.client = ctx->client;
 
     for (i = 0; i < MPP_ARRAY_ELEMS(session->tasks); i++) {
         MppDevTask *task = &session->tasks[i];
@@ -873,6 +1022,15 @@ MPP_RET MppDevServer::detach(MppDevMppService *ctx)
 
     list_del_init(&session->list_server);
 
+    if (mpp_server_debug & MPP_SERVER_DBG_STATS) {
+        MppServerSessionStats *stats = &session->stats;
+
+        mpp_log("session %d task %lld wait avg %lld max %lld us\n",
+                stats->client, stats->task_count,
+                stats->task_count ? stats->wait_sum / stats->task_count : 0,
+                stats->wait_max);
+    }
+
     if (session->cond) {
         delete session->cond;
         session->cond = NULL;
@@ -885,6 +1043,38 @@ MPP_RET MppDevServer::detach(MppDevMppService *ctx)
     return MPP_OK;
 }
 
+MPP_RET MppDevServer::get_stats(MppClientType client_type, MppServerStats *stats)
+{
+    MppDevBatServ *server = NULL;
+
+    if (client_type < 0 || client_type >= VPU_CLIENT_BUTT || NULL == stats) {
+        mpp_err_f("invalid client type %d stats %p\n", client_type, stats);
+        return MPP_NOK;
+    }
+
+    AutoMutex auto_lock(this);
+
+    server = mBatServer[client_type];
+    if (NULL == server) {
+        memset(stats, 0, sizeof(*stats));
+        return MPP_NOK;
+    }
+
+    server->lock->lock();
+    *stats = server->stats;
+    stats->max_task_in_batch = server->max_task_in_batch;
+    stats->batch_target = server->batch_target;
+    stats->fill_window = server->fill_window;
+    stats->arrival_interval = server->arrival_us;
+    stats->hw_time = server->hw_us;
+    stats->fill_ratio = stats->batch_count ?
+                        (RK_S32)(stats->task_count * 100 /
+                                 (stats->batch_count * server->max_task_in_batch)) : 0;
+    server->lock->unlock();
+
+    return MPP_OK;
+}
+
 MPP_RET MppDevServer::check_status(void)
 {
     if (!mInited) {
@@ -926,3 +1116,29 @@ MPP_RET mpp_server_wait_task(MppDev ctx, RK_S64 timeout)
 
     return ret;
 }
+
+MPP_RET mpp_server_get_stats(MppClientType type, MppServerStats *stats)
+{
+    MPP_RET ret = MppDevServer::get_inst()->check_status();
+    if (!ret)
+        ret = MppDevServer::get_inst()->get_stats(type, stats);
+
+    return ret;
+}
+
+MPP_RET mpp_server_get_session_stats(MppDev ctx, MppServerSessionStats *stats)
+{
+    MppDevMppService *dev = (MppDevMppService *)ctx;
+    MppDevSession *session = dev ? (MppDevSession *)dev->serv_ctx : NULL;
+
+    if (NULL == session || NULL == stats) {
+        mpp_err_f("invalid ctx %p session %p stats %p\n", ctx, session, stats);
+        return MPP_NOK;
+    }
+
+    session->cond->lock();
+    *stats = session->stats;
+    session->cond->unlock();
+
+    return MPP_OK;
+}
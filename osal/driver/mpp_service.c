@@ -304,6 +304,66 @@ static MPP_RET mpp_service_ioc_detach_fd(MppDevBufMapNode *node)
     return ret;
 }
 
+static MPP_RET mpp_service_ioc_cache_fds(void *ctx, RK_S32 *attach, RK_S32 attach_cnt,
+                                         RK_S32 *release, RK_S32 release_cnt)
+{
+    MppDevMppService *p = (MppDevMppService *)ctx;
+    MppReqV1 mpp_req[2];
+    RK_S32 req_cnt = 0;
+    RK_S32 i;
+    MPP_RET ret;
+
+    /* release first as the same dma-buf may be attached again */
+    if (release_cnt) {
+        mpp_req[req_cnt].cmd = MPP_CMD_RELEASE_FD;
+        mpp_req[req_cnt].flag = 0;
+        mpp_req[req_cnt].size = release_cnt * sizeof(RK_U32);
+        mpp_req[req_cnt].offset = 0;
+        mpp_req[req_cnt].data_ptr = REQ_DATA_PTR(release);
+        req_cnt++;
+    }
+
+    if (attach_cnt) {
+        mpp_req[req_cnt].cmd = MPP_CMD_TRANS_FD_TO_IOVA;
+        mpp_req[req_cnt].flag = 0;
+        mpp_req[req_cnt].size = attach_cnt * sizeof(RK_U32);
+        mpp_req[req_cnt].offset = 0;
+        mpp_req[req_cnt].data_ptr = REQ_DATA_PTR(attach);
+        req_cnt++;
+    }
+
+    if (!req_cnt)
+        return MPP_OK;
+
+    for (i = 0; i < req_cnt - 1; i++)
+        mpp_req[i].flag |= MPP_FLAGS_MULTI_MSG;
+    mpp_req[req_cnt - 1].flag |= MPP_FLAGS_LAST_MSG;
+
+    ret = mpp_service_ioctl_request(p->client, &mpp_req[0]);
+    if (ret) {
+        mpp_err_f("failed ret %d errno %d %s\n", ret, errno, strerror(errno));
+        for (i = 0; i < attach_cnt; i++)
+            attach[i] = -1;
+    }
+
+    return ret;
+}
+
+static MPP_RET mpp_service_release_node(MppDevMppService *p, MppDevBufMapNode *node)
+{
+    MPP_RET ret;
+
+    if (node->cache) {
+        ret = mpp_iova_cache_put(p->iova_cache, node->cache);
+        node->cache = NULL;
+        node->iova = (RK_U32)(-1);
+    } else {
+        ret = mpp_service_ioc_detach_fd(node);
+    }
+
+    return ret;
+}
+
 MPP_RET mpp_service_init(void *ctx, MppClientType type)
 {
     MppDevMppService *p = (MppDevMppService *)ctx;
@@ -369,6 +429,16 @@ MPP_RET mpp_service_init(void *ctx, MppClientType type)
     p->rcb_pos = 0;
     p->rcb_count = 0;
 
+    {
+        RK_U32 iova_cache = 0;
+
+        /* keep idle dma-buf attached for the buffer imported again */
+        mpp_env_get_u32("mpp_dev_iova_cache", &iova_cache, 0);
+        if (iova_cache)
+            mpp_iova_cache_init(&p->iova_cache, iova_cache,
+                                mpp_service_ioc_cache_fds, p);
+    }
+
     INIT_LIST_HEAD(&p->list_bufs);
     {
         pthread_mutexattr_t attr;
@@ -398,11 +468,19 @@ MPP_RET mpp_service_deinit(void *ctx)
         list_del_init(&pos->list_buf);
         pos->lock_buf = NULL;
         pos->lock_dev = NULL;
-        mpp_service_ioc_detach_fd(pos);
+        mpp_service_release_node(p, pos);
         mpp_mem_pool_put_f(__FUNCTION__, pos->pool, pos);
 
         pthread_mutex_unlock(lock_buf);
     }
+
+    if (p->iova_cache) {
+        if (mpp_device_debug & MPP_DEVICE_DBG_PROBE)
+            mpp_iova_cache_dump(p->iova_cache, __FUNCTION__);
+
+        mpp_iova_cache_deinit(p->iova_cache);
+        p->iova_cache = NULL;
+    }
     pthread_mutex_unlock(&p->lock_bufs);
     pthread_mutex_destroy(&p->lock_bufs);
 
@@ -676,7 +754,9 @@ MPP_RET mpp_service_attach_fd(void *ctx, MppDevBufMapNode *node)
 
     node->lock_dev = &p->lock_bufs;
     node->dev_fd = p->client;
-    ret = mpp_service_ioc_attach_fd(node);
+    ret = mpp_iova_cache_get(p->iova_cache, node->buf_fd, &node->iova, &node->cache);
+    if (!ret && !node->cache)
+        ret = mpp_service_ioc_attach_fd(node);
     if (ret) {
         node->lock_dev = NULL;
         node->dev_fd = -1;
@@ -705,7 +785,7 @@ MPP_RET mpp_service_detach_fd(void *ctx, MppDevBufMapNode *node)
     mpp_dev_dbg_buf("node %p dev %d detach fd %d iova %x\n",
                     node, node->dev_fd, node->buf_fd, node->iova);
 
-    ret = mpp_service_ioc_detach_fd(node);
+    ret = mpp_service_release_node(p, node);
     node->dev = NULL;
     node->dev_fd = -1;
     node->lock_dev = NULL;
@@ -125,6 +125,8 @@ typedef struct MppDevBufMapNode_t {
     pthread_mutex_t     *lock_dev;
     RK_S32              dev_fd;
     RK_U32              iova;
+    /* device iova cache entry, NULL when fd is attached directly */
+    void                *cache;
 } MppDevBufMapNode;
 
 typedef struct MppDevApi_t {
@@ -27,13 +27,19 @@ typedef void* MppMemPool;
 extern "C" {
 #endif
 
+/* skip clearing object on get when the pool user always initializes it */
+#define MPP_MEM_POOL_NO_ZERO        (0x00000001)
+
 #define mpp_mem_pool_init(size)     mpp_mem_pool_init_f(__FUNCTION__, size)
+#define mpp_mem_pool_init_flag(size, flag) \
+    mpp_mem_pool_init_flag_f(__FUNCTION__, size, flag)
 #define mpp_mem_pool_deinit(pool)   mpp_mem_pool_deinit_f(__FUNCTION__, pool);
 
 #define mpp_mem_pool_get(pool)      mpp_mem_pool_get_f(__FUNCTION__, pool)
 #define mpp_mem_pool_put(pool, p)   mpp_mem_pool_put_f(__FUNCTION__, pool, p)
 
 MppMemPool mpp_mem_pool_init_f(const char *caller, size_t size);
+MppMemPool mpp_mem_pool_init_flag_f(const char *caller, size_t size, RK_U32 flag);
 void mpp_mem_pool_deinit_f(const char *caller, MppMemPool pool);
 
 void *mpp_mem_pool_get_f(const char *caller, MppMemPool pool);
@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef __MPP_METRICS_H__
+#define __MPP_METRICS_H__
+
+#include "rk_mpi_stats.h"
+#include "mpp_err.h"
+
+typedef void* MppMetrics;
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Session metrics with per-cpu shards
+ *
+ * Each update is one atomic operation on the shard of current cpu so
+ * threads on different cpu never share a cache line. Every update also goes
+ * to the global metrics which keeps the sum of all sessions. Snapshot sums
+ * the shards with atomic loads and takes no lock.
+ * Update functions accept NULL metrics and do nothing.
+ */
+MPP_RET mpp_metrics_init(MppMetrics *metrics);
+MPP_RET mpp_metrics_deinit(MppMetrics metrics);
+
+void mpp_metrics_add(MppMetrics metrics, MppStatsCounter id, RK_S64 val);
+void mpp_metrics_max(MppMetrics metrics, MppStatsGauge id, RK_S64 val);
+void mpp_metrics_time(MppMetrics metrics, MppStatsHistType id, RK_S64 time_us);
+
+/* NULL metrics for the global snapshot */
+MPP_RET mpp_metrics_snapshot(MppMetrics metrics, MppStats *stats);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __MPP_METRICS_H__ */
@@ -0,0 +1,26 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#ifndef __MPP_NULL_DEVICE_API_H__
+#define __MPP_NULL_DEVICE_API_H__
+
+#include "mpp_device.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Software loopback device for benchmarking the framework without hardware.
+ * Enabled by env mpp_device_null=1. Tasks complete after the latency set
+ * by env mpp_null_dev_latency in us.
+ */
+extern const MppDevApi mpp_null_device_api;
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __MPP_NULL_DEVICE_API_H__ */
@@ -19,6 +19,40 @@
 
 #include "mpp_device.h"
 
+/* log2 histogram: bin 0 for < 2us, bin i for [2^i, 2^(i + 1)) us */
+#define MPP_SERVER_HIST_BINS    16
+
+typedef struct MppServerStats_t {
+    /* current adaptive setting */
+    RK_S32      max_task_in_batch;
+    RK_S32      batch_target;
+    RK_S32      fill_window;        /* ms */
+    RK_S64      arrival_interval;   /* us, average task arrival interval */
+    RK_S64      hw_time;            /* us, average hardware time of a batch */
+
+    /* batch fill */
+    RK_U64      batch_count;
+    RK_U64      batch_full;         /* sent on reaching batch_target */
+    RK_U64      batch_idle;         /* sent early as hardware is idle */
+    RK_U64      batch_timeout;      /* sent on fill window timeout */
+    RK_U64      task_count;
+    RK_S32      fill_ratio;         /* percent of max_task_in_batch */
+
+    /* task queueing delay from send_task to batch send */
+    RK_U64      queue_delay_sum;    /* us */
+    RK_S64      queue_delay_max;    /* us */
+    RK_U32      queue_delay_hist[MPP_SERVER_HIST_BINS];
+} MppServerStats;
+
+typedef struct MppServerSessionStats_t {
+    RK_S32      client;
+    /* task wait time from send_task to hardware finish */
+    RK_U64      task_count;
+    RK_U64      wait_sum;           /* us */
+    RK_S64      wait_max;           /* us */
+    RK_U32      wait_hist[MPP_SERVER_HIST_BINS];
+} MppServerSessionStats;
+
 #ifdef  __cplusplus
 extern "C" {
 #endif
@@ -29,6 +63,11 @@ MPP_RET mpp_server_detach(MppDev ctx);
 MPP_RET mpp_server_send_task(MppDev ctx);
 MPP_RET mpp_server_wait_task(MppDev ctx, RK_S64 timeout);
 
+/* statistics of the batch server of one client type */
+MPP_RET mpp_server_get_stats(MppClientType type, MppServerStats *stats);
+/* statistics of the session attached by mpp_server_attach */
+MPP_RET mpp_server_get_session_stats(MppDev ctx, MppServerSessionStats *stats);
+
 #ifdef  __cplusplus
 }
 #endif
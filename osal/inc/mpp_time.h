@@ -84,6 +84,8 @@ const char *mpp_clock_get_name(MppClock clock);
  *    ... running ...
  * 5. mpp_timer_set_enable(initial, 0)
  * 6. mpp_timer_put
+ *
+ * mpp_timer_set_timing on a running timer re-arms it with the new timing.
  */
 MppTimer mpp_timer_get(const char *name);
 void mpp_timer_set_callback(MppTimer timer, MppThreadFunc func, void *ctx);
@@ -26,7 +26,7 @@ RK_S32 mpp_eventfd_get(RK_U32 init)
     RK_S32 fd = eventfd(init, 0);
 
     if (fd < 0)
-        fd = errno;
+        fd = -errno;
 
     return fd;
 }
@@ -55,6 +55,9 @@ RK_S32 mpp_eventfd_read(RK_S32 fd, RK_U64 *val, RK_S64 timeout)
     if (ret == 1 && (nfds.revents & POLLIN) &&
         sizeof(RK_U64) == read(fd, val, sizeof(RK_U64))) {
         ret = 0;
+    } else if (ret == 0) {
+        /* poll does not set errno on timeout */
+        ret = ETIMEDOUT;
     } else
         ret = errno;
 
@@ -17,27 +17,56 @@
 #define MODULE_TAG "mpp_mem_pool"
 
 #include <string.h>
+#include <stdint.h>
 
 #include "mpp_err.h"
 #include "mpp_env.h"
 #include "mpp_mem.h"
 #include "mpp_list.h"
+#include "mpp_lock.h"
 #include "mpp_debug.h"
+#include "mpp_thread.h"
 
 #include "mpp_mem_pool.h"
 
 #define MPP_MEM_POOL_DBG_FLOW           (0x00000001)
+#define MPP_MEM_POOL_DBG_NO_CACHE       (0x00000002)
 
 #define mem_pool_dbg(flag, fmt, ...)    _mpp_dbg(mpp_mem_pool_debug, flag, fmt, ## __VA_ARGS__)
 #define mem_pool_dbg_f(flag, fmt, ...)  _mpp_dbg_f(mpp_mem_pool_debug, flag, fmt, ## __VA_ARGS__)
 
 #define mem_pool_dbg_flow(fmt, ...)     mem_pool_dbg(MPP_MEM_POOL_DBG_FLOW, fmt, ## __VA_ARGS__)
 
+/* pool count with per-thread cache, the others go to depot directly */
+#define MEM_POOL_CACHE_MAX              64
+/* per-thread magazine size and half of it is moved to / from depot at once */
+#define MEM_POOL_MAG_SIZE               16
+#define MEM_POOL_BATCH_SIZE             (MEM_POOL_MAG_SIZE / 2)
+
+/*
+ * Depot head is a batch pointer packed with a tag counter to avoid ABA on
+ * lock-free pop. User space pointer fits in 48 bits on 64bit platform.
+ */
+#if UINTPTR_MAX > 0xFFFFFFFFu
+#define DEPOT_PTR_BITS                  48
+#else
+#define DEPOT_PTR_BITS                  32
+#endif
+#define DEPOT_PTR_MASK                  ((((RK_U64)1) << DEPOT_PTR_BITS) - 1)
+#define DEPOT_PTR(v)                    ((MppMemPoolNode *)(uintptr_t)((v) & DEPOT_PTR_MASK))
+#define DEPOT_PACK(p, v)                ((RK_U64)(uintptr_t)(p) | ((((v) >> DEPOT_PTR_BITS) + 1) << DEPOT_PTR_BITS))
+
 RK_U32 mpp_mem_pool_debug = 0;
 
 typedef struct MppMemPoolNode_t {
+    /* equal to node itself when the node is in use */
     void                *check;
-    struct list_head    list;
+    /* next node in the same batch */
+    struct MppMemPoolNode_t *next;
+    /* next batch in depot, valid on batch head only */
+    struct MppMemPoolNode_t *batch;
+    /* link of all nodes created by pool for final release */
+    struct MppMemPoolNode_t *all;
     void                *ptr;
     size_t              size;
 } MppMemPoolNode;
@@ -45,18 +74,42 @@ typedef struct MppMemPoolNode_t {
 typedef struct MppMemPoolImpl_t {
     void                *check;
     size_t              size;
-    pthread_mutex_t     lock;
+    RK_U32              flag;
+    /* per-thread cache slot, -1 for no cache */
+    RK_S32              index;
+    RK_U32              serial;
     struct list_head    service_link;
 
-    struct list_head    used;
-    struct list_head    unused;
-    RK_S32              used_count;
-    RK_S32              unused_count;
+    /* lock-free stack of free node batches */
+    volatile RK_U64     depot;
+    MppMemPoolNode      *all;
+    RK_S32              node_count;
 
     /* extra flag for C++ static destruction order error */
     RK_S32              finalized;
 } MppMemPoolImpl;
 
+typedef struct MppMemPoolMag_t {
+    /* serial of the pool owning the nodes */
+    RK_U32              serial;
+    RK_S32              count;
+    MppMemPoolNode      *nodes[MEM_POOL_MAG_SIZE];
+} MppMemPoolMag;
+
+typedef struct MppMemPoolCache_t {
+    MppMemPoolMag       *mags[MEM_POOL_CACHE_MAX];
+} MppMemPoolCache;
+
+static pthread_key_t mem_pool_cache_key;
+static pthread_once_t mem_pool_cache_once = PTHREAD_ONCE_INIT;
+/*
+ * thread exit can release its cache during or after static destruction of
+ * the service. plain mutex and flag are never destructed so the release
+ * checks the service is still alive before using it.
+ */
+static pthread_mutex_t mem_pool_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static RK_S32 mem_pool_service_alive = 0;
+
 class MppMemPoolService
 {
 public:
@@ -70,24 +123,146 @@ public:
         return &lock;
     }
 
-    MppMemPoolImpl *get_pool(size_t size);
+    MppMemPoolImpl *get_pool(size_t size, RK_U32 flag);
     void put_pool(MppMemPoolImpl *impl);
+    void put_cache(MppMemPoolCache *cache);
 
 private:
     MppMemPoolService();
     ~MppMemPoolService();
     struct list_head    mLink;
+    RK_U32              mSerial;
+    MppMemPoolImpl      *mSlots[MEM_POOL_CACHE_MAX];
 };
 
+static void depot_push(MppMemPoolImpl *impl, MppMemPoolNode *head)
+{
+    RK_U64 old_val;
+    RK_U64 new_val;
+
+    do {
+        old_val = impl->depot;
+        head->batch = DEPOT_PTR(old_val);
+        new_val = DEPOT_PACK(head, old_val);
+    } while (!MPP_BOOL_CAS(&impl->depot, old_val, new_val));
+}
+
+static MppMemPoolNode *depot_pop(MppMemPoolImpl *impl)
+{
+    MppMemPoolNode *head;
+    RK_U64 old_val;
+    RK_U64 new_val;
+
+    do {
+        old_val = impl->depot;
+        head = DEPOT_PTR(old_val);
+        if (!head)
+            return NULL;
+
+        /* node memory is never freed before pool deinit so it is safe to read */
+        new_val = DEPOT_PACK(head->batch, old_val);
+    } while (!MPP_BOOL_CAS(&impl->depot, old_val, new_val));
+
+    return head;
+}
+
+static void mem_pool_cache_release(void *ctx)
+{
+    MppMemPoolCache *cache = (MppMemPoolCache *)ctx;
+    RK_S32 i;
+
+    pthread_mutex_lock(&mem_pool_cache_lock);
+    if (mem_pool_service_alive) {
+        MppMemPoolService::getInstance()->put_cache(cache);
+    } else if (cache) {
+        /* nodes are freed by the pools on service destruction */
+        for (i = 0; i < MEM_POOL_CACHE_MAX; i++)
+            MPP_FREE(cache->mags[i]);
+
+        mpp_free(cache);
+    }
+    pthread_mutex_unlock(&mem_pool_cache_lock);
+}
+
+static void mem_pool_cache_key_init(void)
+{
+    pthread_key_create(&mem_pool_cache_key, mem_pool_cache_release);
+}
+
+static MppMemPoolMag *mem_pool_get_mag(MppMemPoolImpl *impl)
+{
+    MppMemPoolCache *cache;
+    MppMemPoolMag *mag;
+
+    if (impl->index < 0)
+        return NULL;
+
+    pthread_once(&mem_pool_cache_once, mem_pool_cache_key_init);
+
+    cache = (MppMemPoolCache *)pthread_getspecific(mem_pool_cache_key);
+    if (!cache) {
+        cache = mpp_calloc(MppMemPoolCache, 1);
+        if (!cache)
+            return NULL;
+
+        pthread_setspecific(mem_pool_cache_key, cache);
+    }
+
+    mag = cache->mags[impl->index];
+    if (!mag) {
+        mag = mpp_calloc(MppMemPoolMag, 1);
+        if (!mag)
+            return NULL;
+
+        mag->serial = impl->serial;
+        cache->mags[impl->index] = mag;
+    }
+
+    /* nodes left by a deinit pool on the same slot are already released */
+    if (mag->serial != impl->serial) {
+        mag->serial = impl->serial;
+        mag->count = 0;
+    }
+
+    return mag;
+}
+
+/* move nodes from magazine tail to depot as one batch */
+static void mem_pool_flush_mag(MppMemPoolImpl *impl, MppMemPoolMag *mag, RK_S32 count)
+{
+    MppMemPoolNode *head = NULL;
+    RK_S32 i;
+
+    for (i = 0; i < count && mag->count; i++) {
+        MppMemPoolNode *node = mag->nodes[--mag->count];
+
+        node->next = head;
+        head = node;
+    }
+
+    if (head)
+        depot_push(impl, head);
+}
+
 MppMemPoolService::MppMemPoolService()
 {
     INIT_LIST_HEAD(&mLink);
+    mSerial = 0;
+    memset(mSlots, 0, sizeof(mSlots));
 
     mpp_env_get_u32("mpp_mem_pool_debug", &mpp_mem_pool_debug, 0);
+
+    pthread_mutex_lock(&mem_pool_cache_lock);
+    mem_pool_service_alive = 1;
+    pthread_mutex_unlock(&mem_pool_cache_lock);
 }
 
 MppMemPoolService::~MppMemPoolService()
 {
+    pthread_mutex_lock(&mem_pool_cache_lock);
+    mem_pool_service_alive = 0;
+    pthread_mutex_unlock(&mem_pool_cache_lock);
+
     if (!list_empty(&mLink)) {
         MppMemPoolImpl *pos, *n;
 
@@ -97,36 +272,46 @@ MppMemPoolService::~MppMemPoolService()
     }
 }
 
-MppMemPoolImpl *MppMemPoolService::get_pool(size_t size)
+MppMemPoolImpl *MppMemPoolService::get_pool(size_t size, RK_U32 flag)
 {
     MppMemPoolImpl *pool = mpp_malloc(MppMemPoolImpl, 1);
+    RK_S32 i;
+
     if (NULL == pool)
         return NULL;
 
-    pthread_mutexattr_t attr;
-    pthread_mutexattr_init(&attr);
-    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
-    pthread_mutex_init(&pool->lock, &attr);
-    pthread_mutexattr_destroy(&attr);
-
     pool->check = pool;
     pool->size = size;
-    pool->used_count = 0;
-    pool->unused_count = 0;
+    pool->flag = flag;
+    pool->index = -1;
+    pool->depot = 0;
+    pool->all = NULL;
+    pool->node_count = 0;
     pool->finalized = 0;
 
-    INIT_LIST_HEAD(&pool->used);
-    INIT_LIST_HEAD(&pool->unused);
     INIT_LIST_HEAD(&pool->service_link);
     AutoMutex auto_lock(get_lock());
     list_add_tail(&pool->service_link, &mLink);
 
+    pool->serial = ++mSerial;
+    if (!(mpp_mem_pool_debug & MPP_MEM_POOL_DBG_NO_CACHE)) {
+        for (i = 0; i < MEM_POOL_CACHE_MAX; i++) {
+            if (!mSlots[i]) {
+                mSlots[i] = pool;
+                pool->index = i;
+                break;
+            }
+        }
+    }
+
     return pool;
 }
 
 void MppMemPoolService::put_pool(MppMemPoolImpl *impl)
 {
     MppMemPoolNode *node, *m;
+    RK_S32 used_count = 0;
+    RK_S32 node_count = 0;
 
     if (impl != impl->check) {
         mpp_err_f("invalid mem impl %p check %p\n", impl, impl->check);
@@ -136,45 +321,71 @@ void MppMemPoolService::put_pool(MppMemPoolImpl *impl)
     if (impl->finalized)
         return;
 
-    pthread_mutex_lock(&impl->lock);
+    {
+        AutoMutex auto_lock(get_lock());
+        list_del_init(&impl->service_link);
+        if (impl->index >= 0)
+            mSlots[impl->index] = NULL;
+    }
 
-    if (!list_empty(&impl->unused)) {
-        list_for_each_entry_safe(node, m, &impl->unused, MppMemPoolNode, list) {
-            MPP_FREE(node);
-            impl->unused_count--;
-        }
+    /* nodes in depot and thread caches are all on the all list */
+    for (node = impl->all; node; node = m) {
+        m = node->all;
+        if (node->check == node)
+            used_count++;
+        node_count++;
+        MPP_FREE(node);
     }
 
-    if (!list_empty(&impl->used)) {
-        mpp_err_f("found %d used buffer size %d\n",
-                  impl->used_count, impl->size);
+    if (used_count)
+        mpp_err_f("found %d used buffer size %d\n", used_count, impl->size);
 
-        list_for_each_entry_safe(node, m, &impl->used, MppMemPoolNode, list) {
-            MPP_FREE(node);
-            impl->used_count--;
-        }
-    }
+    if (node_count != impl->node_count)
+        mpp_err_f("pool size %d found leaked buffer created:released [%d:%d]\n",
+                  impl->size, impl->node_count, node_count);
+
+    impl->finalized = 1;
+    mpp_free(impl);
+}
 
-    if (impl->used_count || impl->unused_count)
-        mpp_err_f("pool size %d found leaked buffer used:unused [%d:%d]\n",
-                  impl->size, impl->used_count, impl->unused_count);
+void MppMemPoolService::put_cache(MppMemPoolCache *cache)
+{
+    RK_S32 i;
 
-    pthread_mutex_unlock(&impl->lock);
+    if (!cache)
+        return;
 
     {
         AutoMutex auto_lock(get_lock());
-        list_del_init(&impl->service_link);
+
+        for (i = 0; i < MEM_POOL_CACHE_MAX; i++) {
+            MppMemPoolMag *mag = cache->mags[i];
+            MppMemPoolImpl *impl = mSlots[i];
+
+            if (!mag)
+                continue;
+
+            /* return nodes to depot when the owner pool is still alive */
+            if (impl && impl->serial == mag->serial)
+                mem_pool_flush_mag(impl, mag, mag->count);
+
+            mpp_free(mag);
+        }
     }
 
-    impl->finalized = 1;
-    mpp_free(impl);
+    mpp_free(cache);
 }
 
 MppMemPool mpp_mem_pool_init_f(const char *caller, size_t size)
 {
-    mem_pool_dbg_flow("pool %d init from %s", size, caller);
+    return mpp_mem_pool_init_flag_f(caller, size, 0);
+}
+
+MppMemPool mpp_mem_pool_init_flag_f(const char *caller, size_t size, RK_U32 flag)
+{
+    mem_pool_dbg_flow("pool %d flag %x init from %s", size, flag, caller);
 
-    return (MppMemPool)MppMemPoolService::getInstance()->get_pool(size);
+    return (MppMemPool)MppMemPoolService::getInstance()->get_pool(size, flag);
 }
 
 void mpp_mem_pool_deinit_f(const char *caller, MppMemPool pool)
@@ -189,52 +400,68 @@ void mpp_mem_pool_deinit_f(const char *caller, MppMemPool pool)
 void *mpp_mem_pool_get_f(const char *caller, MppMemPool pool)
 {
     MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
+    MppMemPoolMag *mag = mem_pool_get_mag(impl);
     MppMemPoolNode *node = NULL;
-    void* ptr = NULL;
-
-    pthread_mutex_lock(&impl->lock);
-
-    mem_pool_dbg_flow("pool %d get used:unused [%d:%d] from %s", impl->size,
-                      impl->used_count, impl->unused_count, caller);
-
-    if (!list_empty(&impl->unused)) {
-        node = list_first_entry(&impl->unused, MppMemPoolNode, list);
-        if (node) {
-            list_del_init(&node->list);
-            list_add_tail(&node->list, &impl->used);
-            impl->unused_count--;
-            impl->used_count++;
-            ptr = node->ptr;
-            node->check = node;
-            goto DONE;
+
+    mem_pool_dbg_flow("pool %d get cached %d from %s", impl->size,
+                      mag ? mag->count : -1, caller);
+
+    if (mag && mag->count) {
+        node = mag->nodes[--mag->count];
+        goto DONE;
+    }
+
+    node = depot_pop(impl);
+    if (node) {
+        /* keep the rest of the batch in local magazine */
+        if (mag) {
+            MppMemPoolNode *next = node->next;
+
+            while (next && mag->count < MEM_POOL_MAG_SIZE) {
+                mag->nodes[mag->count++] = next;
+                next = next->next;
+            }
+
+            if (next)
+                depot_push(impl, next);
+        } else if (node->next) {
+            depot_push(impl, node->next);
         }
+        goto DONE;
     }
 
     node = mpp_malloc_size(MppMemPoolNode, sizeof(MppMemPoolNode) + impl->size);
     if (NULL == node) {
         mpp_err_f("failed to create node from size %d pool\n", impl->size);
-        goto DONE;
+        return NULL;
     }
 
-    node->check = node;
     node->ptr = (void *)(node + 1);
     node->size = impl->size;
-    INIT_LIST_HEAD(&node->list);
-    list_add_tail(&node->list, &impl->used);
-    impl->used_count++;
-    ptr = node->ptr;
+    do {
+        node->all = impl->all;
+    } while (!MPP_BOOL_CAS(&impl->all, node->all, node));
+    MPP_FETCH_ADD(&impl->node_count, 1);
+
+    /* new node is always cleared */
+    memset(node->ptr, 0, node->size);
+    node->check = node;
+    node->next = NULL;
+    return node->ptr;
 
 DONE:
-    pthread_mutex_unlock(&impl->lock);
-    if (node)
-        memset(node->ptr, 0 , node->size);
-    return ptr;
+    node->check = node;
+    node->next = NULL;
+    if (!(impl->flag & MPP_MEM_POOL_NO_ZERO))
+        memset(node->ptr, 0, node->size);
+    return node->ptr;
 }
 
 void mpp_mem_pool_put_f(const char *caller, MppMemPool pool, void *p)
 {
     MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
     MppMemPoolNode *node = (MppMemPoolNode *)((RK_U8 *)p - sizeof(MppMemPoolNode));
+    MppMemPoolMag *mag;
 
     if (impl != impl->check) {
         mpp_err_f("invalid mem pool %p check %p\n", impl, impl->check);
@@ -247,16 +474,21 @@ void mpp_mem_pool_put_f(const char *caller, MppMemPool pool, void *p)
         return ;
     }
 
-    pthread_mutex_lock(&impl->lock);
+    node->check = NULL;
+    node->next = NULL;
 
-    mem_pool_dbg_flow("pool %d put used:unused [%d:%d] from %s", impl->size,
-                      impl->used_count, impl->unused_count, caller);
+    mag = mem_pool_get_mag(impl);
 
-    list_del_init(&node->list);
-    list_add(&node->list, &impl->unused);
-    impl->used_count--;
-    impl->unused_count++;
-    node->check = NULL;
+    mem_pool_dbg_flow("pool %d put cached %d from %s", impl->size,
+                      mag ? mag->count : -1, caller);
+
+    if (!mag) {
+        depot_push(impl, node);
+        return;
+    }
+
+    if (mag->count >= MEM_POOL_MAG_SIZE)
+        mem_pool_flush_mag(impl, mag, MEM_POOL_BATCH_SIZE);
 
-    pthread_mutex_unlock(&impl->lock);
+    mag->nodes[mag->count++] = node;
 }
@@ -0,0 +1,202 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "mpp_metrics"
+
+#include <string.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include "mpp_mem.h"
+#include "mpp_log.h"
+#include "mpp_lock.h"
+#include "mpp_common.h"
+#include "mpp_metrics.h"
+
+#define METRICS_SHARDS          8
+#define METRICS_CACHE_LINE      64
+
+typedef struct MppMetricsShard_t {
+    RK_U64          counter[MPP_STATS_COUNTER_BUTT];
+    RK_U64          gauge[MPP_STATS_GAUGE_BUTT];
+    MppStatsHist    hist[MPP_STATS_HIST_BUTT];
+} MppMetricsShard;
+
+/* shards start and stride are cache line aligned to avoid false sharing */
+#define SHARD_STRIDE    MPP_ALIGN(sizeof(MppMetricsShard), METRICS_CACHE_LINE)
+
+typedef struct MppMetricsImpl_t {
+    RK_U8           *shards;
+    void            *buf;
+} MppMetricsImpl;
+
+static RK_U8 global_shards[SHARD_STRIDE * METRICS_SHARDS + METRICS_CACHE_LINE];
+static MppMetricsImpl global_metrics = {
+    (RK_U8 *)MPP_ALIGN((intptr_t)global_shards, METRICS_CACHE_LINE),
+    NULL,
+};
+
+static MppMetricsShard *get_shard(MppMetricsImpl *p)
+{
+    RK_S32 cpu = 0;
+
+#if defined(__linux__)
+    cpu = sched_getcpu();
+    if (cpu < 0)
+        cpu = 0;
+#endif
+
+    return (MppMetricsShard *)(p->shards + SHARD_STRIDE * (cpu & (METRICS_SHARDS - 1)));
+}
+
+static void atomic_max(RK_U64 *dst, RK_U64 val)
+{
+    RK_U64 old = *dst;
+
+    while (old < val) {
+        if (MPP_BOOL_CAS(dst, old, val))
+            break;
+
+        old = *dst;
+    }
+}
+
+static RK_U64 atomic_load(RK_U64 *src)
+{
+    return MPP_FETCH_ADD(src, 0);
+}
+
+MPP_RET mpp_metrics_init(MppMetrics *metrics)
+{
+    MppMetricsImpl *p = NULL;
+    RK_U8 *buf = NULL;
+
+    if (NULL == metrics) {
+        mpp_err_f("invalid NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    p = mpp_calloc(MppMetricsImpl, 1);
+    buf = mpp_calloc(RK_U8, SHARD_STRIDE * METRICS_SHARDS + METRICS_CACHE_LINE);
+    if (NULL == p || NULL == buf) {
+        mpp_err_f("failed to malloc metrics\n");
+        MPP_FREE(p);
+        MPP_FREE(buf);
+        *metrics = NULL;
+        return MPP_ERR_MALLOC;
+    }
+
+    p->buf = buf;
+    p->shards = (RK_U8 *)MPP_ALIGN((intptr_t)buf, METRICS_CACHE_LINE);
+    *metrics = p;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_metrics_deinit(MppMetrics metrics)
+{
+    MppMetricsImpl *p = (MppMetricsImpl *)metrics;
+
+    if (NULL == p)
+        return MPP_OK;
+
+    MPP_FREE(p->buf);
+    mpp_free(p);
+
+    return MPP_OK;
+}
+
+void mpp_metrics_add(MppMetrics metrics, MppStatsCounter id, RK_S64 val)
+{
+    MppMetricsImpl *p = (MppMetricsImpl *)metrics;
+
+    if (NULL == p || id >= MPP_STATS_COUNTER_BUTT)
+        return;
+
+    MPP_FETCH_ADD(&get_shard(p)->counter[id], val);
+    MPP_FETCH_ADD(&get_shard(&global_metrics)->counter[id], val);
+}
+
+void mpp_metrics_max(MppMetrics metrics, MppStatsGauge id, RK_S64 val)
+{
+    MppMetricsImpl *p = (MppMetricsImpl *)metrics;
+
+    if (NULL == p || id >= MPP_STATS_GAUGE_BUTT || val < 0)
+        return;
+
+    atomic_max(&get_shard(p)->gauge[id], val);
+    atomic_max(&get_shard(&global_metrics)->gauge[id], val);
+}
+
+static void hist_update(MppStatsHist *hist, RK_U64 time, RK_S32 bin)
+{
+    MPP_FETCH_ADD(&hist->count, 1);
+    MPP_FETCH_ADD(&hist->sum, time);
+    MPP_FETCH_ADD(&hist->bins[bin], 1);
+    atomic_max(&hist->max, time);
+}
+
+void mpp_metrics_time(MppMetrics metrics, MppStatsHistType id, RK_S64 time_us)
+{
+    MppMetricsImpl *p = (MppMetricsImpl *)metrics;
+    RK_S32 bin = 0;
+
+    if (NULL == p || id >= MPP_STATS_HIST_BUTT)
+        return;
+
+    if (time_us < 0)
+        time_us = 0;
+
+    if (time_us >= 1)
+        bin = MPP_MIN(mpp_log2((RK_U32)MPP_MIN(time_us, 0x7fffffff)) + 1,
+                      MPP_STATS_HIST_BINS - 1);
+
+    hist_update(&get_shard(p)->hist[id], time_us, bin);
+    hist_update(&get_shard(&global_metrics)->hist[id], time_us, bin);
+}
+
+MPP_RET mpp_metrics_snapshot(MppMetrics metrics, MppStats *stats)
+{
+    MppMetricsImpl *p = (MppMetricsImpl *)metrics;
+    RK_S32 i;
+    RK_S32 j;
+    RK_S32 k;
+
+    if (NULL == stats) {
+        mpp_err_f("invalid NULL stats\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    if (NULL == p)
+        p = &global_metrics;
+
+    memset(stats, 0, sizeof(*stats));
+
+    /* shards are read one by one so the snapshot is not an atomic cut */
+    for (i = 0; i < METRICS_SHARDS; i++) {
+        MppMetricsShard *shard = (MppMetricsShard *)(p->shards + SHARD_STRIDE * i);
+
+        for (j = 0; j < MPP_STATS_COUNTER_BUTT; j++)
+            stats->counter[j] += atomic_load(&shard->counter[j]);
+
+        for (j = 0; j < MPP_STATS_GAUGE_BUTT; j++)
+            stats->gauge[j] = MPP_MAX(stats->gauge[j], atomic_load(&shard->gauge[j]));
+
+        for (j = 0; j < MPP_STATS_HIST_BUTT; j++) {
+            MppStatsHist *src = &shard->hist[j];
+            MppStatsHist *dst = &stats->hist[j];
+
+            dst->count += atomic_load(&src->count);
+            dst->sum += atomic_load(&src->sum);
+            dst->max = MPP_MAX(dst->max, atomic_load(&src->max));
+            for (k = 0; k < MPP_STATS_HIST_BINS; k++)
+                dst->bins[k] += atomic_load(&src->bins[k]);
+        }
+    }
+
+    return MPP_OK;
+}
@@ -0,0 +1,238 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "mpp_iova_cache_test"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "mpp_log.h"
+#include "mpp_common.h"
+
+#include "mpp_iova_cache.h"
+
+/* frame buffers imported again with new fd on each frame */
+#define IOVA_TEST_BUFS          12
+#define IOVA_TEST_PER_FRAME     4
+#define IOVA_TEST_IDLE          8
+#define IOVA_TEST_FRAMES        100000
+
+/* kernel session which imports dma-buf by fd and counts its references */
+typedef struct IovaTestKernel_t {
+    RK_U64      ino[IOVA_TEST_BUFS];
+    RK_S32      ref[IOVA_TEST_BUFS];
+    RK_S32      count;
+    RK_U32      reqs;
+    RK_S32      err;
+} IovaTestKernel;
+
+static RK_S32 iova_test_find(IovaTestKernel *k, RK_S32 fd, RK_S32 add)
+{
+    struct stat st;
+    RK_S32 i;
+
+    if (fstat(fd, &st))
+        return -1;
+
+    for (i = 0; i < k->count; i++)
+        if (k->ino[i] == (RK_U64)st.st_ino)
+            return i;
+
+    if (!add || k->count >= IOVA_TEST_BUFS)
+        return -1;
+
+    k->ino[k->count] = (RK_U64)st.st_ino;
+    k->ref[k->count] = 0;
+    return k->count++;
+}
+
+static MPP_RET iova_test_func(void *ctx, RK_S32 *attach, RK_S32 attach_cnt,
+                              RK_S32 *release, RK_S32 release_cnt)
+{
+    IovaTestKernel *k = (IovaTestKernel *)ctx;
+    RK_S32 i;
+
+    for (i = 0; i < release_cnt; i++) {
+        RK_S32 idx = iova_test_find(k, release[i], 0);
+
+        if (idx < 0 || k->ref[idx] <= 0) {
+            mpp_err("release fd %d not attached\n", release[i]);
+            k->err++;
+            continue;
+        }
+        k->ref[idx]--;
+    }
+
+    for (i = 0; i < attach_cnt; i++) {
+        RK_S32 idx = iova_test_find(k, attach[i], 1);
+
+        if (idx < 0) {
+            k->err++;
+            continue;
+        }
+        k->ref[idx]++;
+        attach[i] = 0x100000 * (idx + 1);
+    }
+
+    k->reqs++;
+
+    return MPP_OK;
+}
+
+static RK_S64 iova_test_cpu_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (RK_S64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static MPP_RET iova_test_run(RK_S32 *bufs, RK_S32 cached)
+{
+    IovaTestKernel kernel;
+    MppIovaCache cache = NULL;
+    RK_S64 start;
+    RK_S64 time;
+    RK_S32 i, j;
+    MPP_RET ret = MPP_NOK;
+
+    memset(&kernel, 0, sizeof(kernel));
+
+    if (cached && mpp_iova_cache_init(&cache, IOVA_TEST_IDLE, iova_test_func, &kernel))
+        return MPP_NOK;
+
+    start = iova_test_cpu_time();
+    for (i = 0; i < IOVA_TEST_FRAMES; i++) {
+        RK_S32 fds[IOVA_TEST_PER_FRAME];
+        void *entry[IOVA_TEST_PER_FRAME];
+
+        for (j = 0; j < IOVA_TEST_PER_FRAME; j++) {
+            /* sliding window over more buffers than idle count */
+            RK_S32 idx = (i + j) % IOVA_TEST_BUFS;
+            RK_S32 fd = dup(bufs[idx]);
+            RK_U32 iova = (RK_U32)fd;
+
+            if (cached) {
+                mpp_iova_cache_get(cache, fd, &iova, &entry[j]);
+                if (NULL == entry[j]) {
+                    mpp_err("frame %d fd %d is not cached\n", i, fd);
+                    goto DONE;
+                }
+            } else {
+                iova_test_func(&kernel, (RK_S32 *)&iova, 1, NULL, 0);
+            }
+
+            if (iova != (RK_U32)(0x100000 * (iova_test_find(&kernel, fd, 0) + 1))) {
+                mpp_err("frame %d fd %d wrong iova %x\n", i, fd, iova);
+                goto DONE;
+            }
+            fds[j] = fd;
+        }
+
+        for (j = 0; j < IOVA_TEST_PER_FRAME; j++) {
+            if (cached)
+                mpp_iova_cache_put(cache, entry[j]);
+            else
+                iova_test_func(&kernel, NULL, 0, &fds[j], 1);
+
+            /* buffer is freed and its fd is closed after detach */
+            close(fds[j]);
+        }
+    }
+    time = iova_test_cpu_time() - start;
+
+    mpp_log("%-6s %5.3f requests %4lld ns per frame\n", cached ? "cached" : "plain",
+            (double)kernel.reqs / IOVA_TEST_FRAMES, time / IOVA_TEST_FRAMES);
+
+    if (cached)
+        mpp_iova_cache_dump(cache, __FUNCTION__);
+
+    ret = MPP_OK;
+DONE:
+    if (cache)
+        mpp_iova_cache_deinit(cache);
+
+    /* all imports are released in the end */
+    for (i = 0; i < kernel.count; i++) {
+        if (kernel.ref[i]) {
+            mpp_err("buffer %d still has %d references\n", i, kernel.ref[i]);
+            ret = MPP_NOK;
+        }
+    }
+
+    return kernel.err ? MPP_NOK : ret;
+}
+
+static MPP_RET iova_test_anon(void)
+{
+    IovaTestKernel kernel;
+    MppIovaCache cache = NULL;
+    char name[] = "/tmp/mpp_iova_cache_XXXXXX";
+    RK_U32 iova = 0;
+    void *entry = NULL;
+    RK_S32 fd;
+
+    memset(&kernel, 0, sizeof(kernel));
+
+    fd = mkstemp(name);
+    if (fd < 0)
+        return MPP_NOK;
+    unlink(name);
+
+    /* empty file looks like dma-buf on the shared anonymous inode */
+    mpp_iova_cache_init(&cache, IOVA_TEST_IDLE, iova_test_func, &kernel);
+    mpp_iova_cache_get(cache, fd, &iova, &entry);
+    mpp_iova_cache_deinit(cache);
+    close(fd);
+
+    if (entry || kernel.reqs) {
+        mpp_err("fd without inode size is cached\n");
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+int main()
+{
+    RK_S32 bufs[IOVA_TEST_BUFS];
+    RK_S32 i;
+    MPP_RET ret = MPP_NOK;
+
+    mpp_log("mpp_iova_cache test start\n");
+
+    for (i = 0; i < IOVA_TEST_BUFS; i++)
+        bufs[i] = -1;
+
+    for (i = 0; i < IOVA_TEST_BUFS; i++) {
+        char name[] = "/tmp/mpp_iova_cache_XXXXXX";
+
+        bufs[i] = mkstemp(name);
+        if (bufs[i] < 0 || ftruncate(bufs[i], 4096)) {
+            mpp_err("failed to create buffer %d\n", i);
+            goto DONE;
+        }
+        unlink(name);
+    }
+
+    ret = iova_test_anon();
+    if (!ret)
+        ret = iova_test_run(bufs, 0);
+    if (!ret)
+        ret = iova_test_run(bufs, 1);
+
+DONE:
+    for (i = 0; i < IOVA_TEST_BUFS; i++)
+        if (bufs[i] >= 0)
+            close(bufs[i]);
+
+    mpp_log("mpp_iova_cache test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
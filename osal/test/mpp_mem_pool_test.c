@@ -17,13 +17,144 @@
 #define MODULE_TAG "mpp_mem_pool_test"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_thread.h"
 #include "mpp_mem_pool.h"
 
 #define MPP_MEM_POOL_TEST_SIZE      1024
 #define MPP_MEM_POOL_TEST_COUNT     20
 
+#define MPP_MEM_POOL_BENCH_SIZE     256
+#define MPP_MEM_POOL_BENCH_HOLD     8
+#define MPP_MEM_POOL_BENCH_LOOP     100000
+#define MPP_MEM_POOL_BENCH_THREAD   8
+
+typedef struct MemPoolBenchCtx_t {
+    MppMemPool  pool;
+    RK_S32      loop;
+    RK_S32      ret;
+} MemPoolBenchCtx;
+
+static void *mem_pool_bench_thread(void *arg)
+{
+    MemPoolBenchCtx *ctx = (MemPoolBenchCtx *)arg;
+    void *p[MPP_MEM_POOL_BENCH_HOLD];
+    RK_S32 i, j;
+
+    for (i = 0; i < ctx->loop; i++) {
+        for (j = 0; j < MPP_MEM_POOL_BENCH_HOLD; j++) {
+            p[j] = mpp_mem_pool_get(ctx->pool);
+            if (!p[j]) {
+                ctx->ret = MPP_NOK;
+                return NULL;
+            }
+            /* touch object like a real user */
+            *(RK_U32 *)p[j] = i;
+        }
+
+        for (j = 0; j < MPP_MEM_POOL_BENCH_HOLD; j++)
+            mpp_mem_pool_put(ctx->pool, p[j]);
+    }
+
+    return NULL;
+}
+
+static MPP_RET mem_pool_bench(RK_U32 flag, RK_S32 thread_count)
+{
+    MemPoolBenchCtx ctx[MPP_MEM_POOL_BENCH_THREAD];
+    pthread_t thd[MPP_MEM_POOL_BENCH_THREAD];
+    MppMemPool pool = mpp_mem_pool_init_flag(MPP_MEM_POOL_BENCH_SIZE, flag);
+    RK_S64 ops = (RK_S64)thread_count * MPP_MEM_POOL_BENCH_LOOP * MPP_MEM_POOL_BENCH_HOLD;
+    MPP_RET ret = MPP_OK;
+    RK_S64 time;
+    RK_S32 i;
+
+    if (!pool)
+        return MPP_NOK;
+
+    time = mpp_time();
+
+    for (i = 0; i < thread_count; i++) {
+        ctx[i].pool = pool;
+        ctx[i].loop = MPP_MEM_POOL_BENCH_LOOP;
+        ctx[i].ret = MPP_OK;
+        pthread_create(&thd[i], NULL, mem_pool_bench_thread, &ctx[i]);
+    }
+
+    for (i = 0; i < thread_count; i++) {
+        pthread_join(thd[i], NULL);
+        if (ctx[i].ret)
+            ret = MPP_NOK;
+    }
+
+    time = mpp_time() - time;
+
+    mpp_log("%s threads %d get/put %lld pairs in %lld us %.2f Mops/s\n",
+            (flag & MPP_MEM_POOL_NO_ZERO) ? "no zero" : "zeroing",
+            thread_count, ops, time, (float)ops / MPP_MAX(time, 1));
+
+    mpp_mem_pool_deinit(pool);
+
+    return ret;
+}
+
+static void *mem_pool_put_thread(void *arg)
+{
+    MemPoolBenchCtx *ctx = (MemPoolBenchCtx *)arg;
+    void **p = (void **)ctx->pool;
+    RK_S32 i;
+
+    for (i = 0; i < ctx->loop; i++)
+        mpp_mem_pool_put(p[0], p[i + 1]);
+
+    return NULL;
+}
+
+/* objects allocated in one thread and freed in another must be reused */
+static MPP_RET mem_pool_cross_thread(void)
+{
+    MppMemPool pool = mpp_mem_pool_init(MPP_MEM_POOL_TEST_SIZE);
+    void *p[MPP_MEM_POOL_TEST_COUNT * 4 + 1];
+    MemPoolBenchCtx ctx;
+    pthread_t thd;
+    RK_S32 count = MPP_MEM_POOL_TEST_COUNT * 4;
+    RK_S32 i;
+
+    if (!pool)
+        return MPP_NOK;
+
+    p[0] = pool;
+    for (i = 1; i <= count; i++) {
+        p[i] = mpp_mem_pool_get(pool);
+        memset(p[i], 0xff, MPP_MEM_POOL_TEST_SIZE);
+    }
+
+    ctx.pool = (MppMemPool)p;
+    ctx.loop = count;
+    pthread_create(&thd, NULL, mem_pool_put_thread, &ctx);
+    pthread_join(thd, NULL);
+
+    for (i = 1; i <= count; i++) {
+        RK_U8 *buf = (RK_U8 *)mpp_mem_pool_get(pool);
+
+        if (!buf || buf[0] || buf[MPP_MEM_POOL_TEST_SIZE - 1]) {
+            mpp_err("mpp_mem_pool_test get dirty object %p\n", buf);
+            return MPP_NOK;
+        }
+        p[i] = buf;
+    }
+
+    for (i = 1; i <= count; i++)
+        mpp_mem_pool_put(pool, p[i]);
+
+    mpp_mem_pool_deinit(pool);
+
+    return MPP_OK;
+}
+
 int main()
 {
     MppMemPool pool = NULL;
@@ -69,6 +200,20 @@ int main()
         }
     }
 
+    mpp_mem_pool_deinit(pool);
+
+    if (mem_pool_cross_thread()) {
+        mpp_err("mpp_mem_pool_test cross thread failed\n");
+        goto mpp_mem_pool_test_failed;
+    }
+
+    for (i = 1; i <= MPP_MEM_POOL_BENCH_THREAD; i <<= 1) {
+        if (mem_pool_bench(0, i) || mem_pool_bench(MPP_MEM_POOL_NO_ZERO, i)) {
+            mpp_err("mpp_mem_pool_test bench failed\n");
+            goto mpp_mem_pool_test_failed;
+        }
+    }
+
     mpp_log("mpp_mem_pool_test success\n");
     return MPP_OK;
 
@@ -76,4 +221,3 @@ mpp_mem_pool_test_failed:
     mpp_log("mpp_mem_pool_test failed\n");
     return MPP_NOK;
 }
-
@@ -0,0 +1,144 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "mpp_metrics_test"
+
+#include <pthread.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_metrics.h"
+
+#define THREAD_COUNT        4
+#define LOOP_COUNT          (256 * 1024)
+
+static MppMetrics metrics = NULL;
+static volatile RK_S32 scrape_stop = 0;
+
+static void *update_thread(void *arg)
+{
+    RK_S32 id = *(RK_S32 *)arg;
+    RK_S32 i;
+
+    for (i = 0; i < LOOP_COUNT; i++) {
+        mpp_metrics_add(metrics, MPP_STATS_PKT_IN, 1);
+        mpp_metrics_time(metrics, MPP_STATS_HW_WAIT_TIME, i & 1023);
+        mpp_metrics_max(metrics, MPP_STATS_BUF_HIGH_WATER, id * LOOP_COUNT + i);
+    }
+
+    return NULL;
+}
+
+/* scraper runs concurrently and counters never go backward */
+static void *scrape_thread(void *arg)
+{
+    RK_U64 last = 0;
+    RK_S32 *bad = (RK_S32 *)arg;
+
+    while (!scrape_stop) {
+        MppStats stats;
+
+        mpp_metrics_snapshot(metrics, &stats);
+        if (stats.counter[MPP_STATS_PKT_IN] < last)
+            *bad = 1;
+        last = stats.counter[MPP_STATS_PKT_IN];
+    }
+
+    return NULL;
+}
+
+static RK_S32 check_stats(MppStats *stats, RK_U64 expect)
+{
+    MppStatsHist *hist = &stats->hist[MPP_STATS_HW_WAIT_TIME];
+    RK_U64 bins = 0;
+    RK_S32 i;
+
+    for (i = 0; i < MPP_STATS_HIST_BINS; i++)
+        bins += hist->bins[i];
+
+    if (stats->counter[MPP_STATS_PKT_IN] != expect || hist->count != expect ||
+        bins != expect || hist->max != 1023 ||
+        stats->gauge[MPP_STATS_BUF_HIGH_WATER] != THREAD_COUNT * LOOP_COUNT - 1) {
+        mpp_err("mismatch pkt %lld hist %lld bins %lld max %lld gauge %lld expect %lld\n",
+                stats->counter[MPP_STATS_PKT_IN], hist->count, bins, hist->max,
+                stats->gauge[MPP_STATS_BUF_HIGH_WATER], expect);
+        return -1;
+    }
+
+    /* zero in bins[0], 1 in bins[1], 512 ~ 1023 in bins[10] */
+    if (hist->bins[0] != expect / 1024 || hist->bins[1] != expect / 1024 ||
+        hist->bins[10] != expect / 2) {
+        mpp_err("bins mismatch %lld %lld %lld\n", hist->bins[0],
+                hist->bins[1], hist->bins[10]);
+        return -1;
+    }
+
+    return 0;
+}
+
+int main()
+{
+    pthread_t threads[THREAD_COUNT];
+    pthread_t scraper;
+    RK_S32 ids[THREAD_COUNT];
+    RK_U64 expect = (RK_U64)THREAD_COUNT * LOOP_COUNT;
+    MppStats global_base;
+    MppStats stats;
+    RK_S32 bad = 0;
+    RK_S64 time;
+    RK_S32 ret = 0;
+    RK_S32 i;
+
+    mpp_log("mpp metrics test start\n");
+
+    mpp_metrics_snapshot(NULL, &global_base);
+    ret = mpp_metrics_init(&metrics);
+    if (ret)
+        goto DONE;
+
+    pthread_create(&scraper, NULL, scrape_thread, &bad);
+
+    time = mpp_time();
+    for (i = 0; i < THREAD_COUNT; i++) {
+        ids[i] = i;
+        pthread_create(&threads[i], NULL, update_thread, &ids[i]);
+    }
+
+    for (i = 0; i < THREAD_COUNT; i++)
+        pthread_join(threads[i], NULL);
+    time = mpp_time() - time;
+
+    scrape_stop = 1;
+    pthread_join(scraper, NULL);
+
+    mpp_log("%d threads %d updates in %lld us, %.1f ns per update\n",
+            THREAD_COUNT, LOOP_COUNT * 3, time,
+            (double)time * 1000 / (LOOP_COUNT * 3));
+
+    if (bad) {
+        mpp_err("counter goes backward on concurrent scraping\n");
+        ret = -1;
+        goto DONE;
+    }
+
+    mpp_metrics_snapshot(metrics, &stats);
+    ret = check_stats(&stats, expect);
+    if (ret)
+        goto DONE;
+
+    /* global metrics sums all sessions */
+    mpp_metrics_snapshot(NULL, &stats);
+    if (stats.counter[MPP_STATS_PKT_IN] - global_base.counter[MPP_STATS_PKT_IN] != expect) {
+        mpp_err("global counter mismatch\n");
+        ret = -1;
+    }
+
+DONE:
+    mpp_metrics_deinit(metrics);
+    mpp_log("mpp metrics test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
@@ -0,0 +1,956 @@
+/* SPDX-License-Identifier: Apache-2.0 OR MIT */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd.
+ */
+
+#define MODULE_TAG "mpi_bench_test"
+
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#if defined(__linux__)
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+#include "rk_mpi.h"
+
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "mpp_opt.h"
+#include "mpi_dec_utils.h"
+
+#define BENCH_TYPE_MAX          8
+#define BENCH_THREAD_MAX        512
+#define BENCH_NAME_LEN          16
+
+typedef struct MpiBenchCmd_t {
+    MppCtxType      mode;
+    RK_S32          type_cnt;
+    MppCodingType   types[BENCH_TYPE_MAX];
+    RK_S32          input_cnt;
+    char            *inputs[BENCH_TYPE_MAX];
+    const char      *output;
+
+    RK_S32          width;
+    RK_S32          height;
+    /* frames per session in each step */
+    RK_S32          frame_num;
+    RK_S32          sessions;
+    /* session count step, 0 for doubling */
+    RK_S32          step;
+} MpiBenchCmd;
+
+/* cpu time of threads with the same name */
+typedef struct BenchThreadCpu_t {
+    char            name[BENCH_NAME_LEN];
+    RK_S64          ticks;
+} BenchThreadCpu;
+
+typedef struct BenchThreadStat_t {
+    /* live threads and their total context switches */
+    RK_S32          tasks;
+    RK_S64          csw;
+    RK_S32          count;
+    BenchThreadCpu  threads[BENCH_THREAD_MAX];
+} BenchThreadStat;
+
+typedef struct BenchStep_t {
+    MpiBenchCmd     *cmd;
+    MppCodingType   type;
+    FileReader      reader;
+    RK_S32          sessions;
+
+    /* sessions are created before start and destroyed after exit */
+    pthread_barrier_t start;
+    pthread_barrier_t done;
+    pthread_barrier_t exit;
+} BenchStep;
+
+typedef struct BenchSession_t {
+    BenchStep       *step;
+    pthread_t       thd;
+    MPP_RET         ret;
+
+    MppCtx          ctx;
+    MppApi          *mpi;
+
+    /* decoder */
+    MppPacket       packet;
+    DecBufMgr       buf_mgr;
+    RK_S32          packet_idx;
+
+    /* encoder */
+    MppBufferGroup  buf_grp;
+    MppBuffer       frm_buf;
+
+    RK_S64          *latency;
+    RK_S32          frame_count;
+    RK_S64          user_cpu;
+} BenchSession;
+
+static RK_S64 bench_cpu_time(RK_S32 thread)
+{
+#if defined(__linux__)
+    struct timespec ts;
+
+    clock_gettime(thread ? CLOCK_THREAD_CPUTIME_ID : CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (RK_S64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+    (void)thread;
+    return 0;
+#endif
+}
+
+static void bench_thread_stat(BenchThreadStat *stat)
+{
+    stat->count = 0;
+    stat->tasks = 0;
+    stat->csw = 0;
+
+#if defined(__linux__)
+    DIR *dir = opendir("/proc/self/task");
+    struct dirent *ent;
+
+    if (NULL == dir)
+        return;
+
+    while ((ent = readdir(dir)) != NULL) {
+        char path[320];
+        char buf[512];
+        unsigned long utime = 0;
+        unsigned long stime = 0;
+        char *name;
+        char *end;
+        FILE *fp;
+        size_t len;
+        RK_S32 i;
+
+        if (ent->d_name[0] == '.')
+            continue;
+
+        snprintf(path, sizeof(path), "/proc/self/task/%s/stat", ent->d_name);
+        fp = fopen(path, "r");
+        if (NULL == fp)
+            continue;
+
+        len = fread(buf, 1, sizeof(buf) - 1, fp);
+        fclose(fp);
+        buf[len] = '\0';
+
+        /* pid (comm) state ppid pgrp session tty tpgid flags 4 x flt utime stime */
+        name = strchr(buf, '(');
+        end = strrchr(buf, ')');
+        if (NULL == name || NULL == end || end < name)
+            continue;
+
+        *end = '\0';
+        name++;
+        if (sscanf(end + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+                   &utime, &stime) != 2)
+            continue;
+
+        for (i = 0; i < stat->count; i++)
+            if (!strncmp(stat->threads[i].name, name, BENCH_NAME_LEN))
+                break;
+
+        if (i == stat->count) {
+            if (stat->count >= BENCH_THREAD_MAX)
+                continue;
+
+            snprintf(stat->threads[i].name, BENCH_NAME_LEN, "%s", name);
+            stat->threads[i].ticks = 0;
+            stat->count++;
+        }
+
+        stat->threads[i].ticks += utime + stime;
+        stat->tasks++;
+
+        snprintf(path, sizeof(path), "/proc/self/task/%s/status", ent->d_name);
+        fp = fopen(path, "r");
+        if (NULL == fp)
+            continue;
+
+        /* voluntary_ctxt_switches and nonvoluntary_ctxt_switches */
+        while (fgets(buf, sizeof(buf), fp)) {
+            char *csw = strstr(buf, "ctxt_switches:");
+
+            if (csw)
+                stat->csw += strtoll(csw + strlen("ctxt_switches:"), NULL, 10);
+        }
+        fclose(fp);
+    }
+
+    closedir(dir);
+#endif
+}
+
+static RK_S64 bench_ticks_to_us(RK_S64 ticks)
+{
+#if defined(__linux__)
+    long hz = sysconf(_SC_CLK_TCK);
+
+    return hz > 0 ? ticks * 1000000 / hz : 0;
+#else
+    (void)ticks;
+    return 0;
+#endif
+}
+
+static MPP_RET dec_session_init(BenchSession *s)
+{
+    BenchStep *step = s->step;
+    MppDecCfg cfg = NULL;
+    MPP_RET ret;
+
+    ret = dec_buf_mgr_init(&s->buf_mgr);
+    if (ret)
+        return ret;
+
+    ret = mpp_packet_init(&s->packet, NULL, 0);
+    if (ret)
+        return ret;
+
+    ret = mpp_create(&s->ctx, &s->mpi);
+    if (ret)
+        return ret;
+
+    ret = mpp_init(s->ctx, MPP_CTX_DEC, step->type);
+    if (ret)
+        return ret;
+
+    mpp_dec_cfg_init(&cfg);
+    ret = s->mpi->control(s->ctx, MPP_DEC_GET_CFG, cfg);
+    if (!ret) {
+        mpp_dec_cfg_set_u32(cfg, "base:split_parse", 1);
+        ret = s->mpi->control(s->ctx, MPP_DEC_SET_CFG, cfg);
+    }
+    mpp_dec_cfg_deinit(cfg);
+
+    return ret;
+}
+
+static MPP_RET dec_session_info_change(BenchSession *s, MppFrame frame)
+{
+    RK_U32 buf_size = mpp_frame_get_buf_size(frame);
+    MppBufferGroup grp;
+    MPP_RET ret;
+
+    grp = dec_buf_mgr_setup(s->buf_mgr, buf_size, 24, MPP_DEC_BUF_HALF_INT);
+    ret = s->mpi->control(s->ctx, MPP_DEC_SET_EXT_BUF_GROUP, grp);
+    if (ret) {
+        mpp_err("%p set buffer group failed ret %d\n", s->ctx, ret);
+        return ret;
+    }
+
+    return s->mpi->control(s->ctx, MPP_DEC_SET_INFO_CHANGE_READY, NULL);
+}
+
+static MPP_RET dec_session_run(BenchSession *s)
+{
+    MpiBenchCmd *cmd = s->step->cmd;
+    MppPacket packet = s->packet;
+    RK_U32 pkt_pending = 0;
+    MPP_RET ret = MPP_OK;
+
+    while (s->frame_count < cmd->frame_num) {
+        RK_U32 get_frm = 0;
+        MppFrame frame = NULL;
+
+        if (!pkt_pending) {
+            FileBufSlot *slot = NULL;
+
+            ret = reader_index_read(s->step->reader, s->packet_idx++, &slot);
+            if (ret || NULL == slot)
+                return MPP_NOK;
+
+            /* loop the stream without eos for steady state */
+            if (slot->eos)
+                s->packet_idx = 0;
+
+            mpp_packet_set_data(packet, slot->data);
+            mpp_packet_set_size(packet, slot->size);
+            mpp_packet_set_pos(packet, slot->data);
+            mpp_packet_set_length(packet, slot->size);
+            /* input time goes through decoder as pts for latency */
+            mpp_packet_set_pts(packet, mpp_time());
+            pkt_pending = 1;
+        }
+
+        if (!s->mpi->decode_put_packet(s->ctx, packet))
+            pkt_pending = 0;
+
+        do {
+            ret = s->mpi->decode_get_frame(s->ctx, &frame);
+            if (ret || NULL == frame)
+                break;
+
+            get_frm = 1;
+            if (mpp_frame_get_info_change(frame)) {
+                ret = dec_session_info_change(s, frame);
+            } else if (s->frame_count < cmd->frame_num) {
+                RK_S64 pts = mpp_frame_get_pts(frame);
+
+                s->latency[s->frame_count++] = pts > 0 ? mpp_time() - pts : 0;
+            }
+            mpp_frame_deinit(&frame);
+        } while (!ret);
+
+        if (ret && ret != MPP_ERR_TIMEOUT) {
+            mpp_err("%p decode get frame failed ret %d\n", s->ctx, ret);
+            return ret;
+        }
+
+        if (pkt_pending && !get_frm)
+            msleep(1);
+    }
+
+    return MPP_OK;
+}
+
+static MPP_RET enc_session_init(BenchSession *s)
+{
+    BenchStep *step = s->step;
+    MpiBenchCmd *cmd = step->cmd;
+    RK_S32 hor_stride = MPP_ALIGN(cmd->width, 16);
+    RK_S32 ver_stride = MPP_ALIGN(cmd->height, 16);
+    MppPollType timeout = MPP_POLL_BLOCK;
+    MppEncCfg cfg = NULL;
+    MPP_RET ret;
+
+    ret = mpp_buffer_group_get_internal(&s->buf_grp, MPP_BUFFER_TYPE_DRM);
+    if (ret)
+        return ret;
+
+    ret = mpp_buffer_get(s->buf_grp, &s->frm_buf, hor_stride * ver_stride * 3 / 2);
+    if (ret)
+        return ret;
+
+    fill_image(mpp_buffer_get_ptr(s->frm_buf), cmd->width, cmd->height,
+               hor_stride, ver_stride, MPP_FMT_YUV420SP, 0);
+
+    ret = mpp_create(&s->ctx, &s->mpi);
+    if (ret)
+        return ret;
+
+    ret = s->mpi->control(s->ctx, MPP_SET_OUTPUT_TIMEOUT, &timeout);
+    if (ret)
+        return ret;
+
+    ret = mpp_init(s->ctx, MPP_CTX_ENC, step->type);
+    if (ret)
+        return ret;
+
+    ret = mpp_enc_cfg_init(&cfg);
+    if (ret)
+        return ret;
+
+    mpp_enc_cfg_set_s32(cfg, "prep:width", cmd->width);
+    mpp_enc_cfg_set_s32(cfg, "prep:height", cmd->height);
+    mpp_enc_cfg_set_s32(cfg, "prep:hor_stride", hor_stride);
+    mpp_enc_cfg_set_s32(cfg, "prep:ver_stride", ver_stride);
+    mpp_enc_cfg_set_s32(cfg, "prep:format", MPP_FMT_YUV420SP);
+
+    /* fixed qp to keep the encoder load stable */
+    mpp_enc_cfg_set_s32(cfg, "rc:mode", MPP_ENC_RC_MODE_FIXQP);
+    mpp_enc_cfg_set_s32(cfg, "rc:fps_in_num", 30);
+    mpp_enc_cfg_set_s32(cfg, "rc:fps_in_denom", 1);
+    mpp_enc_cfg_set_s32(cfg, "rc:fps_out_num", 30);
+    mpp_enc_cfg_set_s32(cfg, "rc:fps_out_denom", 1);
+    mpp_enc_cfg_set_s32(cfg, "rc:gop", 60);
+    mpp_enc_cfg_set_s32(cfg, "codec:type", step->type);
+
+    if (step->type == MPP_VIDEO_CodingMJPEG) {
+        mpp_enc_cfg_set_s32(cfg, "jpeg:q_factor", 80);
+        mpp_enc_cfg_set_s32(cfg, "jpeg:qf_max", 99);
+        mpp_enc_cfg_set_s32(cfg, "jpeg:qf_min", 1);
+    } else {
+        mpp_enc_cfg_set_s32(cfg, "rc:qp_init", 26);
+        mpp_enc_cfg_set_s32(cfg, "rc:qp_max", 26);
+        mpp_enc_cfg_set_s32(cfg, "rc:qp_min", 26);
+        mpp_enc_cfg_set_s32(cfg, "rc:qp_max_i", 26);
+        mpp_enc_cfg_set_s32(cfg, "rc:qp_min_i", 26);
+        mpp_enc_cfg_set_s32(cfg, "rc:qp_ip", 0);
+    }
+
+    ret = s->mpi->control(s->ctx, MPP_ENC_SET_CFG, cfg);
+    mpp_enc_cfg_deinit(cfg);
+
+    return ret;
+}
+
+static MPP_RET enc_session_run(BenchSession *s)
+{
+    MpiBenchCmd *cmd = s->step->cmd;
+    MPP_RET ret = MPP_OK;
+
+    while (s->frame_count < cmd->frame_num) {
+        MppFrame frame = NULL;
+        RK_U32 eoi = 0;
+        RK_S64 start;
+
+        ret = mpp_frame_init(&frame);
+        if (ret)
+            return ret;
+
+        mpp_frame_set_width(frame, cmd->width);
+        mpp_frame_set_height(frame, cmd->height);
+        mpp_frame_set_hor_stride(frame, MPP_ALIGN(cmd->width, 16));
+        mpp_frame_set_ver_stride(frame, MPP_ALIGN(cmd->height, 16));
+        mpp_frame_set_fmt(frame, MPP_FMT_YUV420SP);
+        mpp_frame_set_buffer(frame, s->frm_buf);
+
+        start = mpp_time();
+        ret = s->mpi->encode_put_frame(s->ctx, frame);
+        mpp_frame_deinit(&frame);
+        if (ret) {
+            mpp_err("%p encode put frame failed ret %d\n", s->ctx, ret);
+            return ret;
+        }
+
+        do {
+            MppPacket packet = NULL;
+
+            ret = s->mpi->encode_get_packet(s->ctx, &packet);
+            if (ret || NULL == packet) {
+                mpp_err("%p encode get packet failed ret %d\n", s->ctx, ret);
+                return MPP_NOK;
+            }
+
+            eoi = mpp_packet_is_partition(packet) ? mpp_packet_is_eoi(packet) : 1;
+            mpp_packet_deinit(&packet);
+        } while (!eoi);
+
+        s->latency[s->frame_count++] = mpp_time() - start;
+    }
+
+    return ret;
+}
+
+static void bench_session_deinit(BenchSession *s)
+{
+    if (s->ctx) {
+        s->mpi->reset(s->ctx);
+        mpp_destroy(s->ctx);
+        s->ctx = NULL;
+    }
+
+    if (s->packet)
+        mpp_packet_deinit(&s->packet);
+
+    if (s->buf_mgr) {
+        dec_buf_mgr_deinit(s->buf_mgr);
+        s->buf_mgr = NULL;
+    }
+
+    if (s->frm_buf) {
+        mpp_buffer_put(s->frm_buf);
+        s->frm_buf = NULL;
+    }
+
+    if (s->buf_grp) {
+        mpp_buffer_group_put(s->buf_grp);
+        s->buf_grp = NULL;
+    }
+}
+
+static void *bench_session_thread(void *arg)
+{
+    BenchSession *s = (BenchSession *)arg;
+    BenchStep *step = s->step;
+    RK_U32 is_dec = step->cmd->mode == MPP_CTX_DEC;
+
+    s->ret = is_dec ? dec_session_init(s) : enc_session_init(s);
+    if (s->ret)
+        mpp_err("session %p init failed ret %d\n", s, s->ret);
+
+    /* wait twice for main thread sampling the idle threads */
+    pthread_barrier_wait(&step->start);
+    pthread_barrier_wait(&step->start);
+
+    if (!s->ret) {
+        RK_S64 cpu = bench_cpu_time(1);
+
+        s->ret = is_dec ? dec_session_run(s) : enc_session_run(s);
+        s->user_cpu = bench_cpu_time(1) - cpu;
+    }
+
+    /* keep session alive until main thread sampled the footprint */
+    pthread_barrier_wait(&step->done);
+    pthread_barrier_wait(&step->exit);
+
+    bench_session_deinit(s);
+
+    return NULL;
+}
+
+static int cmp_latency(const void *a, const void *b)
+{
+    RK_S64 x = *(const RK_S64 *)a;
+    RK_S64 y = *(const RK_S64 *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void bench_write_result(FILE *fp_csv, FILE *fp_json, RK_S32 first,
+                               BenchStep *step, BenchSession *sessions,
+                               RK_S64 elapsed, RK_S64 cpu,
+                               BenchThreadStat *stat0, BenchThreadStat *stat1)
+{
+    MpiBenchCmd *cmd = step->cmd;
+    const char *mode = cmd->mode == MPP_CTX_DEC ? "dec" : "enc";
+    RK_S64 *latency = NULL;
+    RK_S64 user_cpu = 0;
+    RK_S64 p50 = 0;
+    RK_S64 p99 = 0;
+    RK_S64 lat_max = 0;
+    RK_S32 frames = 0;
+    RK_S32 div;
+    RK_S32 i;
+    RK_S32 j;
+    float fps;
+    float csw;
+
+    latency = mpp_malloc(RK_S64, step->sessions * cmd->frame_num);
+    if (NULL == latency)
+        return;
+
+    for (i = 0; i < step->sessions; i++) {
+        BenchSession *s = &sessions[i];
+
+        memcpy(latency + frames, s->latency, s->frame_count * sizeof(RK_S64));
+        frames += s->frame_count;
+        user_cpu += s->user_cpu;
+    }
+
+    if (frames) {
+        qsort(latency, frames, sizeof(RK_S64), cmp_latency);
+        p50 = latency[(frames - 1) * 50 / 100];
+        p99 = latency[(frames - 1) * 99 / 100];
+        lat_max = latency[frames - 1];
+    }
+    mpp_free(latency);
+
+    fps = elapsed ? (float)frames * 1000000 / elapsed : 0;
+    div = MPP_MAX(frames, 1);
+    csw = elapsed ? (float)(stat1->csw - stat0->csw) * 1000000 / elapsed : 0;
+
+    mpp_log("%s type %d sessions %3d frames %6d fps %9.2f latency p50 %6lld p99 %6lld us "
+            "cpu %6lld us/frame threads %4d csw %9.0f/s mem %u buf %u\n", mode,
+            step->type, step->sessions, frames, fps, p50, p99, cpu / div,
+            stat1->tasks, csw, mpp_mem_total_now(), mpp_buffer_total_now());
+
+    if (fp_csv) {
+        fprintf(fp_csv, "%s,%d,%d,%d,%lld,%.2f,%lld,%lld,%lld,%lld,%lld,%d,%.0f,%u,%u\n",
+                mode, step->type, step->sessions, frames, elapsed, fps,
+                p50, p99, lat_max, cpu / div, user_cpu / div, stat1->tasks, csw,
+                mpp_mem_total_now(), mpp_buffer_total_now());
+        fflush(fp_csv);
+    }
+
+    if (fp_json) {
+        const char *sep = "";
+
+        fprintf(fp_json, "%s  {\"mode\":\"%s\",\"type\":%d,\"sessions\":%d,"
+                "\"frames\":%d,\"elapsed_us\":%lld,\"fps\":%.2f,"
+                "\"latency_p50_us\":%lld,\"latency_p99_us\":%lld,"
+                "\"latency_max_us\":%lld,\"cpu_us_per_frame\":%lld,"
+                "\"user_cpu_us_per_frame\":%lld,\"thread_count\":%d,"
+                "\"ctx_switch_per_sec\":%.0f,\"mem_now\":%u,\"buf_now\":%u,"
+                "\"threads\":{", first ? "" : ",\n", mode, step->type,
+                step->sessions, frames, elapsed, fps, p50, p99, lat_max,
+                cpu / div, user_cpu / div, stat1->tasks, csw, mpp_mem_total_now(),
+                mpp_buffer_total_now());
+
+        /* cpu time per frame of each thread name in this step */
+        for (i = 0; i < stat1->count; i++) {
+            BenchThreadCpu *t = &stat1->threads[i];
+            RK_S64 ticks = t->ticks;
+
+            for (j = 0; j < stat0->count; j++) {
+                if (!strncmp(stat0->threads[j].name, t->name, BENCH_NAME_LEN)) {
+                    ticks -= stat0->threads[j].ticks;
+                    break;
+                }
+            }
+
+            fprintf(fp_json, "%s\"%s\":%.2f", sep, t->name,
+                    (float)bench_ticks_to_us(ticks) / div);
+            sep = ",";
+        }
+        fprintf(fp_json, "}}");
+        fflush(fp_json);
+    }
+}
+
+static MPP_RET bench_run_step(BenchStep *step, FILE *fp_csv, FILE *fp_json, RK_S32 first)
+{
+    MpiBenchCmd *cmd = step->cmd;
+    BenchSession *sessions = NULL;
+    BenchThreadStat *stat = NULL;
+    RK_S32 count = step->sessions;
+    MPP_RET ret = MPP_OK;
+    RK_S64 time;
+    RK_S64 cpu;
+    RK_S32 i;
+
+    sessions = mpp_calloc(BenchSession, count);
+    stat = mpp_calloc(BenchThreadStat, 2);
+    if (NULL == sessions || NULL == stat) {
+        MPP_FREE(sessions);
+        MPP_FREE(stat);
+        return MPP_ERR_MALLOC;
+    }
+
+    pthread_barrier_init(&step->start, NULL, count + 1);
+    pthread_barrier_init(&step->done, NULL, count + 1);
+    pthread_barrier_init(&step->exit, NULL, count + 1);
+
+    for (i = 0; i < count; i++) {
+        sessions[i].step = step;
+        sessions[i].latency = mpp_calloc(RK_S64, cmd->frame_num);
+        pthread_create(&sessions[i].thd, NULL, bench_session_thread, &sessions[i]);
+    }
+
+    /* all sessions are created and idle here */
+    pthread_barrier_wait(&step->start);
+    bench_thread_stat(&stat[0]);
+    time = mpp_time();
+    cpu = bench_cpu_time(0);
+    /* sessions start running after the idle threads are sampled */
+    pthread_barrier_wait(&step->start);
+
+    pthread_barrier_wait(&step->done);
+    time = mpp_time() - time;
+    cpu = bench_cpu_time(0) - cpu;
+    bench_thread_stat(&stat[1]);
+
+    for (i = 0; i < count; i++) {
+        if (sessions[i].ret)
+            ret = sessions[i].ret;
+    }
+
+    if (!ret)
+        bench_write_result(fp_csv, fp_json, first, step, sessions, time, cpu,
+                           &stat[0], &stat[1]);
+
+    pthread_barrier_wait(&step->exit);
+
+    for (i = 0; i < count; i++) {
+        pthread_join(sessions[i].thd, NULL);
+        MPP_FREE(sessions[i].latency);
+    }
+
+    pthread_barrier_destroy(&step->start);
+    pthread_barrier_destroy(&step->done);
+    pthread_barrier_destroy(&step->exit);
+
+    mpp_free(sessions);
+    mpp_free(stat);
+
+    return ret;
+}
+
+static RK_S32 bench_opt_m(void *ctx, const char *next)
+{
+    MpiBenchCmd *cmd = (MpiBenchCmd *)ctx;
+
+    if (next) {
+        if (!strcmp(next, "dec")) {
+            cmd->mode = MPP_CTX_DEC;
+            return 1;
+        }
+        if (!strcmp(next, "enc")) {
+            cmd->mode = MPP_CTX_ENC;
+            return 1;
+        }
+    }
+
+    mpp_err("invalid mode, use dec or enc\n");
+    return 0;
+}
+
+static RK_S32 bench_opt_t(void *ctx, const char *next)
+{
+    MpiBenchCmd *cmd = (MpiBenchCmd *)ctx;
+    const char *pos = next;
+
+    while (pos && *pos && cmd->type_cnt < BENCH_TYPE_MAX) {
+        cmd->types[cmd->type_cnt++] = (MppCodingType)atoi(pos);
+        pos = strchr(pos, ',');
+        if (pos)
+            pos++;
+    }
+
+    if (cmd->type_cnt)
+        return 1;
+
+    mpp_err("invalid coding type list\n");
+    return 0;
+}
+
+static RK_S32 bench_opt_i(void *ctx, const char *next)
+{
+    MpiBenchCmd *cmd = (MpiBenchCmd *)ctx;
+    const char *pos = next;
+
+    while (pos && *pos && cmd->input_cnt < BENCH_TYPE_MAX) {
+        const char *end = strchr(pos, ',');
+        size_t len = end ? (size_t)(end - pos) : strlen(pos);
+        char *name = mpp_calloc(char, len + 1);
+
+        if (NULL == name)
+            break;
+
+        memcpy(name, pos, len);
+        cmd->inputs[cmd->input_cnt++] = name;
+        pos = end ? end + 1 : NULL;
+    }
+
+    if (cmd->input_cnt)
+        return 1;
+
+    mpp_err("invalid input file list\n");
+    return 0;
+}
+
+static RK_S32 bench_opt_o(void *ctx, const char *next)
+{
+    MpiBenchCmd *cmd = (MpiBenchCmd *)ctx;
+
+    if (next) {
+        cmd->output = next;
+        return 1;
+    }
+
+    mpp_err("invalid output prefix\n");
+    return 0;
+}
+
+static RK_S32 bench_opt_w(void *ctx, const char *next)
+{
+    MpiBenchCmd *cmd = (MpiBenchCmd *)ctx;
+
+    if (next) {
+        cmd->width = atoi(next);
+        return 1;
+    }
+
+    mpp_err("invalid width\n");
+    return 0;
+}
+
+static RK_S32 bench_opt_h(void *ctx, const char *next)
+{
+    MpiBenchCmd *cmd = (MpiBenchCmd *)ctx;
+
+    if (next) {
+        cmd->height = atoi(next);
+        return 1;
+    }
+
+    mpp_err("invalid height\n");
+    return 0;
+}
+
+static RK_S32 bench_opt_n(void *ctx, const char *next)
+{
+    MpiBenchCmd *cmd = (MpiBenchCmd *)ctx;
+
+    if (next) {
+        cmd->frame_num = atoi(next);
+        return 1;
+    }
+
+    mpp_err("invalid frame number\n");
+    return 0;
+}
+
+static RK_S32 bench_opt_s(void *ctx, const char *next)
+{
+    MpiBenchCmd *cmd = (MpiBenchCmd *)ctx;
+
+    if (next) {
+        cmd->sessions = atoi(next);
+        return 1;
+    }
+
+    mpp_err("invalid session number\n");
+    return 0;
+}
+
+static RK_S32 bench_opt_r(void *ctx, const char *next)
+{
+    MpiBenchCmd *cmd = (MpiBenchCmd *)ctx;
+
+    if (next) {
+        cmd->step = atoi(next);
+        return 1;
+    }
+
+    mpp_err("invalid session step\n");
+    return 0;
+}
+
+static MppOptInfo bench_opts[] = {
+    {"m",   "mode",         "dec or enc",                                   bench_opt_m},
+    {"t",   "type",         "coding types separated by comma",              bench_opt_t},
+    {"i",   "input_file",   "decoder input files separated by comma",       bench_opt_i},
+    {"o",   "output",       "result file prefix for .csv and .json",        bench_opt_o},
+    {"w",   "width",        "encoder input width",                          bench_opt_w},
+    {"h",   "height",       "encoder input height",                         bench_opt_h},
+    {"n",   "frame_num",    "frame number of each session in each step",    bench_opt_n},
+    {"s",   "sessions",     "max session number",                           bench_opt_s},
+    {"r",   "step",         "session number step, 0 for doubling",          bench_opt_r},
+};
+
+static void bench_show_help(const char *name)
+{
+    RK_U32 i;
+
+    mpp_log("usage: %s [options]\n", name);
+    for (i = 0; i < MPP_ARRAY_ELEMS(bench_opts); i++)
+        mpp_log("-%-3s %-12s %s\n", bench_opts[i].name, bench_opts[i].full_name,
+                bench_opts[i].help);
+    mpp_log("mpp_mem_total_now is counted with env mpp_mem_debug\n");
+}
+
+static MPP_RET bench_parse_cmd(MpiBenchCmd *cmd, int argc, char **argv)
+{
+    MppOpt opts = NULL;
+    MPP_RET ret = MPP_NOK;
+    RK_U32 i;
+
+    cmd->mode = MPP_CTX_ENC;
+    cmd->output = "mpi_bench";
+    cmd->width = 1920;
+    cmd->height = 1080;
+    cmd->frame_num = 300;
+    cmd->sessions = 4;
+    cmd->step = 1;
+
+    if (argc < 2)
+        return MPP_NOK;
+
+    mpp_opt_init(&opts);
+    mpp_opt_setup(opts, cmd);
+    for (i = 0; i < MPP_ARRAY_ELEMS(bench_opts); i++)
+        mpp_opt_add(opts, &bench_opts[i]);
+    mpp_opt_add(opts, NULL);
+
+    ret = mpp_opt_parse(opts, argc, argv);
+    mpp_opt_deinit(opts);
+
+    if (!cmd->type_cnt) {
+        mpp_err("no coding type\n");
+        ret = MPP_NOK;
+    }
+
+    if (cmd->mode == MPP_CTX_DEC && cmd->input_cnt < cmd->type_cnt) {
+        mpp_err("decoder needs one input file for each type\n");
+        ret = MPP_NOK;
+    }
+
+    for (i = 0; i < (RK_U32)cmd->type_cnt; i++) {
+        if (mpp_check_support_format(cmd->mode, cmd->types[i])) {
+            mpp_err("unsupported coding type %d\n", cmd->types[i]);
+            ret = MPP_NOK;
+        }
+
+        /* jpeg decoder needs output frame on task which simple api has not */
+        if (cmd->mode == MPP_CTX_DEC && cmd->types[i] == MPP_VIDEO_CodingMJPEG) {
+            mpp_err("jpeg decoder is not supported\n");
+            ret = MPP_NOK;
+        }
+    }
+
+    if (cmd->width <= 0 || cmd->height <= 0 || cmd->frame_num <= 0 ||
+        cmd->sessions <= 0 || cmd->step < 0) {
+        mpp_err("invalid w:h [%d:%d] frames %d sessions %d step %d\n",
+                cmd->width, cmd->height, cmd->frame_num, cmd->sessions, cmd->step);
+        ret = MPP_NOK;
+    }
+
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    MpiBenchCmd cmd_ctx;
+    MpiBenchCmd *cmd = &cmd_ctx;
+    FILE *fp_csv = NULL;
+    FILE *fp_json = NULL;
+    char path[256];
+    RK_S32 first = 1;
+    MPP_RET ret;
+    RK_S32 i;
+
+    memset(cmd, 0, sizeof(*cmd));
+
+    ret = bench_parse_cmd(cmd, argc, argv);
+    if (ret) {
+        bench_show_help(argv[0]);
+        goto RET;
+    }
+
+    snprintf(path, sizeof(path), "%s.csv", cmd->output);
+    fp_csv = fopen(path, "w");
+    snprintf(path, sizeof(path), "%s.json", cmd->output);
+    fp_json = fopen(path, "w");
+    if (NULL == fp_csv || NULL == fp_json) {
+        mpp_err("failed to open result file with prefix %s\n", cmd->output);
+        ret = MPP_ERR_OPEN_FILE;
+        goto RET;
+    }
+
+    fprintf(fp_csv, "mode,type,sessions,frames,elapsed_us,fps,latency_p50_us,"
+            "latency_p99_us,latency_max_us,cpu_us_per_frame,user_cpu_us_per_frame,"
+            "thread_count,ctx_switch_per_sec,mem_now,buf_now\n");
+    fprintf(fp_json, "{\"steps\":[\n");
+
+    for (i = 0; i < cmd->type_cnt && !ret; i++) {
+        BenchStep step;
+        RK_S32 count;
+
+        memset(&step, 0, sizeof(step));
+        step.cmd = cmd;
+        step.type = cmd->types[i];
+
+        if (cmd->mode == MPP_CTX_DEC) {
+            reader_init(&step.reader, cmd->inputs[i], step.type);
+            if (NULL == step.reader) {
+                ret = MPP_ERR_OPEN_FILE;
+                break;
+            }
+        }
+
+        for (count = 1; count <= cmd->sessions && !ret;
+             count = cmd->step ? count + cmd->step : count * 2) {
+            step.sessions = count;
+            ret = bench_run_step(&step, fp_csv, fp_json, first);
+            first = 0;
+        }
+
+        if (step.reader)
+            reader_deinit(step.reader);
+    }
+
+    fprintf(fp_json, "\n]}\n");
+
+RET:
+    if (fp_csv)
+        fclose(fp_csv);
+    if (fp_json)
+        fclose(fp_json);
+
+    for (i = 0; i < cmd->input_cnt; i++)
+        MPP_FREE(cmd->inputs[i]);
+
+    mpp_log("mpi bench test %s\n", ret ? "failed" : "done");
+
+    return ret;
+}
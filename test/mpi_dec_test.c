@@ -41,6 +41,8 @@ typedef struct {
     /* input and output */
     DecBufMgr       buf_mgr;
     MppBufferGroup  frm_grp;
+    /* buffer group for MppBuffer input packet */
+    MppBufferGroup  pkt_grp;
     MppPacket       packet;
     MppFrame        frame;
 
@@ -55,6 +57,10 @@ typedef struct {
     float           frame_rate;
     RK_S64          elapsed_time;
     RK_S64          delay;
+
+    /* put_packet latency statistic */
+    RK_S64          put_time;
+    RK_S32          put_count;
     FILE            *fp_verify;
     FrmCrc          checkcrc;
 } MpiDecLoopData;
@@ -68,6 +74,7 @@ static int dec_simple(MpiDecLoopData *data)
     MppCtx ctx  = data->ctx;
     MppApi *mpi = data->mpi;
     MppPacket packet = data->packet;
+    MppBuffer pkt_buf = NULL;
     FileBufSlot *slot = NULL;
     RK_U32 quiet = data->quiet;
     FrmCrc *checkcrc = &data->checkcrc;
@@ -91,10 +98,31 @@ static int dec_simple(MpiDecLoopData *data)
         }
     }
 
-    mpp_packet_set_data(packet, slot->data);
-    mpp_packet_set_size(packet, slot->size);
-    mpp_packet_set_pos(packet, slot->data);
-    mpp_packet_set_length(packet, slot->size);
+    if (cmd->pkt_buf) {
+        /*
+         * MppBuffer input mode:
+         * stream is stored in MppBuffer like demuxer writing to dma buffer
+         * directly. put_packet copies the data before it returns.
+         */
+        pkt_buf = slot->buf;
+        if (!pkt_buf) {
+            mpp_buffer_get(data->pkt_grp, &pkt_buf, MPP_MAX(slot->size, 1));
+            if (!pkt_buf) {
+                mpp_err("%p failed to get packet buffer size %d\n", ctx, slot->size);
+                data->loop_end = 1;
+                return MPP_ERR_NOMEM;
+            }
+            memcpy(mpp_buffer_get_ptr(pkt_buf), slot->data, slot->size);
+        }
+
+        mpp_packet_init_with_buffer(&packet, pkt_buf);
+        mpp_packet_set_length(packet, slot->size);
+    } else {
+        mpp_packet_set_data(packet, slot->data);
+        mpp_packet_set_size(packet, slot->size);
+        mpp_packet_set_pos(packet, slot->data);
+        mpp_packet_set_length(packet, slot->size);
+    }
     // setup eos flag
     if (pkt_eos)
         mpp_packet_set_eos(packet);
@@ -105,9 +133,13 @@ static int dec_simple(MpiDecLoopData *data)
 
         // send the packet first if packet is not done
         if (!pkt_done) {
+            RK_S64 t_put = mpp_time();
+
             ret = mpi->decode_put_packet(ctx, packet);
+            data->put_time += mpp_time() - t_put;
             if (MPP_OK == ret) {
                 pkt_done = 1;
+                data->put_count++;
                 if (!data->first_pkt)
                     data->first_pkt = mpp_time();
             }
@@ -255,6 +287,13 @@ static int dec_simple(MpiDecLoopData *data)
         msleep(1);
     } while (1);
 
+    if (cmd->pkt_buf) {
+        /* put_packet has copied the data so buffer can be returned here */
+        mpp_packet_deinit(&packet);
+        if (pkt_buf != slot->buf)
+            mpp_buffer_put(pkt_buf);
+    }
+
     return ret;
 }
 
@@ -439,6 +478,12 @@ void *thread_decode(void *arg)
             data->frame_count, (RK_S64)(data->elapsed_time / 1000),
             (RK_S32)(data->delay / 1000), data->frame_rate);
 
+    if (cmd->simple && data->put_count) {
+        mpp_log("input %s put %d packets put_packet cost %lld us total %.2f us per packet\n",
+                cmd->pkt_buf ? "MppBuffer" : "copy", data->put_count,
+                data->put_time, (float)data->put_time / data->put_count);
+    }
+
     MPP_FREE(data->checkcrc.luma.sum);
     MPP_FREE(data->checkcrc.chroma.sum);
 
@@ -503,6 +548,14 @@ int dec_decode(MpiDecTestCmd *cmd)
             mpp_err("mpp_packet_init failed\n");
             goto MPP_TEST_OUT;
         }
+
+        if (cmd->pkt_buf) {
+            ret = mpp_buffer_group_get_internal(&data.pkt_grp, MPP_BUFFER_TYPE_ION);
+            if (ret) {
+                mpp_err("failed to get packet buffer group ret %d\n", ret);
+                goto MPP_TEST_OUT;
+            }
+        }
     } else {
         RK_U32 hor_stride = MPP_ALIGN(width, 16);
         RK_U32 ver_stride = MPP_ALIGN(height, 16);
@@ -639,6 +692,11 @@ MPP_TEST_OUT:
     }
 
     data.frm_grp = NULL;
+    if (data.pkt_grp) {
+        mpp_buffer_group_put(data.pkt_grp);
+        data.pkt_grp = NULL;
+    }
+
     if (data.buf_mgr) {
         dec_buf_mgr_deinit(data.buf_mgr);
         data.buf_mgr = NULL;
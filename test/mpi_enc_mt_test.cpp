@@ -33,6 +33,8 @@
 #include "mpp_enc_roi_utils.h"
 
 #define BUF_COUNT   4
+/* look-ahead frames are held by encoder and need extra input buffers */
+#define BUF_MAX     (BUF_COUNT + 16)
 
 typedef struct {
     // base flow context
@@ -70,8 +72,8 @@ typedef struct {
     // input / output
     mpp_list        *list_buf;
     MppBufferGroup buf_grp;
-    MppBuffer frm_buf[BUF_COUNT];
-    MppBuffer pkt_buf[BUF_COUNT];
+    MppBuffer frm_buf[BUF_MAX];
+    MppBuffer pkt_buf[BUF_MAX];
     RK_S32 buf_idx;
     MppEncSeiMode sei_mode;
     MppEncHeaderMode header_mode;
@@ -462,6 +464,7 @@ MPP_RET test_mt_cfg_setup(MpiEncMtCtxInfo *info)
 
     // config gop_len and ref cfg
     mpp_enc_cfg_set_s32(cfg, "rc:gop", p->gop_len ? p->gop_len : p->fps_out_num * 2);
+    mpp_enc_cfg_set_s32(cfg, "rc:lookahead", cmd->lookahead);
 
     mpp_env_get_u32("gop_mode", &gop_mode, gop_mode);
 
@@ -524,6 +527,7 @@ MPP_RET mt_test_res_init(MpiEncMtCtxInfo *info)
     MppPollType timeout = MPP_POLL_NON_BLOCK;
     RK_U32 quiet = cmd->quiet;
     MPP_RET ret = MPP_OK;
+    RK_S32 buf_cnt = BUF_COUNT + MPP_CLIP3(0, BUF_MAX - BUF_COUNT, cmd->lookahead);
     RK_S32 i;
 
     mpp_log_q(quiet, "%s start\n", info->name);
@@ -540,7 +544,7 @@ MPP_RET mt_test_res_init(MpiEncMtCtxInfo *info)
         return ret;
     }
 
-    for (i = 0; i < BUF_COUNT; i++) {
+    for (i = 0; i < buf_cnt; i++) {
         ret = mpp_buffer_get(p->buf_grp, &p->frm_buf[i], p->frame_size + p->header_size);
         if (ret) {
             mpp_err_f("failed to get buffer for input frame ret %d\n", ret);
@@ -628,7 +632,7 @@ MPP_RET mt_test_res_deinit(MpiEncMtCtxInfo *info)
         p->cfg = NULL;
     }
 
-    for (i = 0; i < BUF_COUNT; i++) {
+    for (i = 0; i < BUF_MAX; i++) {
         if (p->frm_buf[i]) {
             mpp_buffer_put(p->frm_buf[i]);
             p->frm_buf[i] = NULL;
@@ -752,6 +756,9 @@ void *enc_test_input(void *arg)
         mpp_frame_set_hor_stride(frame, p->hor_stride);
         mpp_frame_set_ver_stride(frame, p->ver_stride);
         mpp_frame_set_fmt(frame, p->fmt);
+        /* last frame eos flushes the frames held in encoder look-ahead window */
+        if (p->frame_num > 0 && p->frm_cnt_in + 1 >= p->frame_num)
+            p->frm_eos = 1;
         mpp_frame_set_eos(frame, p->frm_eos);
 
         if (p->fp_input && feof(p->fp_input))
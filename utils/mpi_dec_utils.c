@@ -614,6 +614,18 @@ RK_S32 mpi_dec_opt_bufmode(void *ctx, const char *next)
     return 0;
 }
 
+RK_S32 mpi_dec_opt_pktbuf(void *ctx, const char *next)
+{
+    MpiDecTestCmd *cmd = (MpiDecTestCmd *)ctx;
+
+    if (next) {
+        cmd->pkt_buf = atoi(next);
+        return 1;
+    }
+
+    mpp_err("invalid packet buffer value\n");
+    return 0;
+}
 
 RK_S32 mpi_dec_opt_help(void *ctx, const char *next)
 {
@@ -636,6 +648,7 @@ static MppOptInfo dec_opts[] = {
     {"slt",     "slt file",     "slt verify data file",             mpi_dec_opt_slt},
     {"help",    "help",         "show help",                        mpi_dec_opt_help},
     {"bufmode", "buffer mode",  "hi - half internal (default) i -internal e - external", mpi_dec_opt_bufmode},
+    {"pktbuf",  "packet buffer", "input packet mode 0 - copy (default) 1 - MppBuffer", mpi_dec_opt_pktbuf},
 };
 
 static RK_U32 dec_opt_cnt = MPP_ARRAY_ELEMS(dec_opts);
@@ -761,6 +774,7 @@ void mpi_dec_test_cmd_options(MpiDecTestCmd* cmd)
     mpp_log("height     : %4d\n", cmd->height);
     mpp_log("type       : %4d\n", cmd->type);
     mpp_log("max frames : %4d\n", cmd->frame_num);
+    mpp_log("input mode : %s\n", cmd->pkt_buf ? "MppBuffer" : "copy");
     if (cmd->file_slt)
         mpp_log("verify     : %s\n", cmd->file_slt);
 }
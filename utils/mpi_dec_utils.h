@@ -119,6 +119,8 @@ typedef struct MpiDecTestCmd_t {
     RK_S32          frame_num;
     size_t          pkt_size;
     MppDecBufMode   buf_mode;
+    /* put packet with MppBuffer instead of copied data */
+    RK_U32          pkt_buf;
 
     /* use for mpi_dec_multi_test */
     RK_S32          nthreads;
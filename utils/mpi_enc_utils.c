@@ -652,6 +652,19 @@ RK_S32 mpi_enc_opt_bias_p(void *ctx, const char *next)
     return 0;
 }
 
+RK_S32 mpi_enc_opt_la(void *ctx, const char *next)
+{
+    MpiEncTestArgs *cmd = (MpiEncTestArgs *)ctx;
+
+    if (next) {
+        cmd->lookahead = atoi(next);
+        return 1;
+    }
+
+    mpp_err("invalid lookahead\n");
+    return 0;
+}
+
 static MppOptInfo enc_opts[] = {
     {"i",       "input_file",           "input frame file",                         mpi_enc_opt_i},
     {"o",       "output_file",          "output encoded bitstream file",            mpi_enc_opt_o},
@@ -686,7 +699,8 @@ static MppOptInfo enc_opts[] = {
     {"sao_p",   "sao_str_p",            "sao_str_p, 0:off 1 2 3",                   mpi_enc_opt_sao_p},
     {"bc",      "bitrate container",    "rc_container, 0:off 1:weak 2:strong",      mpi_enc_opt_bc},
     {"ibias",   "bias i",               "bias_i",                                   mpi_enc_opt_bias_i},
-    {"pbias",   "bias p",               "bias_p",                                   mpi_enc_opt_bias_p}
+    {"pbias",   "bias p",               "bias_p",                                   mpi_enc_opt_bias_p},
+    {"la",      "lookahead",            "rc look-ahead frames, 0:off max 16",       mpi_enc_opt_la}
 };
 
 static RK_U32 enc_opt_cnt = MPP_ARRAY_ELEMS(enc_opts);
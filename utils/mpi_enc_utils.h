@@ -80,6 +80,9 @@ typedef struct MpiEncTestArgs_t {
     RK_S32              bias_i;
     RK_S32              bias_p;
 
+    /* -la rc look-ahead frames */
+    RK_S32              lookahead;
+
     /* -qpdd cu_qp_delta_depth */
     RK_S32              cu_qp_delta_depth;
     RK_S32              anti_flicker_str;